@@ -903,11 +903,15 @@ gnc_ledger_display_refresh_internal (GNCLedgerDisplay* ld)
      * just use qof_query_last_run().  It's possible that the dates
      * changed, requiring a full new query.  Similar considerations
      * needed for multi-user mode.
+     *
+     * Running the query loads the transactions it shows from a backend that
+     * holds back older ones. The unfiltered splits only feed the
+     * completions, so they come from what is already loaded.
      */
     splits = qof_query_run (ld->query);
 
     if (!qof_query_equal (ld->query, ld->pre_filter_query))
-        pre_filter_splits = qof_query_run (ld->pre_filter_query);
+        pre_filter_splits = qof_query_run_loaded (ld->pre_filter_query);
 
     gnc_ledger_display_set_watches (ld, splits);
 
@@ -951,6 +951,9 @@ GncDbiBackend<Type>::safe_sync (QofBook* book)
     g_return_if_fail (book != nullptr);
 
     ENTER ("book=%p, primary=%p", book, m_book);
+    /* The tables are rewritten from memory, so it must hold everything. */
+    if (!fully_loaded())
+        load (m_book, LOAD_TYPE_LOAD_ALL);
     if (!conn->begin_transaction())
     {
         LEAVE("Failed to obtain a transaction.");
@@ -994,6 +997,9 @@ GncDbiBackend<DbType::DBI_MYSQL>::safe_sync (QofBook* book)
     g_return_if_fail (book != nullptr);
 
     ENTER ("book=%p, primary=%p", book, m_book);
+    /* The tables are rewritten from memory, so it must hold everything. */
+    if (!fully_loaded())
+        load (m_book, LOAD_TYPE_LOAD_ALL);
     if (!conn->table_operation (TableOpType::backup))
     {
         set_error(ERR_BACKEND_SERVER_ERR);
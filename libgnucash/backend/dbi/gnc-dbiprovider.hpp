@@ -44,6 +44,15 @@ public:
                                 const GncSqlColumnInfo& info) = 0;
     virtual StrVec get_index_list (dbi_conn conn) = 0;
     virtual void drop_index(dbi_conn conn, const std::string& index) = 0;
+    /** Have the server parse and plan sql, whose parameters are marked with
+     * '?', as a statement called name. Returns false if the database can't
+     * do that through libdbi, in which case the caller must substitute the
+     * parameters itself.
+     */
+    virtual bool prepare_statement(dbi_conn conn, const std::string& name,
+                                   const std::string& sql) = 0;
+    virtual void deallocate_statement(dbi_conn conn,
+                                      const std::string& name) = 0;
 };
 
 using GncDbiProviderPtr = std::unique_ptr<GncDbiProvider>;
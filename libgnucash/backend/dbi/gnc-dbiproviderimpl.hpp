@@ -44,6 +44,9 @@ public:
     void append_col_def(std::string& ddl, const GncSqlColumnInfo& info);
     StrVec get_index_list (dbi_conn conn);
     void drop_index(dbi_conn conn, const std::string& index);
+    bool prepare_statement(dbi_conn conn, const std::string& name,
+                           const std::string& sql);
+    void deallocate_statement(dbi_conn conn, const std::string& name);
 };
 
 template <DbType T> GncDbiProviderPtr
@@ -385,4 +388,60 @@ GncDbiProviderImpl<DbType::DBI_MYSQL>::drop_index (dbi_conn conn, const std::str
     if (result)
         dbi_result_free (result);
 }
+
+/* libdbi has no prepared statement API, so only PostgreSQL, which can PREPARE
+ * in plain SQL with positional parameters, gets server-side statements. MySQL's
+ * SQL-level PREPARE needs the parameters passed as user variables, which costs
+ * a round trip per parameter, and SQLite has no SQL-level PREPARE at all.
+ */
+template <DbType P> bool
+GncDbiProviderImpl<P>::prepare_statement(dbi_conn, const std::string&,
+                                         const std::string&)
+{
+    return false;
+}
+
+template <DbType P> void
+GncDbiProviderImpl<P>::deallocate_statement(dbi_conn, const std::string&)
+{
+}
+
+template<> bool
+GncDbiProviderImpl<DbType::DBI_PGSQL>::prepare_statement(dbi_conn conn,
+                                                         const std::string& name,
+                                                         const std::string& sql)
+{
+    std::string ddl{"PREPARE " + name + " AS "};
+    unsigned int index = 0;
+    bool in_quote = false;
+    for (auto c : sql)
+    {
+        if (c == '\'')
+            in_quote = !in_quote;
+        if (c == '?' && !in_quote)
+            ddl += "$" + std::to_string(++index);
+        else
+            ddl += c;
+    }
+    auto result = dbi_conn_query (conn, ddl.c_str());
+    if (result == nullptr)
+    {
+        const char* errmsg;
+        dbi_conn_error (conn, &errmsg);
+        PWARN ("Failed to prepare %s, falling back to client-side binding: %s",
+               name.c_str(), errmsg);
+        return false;
+    }
+    dbi_result_free (result);
+    return true;
+}
+
+template<> void
+GncDbiProviderImpl<DbType::DBI_PGSQL>::deallocate_statement(dbi_conn conn,
+                                                            const std::string& name)
+{
+    auto result = dbi_conn_queryf (conn, "DEALLOCATE %s", name.c_str());
+    if (result)
+        dbi_result_free (result);
+}
 #endif //__GNC_DBISQLPROVIDERIMPL_HPP__
@@ -29,6 +29,9 @@
 #include <string>
 #include <regex>
 #include <sstream>
+#include <iomanip>
+#include <limits>
+#include <locale>
 
 #include "gnc-dbisqlconnection.hpp"
 
@@ -45,25 +48,99 @@ class GncDbiSqlStatement : public GncSqlStatement
 public:
     GncDbiSqlStatement(const std::string& sql) :
         m_sql {sql} {}
-    ~GncDbiSqlStatement() {}
+    GncDbiSqlStatement(GncDbiSqlConnection* conn, const std::string& sql,
+                       const std::string& prepared_name) :
+        m_conn {conn}, m_sql {sql}, m_prepared_name {prepared_name},
+        m_session_id {conn->session_id()} {}
+    ~GncDbiSqlStatement();
     const char* to_sql() const override;
     void add_where_cond(QofIdTypeConst, const PairVec&) override;
+    void bind(unsigned int, const GncSqlParam&) override;
+    void clear_bindings() override { m_params.clear(); }
 
 private:
+    std::string param_to_sql(const GncSqlParam&) const;
+    /** Set only for statements created by prepare_statement. */
+    GncDbiSqlConnection* m_conn = nullptr;
     std::string m_sql;
+    /** The server-side name if the provider could prepare the statement. */
+    mutable std::string m_prepared_name;
+    /** The connection session m_prepared_name was prepared in. */
+    mutable unsigned int m_session_id = 0;
+    std::vector<GncSqlParam> m_params;
+    mutable std::string m_bound_sql;
 };
 
+/* After a reconnect the server no longer has the statement, and its name may
+ * have been given to another one.
+ */
+GncDbiSqlStatement::~GncDbiSqlStatement()
+{
+    if (m_conn && !m_prepared_name.empty() &&
+        m_session_id == m_conn->session_id())
+        m_conn->deallocate_statement (m_prepared_name);
+}
 
+/* Statements without a connection are plain SQL. Prepared ones are rendered
+ * either as an EXECUTE of the server-side statement or, for providers which
+ * can't prepare, by substituting the bound values for the placeholders.
+ */
 const char*
 GncDbiSqlStatement::to_sql() const
 {
-    return m_sql.c_str();
+    if (m_conn == nullptr)
+        return m_sql.c_str();
+
+    m_bound_sql.clear();
+    if (!m_prepared_name.empty() && m_session_id != m_conn->session_id())
+    {
+        m_prepared_name = m_conn->prepare_on_server (m_sql);
+        m_session_id = m_conn->session_id();
+    }
+    if (!m_prepared_name.empty())
+    {
+        m_bound_sql = "EXECUTE " + m_prepared_name;
+        for (auto param = m_params.begin(); param != m_params.end(); ++param)
+        {
+            m_bound_sql += param == m_params.begin() ? "(" : ",";
+            m_bound_sql += param_to_sql (*param);
+        }
+        if (!m_params.empty())
+            m_bound_sql += ")";
+        return m_bound_sql.c_str();
+    }
+
+    unsigned int index = 0;
+    bool in_quote = false;
+    m_bound_sql.reserve (m_sql.size() + 16 * m_params.size());
+    for (auto c : m_sql)
+    {
+        if (c == '\'')
+            in_quote = !in_quote;
+        if (c != '?' || in_quote)
+        {
+            m_bound_sql += c;
+            continue;
+        }
+        if (index < m_params.size())
+            m_bound_sql += param_to_sql (m_params[index]);
+        else
+            m_bound_sql += "NULL";
+        ++index;
+    }
+    return m_bound_sql.c_str();
 }
 
 void
 GncDbiSqlStatement::add_where_cond(QofIdTypeConst type_name,
                                    const PairVec& col_values)
 {
+    if (!m_prepared_name.empty())
+    {
+        PERR ("Can't add a where condition to prepared statement %s",
+              m_prepared_name.c_str());
+        return;
+    }
     m_sql += " WHERE ";
     for (auto colpair : col_values)
     {
@@ -76,6 +153,33 @@ GncDbiSqlStatement::add_where_cond(QofIdTypeConst type_name,
     }
 }
 
+void
+GncDbiSqlStatement::bind(unsigned int index, const GncSqlParam& param)
+{
+    if (index >= m_params.size())
+        m_params.resize (index + 1);
+    m_params[index] = param;
+}
+
+std::string
+GncDbiSqlStatement::param_to_sql(const GncSqlParam& param) const
+{
+    if (std::holds_alternative<int64_t>(param))
+        return std::to_string (std::get<int64_t>(param));
+    if (std::holds_alternative<double>(param))
+    {
+        /* Enough digits that the server reads back the same double. */
+        std::ostringstream stream;
+        stream.imbue (std::locale::classic());
+        stream << std::setprecision(std::numeric_limits<double>::max_digits10)
+               << std::get<double>(param);
+        return stream.str();
+    }
+    if (std::holds_alternative<std::string>(param))
+        return m_conn->quote_string (std::get<std::string>(param));
+    return "NULL";
+}
+
 GncDbiSqlConnection::GncDbiSqlConnection (DbType type, QofBackend* qbe,
                                           dbi_conn conn, SessionOpenMode mode) :
     m_qbe{qbe}, m_conn{conn},
@@ -85,7 +189,7 @@ GncDbiSqlConnection::GncDbiSqlConnection (DbType type, QofBackend* qbe,
             make_dbi_provider<DbType::DBI_MYSQL>() :
             make_dbi_provider<DbType::DBI_PGSQL>()},
     m_conn_ok{true}, m_last_error{ERR_BACKEND_NO_ERR}, m_error_repeat{0},
-    m_retry{false}, m_sql_savepoint{0}, m_readonly{false}
+    m_retry{false}, m_sql_savepoint{0}, m_readonly{false}, m_prepared_count{0}
 {
     if (mode == SESSION_READ_ONLY)
         m_readonly = true;
@@ -324,6 +428,41 @@ GncDbiSqlConnection::create_statement_from_sql (const std::string& sql)
     return std::unique_ptr<GncSqlStatement>{new GncDbiSqlStatement (sql)};
 }
 
+GncSqlStatementPtr
+GncDbiSqlConnection::prepare_statement (const std::string& sql) noexcept
+{
+    auto name = prepare_on_server (sql);
+    return std::unique_ptr<GncSqlStatement>{
+        new GncDbiSqlStatement (this, sql, name)};
+}
+
+std::string
+GncDbiSqlConnection::prepare_on_server (const std::string& sql) noexcept
+{
+    std::ostringstream name;
+    name << "gnc_stmt_" << ++m_prepared_count;
+    DEBUG ("PREPARE %s: %s\n", name.str().c_str(), sql.c_str());
+    init_error ();
+    if (!m_provider->prepare_statement (m_conn, name.str(), sql))
+        return std::string{};
+    return name.str();
+}
+
+void
+GncDbiSqlConnection::reconnected () noexcept
+{
+    ++m_session_id;
+    m_prepared_count = 0;
+}
+
+void
+GncDbiSqlConnection::deallocate_statement (const std::string& name)
+    const noexcept
+{
+    if (m_conn)
+        m_provider->deallocate_statement (m_conn, name);
+}
+
 bool
 GncDbiSqlConnection::does_table_exist (const std::string& table_name)
     const noexcept
@@ -568,6 +707,8 @@ GncDbiSqlConnection::verify () noexcept
     init_error ();
     m_conn_ok = true;
     (void)dbi_conn_connect (m_conn);
+    if (m_conn_ok)
+        reconnected();
 
     return m_conn_ok;
 }
@@ -583,6 +724,7 @@ GncDbiSqlConnection::retry_connection(const char* msg)
         {
             init_error();
             m_conn_ok = true;
+            reconnected();
             return true;
         }
 #ifdef G_OS_WIN32
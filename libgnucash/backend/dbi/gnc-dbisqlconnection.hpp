@@ -50,6 +50,18 @@ public:
         noexcept override;
     GncSqlStatementPtr create_statement_from_sql (const std::string&)
         const noexcept override;
+    GncSqlStatementPtr prepare_statement (const std::string&)
+        noexcept override;
+    /** Have the server prepare sql under a fresh name and return the name, or
+     * an empty string if the provider binds on the client instead.
+     */
+    std::string prepare_on_server (const std::string& sql) noexcept;
+    /** Release the server-side resources of a prepared statement. */
+    void deallocate_statement (const std::string& name) const noexcept;
+    /** Incremented on every reconnect, which drops all server-side prepared
+     * statements.
+     */
+    unsigned int session_id () const noexcept { return m_session_id; }
     bool does_table_exist (const std::string&) const noexcept override;
     bool begin_transaction () noexcept override;
     bool rollback_transaction () noexcept override;
@@ -109,6 +121,11 @@ private:
     bool m_retry;
     unsigned int m_sql_savepoint;
     bool m_readonly; 
+    /** Used to give each server-side prepared statement a unique name. */
+    unsigned int m_prepared_count;
+    unsigned int m_session_id = 0;
+    /** Forget the server-side state of the old session after a reconnect. */
+    void reconnected() noexcept;
     bool lock_database(bool break_lock);
     void unlock_database();
     bool rename_table(const std::string& old_name, const std::string& new_name);
@@ -150,17 +150,53 @@ GncDbiSqlResult::IteratorImpl::get_string_at_col(const char* col) const
 
 std::optional<time64>
 GncDbiSqlResult::IteratorImpl::get_time64_at_col (const char* col) const
+{
+    auto idx = dbi_result_get_field_idx (m_inst->m_dbi_result, col);
+    if (idx == 0)
+        return std::nullopt;
+    return get_time64_at_index (idx);
+}
+
+/* libdbi numbers the fields from 1 and returns 0 for an unknown name. */
+int
+GncDbiSqlResult::IteratorImpl::col_index (const char* col) const noexcept
+{
+    auto idx = dbi_result_get_field_idx (m_inst->m_dbi_result, col);
+    return idx == 0 ? -1 : static_cast<int>(idx);
+}
+
+std::optional<int64_t>
+GncDbiSqlResult::IteratorImpl::get_int_at_index (int idx) const
+{
+    auto type = dbi_result_get_field_type_idx (m_inst->m_dbi_result, idx);
+    if(type != DBI_TYPE_INTEGER)
+        return std::nullopt;
+    return std::optional<int64_t>{dbi_result_get_longlong_idx (m_inst->m_dbi_result, idx)};
+}
+
+const char*
+GncDbiSqlResult::IteratorImpl::get_cstring_at_index (int idx) const noexcept
+{
+    auto type = dbi_result_get_field_type_idx (m_inst->m_dbi_result, idx);
+    if(type != DBI_TYPE_STRING)
+        return nullptr;
+    auto strval = dbi_result_get_string_idx (m_inst->m_dbi_result, idx);
+    return strval ? strval : "";
+}
+
+std::optional<time64>
+GncDbiSqlResult::IteratorImpl::get_time64_at_index (int idx) const
 {
     auto result = (dbi_result_t*) (m_inst->m_dbi_result);
-    auto type = dbi_result_get_field_type (result, col);
-    dbi_result_get_field_attribs (result, col);
+    auto type = dbi_result_get_field_type_idx (result, idx);
+    dbi_result_get_field_attribs_idx (result, idx);
     if (type != DBI_TYPE_DATETIME)
         return std::nullopt;
 #if HAVE_LIBDBI_TO_LONGLONG
     /* A less evil hack than the one required by libdbi-0.8, but
      * still necessary to work around the same bug.
      */
-    auto timeval = dbi_result_get_as_longlong(result, col);
+    auto timeval = dbi_result_get_as_longlong_idx(result, idx);
 #else
     /* A seriously evil hack to work around libdbi bug #15
      * https://sourceforge.net/p/libdbi/bugs/15/. When libdbi
@@ -169,8 +205,7 @@ GncDbiSqlResult::IteratorImpl::get_time64_at_col (const char* col) const
      * Note: 0.9 is available in Debian Jessie and Fedora 21.
      */
     auto row = dbi_result_get_currow (result);
-    auto idx = dbi_result_get_field_idx (result, col) - 1;
-    time64 timeval = result->rows[row]->field_values[idx].d_datetime;
+    time64 timeval = result->rows[row]->field_values[idx - 1].d_datetime;
 #endif //HAVE_LIBDBI_TO_LONGLONG
     if (timeval < MINTIME || timeval > MAXTIME)
         timeval = 0;
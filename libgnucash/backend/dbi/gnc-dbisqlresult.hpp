@@ -65,6 +65,10 @@ protected:
         {
             return dbi_result_field_is_null(m_inst->m_dbi_result, col);
         }
+        virtual int col_index (const char* col) const noexcept;
+        virtual std::optional<int64_t> get_int_at_index (int idx) const;
+        virtual const char* get_cstring_at_index (int idx) const noexcept;
+        virtual std::optional<time64> get_time64_at_index (int idx) const;
     private:
         GncDbiSqlResult* m_inst = nullptr;
     };
@@ -0,0 +1,222 @@
+/********************************************************************
+ * bench-backend-dbi.cpp: Throughput benchmarks for the DBI backend *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+#include <kvp-frame.hpp>
+
+#include <config.h>
+
+#include <unistd.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <qof.h>
+#include <cashobjects.h>
+#include "Account.h"
+#include "Transaction.h"
+#include "Split.h"
+#include "gnc-commodity.h"
+#include "../gnc-backend-dbi.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/* Saves a generated book to a fresh SQLite3 file once for each insert batch
+ * size and reports the rows written per second, then loads the file back and
+ * reports the rows read per second.
+ *
+ * Usage: bench-backend-dbi [transactions [accounts]]
+ */
+
+struct BookSize
+{
+    int accounts;
+    int transactions;
+};
+
+static QofBook*
+make_book (const BookSize& size)
+{
+    auto book = qof_book_new ();
+    auto root = gnc_book_get_root_account (book);
+    auto table = gnc_commodity_table_get_table (book);
+    auto currency = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY,
+                                                "USD");
+    std::vector<Account*> accounts;
+    accounts.reserve (size.accounts);
+    for (int i = 0; i < size.accounts; ++i)
+    {
+        auto acct = xaccMallocAccount (book);
+        auto name = std::string{"Account "} + std::to_string (i);
+        xaccAccountBeginEdit (acct);
+        xaccAccountSetType (acct, i % 2 ? ACCT_TYPE_EXPENSE : ACCT_TYPE_BANK);
+        xaccAccountSetName (acct, name.c_str());
+        xaccAccountSetCommodity (acct, currency);
+        xaccAccountCommitEdit (acct);
+        gnc_account_append_child (root, acct);
+        accounts.push_back (acct);
+    }
+
+    auto date = gnc_time (nullptr);
+    for (int i = 0; i < size.transactions; ++i)
+    {
+        auto amount = gnc_numeric_create (100 + i % 10000, 100);
+        auto tx = xaccMallocTransaction (book);
+        xaccTransBeginEdit (tx);
+        xaccTransSetCurrency (tx, currency);
+        xaccTransSetDatePostedSecsNormalized (tx, date - i * 3600);
+        xaccTransSetDescription (tx, "Benchmark transaction");
+        auto frame = qof_instance_get_slots (QOF_INSTANCE (tx));
+        frame->set ({"notes"}, new KvpValue (g_strdup ("Generated")));
+        auto from = xaccMallocSplit (book);
+        xaccSplitSetParent (from, tx);
+        xaccSplitSetAccount (from, accounts[i % size.accounts]);
+        xaccSplitSetValue (from, gnc_numeric_neg (amount));
+        xaccSplitSetAmount (from, gnc_numeric_neg (amount));
+        auto to = xaccMallocSplit (book);
+        xaccSplitSetParent (to, tx);
+        xaccSplitSetAccount (to, accounts[(i + 1) % size.accounts]);
+        xaccSplitSetValue (to, amount);
+        xaccSplitSetAmount (to, amount);
+        xaccTransCommitEdit (tx);
+    }
+    return book;
+}
+
+/* Accounts, transactions, two splits and one slot per transaction. */
+static double
+book_rows (const BookSize& size)
+{
+    return size.accounts + 4.0 * size.transactions;
+}
+
+/* Saves a generated book to url, returning the seconds taken or a negative
+ * number if the save failed.
+ */
+static double
+save_book (const BookSize& size, const char* url)
+{
+    auto src_session = qof_session_new (make_book (size));
+    auto session = qof_session_new (qof_book_new ());
+    qof_session_begin (session, url, SESSION_NEW_OVERWRITE);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+    {
+        fprintf (stderr, "Failed to open %s\n", url);
+        qof_session_destroy (session);
+        qof_session_destroy (src_session);
+        return -1.0;
+    }
+    qof_session_swap_data (src_session, session);
+    qof_book_mark_session_dirty (qof_session_get_book (session));
+
+    auto start = g_get_monotonic_time ();
+    qof_session_save (session, nullptr);
+    auto elapsed = (g_get_monotonic_time () - start) / 1e6;
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+        elapsed = -1.0;
+
+    qof_session_end (session);
+    qof_session_destroy (session);
+    qof_session_destroy (src_session);
+    return elapsed;
+}
+
+static void
+bench_save (const BookSize& size, const char* filename, unsigned int batch_size)
+{
+    auto url = g_strdup_printf ("sqlite3://%s", filename);
+    auto batch = std::to_string (batch_size);
+    g_setenv ("GNC_SQL_INSERT_BATCH_SIZE", batch.c_str(), TRUE);
+
+    auto elapsed = save_book (size, url);
+    if (elapsed < 0)
+        printf ("sync  batch %4u: save failed\n", batch_size);
+    else
+        printf ("sync  batch %4u: %8.3f s %10.0f rows/s\n", batch_size,
+                elapsed, book_rows (size) / elapsed);
+
+    g_unsetenv ("GNC_SQL_INSERT_BATCH_SIZE");
+    g_unlink (filename);
+    g_free (url);
+}
+
+static void
+bench_load (const BookSize& size, const char* filename, int runs)
+{
+    auto url = g_strdup_printf ("sqlite3://%s", filename);
+    if (save_book (size, url) < 0)
+    {
+        printf ("load: save failed\n");
+        g_free (url);
+        return;
+    }
+
+    for (int run = 0; run < runs; ++run)
+    {
+        auto session = qof_session_new (qof_book_new ());
+        qof_session_begin (session, url, SESSION_READ_ONLY);
+        auto start = g_get_monotonic_time ();
+        qof_session_load (session, nullptr);
+        auto elapsed = (g_get_monotonic_time () - start) / 1e6;
+        if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+            printf ("load  run   %4d: load failed\n", run + 1);
+        else
+            printf ("load  run   %4d: %8.3f s %10.0f rows/s\n", run + 1,
+                    elapsed, book_rows (size) / elapsed);
+        qof_session_end (session);
+        qof_session_destroy (session);
+    }
+
+    g_unlink (filename);
+    g_free (url);
+}
+
+int
+main (int argc, char* argv[])
+{
+    BookSize size{50, 20000};
+    if (argc > 1)
+        size.transactions = atoi (argv[1]);
+    if (argc > 2)
+        size.accounts = atoi (argv[2]);
+    if (size.transactions <= 0 || size.accounts <= 1)
+    {
+        fprintf (stderr, "Usage: %s [transactions [accounts]]\n", argv[0]);
+        return 1;
+    }
+
+    g_setenv ("GNC_UNINSTALLED", "1", TRUE);
+    qof_init ();
+    cashobjects_register ();
+    gnc_module_init_backend_dbi ();
+
+    auto filename = g_strdup_printf ("%s/bench-sqlite-%d.gnucash",
+                                     g_get_tmp_dir (), getpid ());
+    printf ("%d accounts, %d transactions\n", size.accounts, size.transactions);
+    for (auto batch_size : {1u, 10u, 100u, 500u})
+        bench_save (size, filename, batch_size);
+    bench_load (size, filename, 3);
+    g_free (filename);
+
+    gnc_module_finalize_backend_dbi ();
+    qof_close ();
+    return 0;
+}
@@ -42,6 +42,7 @@
 #include <TransLog.h>
 #include "Transaction.h"
 #include "Split.h"
+#include "Query.h"
 #include "gnc-commodity.h"
 #include "gncAddress.h"
 #include "gncCustomer.h"
@@ -179,6 +180,62 @@ setup_memory (Fixture* fixture, gconstpointer pData)
         fixture->filename = NULL;
 }
 
+/* Two accounts with a transfer between them every month for two years. */
+static void
+setup_dated (Fixture* fixture, gconstpointer pData)
+{
+    gchar* url = (gchar*)pData;
+    auto book = qof_book_new();
+    auto session = qof_session_new (book);
+
+    gnc_module_init_backend_dbi();
+    auto root = gnc_book_get_root_account (book);
+    auto table = gnc_commodity_table_get_table (book);
+    auto currency = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY,
+                                                "CAD");
+    auto acct1 = xaccMallocAccount (book);
+    xaccAccountSetType (acct1, ACCT_TYPE_BANK);
+    xaccAccountSetName (acct1, "Bank 1");
+    xaccAccountSetCommodity (acct1, currency);
+    gnc_account_append_child (root, acct1);
+    auto acct2 = xaccMallocAccount (book);
+    xaccAccountSetType (acct2, ACCT_TYPE_EXPENSE);
+    xaccAccountSetName (acct2, "Expense 1");
+    xaccAccountSetCommodity (acct2, currency);
+    gnc_account_append_child (root, acct2);
+
+    auto now = gnc_time (nullptr);
+    for (int month = 0; month < 24; ++month)
+    {
+        auto amount = gnc_numeric_create (1000 + month, 100);
+        auto tx = xaccMallocTransaction (book);
+        xaccTransBeginEdit (tx);
+        xaccTransSetCurrency (tx, currency);
+        xaccTransSetDatePostedSecsNormalized (tx, now - month * 31 * 86400);
+        auto spl1 = xaccMallocSplit (book);
+        xaccSplitSetParent (spl1, tx);
+        xaccSplitSetAccount (spl1, acct1);
+        xaccSplitSetValue (spl1, gnc_numeric_neg (amount));
+        xaccSplitSetAmount (spl1, gnc_numeric_neg (amount));
+        if (month % 2)
+            xaccSplitSetReconcile (spl1, YREC);
+        auto spl2 = xaccMallocSplit (book);
+        xaccSplitSetParent (spl2, tx);
+        xaccSplitSetAccount (spl2, acct2);
+        xaccSplitSetValue (spl2, amount);
+        xaccSplitSetAmount (spl2, amount);
+        xaccTransCommitEdit (tx);
+    }
+
+    fixture->session = session;
+    if (g_strcmp0 (url, "sqlite3") == 0)
+        fixture->filename =
+            normalize_path (g_strdup_printf (TEMPDIR "/test-sqlite-%d",
+                                                    getpid ()));
+    else
+        fixture->filename = NULL;
+}
+
 static void
 setup_business (Fixture* fixture, gconstpointer pData)
 {
@@ -438,6 +495,290 @@ test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
     qof_session_destroy (session_3);
 }
 
+/* Save the same data once row by row and once in multi-row INSERTs, with a
+ * batch size that doesn't divide the tables evenly, and check that both saves
+ * load back identically.
+ */
+static void
+test_dbi_batched_insert (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    // Save row by row and load it back
+    g_setenv ("GNC_SQL_INSERT_BATCH_SIZE", "1", TRUE);
+    auto session_2 = qof_session_new (qof_book_new());
+    qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+    g_unsetenv ("GNC_SQL_INSERT_BATCH_SIZE");
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_book_mark_session_dirty (qof_session_get_book (session_2));
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_2);
+
+    auto session_3 = qof_session_new (qof_book_new());
+    qof_session_begin (session_3, url, SESSION_READ_ONLY);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_3);
+
+    // Save the same data in batches of 7 rows and load it back
+    g_setenv ("GNC_SQL_INSERT_BATCH_SIZE", "7", TRUE);
+    auto session_4 = qof_session_new (qof_book_new());
+    qof_session_begin (session_4, url, SESSION_NEW_OVERWRITE);
+    g_unsetenv ("GNC_SQL_INSERT_BATCH_SIZE");
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (session_2, session_4);
+    qof_book_mark_session_dirty (qof_session_get_book (session_4));
+    qof_session_save (session_4, NULL);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+
+    auto session_5 = qof_session_new (qof_book_new());
+    qof_session_begin (session_5, url, SESSION_READ_ONLY);
+    qof_session_load (session_5, NULL);
+    g_assert_cmpint (qof_session_get_error (session_5), == , ERR_BACKEND_NO_ERR);
+
+    compare_books (qof_session_get_book (session_3),
+                   qof_session_get_book (session_5));
+    compare_books (qof_session_get_book (session_4),
+                   qof_session_get_book (session_5));
+
+    qof_session_destroy (session_2);
+    qof_session_destroy (session_3);
+    qof_session_end (session_4);
+    qof_session_destroy (session_4);
+    qof_session_end (session_5);
+    qof_session_destroy (session_5);
+}
+
+/* Reload a saved account, change its slots in place and commit it, which
+ * writes only the slots that differ from those loaded. The changes must all
+ * survive another reload, including a double that differs only past the sixth
+ * significant digit and a numeric that differs only in its denominator.
+ */
+static void
+test_dbi_slots_diff_save (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto book = qof_session_get_book (fixture->session);
+    auto acct = gnc_account_lookup_by_name (gnc_book_get_root_account (book),
+                                            "Bank 1");
+    auto guid = *qof_instance_get_guid (QOF_INSTANCE (acct));
+    auto frame = qof_instance_get_slots (QOF_INSTANCE (acct));
+    frame->set_path ({"nested", "kept"}, new KvpValue (INT64_C (1)));
+    frame->set_path ({"nested", "changed"}, new KvpValue (INT64_C (2)));
+    frame->set_path ({"nested", "removed"}, new KvpValue (INT64_C (3)));
+
+    auto session_2 = qof_session_new (qof_book_new());
+    qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_book_mark_session_dirty (qof_session_get_book (session_2));
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+
+    // Load it back and change the slots
+    auto session_3 = qof_session_new (qof_book_new());
+    qof_session_begin (session_3, url, SESSION_NORMAL_OPEN);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    acct = xaccAccountLookup (&guid, qof_session_get_book (session_3));
+    g_assert_nonnull (acct);
+    xaccAccountBeginEdit (acct);
+    frame = qof_instance_get_slots (QOF_INSTANCE (acct));
+    delete frame->set ({"double-val"}, new KvpValue (3.14159 + 1e-9));
+    delete frame->set ({"numeric-val"},
+                       new KvpValue (gnc_numeric_create (0, 100)));
+    delete frame->set ({"int64-val"}, nullptr);
+    delete frame->set ({"added-val"}, new KvpValue (INT64_C (42)));
+    delete frame->set ({"nested", "changed"}, new KvpValue (INT64_C (20)));
+    delete frame->set ({"nested", "removed"}, nullptr);
+    qof_instance_set_dirty (QOF_INSTANCE (acct));
+    xaccAccountCommitEdit (acct);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_3);
+
+    auto session_4 = qof_session_new (qof_book_new());
+    qof_session_begin (session_4, url, SESSION_READ_ONLY);
+    qof_session_load (session_4, NULL);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    auto reloaded = xaccAccountLookup (&guid, qof_session_get_book (session_4));
+    g_assert_nonnull (reloaded);
+    auto slots = qof_instance_get_slots (QOF_INSTANCE (reloaded));
+
+    auto value = slots->get_slot ({"string-val"});
+    g_assert_nonnull (value);
+    g_assert_cmpstr (value->get<const char*>(), ==, "abcdefghijklmnop");
+    value = slots->get_slot ({"double-val"});
+    g_assert_nonnull (value);
+    g_assert_cmpfloat (value->get<double>(), ==, 3.14159 + 1e-9);
+    value = slots->get_slot ({"numeric-val"});
+    g_assert_nonnull (value);
+    g_assert_cmpint (value->get<gnc_numeric>().num, ==, 0);
+    g_assert_cmpint (value->get<gnc_numeric>().denom, ==, 100);
+    g_assert_null (slots->get_slot ({"int64-val"}));
+    value = slots->get_slot ({"added-val"});
+    g_assert_nonnull (value);
+    g_assert_cmpint (value->get<int64_t>(), ==, 42);
+    value = slots->get_slot ({"nested", "kept"});
+    g_assert_nonnull (value);
+    g_assert_cmpint (value->get<int64_t>(), ==, 1);
+    value = slots->get_slot ({"nested", "changed"});
+    g_assert_nonnull (value);
+    g_assert_cmpint (value->get<int64_t>(), ==, 20);
+    g_assert_null (slots->get_slot ({"nested", "removed"}));
+    compare_books (qof_session_get_book (session_3),
+                   qof_session_get_book (session_4));
+
+    qof_session_destroy (session_3);
+    qof_session_end (session_4);
+    qof_session_destroy (session_4);
+}
+
+/** Test loading only recent transactions: the balances must be those of the
+ * whole history, before and after loading the older transactions.
+ */
+static void
+test_dbi_windowed_load (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto book = qof_session_get_book (fixture->session);
+    auto root = gnc_book_get_root_account (book);
+    auto acct1 = gnc_account_lookup_by_name (root, "Bank 1");
+    auto acct2 = gnc_account_lookup_by_name (root, "Expense 1");
+    auto guid1 = *qof_instance_get_guid (QOF_INSTANCE (acct1));
+    auto guid2 = *qof_instance_get_guid (QOF_INSTANCE (acct2));
+    auto balance = xaccAccountGetBalance (acct1);
+    auto reconciled = xaccAccountGetReconciledBalance (acct1);
+    // Inside the six month window but before its first split, and a year
+    // before the window.
+    auto now = gnc_time (nullptr);
+    auto in_window = now - 160 * 86400;
+    auto before_window = now - 18 * 31 * 86400;
+    auto balance_in_window = xaccAccountGetBalanceAsOfDate (acct1, in_window);
+    auto balance_before_window = xaccAccountGetBalanceAsOfDate (acct1,
+                                                                before_window);
+
+    auto book2{qof_book_new()};
+    auto session_2 = qof_session_new (book2);
+    qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_book_mark_session_dirty (qof_session_get_book (session_2));
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+
+    g_setenv ("GNC_SQL_LOAD_MONTHS", "6", TRUE);
+    auto book3{qof_book_new()};
+    auto session_3 = qof_session_new (book3);
+    qof_session_begin (session_3, url, SESSION_READ_ONLY);
+    g_unsetenv ("GNC_SQL_LOAD_MONTHS");
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+
+    book3 = qof_session_get_book (session_3);
+    acct1 = xaccAccountLookup (&guid1, book3);
+    acct2 = xaccAccountLookup (&guid2, book3);
+    g_assert_nonnull (acct1);
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct1), <, 24);
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalance (acct1), balance));
+    g_assert_true (gnc_numeric_equal (xaccAccountGetReconciledBalance (acct1),
+                                      reconciled));
+
+    // Without a loaded split before the date the starting balance is the
+    // answer; before the window the older splits are loaded first.
+    auto loaded = xaccAccountGetSplitsSize (acct1);
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acct1, in_window),
+                                      balance_in_window));
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct1), ==, loaded);
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acct1,
+                                                                     before_window),
+                                      balance_before_window));
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct1), >, loaded);
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct1), <, 24);
+
+    gnc_account_ensure_loaded (acct1, INT64_MIN);
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct1), ==, 24);
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct2), ==, 24);
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalance (acct1), balance));
+    g_assert_true (gnc_numeric_equal (xaccAccountGetReconciledBalance (acct1),
+                                      reconciled));
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalance (acct2),
+                                      gnc_numeric_neg (balance)));
+
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+
+    // A query on splits sees the whole history without asking for it.
+    g_setenv ("GNC_SQL_LOAD_MONTHS", "6", TRUE);
+    auto session_4 = qof_session_new (qof_book_new());
+    qof_session_begin (session_4, url, SESSION_READ_ONLY);
+    g_unsetenv ("GNC_SQL_LOAD_MONTHS");
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_4, NULL);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+
+    auto book4 = qof_session_get_book (session_4);
+    acct2 = xaccAccountLookup (&guid2, book4);
+    g_assert_nonnull (acct2);
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct2), <, 24);
+
+    // A query from a date loads back to that date only.
+    auto dated = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (dated, book4);
+    xaccQueryAddSingleAccountMatch (dated, acct2, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (dated, TRUE, before_window, FALSE, 0, QOF_QUERY_AND);
+    auto n_dated = g_list_length (qof_query_run (dated));
+    g_assert_cmpuint (n_dated, <, 24);
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct2), ==, n_dated);
+    qof_query_destroy (dated);
+
+    auto query = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (query, book4);
+    xaccQueryAddSingleAccountMatch (query, acct2, QOF_QUERY_AND);
+    g_assert_cmpuint (g_list_length (qof_query_run (query)), ==, 24);
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct2), ==, 24);
+    qof_query_destroy (query);
+
+    qof_session_end (session_4);
+    qof_session_destroy (session_4);
+}
+
 /** Test the safe_save mechanism.  Beware that this test used on its
  * own doesn't ensure that the resave is done safely, only that the
  * database is intact and unchanged after the save. To observe the
@@ -665,6 +1006,12 @@ create_dbi_test_suite (const char* dbm_name, const char* url)
                   test_dbi_version_control, teardown);
     GNC_TEST_ADD (subsuite, "business_store_and_reload", Fixture, url,
                   setup_business, test_dbi_business_store_and_reload, teardown);
+    GNC_TEST_ADD (subsuite, "windowed_load", Fixture, url, setup_dated,
+                  test_dbi_windowed_load, teardown);
+    GNC_TEST_ADD (subsuite, "batched_insert", Fixture, url, setup,
+                  test_dbi_batched_insert, teardown);
+    GNC_TEST_ADD (subsuite, "slots_diff_save", Fixture, url, setup_memory,
+                  test_dbi_slots_diff_save, teardown);
     g_free (subsuite);
 
 }
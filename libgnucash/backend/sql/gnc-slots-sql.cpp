@@ -40,6 +40,8 @@
 #include <string>
 #include <sstream>
 #include <cstdint>
+#include <optional>
+#include <vector>
 
 #include "gnc-sql-connection.hpp"
 #include "gnc-sql-backend.hpp"
@@ -73,6 +75,8 @@ struct slot_info_t
     KvpValue* pKvpValue;
     std::string path;
     std::string parent_path;
+    /* Where to record the rows loaded or saved, if anywhere. */
+    GncSqlSlotSnapshot* snapshot = nullptr;
 };
 
 
@@ -179,9 +183,85 @@ static const EntryVec gdate_col_table
 };
 
 GncSqlSlotsBackend::GncSqlSlotsBackend() :
-    GncSqlObjectBackend(TABLE_VERSION, GNC_ID_ACCOUNT,
+    GncSqlObjectBackend(TABLE_VERSION, TABLE_NAME,
                         TABLE_NAME, col_table) {}
 
+GncSqlSlotSnapshot&
+GncSqlSlotsBackend::snapshot (const GncGUID* guid)
+{
+    return m_snapshots[gnc::GUID{*guid}.to_string()];
+}
+
+GncSqlSlotSnapshot*
+GncSqlSlotsBackend::find_snapshot (const GncGUID* guid)
+{
+    auto snapshot = m_snapshots.find (gnc::GUID{*guid}.to_string());
+    return snapshot == m_snapshots.end() ? nullptr : &snapshot->second;
+}
+
+void
+GncSqlSlotsBackend::forget (const GncGUID* guid)
+{
+    m_snapshots.erase (gnc::GUID{*guid}.to_string());
+}
+
+static GncSqlSlotsBackend*
+get_slots_backend (const GncSqlBackend* sql_be)
+{
+    auto obe = sql_be->get_object_backend (TABLE_NAME);
+    return dynamic_cast<GncSqlSlotsBackend*>(obe.get());
+}
+
+void
+gnc_sql_slots_forget_snapshots (GncSqlBackend* sql_be)
+{
+    g_return_if_fail (sql_be != NULL);
+    auto slots_be = get_slots_backend (sql_be);
+    if (slots_be)
+        slots_be->forget_all();
+}
+
+/* KvpValue's compare treats numerics of equal value as equal, but a changed
+ * denominator still has to be written, so those are compared exactly.
+ */
+static bool
+slot_value_unchanged (const KvpValue& saved, const KvpValue& value)
+{
+    auto type = saved.get_type();
+    if (type != value.get_type())
+        return false;
+    if (type == KvpValue::Type::NUMERIC)
+    {
+        auto a = saved.get<gnc_numeric>(), b = value.get<gnc_numeric>();
+        return a.num == b.num && a.denom == b.denom;
+    }
+    if (type == KvpValue::Type::GLIST)
+    {
+        auto a = saved.get<GList*>(), b = value.get<GList*>();
+        for (; a && b; a = a->next, b = b->next)
+            if (!slot_value_unchanged (*static_cast<KvpValue*>(a->data),
+                                       *static_cast<KvpValue*>(b->data)))
+                return false;
+        return a == b;
+    }
+    return compare (saved, value) == 0;
+}
+
+static void
+record_slot (slot_info_t* pInfo, KvpValue::Type type, const KvpValue* value,
+             const GncGUID* child)
+{
+    if (pInfo->snapshot == nullptr || pInfo->guid == nullptr ||
+        pInfo->context == LIST)
+        return;
+    GncSqlSlotRecord record{type, nullptr, *pInfo->guid, *guid_null()};
+    if (type != KvpValue::Type::FRAME && value)
+        record.value = std::make_shared<const KvpValue> (*value);
+    if (child)
+        record.child = *child;
+    (*pInfo->snapshot)[pInfo->path] = record;
+}
+
 /* ================================================================= */
 
 static std::string
@@ -200,6 +280,8 @@ set_slot_from_value (slot_info_t* pInfo, KvpValue* pValue)
     g_return_if_fail (pInfo != NULL);
     g_return_if_fail (pValue != NULL);
 
+    record_slot (pInfo, pValue->get_type(), pValue, nullptr);
+
     switch (pInfo->context)
     {
     case FRAME:
@@ -436,14 +518,17 @@ set_guid_val (gpointer pObject,  gpointer pValue)
     }
     case KvpValue::Type::GLIST:
     {
-        slot_info_t* newInfo = slot_info_copy (pInfo, (GncGUID*)pValue);
+        auto child = static_cast<GncGUID*>(pValue);
+        slot_info_t* newInfo = slot_info_copy (pInfo, child);
         KvpValue* pValue = NULL;
         auto key = get_key (pInfo);
 
         newInfo->context = LIST;
+        newInfo->snapshot = nullptr;
 
         slots_load_info (newInfo);
         pValue = new KvpValue {newInfo->pList};
+        record_slot (pInfo, KvpValue::Type::GLIST, pValue, child);
         pInfo->pKvpFrame->set ({key.c_str()}, pValue);
 	delete newInfo;
         break;
@@ -460,6 +545,7 @@ set_guid_val (gpointer pObject,  gpointer pValue)
         {
             auto value = new KvpValue {newFrame};
             newInfo->path = get_key (pInfo);
+            newInfo->snapshot = nullptr;
             pInfo->pList = g_list_append (pInfo->pList, value);
             break;
         }
@@ -467,6 +553,8 @@ set_guid_val (gpointer pObject,  gpointer pValue)
         default:
         {
             auto key = get_key (pInfo);
+            record_slot (pInfo, KvpValue::Type::FRAME, nullptr,
+                         static_cast<GncGUID*>(pValue));
             pInfo->pKvpFrame->set ({key.c_str()}, new KvpValue {newFrame});
             break;
         }
@@ -554,6 +642,7 @@ slot_info_copy (slot_info_t* pInfo, GncGUID* guid)
     newSlot->pList = pInfo->pList;
     newSlot->context = pInfo->context;
     newSlot->pKvpValue = pInfo->pKvpValue;
+    newSlot->snapshot = pInfo->snapshot;
     if (!pInfo->path.empty())
         newSlot->parent_path = pInfo->path + "/";
     else
@@ -590,6 +679,7 @@ save_slot (const char* key, KvpValue* value, slot_info_t & slot_info)
                                                             &slot_info,
                                                             col_table);
         g_return_if_fail (slot_info.is_ok);
+        record_slot (&slot_info, KvpValue::Type::FRAME, nullptr, guid);
         pKvpFrame->for_each_slot_temp (save_slot, *pNewInfo);
         delete slot_info.pKvpValue;
         slot_info.pKvpValue = oldValue;
@@ -608,6 +698,8 @@ save_slot (const char* key, KvpValue* value, slot_info_t & slot_info)
                                                             &slot_info,
                                                             col_table);
         g_return_if_fail (slot_info.is_ok);
+        record_slot (&slot_info, KvpValue::Type::GLIST, value, guid);
+        pNewInfo->snapshot = nullptr;
         for (auto cursor = value->get<GList*> (); cursor; cursor = cursor->next)
         {
             auto val = static_cast<KvpValue*> (cursor->data);
@@ -625,11 +717,101 @@ save_slot (const char* key, KvpValue* value, slot_info_t & slot_info)
                                                              TABLE_NAME,
                                                              &slot_info,
                                                              col_table);
+        if (slot_info.is_ok)
+            record_slot (&slot_info, slot_info.value_type, value, nullptr);
     }
     break;
     }
 }
 
+/* Delete the row for path, and the rows of its contents if it's a frame or
+ * list, and forget about them.
+ */
+static bool
+delete_slot_row (GncSqlBackend* sql_be, GncSqlSlotSnapshot& snapshot,
+                 const std::string& path)
+{
+    auto record = snapshot.find (path);
+    if (record == snapshot.end())
+        return true;
+    auto type = record->second.type;
+    if ((type == KvpValue::Type::FRAME || type == KvpValue::Type::GLIST) &&
+        !gnc_sql_slots_delete (sql_be, &record->second.child))
+        return false;
+
+    auto stmt = sql_be->create_statement_from_sql ("DELETE FROM " TABLE_NAME);
+    if (stmt == nullptr)
+        return false;
+    PairVec where{
+        {col_table[obj_guid_col]->name(),
+         sql_be->quote_string (gnc::GUID{record->second.owner}.to_string())},
+        {col_table[name_col]->name(), sql_be->quote_string (path)}};
+    stmt->add_where_cond (TABLE_NAME, where);
+    if (sql_be->execute_nonselect_statement (stmt) == -1)
+        return false;
+
+    auto prefix = path + "/";
+    snapshot.erase (record);
+    if (type == KvpValue::Type::FRAME)
+    {
+        auto first = snapshot.lower_bound (prefix);
+        auto last = first;
+        while (last != snapshot.end() && last->first.compare (0, prefix.size(), prefix) == 0)
+            ++last;
+        snapshot.erase (first, last);
+    }
+    return true;
+}
+
+static bool
+path_in_frame (const KvpFrame* frame, const std::string& path)
+{
+    Path keys;
+    std::string::size_type start = 0, end;
+    while ((end = path.find ('/', start)) != std::string::npos)
+    {
+        keys.emplace_back (path.substr (start, end - start));
+        start = end + 1;
+    }
+    keys.emplace_back (path.substr (start));
+    return frame->get_slot (keys) != nullptr;
+}
+
+/* Write the slots of frame that differ from those in slot_info's snapshot,
+ * which must hold the rows stored under slot_info.guid.
+ */
+static void
+save_changed_slots (const char* key, KvpValue* value, slot_info_t& slot_info)
+{
+    if (!slot_info.is_ok)
+        return;
+
+    auto& snapshot = *slot_info.snapshot;
+    auto path = slot_info.parent_path + key;
+    auto type = value->get_type();
+    auto record = snapshot.find (path);
+    if (record != snapshot.end() && record->second.type == type)
+    {
+        if (type == KvpValue::Type::FRAME)
+        {
+            slot_info_t frame_info{slot_info};
+            frame_info.guid = &record->second.child;
+            frame_info.parent_path = path + "/";
+            value->get<KvpFrame*>()->for_each_slot_temp (save_changed_slots,
+                                                         frame_info);
+            slot_info.is_ok = frame_info.is_ok;
+            return;
+        }
+        if (record->second.value &&
+            slot_value_unchanged (*record->second.value, *value))
+            return;
+    }
+    if (record != snapshot.end())
+        slot_info.is_ok = delete_slot_row (slot_info.be, snapshot, path);
+    if (slot_info.is_ok)
+        save_slot (key, value, slot_info);
+}
+
 gboolean
 gnc_sql_slots_save (GncSqlBackend* sql_be, const GncGUID* guid, gboolean is_infant,
                     QofInstance* inst)
@@ -642,16 +824,43 @@ gnc_sql_slots_save (GncSqlBackend* sql_be, const GncGUID* guid, gboolean is_infa
     g_return_val_if_fail (guid != NULL, FALSE);
     g_return_val_if_fail (pFrame != NULL, FALSE);
 
-    // If this is not saving into a new db, clear out the old saved slots first
-    if (!sql_be->pristine() && !is_infant)
-    {
-        (void)gnc_sql_slots_delete (sql_be, guid);
-    }
-
     slot_info.be = sql_be;
     slot_info.guid = guid;
-    pFrame->for_each_slot_temp (save_slot, slot_info);
+    /* Saving a whole book into a new db doesn't need snapshots, every
+     * object is written once.
+     */
+    auto slots_be = sql_be->pristine() ? nullptr : get_slots_backend (sql_be);
+    auto snapshot = slots_be ? slots_be->find_snapshot (guid) : nullptr;
+    if (snapshot != nullptr && !is_infant)
+    {
+        std::vector<std::string> removed;
+        for (const auto& record : *snapshot)
+            if (!path_in_frame (pFrame, record.first))
+                removed.push_back (record.first);
+        for (const auto& path : removed)
+            if (slot_info.is_ok)
+                slot_info.is_ok = delete_slot_row (sql_be, *snapshot, path);
+
+        slot_info.snapshot = snapshot;
+        pFrame->for_each_slot_temp (save_changed_slots, slot_info);
+    }
+    else
+    {
+        /* Without a record of what's in the db the old saved slots must be
+         * cleared out first.
+         */
+        if (!sql_be->pristine() && !is_infant)
+            (void)gnc_sql_slots_delete (sql_be, guid);
+        if (slots_be)
+        {
+            slot_info.snapshot = &slots_be->snapshot (guid);
+            slot_info.snapshot->clear();
+        }
+        pFrame->for_each_slot_temp (save_slot, slot_info);
+    }
 
+    if (!slot_info.is_ok && slots_be)
+        slots_be->forget (guid);
     return slot_info.is_ok;
 }
 
@@ -692,12 +901,86 @@ gnc_sql_slots_delete (GncSqlBackend* sql_be, const GncGUID* guid)
     slot_info.is_ok = sql_be->do_db_operation(OP_DB_DELETE, TABLE_NAME,
                                               TABLE_NAME, &slot_info,
                                               obj_guid_col_table);
+    auto slots_be = get_slots_backend (sql_be);
+    if (slots_be)
+        slots_be->forget (guid);
 
     return slot_info.is_ok;
 }
 
+/* Positions of the slots table's columns in a result. Looking them up once
+ * lets decode_slot() read the common value types without searching every
+ * column by name for every row.
+ */
+struct SlotColumns
+{
+    explicit SlotColumns (GncSqlRow& row) noexcept :
+        obj_guid{row.col_index ("obj_guid")},
+        name{row.col_index ("name")},
+        slot_type{row.col_index ("slot_type")},
+        int64_val{row.col_index ("int64_val")},
+        string_val{row.col_index ("string_val")},
+        guid_val{row.col_index ("guid_val")},
+        numeric_num{row.col_index ("numeric_val_num")},
+        numeric_denom{row.col_index ("numeric_val_denom")} {}
+    bool valid () const noexcept
+    {
+        return obj_guid >= 0 && name >= 0 && slot_type >= 0 &&
+            int64_val >= 0 && string_val >= 0 && guid_val >= 0 &&
+            numeric_num >= 0 && numeric_denom >= 0;
+    }
+    int obj_guid, name, slot_type, int64_val, string_val, guid_val,
+        numeric_num, numeric_denom;
+};
+
 static void
-load_slot (slot_info_t* pInfo, GncSqlRow& row)
+decode_slot (slot_info_t* pInfo, GncSqlRow& row, const SlotColumns& cols)
+{
+    auto name = cols.valid () ? row.get_cstring_at_index (cols.name) : nullptr;
+    auto type = cols.valid () ? row.get_int_at_index (cols.slot_type) :
+        std::nullopt;
+    if (name == nullptr || !type)
+    {
+        gnc_sql_load_object (pInfo->be, row, TABLE_NAME, pInfo, col_table);
+        return;
+    }
+
+    set_path (pInfo, const_cast<char*>(name));
+    pInfo->value_type = static_cast<KvpValue::Type> (*type);
+    switch (pInfo->value_type)
+    {
+    case KvpValue::Type::INT64:
+        if (auto val = row.get_int_at_index (cols.int64_val))
+            set_int64_val (pInfo, *val);
+        break;
+    case KvpValue::Type::STRING:
+        set_string_val (pInfo, const_cast<char*>(
+                            row.get_cstring_at_index (cols.string_val)));
+        break;
+    case KvpValue::Type::NUMERIC:
+    {
+        auto num = row.get_int_at_index (cols.numeric_num);
+        auto denom = row.get_int_at_index (cols.numeric_denom);
+        if (num && denom)
+            set_numeric_val (pInfo, gnc_numeric_create (*num, *denom));
+        break;
+    }
+    case KvpValue::Type::GUID:
+    {
+        GncGUID guid;
+        if (gnc_sql_guid_at_index (row, cols.guid_val, &guid))
+            set_guid_val (pInfo, &guid);
+        break;
+    }
+    default:
+        // Frames, lists, dates and doubles need the column loaders.
+        gnc_sql_load_object (pInfo->be, row, TABLE_NAME, pInfo, col_table);
+        break;
+    }
+}
+
+static void
+load_slot (slot_info_t* pInfo, GncSqlRow& row, const SlotColumns& cols)
 {
     slot_info_t* slot_info;
 
@@ -707,7 +990,7 @@ load_slot (slot_info_t* pInfo, GncSqlRow& row)
 
     slot_info = slot_info_copy (pInfo, NULL);
 
-    gnc_sql_load_object (pInfo->be, row, TABLE_NAME, slot_info, col_table);
+    decode_slot (slot_info, row, cols);
 
     if (slot_info->pList != pInfo->pList)
     {
@@ -735,6 +1018,12 @@ gnc_sql_slots_load (GncSqlBackend* sql_be, QofInstance* inst)
     info.guid = qof_instance_get_guid (inst);
     info.pKvpFrame = qof_instance_get_slots (inst);
     info.context = NONE;
+    auto slots_be = get_slots_backend (sql_be);
+    if (slots_be)
+    {
+        info.snapshot = &slots_be->snapshot (info.guid);
+        info.snapshot->clear();
+    }
 
     slots_load_info (&info);
 }
@@ -754,8 +1043,13 @@ slots_load_info (slot_info_t* pInfo)
     if (stmt != nullptr)
     {
         auto result = pInfo->be->execute_select_statement (stmt);
+        std::optional<SlotColumns> cols;
         for (auto row : *result)
-            load_slot (pInfo, row);
+        {
+            if (!cols)
+                cols.emplace (row);
+            load_slot (pInfo, row, *cols);
+        }
         delete result;
     }
 }
@@ -772,28 +1066,52 @@ load_obj_guid (const GncSqlBackend* sql_be, GncSqlRow& row)
     return &guid;
 }
 
+/* The object whose slots were in the previous row. An object's rows usually
+ * come together, so this saves most of the lookups.
+ */
+struct SlotOwner
+{
+    GncGUID guid;
+    QofInstance* inst = nullptr;
+    GncSqlSlotSnapshot* snapshot = nullptr;
+};
+
 static void
 load_slot_for_book_object (GncSqlBackend* sql_be, GncSqlRow& row,
-                           BookLookupFn lookup_fn)
+                           BookLookupFn lookup_fn, GncSqlSlotsBackend* slots_be,
+                           const SlotColumns& cols, SlotOwner& owner)
 {
     slot_info_t slot_info = { NULL, NULL, TRUE, NULL, KvpValue::Type::INVALID,
                               NULL, FRAME, NULL, "" };
     const GncGUID* guid;
+    GncGUID row_guid;
     QofInstance* inst;
 
     g_return_if_fail (sql_be != NULL);
     g_return_if_fail (lookup_fn != NULL);
 
-    guid = load_obj_guid (sql_be, row);
+    if (cols.valid () && gnc_sql_guid_at_index (row, cols.obj_guid, &row_guid))
+        guid = &row_guid;
+    else
+        guid = load_obj_guid (sql_be, row);
     g_return_if_fail (guid != NULL);
-    inst = lookup_fn (guid, sql_be->book());
+    if (owner.inst == nullptr || !guid_equal (guid, &owner.guid))
+    {
+        owner.guid = *guid;
+        owner.inst = lookup_fn (guid, sql_be->book());
+        owner.snapshot = owner.inst && slots_be ?
+            &slots_be->snapshot (qof_instance_get_guid (owner.inst)) : nullptr;
+    }
+    inst = owner.inst;
     if (inst == NULL) return; /* Silently bail if the guid isn't loaded yet. */
 
     slot_info.be = sql_be;
+    slot_info.guid = qof_instance_get_guid (inst);
     slot_info.pKvpFrame = qof_instance_get_slots (inst);
     slot_info.path.clear();
+    slot_info.snapshot = owner.snapshot;
 
-    gnc_sql_load_object (sql_be, row, TABLE_NAME, &slot_info, col_table);
+    decode_slot (&slot_info, row, cols);
 }
 
 /**
@@ -825,9 +1143,17 @@ void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* sql_be,
         PERR ("stmt == NULL, SQL = '%s'\n", sql.c_str());
         return;
     }
+    auto slots_be = get_slots_backend (sql_be);
     auto result = sql_be->execute_select_statement(stmt);
+    std::optional<SlotColumns> cols;
+    SlotOwner owner;
     for (auto row : *result)
-        load_slot_for_book_object (sql_be, row, lookup_fn);
+    {
+        if (!cols)
+            cols.emplace (row);
+        load_slot_for_book_object (sql_be, row, lookup_fn, slots_be, *cols,
+                                   owner);
+    }
     delete result;
 }
 
@@ -840,6 +1166,8 @@ GncSqlSlotsBackend::create_tables (GncSqlBackend* sql_be)
 
     g_return_if_fail (sql_be != NULL);
 
+    /* Whatever we knew about the contents of another database is useless. */
+    forget_all();
     version = sql_be->get_table_version( TABLE_NAME);
     if (version == 0)
     {
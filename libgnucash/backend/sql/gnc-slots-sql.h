@@ -34,9 +34,37 @@
 #include "qof.h"
 #include "gnc-sql-object-backend.hpp"
 
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <kvp-value.hpp>
+
+/**
+ * A row of the slots table as it was last loaded or saved. Frames and lists
+ * keep the guid under which their contents are stored; leaves and lists keep a
+ * copy of their value to detect changes.
+ */
+struct GncSqlSlotRecord
+{
+    KvpValue::Type type;
+    std::shared_ptr<const KvpValue> value;
+    GncGUID owner;
+    GncGUID child;
+};
+
+/**
+ * The slot rows of one object, keyed by their full path. Members of lists
+ * aren't tracked, a changed list is rewritten as a whole.
+ */
+using GncSqlSlotSnapshot = std::map<std::string, GncSqlSlotRecord>;
+
 /**
  * Slots are neither loadable nor committable. Note that the default
  * write() implementation is also a no-op.
+ *
+ * The backend does keep a snapshot of each object's slots as loaded or last
+ * saved, so that gnc_sql_slots_save() need only write the ones that changed.
  */
 class GncSqlSlotsBackend : public GncSqlObjectBackend
 {
@@ -45,6 +73,15 @@ public:
     void load_all(GncSqlBackend*) override { return; }
     void create_tables(GncSqlBackend*) override;
     bool commit(GncSqlBackend*, QofInstance*) override { return false; }
+    /** The snapshot for guid, created empty if there isn't one. */
+    GncSqlSlotSnapshot& snapshot(const GncGUID* guid);
+    /** The snapshot for guid or nullptr if there isn't one. */
+    GncSqlSlotSnapshot* find_snapshot(const GncGUID* guid);
+    void forget(const GncGUID* guid);
+    /** Forget all snapshots, e.g. because the database may not match them. */
+    void forget_all() noexcept { m_snapshots.clear(); }
+private:
+    std::unordered_map<std::string, GncSqlSlotSnapshot> m_snapshots;
 };
 
 /**
@@ -90,6 +127,15 @@ void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* sql_be,
                                           const std::string subquery,
                                           BookLookupFn lookup_fn);
 
+/**
+ * gnc_sql_slots_forget_snapshots - Discard the record of which slots are in the
+ * database, e.g. because a database transaction that saved some was rolled
+ * back. Subsequent saves of an object's slots replace all of them once.
+ *
+ * @param sql_be SQL backend
+ */
+void gnc_sql_slots_forget_snapshots (GncSqlBackend* sql_be);
+
 void gnc_sql_init_slots_handler (void);
 
 #endif /* GNC_SLOTS_SQL_H */
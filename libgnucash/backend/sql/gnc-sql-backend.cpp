@@ -31,6 +31,10 @@
 #include <gncInvoice.h>
 #include <gnc-pricedb.h>
 #include <TransLog.h>
+#include <Transaction.h>
+#include <Split.h>
+#include <qofquery-p.h>
+#include <qofquerycore-p.h>
 
 #include <algorithm>
 #include <cassert>
@@ -67,6 +71,17 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define MAX_TABLE_NAME_LEN 50
 #define TABLE_COL_NAME "table_name"
 #define VERSION_COL_NAME "table_version"
+/* Rows per multi-row INSERT when saving to a new database. Can be overridden
+ * with the GNC_SQL_INSERT_BATCH_SIZE environment variable, up to
+ * MAX_INSERT_BATCH_SIZE; 1 disables batching.
+ */
+#define DEFAULT_INSERT_BATCH_SIZE 100
+#define MAX_INSERT_BATCH_SIZE 1000
+/* A batch is also written out before its statement would grow past this many
+ * bytes, well below SQLite's default SQLITE_MAX_SQL_LENGTH of 1000000 and
+ * MySQL's smallest max_allowed_packet.
+ */
+#define MAX_INSERT_BATCH_BYTES 500000
 
 using StrVec = std::vector<std::string>;
 
@@ -80,8 +95,15 @@ static EntryVec version_table
 
 GncSqlBackend::GncSqlBackend(GncSqlConnection *conn, QofBook* book) :
     QofBackend {}, m_conn{conn}, m_book{book}, m_loading{false},
-    m_in_query{false}, m_is_pristine_db{false}
+    m_in_query{false}, m_is_pristine_db{false},
+    m_insert_batch_size{DEFAULT_INSERT_BATCH_SIZE}
 {
+    auto batch_size = g_getenv ("GNC_SQL_INSERT_BATCH_SIZE");
+    if (batch_size != nullptr)
+        set_insert_batch_size (g_ascii_strtoull (batch_size, nullptr, 10));
+    auto load_months = g_getenv ("GNC_SQL_LOAD_MONTHS");
+    if (load_months != nullptr)
+        set_load_window (g_ascii_strtoull (load_months, nullptr, 10));
     if (conn != nullptr)
         connect (conn);
 }
@@ -94,6 +116,9 @@ GncSqlBackend::~GncSqlBackend()
 void
 GncSqlBackend::connect(GncSqlConnection *conn) noexcept
 {
+    /* Prepared statements belong to the connection they were created on. */
+    m_pending_inserts.clear();
+    clear_prepared_statements();
     if (m_conn != nullptr && m_conn != conn)
         delete m_conn;
     finalize_version_info();
@@ -114,6 +139,14 @@ GncSqlBackend::create_statement_from_sql(const std::string& str) const noexcept
 
 GncSqlResultPtr
 GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const noexcept
+{
+    /* Let the query see any rows still waiting in an insert batch. */
+    flush_inserts();
+    return select_statement (stmt);
+}
+
+GncSqlResultPtr
+GncSqlBackend::select_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
     auto result = m_conn ? m_conn->execute_select_statement(stmt) : nullptr;
     if (result == nullptr)
@@ -127,6 +160,7 @@ GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const no
 int
 GncSqlBackend::execute_nonselect_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
+    flush_inserts();
     int result = m_conn ? m_conn->execute_nonselect_statement(stmt) : -1;
     if (result == -1)
     {
@@ -296,6 +330,21 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
         assert (m_book == nullptr);
         m_book = book;
 
+        /* With a load window the transaction backend loads only the recent
+         * transactions and sets the accounts' starting balances from the
+         * older ones.
+         */
+        m_loaded_since.clear();
+        m_load_cutoff = INT64_MIN;
+        if (m_load_window > 0)
+        {
+            GDate date;
+            g_date_clear (&date, 1);
+            gnc_gdate_set_today (&date);
+            g_date_subtract_months (&date, m_load_window);
+            m_load_cutoff = gdate_to_time64 (date);
+        }
+
         auto num_types = m_backend_registry.size();
         auto num_done = 0;
 
@@ -330,6 +379,12 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
         gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
                                        nullptr);
     }
+    else if (loadType == LOAD_TYPE_LOAD_ALL && !fully_loaded())
+    {
+        // Load the transactions left out of the initial load
+        ensure_loaded (QOF_INSTANCE (gnc_book_get_root_account (book)),
+                       INT64_MIN);
+    }
     else if (loadType == LOAD_TYPE_LOAD_ALL)
     {
         // Load all transactions
@@ -478,6 +533,11 @@ GncSqlBackend::sync(QofBook* book)
     g_return_if_fail (m_conn != nullptr);
 
     reset_version_info();
+    /* A safe-save renames the tables out from under any prepared statements. */
+    m_pending_inserts.clear();
+    m_batch_inserts = false;
+    m_insert_failed = false;
+    clear_prepared_statements();
     ENTER ("book=%p, sql_be->book=%p", book, m_book);
     update_progress(101.0);
 
@@ -488,6 +548,7 @@ GncSqlBackend::sync(QofBook* book)
     /* Save all contents */
     m_book = book;
     auto is_ok = m_conn->begin_transaction();
+    m_batch_inserts = m_insert_batch_size > 1;
 
     // FIXME: should write the set of commodities that are used
     // write_commodities(sql_be, book);
@@ -518,6 +579,11 @@ GncSqlBackend::sync(QofBook* book)
             std::get<1>(entry)->write (this);
     }
     if (is_ok)
+    {
+        is_ok = flush_inserts() && !m_insert_failed;
+    }
+    m_batch_inserts = false;
+    if (is_ok)
     {
         is_ok = m_conn->commit_transaction();
     }
@@ -532,6 +598,7 @@ GncSqlBackend::sync(QofBook* book)
     }
     else
     {
+        m_pending_inserts.clear();
         set_error (ERR_BACKEND_SERVER_ERR);
         m_conn->rollback_transaction ();
     }
@@ -560,6 +627,133 @@ GncSqlBackend::rollback(QofInstance* inst)
     //LEAVE ("");
 }
 
+time64
+GncSqlBackend::loaded_since(const Account* acct) const noexcept
+{
+    if (acct == nullptr || fully_loaded())
+        return m_load_cutoff;
+    auto since = m_loaded_since.find(acct);
+    if (since == m_loaded_since.end())
+        return m_load_cutoff;
+    return std::min(since->second, m_load_cutoff);
+}
+
+void
+GncSqlBackend::ensure_loaded(QofInstance* inst, time64 since)
+{
+    g_return_if_fail (GNC_IS_ACCOUNT (inst));
+
+    if (m_conn == nullptr || m_book == nullptr)
+        return;
+    auto acct = GNC_ACCOUNT (inst);
+    if (gnc_account_get_parent (acct) == nullptr)
+        acct = nullptr;
+    auto until = loaded_since (acct);
+    if (since >= until)
+        return;
+
+    ENTER ("acct=%p since=%" G_GINT64_FORMAT " until=%" G_GINT64_FORMAT,
+           acct, since, until);
+    auto loading = m_loading;
+    m_loading = TRUE;
+    gnc_sql_transaction_load_tx_for_range (this, acct, since, until);
+    m_loading = loading;
+
+    if (acct != nullptr)
+    {
+        m_loaded_since[acct] = since;
+    }
+    else
+    {
+        m_load_cutoff = since;
+        if (fully_loaded())
+            m_loaded_since.clear();
+    }
+    LEAVE ("");
+}
+
+static bool
+param_path_is (const QofQueryParamList* path, const char* first,
+               const char* second)
+{
+    return path && path->next && !path->next->next &&
+        g_strcmp0 (static_cast<const char*>(path->data), first) == 0 &&
+        g_strcmp0 (static_cast<const char*>(path->next->data), second) == 0;
+}
+
+/* What one AND-term list of a split query can match: splits in transactions
+ * posted on or after since, in accounts, or in any account if it is empty.
+ * Terms that don't bound either are passed over, which only widens the range.
+ */
+struct SplitQueryRange
+{
+    time64 since = INT64_MIN;
+    std::vector<Account*> accounts;
+};
+
+static SplitQueryRange
+split_query_range (QofBook* book, const GList* and_terms)
+{
+    SplitQueryRange range;
+    for (auto node = and_terms; node != nullptr; node = node->next)
+    {
+        auto term = static_cast<const QofQueryTerm*>(node->data);
+        if (qof_query_term_is_inverted (term))
+            continue;
+        auto path = qof_query_term_get_param_path (term);
+        auto pdata = qof_query_term_get_pred_data (term);
+        time64 date;
+        if (param_path_is (path, SPLIT_TRANS, TRANS_DATE_POSTED) &&
+            (pdata->how == QOF_COMPARE_GT || pdata->how == QOF_COMPARE_GTE ||
+             pdata->how == QOF_COMPARE_EQUAL) &&
+            qof_query_date_predicate_get_date (pdata, &date))
+        {
+            if (reinterpret_cast<query_date_t>(pdata)->options == QOF_DATE_MATCH_DAY)
+                date = gnc_time64_get_day_start (date);
+            range.since = std::max (range.since, date);
+        }
+        else if (range.accounts.empty() &&
+                 param_path_is (path, SPLIT_ACCOUNT, QOF_PARAM_GUID) &&
+                 g_strcmp0 (pdata->type_name, QOF_TYPE_GUID) == 0 &&
+                 reinterpret_cast<query_guid_t>(pdata)->options == QOF_GUID_MATCH_ANY)
+        {
+            for (auto guid = reinterpret_cast<query_guid_t>(pdata)->guids;
+                 guid != nullptr; guid = guid->next)
+                if (auto acct = xaccAccountLookup (static_cast<GncGUID*>(guid->data), book))
+                    range.accounts.push_back (acct);
+        }
+    }
+    return range;
+}
+
+void
+GncSqlBackend::prepare_query(QofQuery* query)
+{
+    if (fully_loaded() || m_loading || m_book == nullptr)
+        return;
+    auto root = QOF_INSTANCE (gnc_book_get_root_account (m_book));
+    auto search_for = qof_query_get_search_for (query);
+    if (g_strcmp0 (search_for, GNC_ID_TRANS) == 0 ||
+        g_strcmp0 (search_for, GNC_ID_LOT) == 0)
+        ensure_loaded (root, INT64_MIN);
+    if (g_strcmp0 (search_for, GNC_ID_SPLIT) != 0)
+        return;
+
+    /* Without terms the query matches every split. */
+    auto or_terms = qof_query_get_terms (query);
+    if (or_terms == nullptr)
+        ensure_loaded (root, INT64_MIN);
+    for (auto node = or_terms; node != nullptr; node = node->next)
+    {
+        auto range = split_query_range (m_book,
+                                        static_cast<const GList*>(node->data));
+        if (range.accounts.empty())
+            ensure_loaded (root, range.since);
+        for (auto acct : range.accounts)
+            ensure_loaded (QOF_INSTANCE (acct), range.since);
+    }
+}
+
 void
 GncSqlBackend::commodity_for_postload_processing(gnc_commodity* commodity)
 {
@@ -651,6 +845,8 @@ GncSqlBackend::commit (QofInstance* inst)
     {
         // Error - roll it back
         (void)m_conn->rollback_transaction();
+        // The slots recorded as saved were rolled back too
+        gnc_sql_slots_forget_snapshots (this);
 
         // This *should* leave things marked dirty
         LEAVE ("Rolled back - database error");
@@ -796,6 +992,7 @@ GncSqlBackend::upgrade_table (const std::string& table_name,
                               const EntryVec& col_table) noexcept
 {
     DEBUG ("Upgrading %s table\n", table_name.c_str());
+    clear_prepared_statements();
 
     auto temp_table_name = table_name + "_new";
     create_table (temp_table_name, col_table);
@@ -849,38 +1046,229 @@ GncSqlBackend::object_in_db (const char* table_name, QofIdTypeConst obj_name,
     /* We want only the first item in the table, which should be the PK. */
     values.resize(1);
     stmt->add_where_cond(obj_name, values);
-    auto result = execute_select_statement (stmt);
+    /* Only the batch for this table can affect the answer, so leave the
+     * others to fill up.
+     */
+    flush_inserts(table_name);
+    auto result = select_statement (stmt);
     return (result != nullptr && result->size() > 0);
 }
 
+static inline ParamVec
+get_object_params (QofIdTypeConst obj_name,
+                   gpointer pObject, const EntryVec& table)
+{
+    ParamVec vec;
+
+    for (auto const& table_row : table)
+    {
+        if (!(table_row->is_autoincr()))
+        {
+            table_row->add_to_params (obj_name, pObject, vec);
+        }
+    }
+    return vec;
+}
+
 bool
 GncSqlBackend::do_db_operation (E_DB_OPERATION op, const char* table_name,
                                 QofIdTypeConst obj_name, gpointer pObject,
                                 const EntryVec& table) const noexcept
 {
-    GncSqlStatementPtr stmt;
+    ParamVec values;
 
     g_return_val_if_fail (table_name != nullptr, false);
     g_return_val_if_fail (obj_name != nullptr, false);
     g_return_val_if_fail (pObject != nullptr, false);
 
+    if (op == OP_DB_DELETE)
+    {
+        table[0]->add_to_params (obj_name, pObject, values);
+        values.resize (std::min<size_t>(values.size(), 1));
+    }
+    else
+        values = get_object_params (obj_name, pObject, table);
+    if (values.empty())
+        return false;
+    if (op == OP_DB_INSERT && m_batch_inserts)
+        return queue_insert (table_name, values);
+    flush_inserts();
+
+    std::string sql;
     switch(op)
     {
         case  OP_DB_INSERT:
-        stmt = build_insert_statement (table_name, obj_name, pObject, table);
+        sql = build_insert_sql (table_name, values);
         break;
         case OP_DB_UPDATE:
-        stmt = build_update_statement (table_name, obj_name, pObject, table);
+        sql = build_update_sql (table_name, values);
         break;
         case OP_DB_DELETE:
-        stmt = build_delete_statement (table_name, obj_name, pObject, table);
+        sql = build_delete_sql (table_name, values);
         break;
     }
+    auto& stmt = prepared_statement (sql);
     if (stmt == nullptr)
         return false;
+
+    unsigned int index = 0;
+    stmt->clear_bindings();
+    for (const auto& col_value : values)
+        stmt->bind (index++, col_value.second);
+    /* The where condition of an update is the guid, i.e. the first column. */
+    if (op == OP_DB_UPDATE)
+        stmt->bind (index, values[0].second);
     return (execute_nonselect_statement(stmt) != -1);
 }
 
+const GncSqlStatementPtr&
+GncSqlBackend::prepared_statement (const std::string& sql) const noexcept
+{
+    auto& stmt = m_prepared_stmts[sql];
+    if (stmt == nullptr)
+    {
+        stmt = m_conn ? m_conn->prepare_statement (sql) : nullptr;
+        if (stmt == nullptr)
+        {
+            PERR ("SQL error: %s\n", sql.c_str());
+            qof_backend_set_error ((QofBackend*)this, ERR_BACKEND_SERVER_ERR);
+        }
+    }
+    return stmt;
+}
+
+void
+GncSqlBackend::clear_prepared_statements () noexcept
+{
+    m_prepared_stmts.clear();
+}
+
+void
+GncSqlBackend::set_insert_batch_size (unsigned int rows) noexcept
+{
+    flush_inserts();
+    m_insert_batch_size = std::clamp<unsigned int> (rows, 1, MAX_INSERT_BATCH_SIZE);
+}
+
+/* An upper bound for the bytes a value adds to the SQL once bound: strings may
+ * have every character escaped, numbers need at most 25 characters.
+ */
+static size_t
+param_sql_length (const GncSqlParam& param)
+{
+    if (std::holds_alternative<std::string>(param))
+        return 2 * std::get<std::string>(param).size() + 3;
+    return 25;
+}
+
+/* Rows for the same table are kept in one batch so that they reach the
+ * database in the order they were written; the slots table depends on that for
+ * the order of list values. A row with a different set of columns than the
+ * pending ones therefore pushes those out first.
+ */
+bool
+GncSqlBackend::queue_insert (const char* table_name,
+                             const ParamVec& values) const noexcept
+{
+    std::string columns;
+    for (auto const& col_value : values)
+    {
+        if (!columns.empty())
+            columns += ",";
+        columns += col_value.first;
+    }
+    size_t row_bytes = 3;
+    for (auto const& col_value : values)
+        row_bytes += param_sql_length (col_value.second);
+    auto batch = std::find_if (m_pending_inserts.begin(), m_pending_inserts.end(),
+                               [table_name](const InsertBatch& b) {
+                                   return b.table == table_name; });
+    if (batch == m_pending_inserts.end())
+        batch = m_pending_inserts.insert (m_pending_inserts.end(),
+                                          InsertBatch{table_name, columns, 0, {}});
+    else if (batch->columns != columns)
+    {
+        if (!flush_batch (*batch))
+            return false;
+        batch->columns = columns;
+    }
+    else if (batch->bytes + row_bytes > MAX_INSERT_BATCH_BYTES &&
+             !flush_batch (*batch))
+        return false;
+
+    for (auto const& col_value : values)
+        batch->params.emplace_back (col_value.second);
+    batch->bytes += row_bytes;
+    if (++batch->rows < m_insert_batch_size)
+        return true;
+    return flush_batch (*batch);
+}
+
+/* The INSERT of rows rows of n_cols values each. */
+static std::string
+build_batch_sql (const std::string& table, const std::string& columns,
+                 size_t n_cols, unsigned int rows)
+{
+    std::string row{"("};
+    for (size_t col = 0; col < n_cols; ++col)
+        row += col == 0 ? "?" : ",?";
+    row += ")";
+    std::ostringstream sql;
+    sql << "INSERT INTO " << table << "(" << columns << ") VALUES";
+    for (unsigned int i = 0; i < rows; ++i)
+        sql << (i == 0 ? "" : ",") << row;
+    return sql.str();
+}
+
+/* Only a full batch and a single row get a prepared statement, so a table has
+ * at most two; on PostgreSQL each is a server-side PREPARE. A short batch, cut
+ * off by a change of columns, the byte limit or the end of the save, is
+ * written a row at a time rather than preparing a statement for its length.
+ */
+bool
+GncSqlBackend::flush_batch (InsertBatch& batch) const noexcept
+{
+    if (batch.rows == 0)
+        return true;
+
+    auto n_cols = batch.params.size() / batch.rows;
+    auto stmt_rows = batch.rows == m_insert_batch_size ? batch.rows : 1u;
+    auto& stmt = prepared_statement (build_batch_sql (batch.table, batch.columns,
+                                                      n_cols, stmt_rows));
+    auto is_ok = stmt != nullptr;
+    auto param = batch.params.cbegin();
+    while (is_ok && param != batch.params.cend())
+    {
+        stmt->clear_bindings();
+        for (unsigned int index = 0; index < stmt_rows * n_cols; ++index)
+            stmt->bind (index, *param++);
+        if (m_conn->execute_nonselect_statement (stmt) == -1)
+        {
+            PERR ("SQL error: %s\n", stmt->to_sql());
+            qof_backend_set_error ((QofBackend*)this, ERR_BACKEND_SERVER_ERR);
+            is_ok = false;
+        }
+    }
+    if (!is_ok)
+        m_insert_failed = true;
+    batch.params.clear();
+    batch.rows = 0;
+    batch.bytes = 0;
+    return is_ok;
+}
+
+bool
+GncSqlBackend::flush_inserts (const char* table_name) const noexcept
+{
+    auto is_ok = true;
+    for (auto& batch : m_pending_inserts)
+    {
+        if (table_name == nullptr || batch.table == table_name)
+            is_ok = flush_batch (batch) && is_ok;
+    }
+    return is_ok;
+}
+
 bool
 GncSqlBackend::save_commodity(gnc_commodity* comm) noexcept
 {
@@ -892,21 +1280,12 @@ GncSqlBackend::save_commodity(gnc_commodity* comm) noexcept
     return true;
 }
 
-GncSqlStatementPtr
-GncSqlBackend::build_insert_statement (const char* table_name,
-                                       QofIdTypeConst obj_name,
-                                       gpointer pObject,
-                                       const EntryVec& table) const noexcept
+std::string
+GncSqlBackend::build_insert_sql (const char* table_name,
+                                 const ParamVec& values) const noexcept
 {
-    GncSqlStatementPtr stmt;
-    PairVec col_values;
     std::ostringstream sql;
 
-    g_return_val_if_fail (table_name != nullptr, nullptr);
-    g_return_val_if_fail (obj_name != nullptr, nullptr);
-    g_return_val_if_fail (pObject != nullptr, nullptr);
-    PairVec values{get_object_values(obj_name, pObject, table)};
-
     sql << "INSERT INTO " << table_name <<"(";
     for (auto const& col_value : values)
     {
@@ -916,75 +1295,43 @@ GncSqlBackend::build_insert_statement (const char* table_name,
     }
 
     sql << ") VALUES(";
-    for (const auto& col_value : values)
-    {
-        if (col_value != *values.begin())
-            sql << ",";
-        sql << col_value.second;
-    }
+    for (auto col = values.begin(); col != values.end(); ++col)
+        sql << (col == values.begin() ? "?" : ",?");
     sql << ")";
 
-    stmt = create_statement_from_sql(sql.str());
-    return stmt;
+    return sql.str();
 }
 
-GncSqlStatementPtr
-GncSqlBackend::build_update_statement(const gchar* table_name,
-                                      QofIdTypeConst obj_name, gpointer pObject,
-                                      const EntryVec& table) const noexcept
+std::string
+GncSqlBackend::build_update_sql (const char* table_name,
+                                 const ParamVec& values) const noexcept
 {
-    GncSqlStatementPtr stmt;
     std::ostringstream sql;
 
-    g_return_val_if_fail (table_name != nullptr, nullptr);
-    g_return_val_if_fail (obj_name != nullptr, nullptr);
-    g_return_val_if_fail (pObject != nullptr, nullptr);
-
-
-    PairVec values{get_object_values (obj_name, pObject, table)};
-
-    // Create the SQL statement
     sql <<  "UPDATE " << table_name << " SET ";
 
     for (auto const& col_value : values)
     {
         if (col_value != *values.begin())
             sql << ",";
-        sql << col_value.first << "=" <<
-            col_value.second;
+        sql << col_value.first << "=?";
     }
 
-    stmt = create_statement_from_sql(sql.str());
     /* We want our where condition to be just the first column and
      * value, i.e. the guid of the object.
      */
-    values.erase(values.begin() + 1, values.end());
-    stmt->add_where_cond(obj_name, values);
-    return stmt;
+    sql << " WHERE " << values[0].first << "=?";
+    return sql.str();
 }
 
-GncSqlStatementPtr
-GncSqlBackend::build_delete_statement(const gchar* table_name,
-                                      QofIdTypeConst obj_name,
-                                      gpointer pObject,
-                                      const EntryVec& table) const noexcept
+std::string
+GncSqlBackend::build_delete_sql (const char* table_name,
+                                 const ParamVec& values) const noexcept
 {
     std::ostringstream sql;
 
-    g_return_val_if_fail (table_name != nullptr, nullptr);
-    g_return_val_if_fail (obj_name != nullptr, nullptr);
-    g_return_val_if_fail (pObject != nullptr, nullptr);
-
-    sql << "DELETE FROM " << table_name;
-    auto stmt = create_statement_from_sql (sql.str());
-
-    /* WHERE */
-    PairVec values;
-    table[0]->add_to_query (obj_name, pObject, values);
-    PairVec col_values{values[0]};
-    stmt->add_where_cond (obj_name, col_values);
-
-    return stmt;
+    sql << "DELETE FROM " << table_name << " WHERE " << values[0].first << "=?";
+    return sql.str();
 }
 
 GncSqlBackend::ObjectBackendRegistry::ObjectBackendRegistry()
@@ -30,9 +30,12 @@
 #include <memory>
 #include <exception>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 #include <qof-backend.hpp>
 
+#include "gnc-sql-connection.hpp"
+
 class GncSqlColumnTableEntry;
 using GncSqlColumnTableEntryPtr = std::shared_ptr<GncSqlColumnTableEntry>;
 using EntryVec = std::vector<GncSqlColumnTableEntryPtr>;
@@ -95,6 +98,23 @@ public:
      * @param inst Object being edited
      */
     void rollback(QofInstance*) override;
+    /**
+     * Load the transactions of an account posted since a date if they weren't
+     * loaded at startup because of the load window.
+     *
+     * @param inst The account, or the root account for all accounts
+     * @param since The earliest posted date needed
+     */
+    void ensure_loaded(QofInstance* inst, time64 since) override;
+    /**
+     * Load the transactions a query on splits could match before it runs:
+     * those posted since the earliest date it asks for, in the accounts it
+     * is limited to. A query on transactions or lots loads the rest of
+     * them.
+     *
+     * @param query The query about to run
+     */
+    void prepare_query(QofQuery* query) override;
     /** Connect the backend to a GncSqlConnection.
      * Sets up version info. Calling with nullptr clears the connection and
      * destroys the version info.
@@ -119,6 +139,12 @@ public:
      * @return Results, or nullptr if an error has occurred
      */
     GncSqlResultPtr execute_select_statement(const GncSqlStatementPtr& stmt) const noexcept;
+    /** Executes an SQL statement that doesn't return rows. Any batched inserts
+     * are written first.
+     *
+     * @param statement Statement
+     * @return Number of rows affected, or -1 if an error has occurred
+     */
     int execute_nonselect_statement(const GncSqlStatementPtr& stmt) const noexcept;
     std::string quote_string(const std::string&) const noexcept;
     /**
@@ -224,6 +250,48 @@ public:
     bool do_db_operation (E_DB_OPERATION op, const char* table_name,
                           QofIdTypeConst obj_name, gpointer pObject,
                           const EntryVec& table) const noexcept;
+    /**
+     * Discard the cached insert, update and delete statements. Must be called
+     * whenever the tables they refer to are replaced.
+     */
+    void clear_prepared_statements() noexcept;
+    /**
+     * Set the number of rows grouped into each multi-row INSERT while saving
+     * to a new database. 1 writes every row with its own statement; values
+     * over 1000 are clamped to 1000. A batch is also split when its SQL would
+     * get too long for the server.
+     *
+     * @param rows Rows per INSERT
+     */
+    void set_insert_batch_size(unsigned int rows) noexcept;
+    unsigned int insert_batch_size() const noexcept { return m_insert_batch_size; }
+    /**
+     * Write out the rows waiting in insert batches.
+     *
+     * @param table_name Only write the batch for this table, or all of them if
+     * nullptr.
+     * @return TRUE if successful, FALSE if not
+     */
+    bool flush_inserts(const char* table_name = nullptr) const noexcept;
+    /**
+     * Set how many months of transactions the initial load reads. Older ones
+     * are read on demand by ensure_loaded() and accounted for until then by
+     * the accounts' starting balances. 0 loads everything.
+     *
+     * @param months Months before today to load
+     */
+    void set_load_window(unsigned int months) noexcept { m_load_window = months; }
+    unsigned int load_window() const noexcept { return m_load_window; }
+    /**
+     * The posted date before which an account's transactions haven't been
+     * loaded.
+     *
+     * @param acct The account, or nullptr for the date before which no
+     * account's transactions have been loaded.
+     * @return The date, or INT64_MIN if all have been loaded.
+     */
+    time64 loaded_since(const Account* acct) const noexcept;
+    bool fully_loaded() const noexcept { return m_load_cutoff == INT64_MIN; }
     /**
      * Ensure that a commodity referenced in another object is in fact saved
      * in the database.
@@ -246,24 +314,41 @@ protected:
     bool m_is_pristine_db; /**< Are we saving to a new pristine db? */
     const char* m_time_format = nullptr; /**< Server-specific date-time string format */
     VersionVec m_versions;    /**< Version number for each table */
+    unsigned int m_insert_batch_size; /**< Rows per multi-row INSERT */
+    unsigned int m_load_window = 0; /**< Months of transactions loaded initially */
+    time64 m_load_cutoff = INT64_MIN; /**< Transactions posted before this aren't loaded */
+    /** Accounts whose transactions have been loaded from before m_load_cutoff */
+    std::unordered_map<const Account*, time64> m_loaded_since;
 private:
+    /** Rows queued for a multi-row INSERT into one table. */
+    struct InsertBatch
+    {
+        std::string table;
+        std::string columns;
+        unsigned int rows;
+        std::vector<GncSqlParam> params;
+        size_t bytes = 0; /**< Upper bound on the length of params as SQL */
+    };
     bool write_account_tree(Account*);
     bool write_accounts();
     bool write_transactions();
     bool write_template_transactions();
     bool write_schedXactions();
-    GncSqlStatementPtr build_insert_statement (const char* table_name,
-                                               QofIdTypeConst obj_name,
-                                               gpointer pObject,
-                                               const EntryVec& table) const noexcept;
-    GncSqlStatementPtr build_update_statement (const gchar* table_name,
-                                               QofIdTypeConst obj_name,
-                                               gpointer pObject,
-                                               const EntryVec& table) const noexcept;
-    GncSqlStatementPtr build_delete_statement (const char* table_name,
-                                               QofIdTypeConst obj_name,
-                                               gpointer pObject,
-                                               const EntryVec& table) const noexcept;
+    std::string build_insert_sql (const char* table_name,
+                                  const ParamVec& values) const noexcept;
+    std::string build_update_sql (const char* table_name,
+                                  const ParamVec& values) const noexcept;
+    std::string build_delete_sql (const char* table_name,
+                                  const ParamVec& values) const noexcept;
+    /**
+     * Get the cached prepared statement for sql, preparing it on first use.
+     * sql has a placeholder for each value so the same statement serves every
+     * object written to a table with the same set of columns.
+     */
+    const GncSqlStatementPtr& prepared_statement (const std::string& sql) const noexcept;
+    GncSqlResultPtr select_statement(const GncSqlStatementPtr& stmt) const noexcept;
+    bool queue_insert (const char* table_name, const ParamVec& values) const noexcept;
+    bool flush_batch (InsertBatch& batch) const noexcept;
 
     class ObjectBackendRegistry
     {
@@ -286,6 +371,11 @@ private:
     };
     ObjectBackendRegistry m_backend_registry;
     std::vector<gnc_commodity*> m_postload_commodities;
+    /** Insert, update and delete statements keyed by their SQL. */
+    mutable std::unordered_map<std::string, GncSqlStatementPtr> m_prepared_stmts;
+    mutable std::vector<InsertBatch> m_pending_inserts;
+    bool m_batch_inserts = false; /**< Queue inserts for multi-row INSERTs */
+    mutable bool m_insert_failed = false; /**< A batched insert has failed */
 };
 
 #endif //__GNC_SQL_BACKEND_HPP__
@@ -26,6 +26,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cstdint>
+#include <optional>
 #include <gnc-datetime.hpp>
 #include "gnc-sql-backend.hpp"
 #include "gnc-sql-object-backend.hpp"
@@ -113,6 +114,33 @@ GncSqlColumnTableEntry::add_objectref_guid_to_table (ColVec& vec) const noexcept
     vec.emplace_back(std::move(info));
 }
 
+GncSqlParam
+gnc_sql_param_from_literal (const std::string& literal)
+{
+    if (literal.empty() || literal == "NULL")
+        return std::monostate{};
+    if (literal.front() == '\'' && literal.size() > 1 && literal.back() == '\'')
+    {
+        std::string str;
+        str.reserve(literal.size());
+        for (auto c = literal.begin() + 1; c < literal.end() - 1; ++c)
+        {
+            if (*c == '\'' && *(c + 1) == '\'')
+                ++c;
+            str += *c;
+        }
+        return str;
+    }
+    char* end = nullptr;
+    auto ival = g_ascii_strtoll (literal.c_str(), &end, 10);
+    if (end && *end == '\0')
+        return static_cast<int64_t>(ival);
+    auto dval = g_ascii_strtod (literal.c_str(), &end);
+    if (end && *end == '\0')
+        return dval;
+    return literal;
+}
+
 
 /* ----------------------------------------------------------------- */
 template<> void
@@ -156,6 +184,22 @@ GncSqlColumnTableEntryImpl<CT_STRING>::add_to_query(QofIdTypeConst obj_name,
     }
 }
 
+template<> void
+GncSqlColumnTableEntryImpl<CT_STRING>::add_to_params(QofIdTypeConst obj_name,
+                                                     const gpointer pObject,
+                                                     ParamVec& vec) const noexcept
+{
+    auto s = get_row_value_from_object<char*>(obj_name, pObject);
+
+    if (s == nullptr)
+        return;
+    /* Match quote_string, which writes these as NULL. */
+    if (g_strcmp0 (s, "NULL") == 0 || g_strcmp0 (s, "null") == 0)
+        vec.emplace_back (std::string{m_col_name}, std::monostate{});
+    else
+        vec.emplace_back (std::string{m_col_name}, std::string{s});
+}
+
 /* ----------------------------------------------------------------- */
 typedef gint (*IntAccessFunc) (const gpointer);
 typedef void (*IntSetterFunc) (const gpointer, gint);
@@ -192,6 +236,15 @@ GncSqlColumnTableEntryImpl<CT_INT>::add_to_query(QofIdTypeConst obj_name,
     add_value_to_vec<int>(obj_name, pObject, vec);
 }
 
+template<> void
+GncSqlColumnTableEntryImpl<CT_INT>::add_to_params(QofIdTypeConst obj_name,
+                                                  const gpointer pObject,
+                                                  ParamVec& vec) const noexcept
+{
+    auto val = get_row_value_from_object<int>(obj_name, pObject);
+    vec.emplace_back (std::string{m_col_name}, static_cast<int64_t>(val));
+}
+
 /* ----------------------------------------------------------------- */
 typedef gboolean (*BooleanAccessFunc) (const gpointer);
 typedef void (*BooleanSetterFunc) (const gpointer, gboolean);
@@ -228,6 +281,15 @@ GncSqlColumnTableEntryImpl<CT_BOOLEAN>::add_to_query(QofIdTypeConst obj_name,
     add_value_to_vec<int>(obj_name, pObject, vec);
 }
 
+template<> void
+GncSqlColumnTableEntryImpl<CT_BOOLEAN>::add_to_params(QofIdTypeConst obj_name,
+                                                      const gpointer pObject,
+                                                      ParamVec& vec) const noexcept
+{
+    auto val = get_row_value_from_object<int>(obj_name, pObject);
+    vec.emplace_back (std::string{m_col_name}, static_cast<int64_t>(val));
+}
+
 /* ----------------------------------------------------------------- */
 typedef gint64 (*Int64AccessFunc) (const gpointer);
 typedef void (*Int64SetterFunc) (const gpointer, gint64);
@@ -282,6 +344,15 @@ GncSqlColumnTableEntryImpl<CT_INT64>::add_to_query(QofIdTypeConst obj_name,
 {
     add_value_to_vec<int64_t>(obj_name, pObject, vec);
 }
+
+template<> void
+GncSqlColumnTableEntryImpl<CT_INT64>::add_to_params(QofIdTypeConst obj_name,
+                                                    const gpointer pObject,
+                                                    ParamVec& vec) const noexcept
+{
+    auto val = get_row_value_from_object<int64_t>(obj_name, pObject);
+    vec.emplace_back (std::string{m_col_name}, val);
+}
 /* ----------------------------------------------------------------- */
 
 template<> void
@@ -320,6 +391,16 @@ GncSqlColumnTableEntryImpl<CT_DOUBLE>::add_to_query(QofIdTypeConst obj_name,
     add_value_to_vec<double*>(obj_name, pObject, vec);
 }
 
+template<> void
+GncSqlColumnTableEntryImpl<CT_DOUBLE>::add_to_params(QofIdTypeConst obj_name,
+                                                     const gpointer pObject,
+                                                     ParamVec& vec) const noexcept
+{
+    auto val = get_row_value_from_object<double*>(obj_name, pObject);
+    if (val != nullptr)
+        vec.emplace_back (std::string{m_col_name}, *val);
+}
+
 /* ----------------------------------------------------------------- */
 
 template<> void
@@ -362,6 +443,21 @@ GncSqlColumnTableEntryImpl<CT_GUID>::add_to_query(QofIdTypeConst obj_name,
         return;
     }
 }
+
+template<> void
+GncSqlColumnTableEntryImpl<CT_GUID>::add_to_params(QofIdTypeConst obj_name,
+                                                   const gpointer pObject,
+                                                   ParamVec& vec) const noexcept
+{
+    auto s = get_row_value_from_object<GncGUID*>(obj_name, pObject);
+
+    if (s != nullptr)
+    {
+        char guid_s[GUID_ENCODING_LENGTH + 1];
+        guid_to_string_buff (s, guid_s);
+        vec.emplace_back (std::string{m_col_name}, std::string{guid_s});
+    }
+}
 /* ----------------------------------------------------------------- */
 typedef time64 (*Time64AccessFunc) (const gpointer);
 typedef void (*Time64SetterFunc) (const gpointer, time64);
@@ -419,40 +515,63 @@ GncSqlColumnTableEntryImpl<CT_TIME>::add_to_table(ColVec& vec) const noexcept
     vec.emplace_back(std::move(info));
 }
 
-template<> void
-GncSqlColumnTableEntryImpl<CT_TIME>::add_to_query(QofIdTypeConst obj_name,
-                                                   const gpointer pObject,
-                                                   PairVec& vec) const noexcept
+/* Returns std::nullopt if the object has no getter for the column. */
+static std::optional<std::string>
+time_column_value (const GncSqlColumnTableEntry& entry, const char* gobj_name,
+                   QofIdTypeConst obj_name, const gpointer pObject)
 {
     /* We still can't use get_row_value_from_object because while g_value could
      * contentedly store a time64 in an int64, KVP wouldn't be able to tell them
      * apart, so we have the struct Time64 hack, see engine/gnc-date.c.
      */
     time64 t64;
-    if (m_gobj_param_name != nullptr)
+    if (gobj_name != nullptr)
     {
         Time64* t;
-        g_object_get (pObject, m_gobj_param_name, &t, nullptr);
+        g_object_get (pObject, gobj_name, &t, nullptr);
         t64 = t->t;
     }
     else
     {
-        auto getter = (Time64AccessFunc)get_getter (obj_name);
-        g_return_if_fail(getter != nullptr);
+        auto getter = (Time64AccessFunc)entry.get_getter (obj_name);
+        g_return_val_if_fail(getter != nullptr, std::nullopt);
         t64 = (*getter)(pObject);
     }
     if (t64 > MINTIME && t64 < MAXTIME)
-    {
-        GncDateTime time(t64);
-        std::string timestr("'");
-        timestr += time.format_iso8601() + "'";
-        vec.emplace_back (std::make_pair (std::string{m_col_name}, timestr));
-    }
+        return GncDateTime(t64).format_iso8601();
+    return std::string{};
+}
+
+template<> void
+GncSqlColumnTableEntryImpl<CT_TIME>::add_to_query(QofIdTypeConst obj_name,
+                                                   const gpointer pObject,
+                                                   PairVec& vec) const noexcept
+{
+    auto timestr = time_column_value (*this, m_gobj_param_name, obj_name,
+                                      pObject);
+    if (!timestr)
+        return;
+    if (!timestr->empty())
+        vec.emplace_back (std::make_pair (std::string{m_col_name},
+                                          "'" + *timestr + "'"));
     else
-    {
         vec.emplace_back (std::make_pair (std::string{m_col_name},
                                           "NULL"));
-    }
+}
+
+template<> void
+GncSqlColumnTableEntryImpl<CT_TIME>::add_to_params(QofIdTypeConst obj_name,
+                                                   const gpointer pObject,
+                                                   ParamVec& vec) const noexcept
+{
+    auto timestr = time_column_value (*this, m_gobj_param_name, obj_name,
+                                      pObject);
+    if (!timestr)
+        return;
+    if (!timestr->empty())
+        vec.emplace_back (std::string{m_col_name}, std::move(*timestr));
+    else
+        vec.emplace_back (std::string{m_col_name}, std::monostate{});
 }
 
 /* ----------------------------------------------------------------- */
@@ -509,6 +628,16 @@ GncSqlColumnTableEntryImpl<CT_GDATE>::add_to_table(ColVec& vec) const noexcept
     vec.emplace_back(std::move(info));
 }
 
+static std::string
+gdate_column_value (const GDate* date)
+{
+    std::ostringstream buf;
+    buf << std::setfill ('0') << std::setw (4) << g_date_get_year (date) <<
+        std::setw (2) << g_date_get_month (date) <<
+        std::setw (2) << static_cast<int>(g_date_get_day (date));
+    return buf.str();
+}
+
 template<> void
 GncSqlColumnTableEntryImpl<CT_GDATE>::add_to_query(QofIdTypeConst obj_name,
                                                    const gpointer pObject,
@@ -517,15 +646,19 @@ GncSqlColumnTableEntryImpl<CT_GDATE>::add_to_query(QofIdTypeConst obj_name,
     GDate *date = get_row_value_from_object<GDate*>(obj_name, pObject);
 
     if (date && g_date_valid (date))
-    {
-        std::ostringstream buf;
-        buf << std::setfill ('0') << std::setw (4) << g_date_get_year (date) <<
-            std::setw (2) << g_date_get_month (date) <<
-            std::setw (2) << static_cast<int>(g_date_get_day (date));
         vec.emplace_back (std::make_pair (std::string{m_col_name},
-                                          quote_string(buf.str())));
-        return;
-    }
+                                          quote_string(gdate_column_value (date))));
+}
+
+template<> void
+GncSqlColumnTableEntryImpl<CT_GDATE>::add_to_params(QofIdTypeConst obj_name,
+                                                    const gpointer pObject,
+                                                    ParamVec& vec) const noexcept
+{
+    GDate *date = get_row_value_from_object<GDate*>(obj_name, pObject);
+
+    if (date && g_date_valid (date))
+        vec.emplace_back (std::string{m_col_name}, gdate_column_value (date));
 }
 
 /* ----------------------------------------------------------------- */
@@ -590,37 +723,30 @@ GncSqlColumnTableEntryImpl<CT_NUMERIC>::add_to_table(ColVec& vec) const noexcept
     }
 }
 
+static gnc_numeric
+numeric_column_value (const GncSqlColumnTableEntry& entry, const char* gobj_name,
+                      QofIdTypeConst obj_name, const gpointer pObject)
+{
+/* We can't use get_row_value_from_object for the same reason as time64. */
+    if (gobj_name != nullptr)
+    {
+        gnc_numeric* s;
+        g_object_get (pObject, gobj_name, &s, NULL);
+        return *s;
+    }
+    auto getter = reinterpret_cast<NumericGetterFunc>(entry.get_getter (obj_name));
+    return getter != NULL ? (*getter) (pObject) : gnc_numeric_zero ();
+}
+
 template<> void
 GncSqlColumnTableEntryImpl<CT_NUMERIC>::add_to_query(QofIdTypeConst obj_name,
                                                      const gpointer pObject,
                                                      PairVec& vec) const noexcept
 {
-/* We can't use get_row_value_from_object for the same reason as time64. */
-    NumericGetterFunc getter;
-    gnc_numeric n;
-
     g_return_if_fail (obj_name != NULL);
     g_return_if_fail (pObject != NULL);
 
-    if (m_gobj_param_name != nullptr)
-    {
-        gnc_numeric* s;
-        g_object_get (pObject, m_gobj_param_name, &s, NULL);
-        n = *s;
-    }
-    else
-    {
-        getter = reinterpret_cast<NumericGetterFunc>(get_getter (obj_name));
-        if (getter != NULL)
-        {
-            n = (*getter) (pObject);
-        }
-        else
-        {
-            n = gnc_numeric_zero ();
-        }
-    }
-
+    auto n = numeric_column_value (*this, m_gobj_param_name, obj_name, pObject);
     std::ostringstream buf;
     std::string num_col{m_col_name};
     std::string denom_col{m_col_name};
@@ -633,6 +759,21 @@ GncSqlColumnTableEntryImpl<CT_NUMERIC>::add_to_query(QofIdTypeConst obj_name,
     vec.emplace_back (denom_col, buf.str ());
 }
 
+template<> void
+GncSqlColumnTableEntryImpl<CT_NUMERIC>::add_to_params(QofIdTypeConst obj_name,
+                                                      const gpointer pObject,
+                                                      ParamVec& vec) const noexcept
+{
+    g_return_if_fail (obj_name != NULL);
+    g_return_if_fail (pObject != NULL);
+
+    auto n = numeric_column_value (*this, m_gobj_param_name, obj_name, pObject);
+    vec.emplace_back (std::string{m_col_name} + "_num",
+                      static_cast<int64_t>(gnc_numeric_num (n)));
+    vec.emplace_back (std::string{m_col_name} + "_denom",
+                      static_cast<int64_t>(gnc_numeric_denom (n)));
+}
+
 static void
 _retrieve_guid_ (gpointer pObject,  gpointer pValue)
 {
@@ -663,6 +804,13 @@ gnc_sql_load_guid (const GncSqlBackend* sql_be, GncSqlRow& row)
     return &guid;
 }
 
+bool
+gnc_sql_guid_at_index (GncSqlRow& row, int idx, GncGUID* guid)
+{
+    auto str = row.get_cstring_at_index (idx);
+    return str != nullptr && *str != '\0' && string_to_guid (str, guid);
+}
+
 void
 gnc_sql_load_object (const GncSqlBackend* sql_be, GncSqlRow& row,
                      QofIdTypeConst obj_name, gpointer pObject,
@@ -31,6 +31,7 @@
 #include <iomanip>
 
 #include "gnc-sql-result.hpp"
+#include "gnc-sql-connection.hpp"
 
 struct GncSqlColumnInfo;
 using ColVec = std::vector<GncSqlColumnInfo>;
@@ -155,6 +156,13 @@ public:
      */
     virtual void add_to_query(QofIdTypeConst obj_name,
                               void* pObject, PairVec& vec) const noexcept = 0;
+    /**
+     * Add a pair of the table column heading and the object's value to a
+     * ParamVec for binding to a prepared statement. Unlike add_to_query the
+     * value keeps its type, so it isn't rounded or re-parsed on the way in.
+     */
+    virtual void add_to_params(QofIdTypeConst obj_name,
+                               void* pObject, ParamVec& vec) const noexcept = 0;
     /**
      * Retrieve the getter function depending on whether it's an auto-increment
      * field, a QofClass getter, or a function passed to the constructor.
@@ -281,8 +289,61 @@ public:
     void add_to_table(ColVec& vec) const noexcept override;
     void add_to_query(QofIdTypeConst obj_name, void* pObject, PairVec& vec)
         const noexcept override;
+    void add_to_params(QofIdTypeConst obj_name, void* pObject, ParamVec& vec)
+        const noexcept override;
 };
 
+/**
+ * Convert a SQL literal as made by add_to_query back into a parameter: quoted
+ * strings are unquoted, bare integers and reals become numbers, NULL becomes
+ * std::monostate.
+ */
+GncSqlParam gnc_sql_param_from_literal (const std::string& literal);
+
+/* Column types whose values are all references to other objects or strings
+ * use their add_to_query literals; the basic types below bind their values
+ * directly.
+ */
+template <GncSqlObjectType Type> void
+GncSqlColumnTableEntryImpl<Type>::add_to_params(QofIdTypeConst obj_name,
+                                                void* pObject,
+                                                ParamVec& vec) const noexcept
+{
+    PairVec pairs;
+    add_to_query (obj_name, pObject, pairs);
+    for (auto const& col_value : pairs)
+        vec.emplace_back (col_value.first,
+                          gnc_sql_param_from_literal (col_value.second));
+}
+
+template<> void
+GncSqlColumnTableEntryImpl<CT_STRING>::add_to_params(QofIdTypeConst, void*,
+                                                     ParamVec&) const noexcept;
+template<> void
+GncSqlColumnTableEntryImpl<CT_INT>::add_to_params(QofIdTypeConst, void*,
+                                                  ParamVec&) const noexcept;
+template<> void
+GncSqlColumnTableEntryImpl<CT_BOOLEAN>::add_to_params(QofIdTypeConst, void*,
+                                                      ParamVec&) const noexcept;
+template<> void
+GncSqlColumnTableEntryImpl<CT_INT64>::add_to_params(QofIdTypeConst, void*,
+                                                    ParamVec&) const noexcept;
+template<> void
+GncSqlColumnTableEntryImpl<CT_DOUBLE>::add_to_params(QofIdTypeConst, void*,
+                                                     ParamVec&) const noexcept;
+template<> void
+GncSqlColumnTableEntryImpl<CT_GUID>::add_to_params(QofIdTypeConst, void*,
+                                                   ParamVec&) const noexcept;
+template<> void
+GncSqlColumnTableEntryImpl<CT_TIME>::add_to_params(QofIdTypeConst, void*,
+                                                   ParamVec&) const noexcept;
+template<> void
+GncSqlColumnTableEntryImpl<CT_GDATE>::add_to_params(QofIdTypeConst, void*,
+                                                    ParamVec&) const noexcept;
+template<> void
+GncSqlColumnTableEntryImpl<CT_NUMERIC>::add_to_params(QofIdTypeConst, void*,
+                                                      ParamVec&) const noexcept;
+
 using GncSqlColumnTableEntryPtr = std::shared_ptr<GncSqlColumnTableEntry>;
 using EntryVec = std::vector<GncSqlColumnTableEntryPtr>;
 
@@ -460,6 +521,16 @@ void gnc_sql_load_object (const GncSqlBackend* sql_be, GncSqlRow& row,
 const GncGUID*
 gnc_sql_load_guid (const GncSqlBackend* sql_be, GncSqlRow& row);
 
+/**
+ * Read a guid from a row by column position, see GncSqlRow::col_index().
+ *
+ * @param row: The GncSqlResult row.
+ * @param idx: The column's position.
+ * @param guid: Receives the guid.
+ * @return true if the column held a valid guid.
+ */
+bool gnc_sql_guid_at_index (GncSqlRow& row, int idx, GncGUID* guid);
+
 /**
  * Append the GUIDs of QofInstances to a SQL query.
  *
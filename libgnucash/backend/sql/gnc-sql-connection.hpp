@@ -25,8 +25,10 @@
 #define __GNC_SQL_CONNECTION_HPP__
 
 #include <qof.h>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <variant>
 #include <vector>
 
 class GncSqlResult;
@@ -37,6 +39,11 @@ using EntryVec = std::vector<GncSqlColumnTableEntryPtr>;
 using PairVec = std::vector<std::pair<std::string, std::string>>;
 struct GncSqlColumnInfo;
 using ColVec = std::vector<GncSqlColumnInfo>;
+/**
+ * A typed value for a prepared statement parameter. std::monostate binds NULL.
+ */
+using GncSqlParam = std::variant<std::monostate, int64_t, double, std::string>;
+using ParamVec = std::vector<std::pair<std::string, GncSqlParam>>;
 
 /**
  * SQL statement provider.
@@ -47,6 +54,14 @@ public:
     virtual ~GncSqlStatement() {}
     virtual const char* to_sql() const = 0;
     virtual void add_where_cond (QofIdTypeConst, const PairVec&) = 0;
+    /** Bind a value to the index'th (0-based) '?' placeholder of a statement
+     * created with GncSqlConnection::prepare_statement. Bindings persist
+     * until replaced or cleared, so a statement can be re-executed with only
+     * the changed parameters rebound.
+     */
+    virtual void bind (unsigned int, const GncSqlParam&) {}
+    /** Discard all bound parameters. */
+    virtual void clear_bindings () {}
 };
 
 using GncSqlStatementPtr = std::unique_ptr<GncSqlStatement>;
@@ -67,6 +82,13 @@ public:
         noexcept = 0;
     virtual GncSqlStatementPtr create_statement_from_sql (const std::string&)
         const noexcept = 0;
+    /** Create a statement from SQL containing '?' placeholders for values that
+     * will be supplied with GncSqlStatement::bind. Connections able to do so
+     * will have the server parse and plan the statement once. The statement
+     * must not outlive the connection. Returns nullptr if error.
+     */
+    virtual GncSqlStatementPtr prepare_statement (const std::string& sql)
+        noexcept { return create_statement_from_sql (sql); }
     /** Returns true if successful */
     virtual bool does_table_exist (const std::string&) const noexcept = 0;
     /** Returns TRUE if successful, false if error */
@@ -56,6 +56,19 @@ protected:
         virtual std::optional<std::string> get_string_at_col (const char* col) const = 0;
         virtual std::optional<time64> get_time64_at_col (const char* col) const = 0;
         virtual bool is_col_null (const char* col) const noexcept = 0;
+        /* Positional access for decoders that read many rows of one table:
+         * col_index() is looked up once per result and the getters then
+         * skip the search by column name. An implementation that doesn't
+         * support it returns -1 from col_index().
+         */
+        virtual int col_index (const char*) const noexcept { return -1; }
+        virtual std::optional<int64_t> get_int_at_index (int) const
+        { return std::nullopt; }
+        /* The string stays valid until the iterator moves on. */
+        virtual const char* get_cstring_at_index (int) const noexcept
+        { return nullptr; }
+        virtual std::optional<time64> get_time64_at_index (int) const
+        { return std::nullopt; }
     };
 };
 
@@ -97,6 +110,14 @@ public:
         return m_iter->get_time64_at_col (col); }
     bool is_col_null (const char* col) const noexcept {
         return m_iter->is_col_null (col); }
+    int col_index (const char* col) const noexcept {
+        return m_iter->col_index (col); }
+    std::optional<int64_t> get_int_at_index (int idx) const {
+        return m_iter->get_int_at_index (idx); }
+    const char* get_cstring_at_index (int idx) const noexcept {
+        return m_iter->get_cstring_at_index (idx); }
+    std::optional<time64> get_time64_at_index (int idx) const {
+        return m_iter->get_time64_at_index (idx); }
 private:
     GncSqlResult::IteratorImpl* m_iter;
 };
@@ -47,8 +47,11 @@
 #include "splint-defs.h"
 #endif
 
+#include <optional>
 #include <string>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
 #include "escape.h"
 
@@ -69,6 +72,8 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define TX_TABLE_VERSION 4
 #define SPLIT_TABLE "splits"
 #define SPLIT_TABLE_VERSION 5
+/* The slot marking book closing transactions, see xaccTransSetIsClosingTxn. */
+#define TRANS_CLOSING_SLOT "book_closing"
 
 struct split_info_t : public write_objects_t
 {
@@ -199,6 +204,205 @@ set_split_lot (gpointer pObject,  gpointer pLot)
     gnc_lot_add_split (lot, split);
 }
 
+/* ================================================================= */
+/* Loading a book reads every row of the transactions and splits tables.
+ * Rather than going through the column tables, which look each column up
+ * by name and set most of them with g_object_set, these decoders find the
+ * columns once per result and call the engine's setters directly. Rows they
+ * can't decode are handed to the column tables.
+ */
+
+static Split* load_single_split (GncSqlBackend* sql_be, GncSqlRow& row);
+static Transaction* load_single_tx (GncSqlBackend* sql_be, GncSqlRow& row);
+
+struct TxColumns
+{
+    explicit TxColumns (GncSqlRow& row) noexcept :
+        guid{row.col_index ("guid")},
+        currency{row.col_index ("currency_guid")},
+        num{row.col_index ("num")},
+        post_date{row.col_index ("post_date")},
+        enter_date{row.col_index ("enter_date")},
+        description{row.col_index ("description")} {}
+    bool valid () const noexcept
+    {
+        return guid >= 0 && currency >= 0 && num >= 0 && post_date >= 0 &&
+            enter_date >= 0 && description >= 0;
+    }
+    int guid, currency, num, post_date, enter_date, description;
+};
+
+struct SplitColumns
+{
+    explicit SplitColumns (GncSqlRow& row) noexcept :
+        guid{row.col_index ("guid")},
+        tx{row.col_index ("tx_guid")},
+        account{row.col_index ("account_guid")},
+        memo{row.col_index ("memo")},
+        action{row.col_index ("action")},
+        reconcile_state{row.col_index ("reconcile_state")},
+        reconcile_date{row.col_index ("reconcile_date")},
+        value_num{row.col_index ("value_num")},
+        value_denom{row.col_index ("value_denom")},
+        quantity_num{row.col_index ("quantity_num")},
+        quantity_denom{row.col_index ("quantity_denom")},
+        lot{row.col_index ("lot_guid")} {}
+    bool valid () const noexcept
+    {
+        return guid >= 0 && tx >= 0 && account >= 0 && memo >= 0 &&
+            action >= 0 && reconcile_state >= 0 && reconcile_date >= 0 &&
+            value_num >= 0 && value_denom >= 0 && quantity_num >= 0 &&
+            quantity_denom >= 0 && lot >= 0;
+    }
+    int guid, tx, account, memo, action, reconcile_state, reconcile_date,
+        value_num, value_denom, quantity_num, quantity_denom, lot;
+};
+
+static std::optional<gnc_numeric>
+numeric_at_index (GncSqlRow& row, int num_idx, int denom_idx)
+{
+    auto num = row.get_int_at_index (num_idx);
+    auto denom = row.get_int_at_index (denom_idx);
+    if (!num || !denom)
+        return std::nullopt;
+    return gnc_numeric_create (*num, *denom);
+}
+
+/* Reads a time the same way as the CT_TIME column loader. */
+static time64
+time_at_index (GncSqlRow& row, int idx)
+{
+    if (auto str = row.get_cstring_at_index (idx))
+    {
+        if (*str == '\0')
+            return 0;
+        try
+        {
+            return static_cast<time64>(GncDateTime (std::string{str}));
+        }
+        catch (const std::invalid_argument& err)
+        {
+            PWARN("An invalid date %s was found in your database."
+                  "It has been set to 1 January 1970.", str);
+            return 0;
+        }
+    }
+    if (auto time = row.get_time64_at_index (idx))
+        return *time;
+    return 0;
+}
+
+static Transaction*
+decode_tx (GncSqlBackend* sql_be, GncSqlRow& row, const TxColumns& cols)
+{
+    GncGUID guid;
+    if (!cols.valid () || !gnc_sql_guid_at_index (row, cols.guid, &guid))
+        return load_single_tx (sql_be, row);
+
+    auto book = sql_be->book ();
+    if (xaccTransLookup (&guid, book))
+        return nullptr; // Nothing to do.
+
+    auto tx = xaccMallocTransaction (book);
+    xaccTransBeginEdit (tx);
+    qof_instance_set_guid (QOF_INSTANCE (tx), &guid);
+
+    GncGUID ref;
+    if (gnc_sql_guid_at_index (row, cols.currency, &ref))
+    {
+        auto currency = gnc_commodity_find_commodity_by_guid (&ref, book);
+        if (currency)
+            xaccTransSetCurrency (tx, currency);
+    }
+    if (auto num = row.get_cstring_at_index (cols.num))
+        xaccTransSetNum (tx, num);
+    xaccTransSetDatePostedSecs (tx, time_at_index (row, cols.post_date));
+    xaccTransSetDateEnteredSecs (tx, time_at_index (row, cols.enter_date));
+    if (auto description = row.get_cstring_at_index (cols.description))
+        xaccTransSetDescription (tx, description);
+
+    if (tx != xaccTransLookup (&guid, book))
+    {
+        gchar guidstr[GUID_ENCODING_LENGTH + 1];
+        guid_to_string_buff (qof_instance_get_guid (tx), guidstr);
+        PERR ("A malformed transaction with id %s was found in the dataset.", guidstr);
+        qof_backend_set_error ((QofBackend*)sql_be, ERR_BACKEND_DATA_CORRUPT);
+        return nullptr;
+    }
+    return tx;
+}
+
+static Split*
+decode_split (GncSqlBackend* sql_be, GncSqlRow& row, const SplitColumns& cols)
+{
+    GncGUID guid;
+    if (!cols.valid () || !gnc_sql_guid_at_index (row, cols.guid, &guid))
+        return load_single_split (sql_be, row);
+
+    auto book = sql_be->book ();
+    if (guid_equal (&guid, guid_null ()))
+    {
+        PWARN ("Bad GUID, creating new");
+        guid = guid_new_return ();
+    }
+    else if (auto split = xaccSplitLookup (&guid, book))
+    {
+        return split; //Already loaded, nothing to do.
+    }
+
+    auto split = xaccMallocSplit (book);
+    qof_instance_set_guid (QOF_INSTANCE (split), &guid);
+
+    GncGUID ref;
+    auto tx = gnc_sql_guid_at_index (row, cols.tx, &ref) ?
+        xaccTransLookup (&ref, book) : nullptr;
+    if (tx)
+        xaccSplitSetParent (split, tx);
+    else // Let the column loader find or load it.
+        split_col_table[1]->load (sql_be, row, GNC_ID_SPLIT, split);
+    if (gnc_sql_guid_at_index (row, cols.account, &ref))
+    {
+        auto account = xaccAccountLookup (&ref, book);
+        if (account)
+            xaccSplitSetAccount (split, account);
+    }
+    if (auto memo = row.get_cstring_at_index (cols.memo))
+        xaccSplitSetMemo (split, memo);
+    if (auto action = row.get_cstring_at_index (cols.action))
+        xaccSplitSetAction (split, action);
+    auto state = row.get_cstring_at_index (cols.reconcile_state);
+    if (state && *state != '\0')
+        xaccSplitSetReconcile (split, state[0]);
+    xaccSplitSetDateReconciledSecs (split,
+                                    time_at_index (row, cols.reconcile_date));
+    if (auto value = numeric_at_index (row, cols.value_num, cols.value_denom))
+        xaccSplitSetValue (split, *value);
+    if (auto amount = numeric_at_index (row, cols.quantity_num,
+                                        cols.quantity_denom))
+        xaccSplitSetAmount (split, *amount);
+    if (gnc_sql_guid_at_index (row, cols.lot, &ref))
+    {
+        auto lot = gnc_lot_lookup (&ref, book);
+        if (lot)
+            gnc_lot_add_split (lot, split);
+    }
+
+    gchar guidstr[GUID_ENCODING_LENGTH + 1];
+    if (split != xaccSplitLookup (&guid, book))
+    {
+        guid_to_string_buff (qof_instance_get_guid (split), guidstr);
+        PERR ("A malformed split with id %s was found in the dataset.", guidstr);
+        qof_backend_set_error ((QofBackend*)sql_be, ERR_BACKEND_DATA_CORRUPT);
+        return nullptr;
+    }
+    if (!xaccSplitGetAccount (split))
+    {
+        guid_to_string_buff (&guid, guidstr);
+        PERR("Split %s created with no account!", guidstr);
+    }
+    return split;
+}
+
 static  Split*
 load_single_split (GncSqlBackend* sql_be, GncSqlRow& row)
 {
@@ -268,8 +472,13 @@ load_splits_for_transactions (GncSqlBackend* sql_be, std::string selector)
     auto stmt = sql_be->create_statement_from_sql(sql);
     auto result = sql_be->execute_select_statement (stmt);
 
+    std::optional<SplitColumns> cols;
     for (auto row : *result)
-        load_single_split (sql_be, row);
+    {
+        if (!cols)
+            cols.emplace (row);
+        decode_split (sql_be, row, *cols);
+    }
     sql = "SELECT DISTINCT ";
     sql += spkey + " FROM " SPLIT_TABLE " WHERE " + sskey + " IN " + selector;
     gnc_sql_slots_load_for_sql_subquery(sql_be, sql,
@@ -324,8 +533,30 @@ typedef struct
     gnc_numeric end_cleared_bal;
     gnc_numeric start_reconciled_bal;
     gnc_numeric end_reconciled_bal;
+    gnc_numeric start_noclosing_bal;
+    gnc_numeric end_noclosing_bal;
 } full_acct_balances_t;
 
+static void load_balance_checkpoints (GncSqlBackend* sql_be, time64 cutoff);
+
+/**
+ * Builds the condition selecting transactions posted in [since, until).
+ * INT64_MIN and INT64_MAX leave the range open.
+ */
+static std::string
+post_date_condition (time64 since, time64 until)
+{
+    const std::string pdkey(post_date_col_table[0]->name());
+    std::string cond;
+    if (since != INT64_MIN)
+        cond += pdkey + " >= '" + GncDateTime(since).format_iso8601() + "'";
+    if (since != INT64_MIN && until != INT64_MAX)
+        cond += " AND ";
+    if (until != INT64_MAX)
+        cond += pdkey + " < '" + GncDateTime(until).format_iso8601() + "'";
+    return cond;
+}
+
 /**
  * Executes a transaction query statement and loads the transactions and all
  * of the splits.
@@ -358,9 +589,12 @@ query_transactions (GncSqlBackend* sql_be, std::string selector)
     // Load the transactions
     InstanceVec instances;
     instances.reserve(result->size());
+    std::optional<TxColumns> cols;
     for (auto row : *result)
     {
-        tx = load_single_tx (sql_be, row);
+        if (!cols)
+            cols.emplace (row);
+        tx = decode_tx (sql_be, row, *cols);
         if (tx != nullptr)
         {
             xaccTransScrubPostedDate (tx);
@@ -721,7 +955,19 @@ GncSqlTransBackend::load_all (GncSqlBackend* sql_be)
     auto root = gnc_book_get_root_account (sql_be->book());
     gnc_account_foreach_descendant(root, (AccountCb)xaccAccountBeginEdit,
                                    nullptr);
-    query_transactions (sql_be, "");
+    /* With a load window only the recent transactions are loaded; the older
+     * ones are summed up into the accounts' starting balances instead.
+     */
+    auto cutoff = sql_be->loaded_since (nullptr);
+    if (cutoff == INT64_MIN)
+    {
+        query_transactions (sql_be, "");
+    }
+    else
+    {
+        load_balance_checkpoints (sql_be, cutoff);
+        query_transactions (sql_be, post_date_condition (cutoff, INT64_MAX));
+    }
     gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
                                    nullptr);
 }
@@ -785,6 +1031,174 @@ static const EntryVec acct_balances_col_table
                                          (QofSetterFunc)set_acct_bal_balance),
 };
 
+/**
+ * Sums the split quantities by account for the transactions posted before
+ * cutoff, optionally excluding book closing transactions.
+ */
+static std::unordered_map<Account*, acct_balances_t>
+query_balances_before (GncSqlBackend* sql_be, time64 cutoff, bool noclosing)
+{
+    std::unordered_map<Account*, acct_balances_t> balances;
+    const std::string tpkey(tx_col_table[0]->name());
+    const std::string stkey(split_col_table[1]->name());
+    const std::string sakey(split_col_table[2]->name());
+    std::string sql("SELECT " + sakey + ", reconcile_state, "
+                    "SUM(quantity_num) AS quantity_num, quantity_denom FROM "
+                    SPLIT_TABLE " WHERE " + stkey + " IN (SELECT " + tpkey +
+                    " FROM " TRANSACTION_TABLE " WHERE " +
+                    post_date_condition (INT64_MIN, cutoff) + ")");
+    if (noclosing)
+        sql += " AND " + stkey + " NOT IN (SELECT obj_guid FROM slots "
+            "WHERE name = '" TRANS_CLOSING_SLOT "' AND int64_val <> 0)";
+    sql += " GROUP BY " + sakey + ", reconcile_state, quantity_denom";
+
+    auto stmt = sql_be->create_statement_from_sql (sql);
+    auto result = sql_be->execute_select_statement (stmt);
+    if (result == nullptr)
+        return balances;
+    for (auto row : *result)
+    {
+        single_acct_balance_t bal{sql_be, nullptr, NREC, gnc_numeric_zero ()};
+        gnc_sql_load_object (sql_be, row, NULL, &bal, acct_balances_col_table);
+        if (bal.acct == nullptr)
+            continue;
+        auto zero = gnc_numeric_zero ();
+        auto& acct_bal = balances.emplace (bal.acct, acct_balances_t{bal.acct,
+                                                    zero, zero, zero}).first->second;
+        acct_bal.balance = gnc_numeric_add (acct_bal.balance, bal.balance,
+                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        if (bal.reconcile_state != NREC)
+            acct_bal.cleared_balance = gnc_numeric_add (acct_bal.cleared_balance,
+                                                        bal.balance,
+                                                        GNC_DENOM_AUTO,
+                                                        GNC_HOW_DENOM_LCD);
+        if (bal.reconcile_state == YREC || bal.reconcile_state == FREC)
+            acct_bal.reconciled_balance =
+                gnc_numeric_add (acct_bal.reconciled_balance, bal.balance,
+                                 GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+    }
+    return balances;
+}
+
+/**
+ * Sets the starting balances of the accounts to the totals of the splits in
+ * the transactions posted before cutoff, which aren't loaded. These are the
+ * checkpoints from which the running balances of the loaded splits continue.
+ *
+ * @param sql_be SQL backend
+ * @param cutoff Posted date of the earliest loaded transactions
+ */
+static void
+load_balance_checkpoints (GncSqlBackend* sql_be, time64 cutoff)
+{
+    for (const auto& entry : query_balances_before (sql_be, cutoff, false))
+    {
+        const auto& bal = entry.second;
+        gnc_account_set_start_balance (bal.acct, bal.balance);
+        gnc_account_set_start_cleared_balance (bal.acct, bal.cleared_balance);
+        gnc_account_set_start_reconciled_balance (bal.acct,
+                                                  bal.reconciled_balance);
+    }
+    for (const auto& entry : query_balances_before (sql_be, cutoff, true))
+        gnc_account_set_start_noclosing_balance (entry.second.acct,
+                                                 entry.second.balance);
+}
+
+static gnc_numeric
+get_balance_property (Account* acc, const char* name)
+{
+    gnc_numeric* value = nullptr;
+    g_object_get (acc, name, &value, NULL);
+    auto balance = value ? *value : gnc_numeric_zero ();
+    if (value)
+        g_boxed_free (GNC_TYPE_NUMERIC, value);
+    return balance;
+}
+
+/* Moves the change of the ending balance into the starting balance. */
+static gnc_numeric
+adjust_start_balance (gnc_numeric start, gnc_numeric old_end,
+                      gnc_numeric new_end)
+{
+    auto diff = gnc_numeric_sub (new_end, old_end, GNC_DENOM_AUTO,
+                                 GNC_HOW_DENOM_LCD);
+    return gnc_numeric_sub (start, diff, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+}
+
+void
+gnc_sql_transaction_load_tx_for_range (GncSqlBackend* sql_be, Account* account,
+                                       time64 since, time64 until)
+{
+    g_return_if_fail (sql_be != NULL);
+
+    /* The splits being loaded are already part of their accounts' starting
+     * balances, so take them back out of those to keep the ending balances.
+     */
+    std::vector<full_acct_balances_t> balances;
+    auto root = gnc_book_get_root_account (sql_be->book());
+    auto accounts = gnc_account_get_descendants (root);
+    for (auto node = accounts; node != nullptr; node = node->next)
+    {
+        auto acc = GNC_ACCOUNT (node->data);
+        full_acct_balances_t bal;
+        bal.acc = acc;
+        bal.start_bal = get_balance_property (acc, "start-balance");
+        bal.end_bal = get_balance_property (acc, "end-balance");
+        bal.start_cleared_bal = get_balance_property (acc, "start-cleared-balance");
+        bal.end_cleared_bal = get_balance_property (acc, "end-cleared-balance");
+        bal.start_reconciled_bal = get_balance_property (acc,
+                                                         "start-reconciled-balance");
+        bal.end_reconciled_bal = get_balance_property (acc,
+                                                       "end-reconciled-balance");
+        bal.start_noclosing_bal = get_balance_property (acc,
+                                                        "start-noclosing-balance");
+        bal.end_noclosing_bal = get_balance_property (acc,
+                                                      "end-noclosing-balance");
+        balances.push_back (bal);
+    }
+    g_list_free (accounts);
+
+    auto cond = post_date_condition (since, until);
+    if (account != nullptr)
+    {
+        const std::string tpkey(tx_col_table[0]->name());
+        const std::string stkey(split_col_table[1]->name());
+        const std::string sakey(split_col_table[2]->name());
+        auto guid = qof_instance_get_guid (QOF_INSTANCE (account));
+        std::string sql("(SELECT DISTINCT " + stkey + " FROM " SPLIT_TABLE
+                        " WHERE " + sakey + " = '" +
+                        gnc::GUID(*guid).to_string() + "'");
+        if (!cond.empty())
+            sql += " AND " + stkey + " IN (SELECT " + tpkey + " FROM "
+                TRANSACTION_TABLE " WHERE " + cond + ")";
+        cond = sql + ")";
+    }
+    query_transactions (sql_be, cond);
+
+    for (auto& bal : balances)
+    {
+        xaccAccountRecomputeBalance (bal.acc);
+        auto end = get_balance_property (bal.acc, "end-balance");
+        if (gnc_numeric_equal (end, bal.end_bal))
+            continue;
+        gnc_account_set_start_balance (bal.acc,
+            adjust_start_balance (bal.start_bal, bal.end_bal, end));
+        end = get_balance_property (bal.acc, "end-cleared-balance");
+        gnc_account_set_start_cleared_balance (bal.acc,
+            adjust_start_balance (bal.start_cleared_bal, bal.end_cleared_bal,
+                                  end));
+        end = get_balance_property (bal.acc, "end-reconciled-balance");
+        gnc_account_set_start_reconciled_balance (bal.acc,
+            adjust_start_balance (bal.start_reconciled_bal,
+                                  bal.end_reconciled_bal, end));
+        end = get_balance_property (bal.acc, "end-noclosing-balance");
+        gnc_account_set_start_noclosing_balance (bal.acc,
+            adjust_start_balance (bal.start_noclosing_bal,
+                                  bal.end_noclosing_bal, end));
+        xaccAccountRecomputeBalance (bal.acc);
+    }
+}
+
 /* ----------------------------------------------------------------- */
 template<> void
 GncSqlColumnTableEntryImpl<CT_TXREF>::load (const GncSqlBackend* sql_be,
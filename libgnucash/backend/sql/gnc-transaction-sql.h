@@ -59,6 +59,20 @@ public:
  */
 void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* sql_be,
                                               Account* account);
+/**
+ * Loads the transactions posted in [since, until) which have splits for a
+ * specific account or, if account is nullptr, for any account. The starting
+ * balances of the accounts which gain splits are lowered by their amounts so
+ * that the ending balances don't change.
+ *
+ * @param sql_be SQL backend
+ * @param account Account, or nullptr for all accounts
+ * @param since Earliest posted date, INT64_MIN for no limit
+ * @param until Posted date to load up to, excluded
+ */
+void gnc_sql_transaction_load_tx_for_range (GncSqlBackend* sql_be,
+                                            Account* account,
+                                            time64 since, time64 until);
 typedef struct
 {
     Account* acct;
@@ -23,6 +23,7 @@
 #include <glib.h>
 
 #include <config.h>
+#include <climits>
 #include <cstdint>
 #include <string.h>
 #include <unittest-support.h>
@@ -30,6 +31,7 @@
 #include "../gnc-sql-connection.hpp"
 #include "../gnc-sql-backend.hpp"
 #include "../gnc-sql-result.hpp"
+#include "../gnc-sql-column-table-entry.hpp"
 
 static const gchar* suitename = "/backend/sql/gnc-backend-sql";
 void test_suite_gnc_backend_sql (void);
@@ -86,21 +88,47 @@ private:
 class GncMockSqlStatement : public GncSqlStatement
 {
 public:
-    const char* to_sql() const { return "SELECT * FROM foo"; }
+    GncMockSqlStatement() = default;
+    GncMockSqlStatement(const std::string& sql) : m_sql{sql} {}
+    const char* to_sql() const { return m_sql.c_str(); }
     void add_where_cond (QofIdTypeConst, const PairVec&) {}
+    void bind (unsigned int index, const GncSqlParam& param) override
+    {
+        if (index >= m_params.size())
+            m_params.resize (index + 1);
+        m_params[index] = param;
+    }
+    void clear_bindings () override { m_params.clear(); }
+    const std::vector<GncSqlParam>& params() const { return m_params; }
+private:
+    std::string m_sql{"SELECT * FROM foo"};
+    std::vector<GncSqlParam> m_params;
 };
 
+/* A statement as the connection saw it when executing it. */
+using ExecutedStatement = std::pair<std::string, std::vector<GncSqlParam>>;
+
 
 class GncMockSqlConnection : public GncSqlConnection
 {
 public:
     GncSqlResultPtr execute_select_statement (const GncSqlStatementPtr&)
         noexcept override { return &m_result; }
-    int execute_nonselect_statement (const GncSqlStatementPtr&)
-        noexcept override { return 1; }
+    int execute_nonselect_statement (const GncSqlStatementPtr& stmt)
+        noexcept override
+    {
+        auto mock = dynamic_cast<const GncMockSqlStatement*>(stmt.get());
+        if (mock)
+            m_executed.emplace_back (mock->to_sql(), mock->params());
+        return 1;
+    }
     GncSqlStatementPtr create_statement_from_sql (const std::string&)
         const noexcept override {
         return std::unique_ptr<GncMockSqlStatement>(new GncMockSqlStatement); }
+    GncSqlStatementPtr prepare_statement (const std::string& sql)
+        noexcept override {
+        ++m_prepared;
+        return std::unique_ptr<GncMockSqlStatement>(new GncMockSqlStatement{sql}); }
     bool does_table_exist (const std::string&) const noexcept override {
         return true; }
     bool begin_transaction () noexcept override { return true;}
@@ -118,6 +146,8 @@ public:
     void set_error(QofBackendError error, unsigned int repeat, bool retry) noexcept override { return; }
     bool verify() noexcept override { return true; }
     bool retry_connection(const char* msg) noexcept override { return true; }
+    unsigned int m_prepared = 0;
+    std::vector<ExecutedStatement> m_executed;
 private:
     GncMockSqlResult m_result;
 };
@@ -734,12 +764,141 @@ test_gnc_sql_object_is_it_in_db (Fixture *fixture, gconstpointer pData)
 {
 }*/
 /* GncSqlBackend::do_db_operation
-gboolean
-GncSqlBackend::do_db_operation (GncSqlBackend* sql_be,// C: 22 in 12 */
-/* static void
-test_gnc_sql_do_db_operation (Fixture *fixture, gconstpointer pData)
+ * Values are bound to one prepared statement per table and operation with
+ * their own types, not rendered as SQL.
+ */
+struct TestDbObject
+{
+    const char* name;
+    double ratio;
+    gint64 count;
+};
+
+static gpointer
+test_db_object_get_name (gpointer obj, const QofParam*)
 {
-}*/
+    return const_cast<char*>(static_cast<TestDbObject*>(obj)->name);
+}
+
+static gpointer
+test_db_object_get_ratio (gpointer obj, const QofParam*)
+{
+    return &static_cast<TestDbObject*>(obj)->ratio;
+}
+
+static gint64
+test_db_object_get_count (gpointer obj)
+{
+    return static_cast<TestDbObject*>(obj)->count;
+}
+
+static void
+test_gnc_sql_do_db_operation (void)
+{
+    const EntryVec table
+    {
+        gnc_sql_make_table_entry<CT_STRING>(
+            "name", 50, COL_PKEY, (QofAccessFunc)test_db_object_get_name,
+            nullptr),
+        gnc_sql_make_table_entry<CT_DOUBLE>(
+            "ratio", 0, 0, (QofAccessFunc)test_db_object_get_ratio, nullptr),
+        gnc_sql_make_table_entry<CT_INT64>(
+            "count", 0, 0, (QofAccessFunc)test_db_object_get_count, nullptr),
+    };
+    TestDbObject obj1{"it's a '?'", 1.0 / 3.0, INT64_MAX};
+    TestDbObject obj2{"NULL", 1.0e-17, -1};
+    auto conn{new GncMockSqlConnection};
+    auto book = qof_book_new();
+    auto sql_be = new GncMockSqlBackend{conn, book};
+
+    g_assert_true (sql_be->do_db_operation (OP_DB_INSERT, "test", "test",
+                                            &obj1, table));
+    g_assert_true (sql_be->do_db_operation (OP_DB_INSERT, "test", "test",
+                                            &obj2, table));
+    g_assert_cmpuint (conn->m_prepared, ==, 1);
+    g_assert_cmpuint (conn->m_executed.size(), ==, 2);
+    auto& insert1 = conn->m_executed[0];
+    g_assert_cmpstr (insert1.first.c_str(), ==,
+                     "INSERT INTO test(name,ratio,count) VALUES(?,?,?)");
+    g_assert_cmpuint (insert1.second.size(), ==, 3);
+    g_assert_cmpstr (std::get<std::string>(insert1.second[0]).c_str(), ==,
+                     "it's a '?'");
+    g_assert_true (std::get<double>(insert1.second[1]) == 1.0 / 3.0);
+    g_assert_cmpint (std::get<int64_t>(insert1.second[2]), ==, INT64_MAX);
+    auto& insert2 = conn->m_executed[1];
+    g_assert_true (std::holds_alternative<std::monostate>(insert2.second[0]));
+    g_assert_true (std::get<double>(insert2.second[1]) == 1.0e-17);
+    g_assert_cmpint (std::get<int64_t>(insert2.second[2]), ==, -1);
+
+    obj1.ratio = 2.0 / 3.0;
+    g_assert_true (sql_be->do_db_operation (OP_DB_UPDATE, "test", "test",
+                                            &obj1, table));
+    g_assert_true (sql_be->do_db_operation (OP_DB_UPDATE, "test", "test",
+                                            &obj1, table));
+    g_assert_cmpuint (conn->m_prepared, ==, 2);
+    auto& update = conn->m_executed.back();
+    g_assert_cmpstr (update.first.c_str(), ==,
+                     "UPDATE test SET name=?,ratio=?,count=? WHERE name=?");
+    g_assert_cmpuint (update.second.size(), ==, 4);
+    g_assert_true (std::get<double>(update.second[1]) == 2.0 / 3.0);
+    g_assert_cmpstr (std::get<std::string>(update.second[3]).c_str(), ==,
+                     "it's a '?'");
+
+    g_assert_true (sql_be->do_db_operation (OP_DB_DELETE, "test", "test",
+                                            &obj1, table));
+    g_assert_cmpuint (conn->m_prepared, ==, 3);
+    auto& del = conn->m_executed.back();
+    g_assert_cmpstr (del.first.c_str(), ==, "DELETE FROM test WHERE name=?");
+    g_assert_cmpuint (del.second.size(), ==, 1);
+
+    /* Replacing the tables, e.g. for a safe-save, discards the statements. */
+    sql_be->clear_prepared_statements();
+    g_assert_true (sql_be->do_db_operation (OP_DB_INSERT, "test", "test",
+                                            &obj1, table));
+    g_assert_cmpuint (conn->m_prepared, ==, 4);
+    g_assert_cmpuint (conn->m_executed.size(), ==, 6);
+
+    qof_book_destroy (book);
+    delete sql_be;
+}
+
+/* GncSqlBackend::set_insert_batch_size
+ * Batches can't be made so large that their SQL gets too long.
+ */
+static void
+test_gnc_sql_insert_batch_size (void)
+{
+    auto book = qof_book_new();
+    auto sql_be = new GncMockSqlBackend{new GncMockSqlConnection, book};
+
+    sql_be->set_insert_batch_size (0);
+    g_assert_cmpuint (sql_be->insert_batch_size(), ==, 1);
+    sql_be->set_insert_batch_size (250);
+    g_assert_cmpuint (sql_be->insert_batch_size(), ==, 250);
+    sql_be->set_insert_batch_size (UINT_MAX);
+    g_assert_cmpuint (sql_be->insert_batch_size(), ==, 1000);
+
+    qof_book_destroy (book);
+    delete sql_be;
+}
+
+/* gnc_sql_param_from_literal
+ * The fallback for column types that only produce SQL literals.
+ */
+static void
+test_gnc_sql_param_from_literal (void)
+{
+    g_assert_true (std::holds_alternative<std::monostate>(
+                       gnc_sql_param_from_literal ("NULL")));
+    g_assert_cmpstr (std::get<std::string>(
+                         gnc_sql_param_from_literal ("'it''s'")).c_str(), ==,
+                     "it's");
+    g_assert_cmpstr (std::get<std::string>(
+                         gnc_sql_param_from_literal ("'42'")).c_str(), ==, "42");
+    g_assert_cmpint (std::get<int64_t>(gnc_sql_param_from_literal ("-42")), ==,
+                     -42);
+    g_assert_true (std::get<double>(gnc_sql_param_from_literal ("0.5")) == 0.5);
+}
 /* gnc_sql_get_sql_value
 gchar*
 gnc_sql_get_sql_value (const GncSqlConnection* conn, const GValue* value)// C: 1 */
@@ -910,7 +1069,9 @@ test_suite_gnc_backend_sql (void)
 // GNC_TEST_ADD (suitename, "execute statement get count", Fixture, nullptr, test_execute_statement_get_count,  teardown);
 // GNC_TEST_ADD (suitename, "gnc sql append guid list to sql", Fixture, nullptr, test_gnc_sql_append_guid_list_to_sql,  teardown);
 // GNC_TEST_ADD (suitename, "gnc sql object is it in db", Fixture, nullptr, test_gnc_sql_object_is_it_in_db,  teardown);
-// GNC_TEST_ADD (suitename, "gnc sql do db operation", Fixture, nullptr, test_gnc_sql_do_db_operation,  teardown);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql do db operation", test_gnc_sql_do_db_operation);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql param from literal", test_gnc_sql_param_from_literal);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql insert batch size", test_gnc_sql_insert_batch_size);
 // GNC_TEST_ADD (suitename, "gnc sql get sql value", Fixture, nullptr, test_gnc_sql_get_sql_value,  teardown);
 // GNC_TEST_ADD (suitename, "build insert statement", Fixture, nullptr, test_build_insert_statement,  teardown);
 // GNC_TEST_ADD (suitename, "build update statement", Fixture, nullptr, test_build_update_statement,  teardown);
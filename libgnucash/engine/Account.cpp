@@ -46,6 +46,7 @@
 #include "qofinstance-p.h"
 #include "gnc-features.h"
 #include "guid.hpp"
+#include "qof-backend.hpp"
 
 #include <numeric>
 #include <map>
@@ -3423,6 +3424,29 @@ gnc_account_set_start_reconciled_balance (Account *acc,
     priv->balance_dirty = TRUE;
 }
 
+void
+gnc_account_set_start_noclosing_balance (Account *acc,
+        const gnc_numeric start_baln)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    priv = GET_PRIVATE(acc);
+    priv->starting_noclosing_balance = start_baln;
+    priv->balance_dirty = TRUE;
+}
+
+void
+gnc_account_ensure_loaded (Account *acc, time64 since)
+{
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    auto be = qof_book_get_backend (gnc_account_get_book (acc));
+    if (be)
+        be->ensure_loaded (QOF_INSTANCE(acc), since);
+}
+
 gnc_numeric
 xaccAccountGetBalance (const Account *acc)
 {
@@ -3460,18 +3484,26 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
     // scan to find today's split, but we're really interested in the
     // minimum balance
     [[maybe_unused]] auto todays_split = gnc_account_find_split (acc, before_today_end, true);
-    return minimum ? *minimum : gnc_numeric_zero();
+    return minimum ? *minimum : GET_PRIVATE(acc)->starting_balance;
 }
 
 
 /********************************************************************\
 \********************************************************************/
 
+/* A backend may hold back older transactions, counting them in the account's
+ * starting balances instead; it is asked for those posted since date, so that
+ * the starting balances cover no split after date.  Without a split before
+ * date the balance is then the starting one.
+ */
 static gnc_numeric
-GetBalanceAsOfDate (Account *acc, time64 date, std::function<gnc_numeric(Split*)> split_to_numeric)
+GetBalanceAsOfDate (Account *acc, time64 date,
+                    std::function<gnc_numeric(Split*)> split_to_numeric,
+                    gnc_numeric AccountPrivate::*starting_balance)
 {
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
+    gnc_account_ensure_loaded (acc, date);
     xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
@@ -3479,25 +3511,29 @@ GetBalanceAsOfDate (Account *acc, time64 date, std::function<gnc_numeric(Split*)
     { return xaccTransGetDate(xaccSplitGetParent(s)) < date; };
 
     auto latest_split{gnc_account_find_split (acc, is_before_date, true)};
-    return latest_split ? split_to_numeric (latest_split) : gnc_numeric_zero();
+    return latest_split ? split_to_numeric (latest_split)
+        : GET_PRIVATE(acc)->*starting_balance;
 }
 
 gnc_numeric
 xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetBalance);
+    return GetBalanceAsOfDate (acc, date, xaccSplitGetBalance,
+                               &AccountPrivate::starting_balance);
 }
 
 static gnc_numeric
 xaccAccountGetNoclosingBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetNoclosingBalance);
+    return GetBalanceAsOfDate (acc, date, xaccSplitGetNoclosingBalance,
+                               &AccountPrivate::starting_noclosing_balance);
 }
 
 gnc_numeric
 xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetReconciledBalance);
+    return GetBalanceAsOfDate (acc, date, xaccSplitGetReconciledBalance,
+                               &AccountPrivate::starting_reconciled_balance);
 }
 
 /*
@@ -3856,8 +3892,8 @@ xaccAccountBalanceChangeHelper (Account *acc, gpointer data)
     CurrencyBalanceChange *cbdiff = static_cast<CurrencyBalanceChange*>(data);
 
     gnc_numeric b1, b2;
-    b1 = GetBalanceAsOfDate(acc, cbdiff->t1, xaccSplitGetNoclosingBalance);
-    b2 = GetBalanceAsOfDate(acc, cbdiff->t2, xaccSplitGetNoclosingBalance);
+    b1 = xaccAccountGetNoclosingBalanceAsOfDate(acc, cbdiff->t1);
+    b2 = xaccAccountGetNoclosingBalanceAsOfDate(acc, cbdiff->t2);
     gnc_numeric balanceChange = gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
     gnc_numeric balanceChange_conv = xaccAccountConvertBalanceToCurrencyAsOfDate(acc, balanceChange, xaccAccountGetCommodity(acc), cbdiff->currency, cbdiff->t2);
     cbdiff->balanceChange = gnc_numeric_add (cbdiff->balanceChange, balanceChange_conv,
@@ -3872,8 +3908,8 @@ xaccAccountGetNoclosingBalanceChangeInCurrencyForPeriod (Account *acc, time64 t1
     
 
     gnc_numeric b1, b2;
-    b1 = GetBalanceAsOfDate(acc, t1, xaccSplitGetNoclosingBalance);
-    b2 = GetBalanceAsOfDate(acc, t2, xaccSplitGetNoclosingBalance);
+    b1 = xaccAccountGetNoclosingBalanceAsOfDate(acc, t1);
+    b2 = xaccAccountGetNoclosingBalanceAsOfDate(acc, t2);
     gnc_numeric balanceChange = gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
 
     gnc_commodity *report_commodity = xaccAccountGetCommodity(acc);
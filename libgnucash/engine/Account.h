@@ -364,6 +364,23 @@ typedef enum
     void gnc_account_set_start_reconciled_balance (Account *acc,
             const gnc_numeric start_baln);
 
+    /** This function will set the starting commodity balance, excluding
+     *  book closing transactions, for this account.  Like
+     *  gnc_account_set_start_balance() it is intended for use with
+     *  backends that return a partial list of splits. */
+    void gnc_account_set_start_noclosing_balance (Account *acc,
+            const gnc_numeric start_baln);
+
+    /** Ask the book's backend to make sure that the splits in this account
+     *  belonging to transactions posted on or after since are in memory.
+     *  Backends that load every transaction at startup do nothing.  Pass
+     *  the book's root account to include all accounts.
+     *
+     *  @param acc The account whose splits are needed.
+     *
+     *  @param since The earliest posted date needed, INT64_MIN for all. */
+    void gnc_account_ensure_loaded (Account *acc, time64 since);
+
     /** Tell the account that the running balances may be incorrect and
      *  need to be recomputed.
      *
@@ -573,7 +590,9 @@ typedef enum
     gnc_numeric xaccAccountGetReconciledBalance (const Account *account);
     gnc_numeric xaccAccountGetPresentBalance (const Account *account);
     gnc_numeric xaccAccountGetProjectedMinimumBalance (const Account *account);
-    /** Get the balance of the account at the end of the day before the date specified. */
+    /** Get the balance of the account at the end of the day before the date
+     *  specified.  A backend that loads transactions on demand is first
+     *  asked for those posted since the date. */
     gnc_numeric xaccAccountGetBalanceAsOfDate (Account *account,
             time64 date);
 
@@ -210,6 +210,19 @@ public:
  *    better to wait for the query).
  */
     virtual void load (QofBook*, QofBackendLoadType) = 0;
+/**
+ *    Make sure that the transactions posted on or after since with splits in
+ *    the account inst are in memory, for backends that don't load all of
+ *    them at startup. inst may be the book's root account to ask for all
+ *    accounts.
+ */
+    virtual void ensure_loaded(QofInstance*, time64) {}
+/**
+ *    Called by qof_query_run() before it searches the book's objects, so that
+ *    backends which load lazily can first bring in the objects the query
+ *    could match.
+ */
+    virtual void prepare_query(QofQuery*) {}
 /**
  *    Called when the engine is about to make a change to a data structure. It
  *    could provide an advisory lock on data, but no backend does this.
@@ -831,11 +831,11 @@ static GList * qof_query_run_internal (QofQuery *q,
     return matching_objects;
 }
 
+/* cb_arg is non-null to search only the objects already in memory. */
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     GList *node;
 
-    (void)cb_arg; /* unused */
     g_return_if_fail(qcb);
 
     for (node = qcb->query->books; node; node = node->next)
@@ -856,6 +856,8 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
             }
         }
 #endif
+        if (book->backend && !cb_arg)
+            book->backend->prepare_query (qcb->query);
         /* And then iterate over all the objects */
         qof_object_foreach (qcb->query->search_for, book,
                             (QofInstanceForeachCB) check_item_cb, qcb);
@@ -868,6 +870,11 @@ GList * qof_query_run (QofQuery *q)
     return qof_query_run_internal(q, qof_query_run_cb, nullptr);
 }
 
+GList * qof_query_run_loaded (QofQuery *q)
+{
+    return qof_query_run_internal(q, qof_query_run_cb, GINT_TO_POINTER (TRUE));
+}
+
 static void qof_query_run_subq_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     QofQuery* pq = static_cast<QofQuery*>(cb_arg);
@@ -220,6 +220,12 @@ void qof_query_add_boolean_match (QofQuery *q,
  */
 GList * qof_query_run (QofQuery *query);
 
+/** Like qof_query_run(), but searches only the objects already in memory:
+ *  a backend that loads lazily is not asked for the others the query could
+ *  match.  Do NOT free the resulting list.
+ */
+GList * qof_query_run_loaded (QofQuery *query);
+
 /** Return the results of the last query, without causing the query to
  *  be re-run.  Do NOT free the resulting list.  This list is managed
  *  internally by QofQuery.
@@ -0,0 +1,187 @@
+/*
+ * libgnucash/marketplace/analytics.cpp
+ *
+ * Sales rollups for marketplace analytics
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "analytics.hpp"
+
+#include <unordered_map>
+
+namespace gnc {
+namespace marketplace {
+
+SalesCounters& SalesCounters::operator+=(const SalesCounters& other)
+{
+    orders += other.orders;
+    units += other.units;
+    revenue += other.revenue;
+    cancelled += other.cancelled;
+    refunds += other.refunds;
+    refunded += other.refunded;
+    for (size_t i = 0; i < by_status.size(); ++i)
+        by_status[i] += other.by_status[i];
+    return *this;
+}
+
+void AnalyticsManager::record_order(const OrderInfo& order)
+{
+    if (!SalesCounters::counts_status(order.status)) return;
+    auto status = static_cast<size_t>(order.status);
+    apply(order, [&](SalesCounters& counters, const Share& share) {
+        ++counters.orders;
+        counters.units += share.units;
+        counters.revenue += share.amount;
+        ++counters.by_status[status];
+        if (order.status == OrderStatus::CANCELLED)
+            counters.cancelled += share.amount;
+    });
+
+    if (order.seller_id.empty()) return;
+    m_rollups.upsert(seller_key(order.seller_id), [&](Rollup& rollup) {
+        for (const auto& item : order.items)
+            rollup.products.insert(item.product_id);
+    });
+}
+
+void AnalyticsManager::record_status(const OrderInfo& order, OrderStatus status)
+{
+    if (order.status == status) return;
+    if (!SalesCounters::counts_status(order.status) || !SalesCounters::counts_status(status))
+        return;
+    apply(order, [&](SalesCounters& counters, const Share& share) {
+        --counters.by_status[static_cast<size_t>(order.status)];
+        ++counters.by_status[static_cast<size_t>(status)];
+        if (order.status == OrderStatus::CANCELLED)
+            counters.cancelled -= share.amount;
+        if (status == OrderStatus::CANCELLED)
+            counters.cancelled += share.amount;
+    });
+}
+
+void AnalyticsManager::record_refund(const OrderInfo& order, double amount)
+{
+    apply(order, [&](SalesCounters& counters, const Share& share) {
+        double part = 1.0;
+        if (!share.whole)
+            part = order.total_amount > 0 ? share.amount / order.total_amount : 0.0;
+        ++counters.refunds;
+        counters.refunded += amount * part;
+    });
+}
+
+SalesCounters AnalyticsManager::seller_between(const std::string& seller_id,
+                                               const time_point& start,
+                                               const time_point& end) const
+{
+    SalesCounters sum;
+    int64_t first = day_of(start);
+    int64_t last = day_of(end);
+    if (first > last) return sum;
+    m_rollups.visit(seller_key(seller_id), [&](const Rollup& rollup) {
+        for (auto it = rollup.days.lower_bound(first);
+             it != rollup.days.end() && it->first <= last; ++it)
+            sum += it->second;
+    });
+    return sum;
+}
+
+SalesCounters AnalyticsManager::seller_totals(const std::string& seller_id) const
+{
+    return totals(seller_key(seller_id));
+}
+
+SalesCounters AnalyticsManager::customer_totals(const std::string& customer_id) const
+{
+    return totals(customer_key(customer_id));
+}
+
+SalesCounters AnalyticsManager::product_totals(const std::string& product_id) const
+{
+    return totals(product_key(product_id));
+}
+
+std::vector<std::string> AnalyticsManager::seller_products(const std::string& seller_id) const
+{
+    std::vector<std::string> products;
+    m_rollups.visit(seller_key(seller_id), [&](const Rollup& rollup) {
+        products.assign(rollup.products.begin(), rollup.products.end());
+    });
+    return products;
+}
+
+int64_t AnalyticsManager::day_of(const time_point& time)
+{
+    const int64_t seconds_per_day = 24 * 60 * 60;
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+    // Round down, also before the epoch.
+    return seconds >= 0 ? seconds / seconds_per_day
+                        : (seconds - seconds_per_day + 1) / seconds_per_day;
+}
+
+std::vector<AnalyticsManager::Share> AnalyticsManager::shares_of(const OrderInfo& order)
+{
+    int64_t units = 0;
+    std::unordered_map<std::string, Share> products;
+    for (const auto& item : order.items) {
+        double line = item.total_price > 0 ? item.total_price : item.unit_price * item.quantity;
+        auto& share = products.try_emplace(item.product_id,
+                                           Share{product_key(item.product_id), 0.0, 0, false})
+                          .first->second;
+        share.amount += line;
+        share.units += item.quantity;
+        units += item.quantity;
+    }
+
+    std::vector<Share> shares;
+    shares.reserve(products.size() + 3);
+    shares.push_back({seller_key(""), order.total_amount, units, true});
+    if (!order.seller_id.empty())
+        shares.push_back({seller_key(order.seller_id), order.total_amount, units, true});
+    if (!order.customer_id.empty())
+        shares.push_back({customer_key(order.customer_id), order.total_amount, units, true});
+    for (auto& [product_id, share] : products)
+        shares.push_back(std::move(share));
+    return shares;
+}
+
+template<typename Fn>
+void AnalyticsManager::apply(const OrderInfo& order, Fn&& fn)
+{
+    int64_t day = day_of(order.created_at);
+    for (const auto& share : shares_of(order)) {
+        m_rollups.upsert(share.key, [&](Rollup& rollup) {
+            fn(rollup.totals, share);
+            fn(rollup.days[day], share);
+        });
+    }
+}
+
+SalesCounters AnalyticsManager::totals(const std::string& key) const
+{
+    SalesCounters counters;
+    m_rollups.visit(key, [&](const Rollup& rollup) { counters = rollup.totals; });
+    return counters;
+}
+
+std::string AnalyticsManager::seller_key(const std::string& seller_id)
+{
+    // The whole marketplace is filed under the empty key.
+    return seller_id.empty() ? std::string() : "s" + seller_id;
+}
+
+std::string AnalyticsManager::customer_key(const std::string& customer_id)
+{
+    return customer_id.empty() ? std::string() : "c" + customer_id;
+}
+
+std::string AnalyticsManager::product_key(const std::string& product_id)
+{
+    return "p" + product_id;
+}
+
+} // namespace marketplace
+} // namespace gnc
@@ -0,0 +1,149 @@
+/*
+ * libgnucash/marketplace/analytics.hpp
+ *
+ * Sales rollups for marketplace analytics
+ *
+ * Counters are kept per seller, product, customer and for the whole
+ * marketplace, in one bucket per day, and are updated as orders are
+ * placed, change status and are refunded. A report adds up the buckets
+ * of its date range instead of walking the orders, so its cost depends
+ * on the number of days, not the number of orders.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_MARKETPLACE_ANALYTICS_HPP
+#define GNC_MARKETPLACE_ANALYTICS_HPP
+
+#include "marketplace_types.hpp"
+#include "sharded_map.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gnc {
+namespace marketplace {
+
+/**
+ * Sales counters of a seller, product, customer or the marketplace over
+ * some days. Orders are counted on the day they were created, so a
+ * later cancellation or refund changes the counters of that day.
+ */
+struct SalesCounters
+{
+    int64_t orders = 0;         // orders placed
+    int64_t units = 0;          // items ordered
+    double revenue = 0.0;       // amount ordered
+    double cancelled = 0.0;     // amount of the orders now cancelled
+    int64_t refunds = 0;        // refunds issued
+    double refunded = 0.0;      // amount refunded
+    static constexpr size_t STATUS_COUNT = static_cast<size_t>(OrderStatus::REFUNDED) + 1;
+    std::array<int64_t, STATUS_COUNT> by_status{};
+
+    /** Whether status is one of the OrderStatus values counted in by_status. */
+    static bool counts_status(OrderStatus status)
+    {
+        return static_cast<size_t>(status) < STATUS_COUNT;
+    }
+
+    int64_t in_status(OrderStatus status) const
+    {
+        return counts_status(status) ? by_status[static_cast<size_t>(status)] : 0;
+    }
+
+    /** Revenue less what was cancelled or refunded. */
+    double net_revenue() const { return revenue - cancelled - refunded; }
+
+    SalesCounters& operator+=(const SalesCounters& other);
+};
+
+/**
+ * AnalyticsManager - sales rollups fed by order events. Safe to use from
+ * any thread.
+ *
+ * For a product, amounts are its share of each order: its line totals,
+ * and the same fraction of a refund. An empty seller or customer id
+ * names the whole marketplace.
+ */
+class AnalyticsManager
+{
+public:
+    using time_point = std::chrono::system_clock::time_point;
+
+    /**
+     * Count a new order, in the status it was created with. An order
+     * whose status is not an OrderStatus value is not counted.
+     */
+    void record_order(const OrderInfo& order);
+
+    /**
+     * Count order, as it was before the change, moving to status.
+     */
+    void record_status(const OrderInfo& order, OrderStatus status);
+
+    /**
+     * Count a refund of amount against order.
+     */
+    void record_refund(const OrderInfo& order, double amount);
+
+    /**
+     * Counters of a seller's orders created on the days from start to
+     * end; whole days count, in UTC.
+     */
+    SalesCounters seller_between(const std::string& seller_id,
+                                 const time_point& start, const time_point& end) const;
+
+    /** All-time counters of a seller. */
+    SalesCounters seller_totals(const std::string& seller_id) const;
+
+    /** All-time counters of a customer. */
+    SalesCounters customer_totals(const std::string& customer_id) const;
+
+    /** All-time counters of a product. */
+    SalesCounters product_totals(const std::string& product_id) const;
+
+    /** The products a seller has had orders for. */
+    std::vector<std::string> seller_products(const std::string& seller_id) const;
+
+    /** The UTC day of time, as days since the epoch. */
+    static int64_t day_of(const time_point& time);
+
+private:
+    struct Rollup
+    {
+        SalesCounters totals;
+        std::map<int64_t, SalesCounters> days;
+        std::set<std::string> products;     // for sellers only
+    };
+
+    /** A rollup an order counts towards, with its share of the order. */
+    struct Share
+    {
+        std::string key;
+        double amount;
+        int64_t units;
+        bool whole;     // the whole order, not a product's part of it
+    };
+
+    ShardedMap<std::string, Rollup> m_rollups;
+
+    static std::vector<Share> shares_of(const OrderInfo& order);
+    template<typename Fn>
+    void apply(const OrderInfo& order, Fn&& fn);
+    SalesCounters totals(const std::string& key) const;
+
+    static std::string seller_key(const std::string& seller_id);
+    static std::string customer_key(const std::string& customer_id);
+    static std::string product_key(const std::string& product_id);
+};
+
+} // namespace marketplace
+} // namespace gnc
+
+#endif // GNC_MARKETPLACE_ANALYTICS_HPP
@@ -12,7 +12,24 @@
 namespace gnc {
 namespace marketplace {
 
-// Customer management implementation (integrated into marketplace_engine.cpp)
+std::string CustomerManager::save(const CustomerInfo& customer)
+{
+    auto id = customer.id.empty() ? generate_id() : customer.id;
+    CustomerInfo stored = customer;
+    stored.id = id;
+    m_customers.insert_or_assign(id, std::move(stored));
+    return id;
+}
+
+CustomerInfo CustomerManager::get(const std::string& id) const
+{
+    return m_customers.find(id).value_or(CustomerInfo{});
+}
+
+std::string CustomerManager::generate_id()
+{
+    return "CUST-" + std::to_string(m_next_id.fetch_add(1, std::memory_order_relaxed));
+}
 
 } // namespace marketplace
 } // namespace gnc
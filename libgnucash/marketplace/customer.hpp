@@ -11,11 +11,35 @@
 #define GNC_MARKETPLACE_CUSTOMER_HPP
 
 #include "marketplace_types.hpp"
+#include "sharded_map.hpp"
+
+#include <atomic>
+#include <cstdint>
 
 namespace gnc {
 namespace marketplace {
 
-// Customer management functions (currently integrated into MarketplaceEngine)
+/**
+ * CustomerManager - customer profiles. Safe to use from any thread.
+ */
+class CustomerManager
+{
+public:
+    /**
+     * Store a customer, generating an id if it has none. Returns the id.
+     */
+    std::string save(const CustomerInfo& customer);
+
+    CustomerInfo get(const std::string& id) const;
+
+    size_t count() const { return m_customers.size(); }
+
+private:
+    ShardedMap<std::string, CustomerInfo> m_customers;
+    std::atomic<uint64_t> m_next_id{4000};
+
+    std::string generate_id();
+};
 
 } // namespace marketplace
 } // namespace gnc
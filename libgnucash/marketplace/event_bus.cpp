@@ -0,0 +1,168 @@
+/*
+ * libgnucash/marketplace/event_bus.cpp
+ *
+ * Asynchronous delivery of marketplace events
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "event_bus.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace gnc {
+namespace marketplace {
+
+const char* event_name(MarketplaceEventType type)
+{
+    switch (type) {
+    case MarketplaceEventType::MARKETPLACE_INITIALIZED: return "marketplace.initialized";
+    case MarketplaceEventType::MARKETPLACE_SHUTDOWN:    return "marketplace.shutdown";
+    case MarketplaceEventType::PRODUCT_CREATED:         return "product.created";
+    case MarketplaceEventType::PRODUCT_UPDATED:         return "product.updated";
+    case MarketplaceEventType::PRODUCT_DELETED:         return "product.deleted";
+    case MarketplaceEventType::ORDER_CREATED:           return "order.created";
+    case MarketplaceEventType::ORDER_STATUS_CHANGED:    return "order.status_changed";
+    case MarketplaceEventType::ORDER_PAYMENT_PROCESSED: return "order.payment_processed";
+    case MarketplaceEventType::ORDER_CANCELLED:         return "order.cancelled";
+    case MarketplaceEventType::ORDER_REFUNDED:          return "order.refunded";
+    case MarketplaceEventType::STOREFRONT_SAVED:        return "storefront.saved";
+    }
+    return "";
+}
+
+EventBus::EventBus(size_t threads)
+    : m_pool(std::max<size_t>(threads, 1))
+{
+}
+
+EventBus::~EventBus()
+{
+    flush();
+}
+
+uint64_t EventBus::subscribe(Handler handler, const EventSubscriberOptions& options)
+{
+    if (!handler || options.capacity == 0 || options.max_batch == 0 || options.lanes == 0)
+        return 0;
+
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->handler = std::move(handler);
+    subscriber->options = options;
+    for (size_t i = 0; i < options.lanes; ++i)
+        subscriber->lanes.push_back(std::make_unique<Lane>(options.capacity));
+
+    std::unique_lock<std::shared_mutex> lock(m_subscribers_mutex);
+    if (m_lanes + options.lanes > MAX_LANES) return 0;
+    m_lanes += options.lanes;
+    subscriber->id = m_next_id++;
+    m_subscribers.push_back(subscriber);
+    m_subscriber_count = m_subscribers.size();
+    return subscriber->id;
+}
+
+bool EventBus::unsubscribe(uint64_t id)
+{
+    std::unique_lock<std::shared_mutex> lock(m_subscribers_mutex);
+    auto it = std::find_if(m_subscribers.begin(), m_subscribers.end(),
+                           [id](const auto& subscriber) { return subscriber->id == id; });
+    if (it == m_subscribers.end()) return false;
+    (*it)->active = false;
+    m_lanes -= (*it)->lanes.size();
+    m_subscribers.erase(it);
+    m_subscriber_count = m_subscribers.size();
+    return true;
+}
+
+void EventBus::publish(MarketplaceEvent event)
+{
+    std::shared_lock<std::shared_mutex> lock(m_subscribers_mutex);
+    size_t hash = m_subscribers.empty() ? 0 : std::hash<std::string>{}(event.subject_id);
+    for (size_t i = 0; i < m_subscribers.size(); ++i) {
+        const auto& subscriber = m_subscribers[i];
+        auto& lane = *subscriber->lanes[hash % subscriber->lanes.size()];
+        bool last = i + 1 == m_subscribers.size();
+
+        // Counted first, so the event cannot be settled before it is
+        // published.
+        m_published.fetch_add(1);
+        for (;;) {
+            bool pushed = last ? lane.queue.try_push(std::move(event)) : lane.queue.try_push(event);
+            if (pushed) {
+                schedule(subscriber, lane);
+                break;
+            }
+            if (subscriber->options.overflow == EventOverflow::DROP) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                settle(1);
+                break;
+            }
+            // Full: the lane is scheduled, so wait for its drain.
+            std::this_thread::yield();
+        }
+    }
+}
+
+void EventBus::flush()
+{
+    std::unique_lock<std::mutex> lock(m_idle_mutex);
+    m_idle.wait(lock, [this] {
+        // Settled never passes published, so reading it first cannot
+        // see the two meet while an event is pending.
+        uint64_t settled = m_settled.load();
+        return settled == m_published.load();
+    });
+}
+
+void EventBus::schedule(const std::shared_ptr<Subscriber>& subscriber, Lane& lane)
+{
+    // Pairs with the fence in drain(): either the drain sees this event
+    // or this sees the drain's scheduled flag cleared.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!lane.scheduled.exchange(true))
+        m_pool.post([this, subscriber, &lane] { drain(subscriber, lane); });
+}
+
+void EventBus::drain(const std::shared_ptr<Subscriber>& subscriber, Lane& lane)
+{
+    // One batch per task, so lanes with a backlog take turns on the
+    // dispatchers.
+    std::vector<MarketplaceEvent> batch;
+    batch.reserve(std::min<size_t>(subscriber->options.max_batch, 64));
+    MarketplaceEvent event;
+    while (batch.size() < subscriber->options.max_batch && lane.queue.try_pop(event))
+        batch.push_back(std::move(event));
+
+    if (!batch.empty()) {
+        if (subscriber->active) {
+            try {
+                subscriber->handler(batch);
+            } catch (...) {
+                // A failing subscriber must not stop delivery to the others.
+            }
+        }
+        settle(batch.size());
+    }
+
+    if (batch.size() == subscriber->options.max_batch) {
+        m_pool.post([this, subscriber, &lane] { drain(subscriber, lane); });
+        return;
+    }
+    lane.scheduled.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!lane.queue.empty() && !lane.scheduled.exchange(true))
+        m_pool.post([this, subscriber, &lane] { drain(subscriber, lane); });
+}
+
+void EventBus::settle(uint64_t count)
+{
+    if (m_settled.fetch_add(count) + count == m_published.load()) {
+        std::lock_guard<std::mutex> lock(m_idle_mutex);
+        m_idle.notify_all();
+    }
+}
+
+} // namespace marketplace
+} // namespace gnc
@@ -0,0 +1,205 @@
+/*
+ * libgnucash/marketplace/event_bus.hpp
+ *
+ * Asynchronous delivery of marketplace events
+ *
+ * Publishing an event copies it into a bounded lock-free queue per
+ * subscriber and returns; a small thread pool hands the queued events to
+ * each subscriber in batches. A slow subscriber therefore delays only
+ * its own events, until its queue fills and backpressure applies.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_MARKETPLACE_EVENT_BUS_HPP
+#define GNC_MARKETPLACE_EVENT_BUS_HPP
+
+#include "marketplace_types.hpp"
+#include "../opencog/cogutil/mpmc_queue.hpp"
+#include "../opencog/cogutil/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace gnc {
+namespace marketplace {
+
+/**
+ * Kinds of marketplace event.
+ */
+enum class MarketplaceEventType
+{
+    MARKETPLACE_INITIALIZED,
+    MARKETPLACE_SHUTDOWN,
+    PRODUCT_CREATED,
+    PRODUCT_UPDATED,
+    PRODUCT_DELETED,
+    ORDER_CREATED,
+    ORDER_STATUS_CHANGED,
+    ORDER_PAYMENT_PROCESSED,
+    ORDER_CANCELLED,
+    ORDER_REFUNDED,
+    STOREFRONT_SAVED
+};
+
+/**
+ * The dotted name of an event type, such as "order.created".
+ */
+const char* event_name(MarketplaceEventType type);
+
+/**
+ * A marketplace event.
+ */
+struct MarketplaceEvent
+{
+    MarketplaceEventType type = MarketplaceEventType::MARKETPLACE_INITIALIZED;
+    std::string subject_id;     // product, order or storefront id
+    OrderStatus order_status = OrderStatus::PENDING;    // order events: status after it
+    double amount = 0.0;        // order events: the order total, or the refund
+    std::chrono::system_clock::time_point time;
+};
+
+/**
+ * What publishing does when a subscriber's queue is full.
+ */
+enum class EventOverflow
+{
+    BLOCK,      // wait for the subscriber to catch up
+    DROP        // discard the event for this subscriber
+};
+
+/**
+ * How events are queued for and handed to one subscriber.
+ */
+struct EventSubscriberOptions
+{
+    size_t capacity = 1024;     // events queued per lane before overflow applies
+    size_t max_batch = 64;      // most events per handler call
+    size_t lanes = 1;           // queues handled in parallel
+    EventOverflow overflow = EventOverflow::BLOCK;
+};
+
+/**
+ * EventBus - publishes events to subscribers asynchronously. Safe to
+ * use from any thread.
+ *
+ * Events for one subject always go to the same lane of a subscriber, and
+ * a lane's events are handled one batch at a time in the order they were
+ * published, so a subscriber sees the events of each order in order.
+ * With more than one lane its handler runs on several threads at once.
+ *
+ * Handlers run on the bus's threads. A handler that publishes, directly
+ * or by changing the marketplace, must not do so to a BLOCK subscriber
+ * whose queue may be full, and must not call flush() or unsubscribe().
+ */
+class EventBus
+{
+public:
+    using Handler = std::function<void(const std::vector<MarketplaceEvent>& events)>;
+
+    /** Lanes over all subscribers, so that scheduling one never blocks. */
+    static constexpr size_t MAX_LANES = opencog::ThreadPool::QUEUE_CAPACITY;
+
+    /**
+     * Start the given number of dispatcher threads.
+     */
+    explicit EventBus(size_t threads = 2);
+
+    /**
+     * Deliver every queued event, then stop the dispatchers.
+     */
+    ~EventBus();
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    /**
+     * Add a subscriber. Returns its id, or 0 if the options are invalid
+     * or the bus has MAX_LANES lanes already.
+     */
+    uint64_t subscribe(Handler handler, const EventSubscriberOptions& options = {});
+
+    /**
+     * Remove a subscriber; its queued events are discarded. A batch
+     * being handled may still finish after this returns. Returns false
+     * if there is no such subscriber.
+     */
+    bool unsubscribe(uint64_t id);
+
+    /**
+     * Queue event for every subscriber.
+     */
+    void publish(MarketplaceEvent event);
+
+    /**
+     * Wait until every event published so far has been handled or
+     * dropped.
+     */
+    void flush();
+
+    /**
+     * True if anyone is subscribed, so publishers can skip building
+     * events nobody will see.
+     */
+    bool has_subscribers() const { return m_subscriber_count.load(std::memory_order_relaxed) > 0; }
+
+    /**
+     * Number of events discarded by DROP subscribers.
+     */
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Lane
+    {
+        explicit Lane(size_t capacity)
+            : queue(capacity)
+        {}
+
+        opencog::MpmcQueue<MarketplaceEvent> queue;
+        std::atomic<bool> scheduled{false};     // a drain is posted or running
+    };
+
+    struct Subscriber
+    {
+        uint64_t id = 0;
+        Handler handler;
+        EventSubscriberOptions options;
+        std::vector<std::unique_ptr<Lane>> lanes;
+        std::atomic<bool> active{true};
+    };
+
+    mutable std::shared_mutex m_subscribers_mutex;
+    std::vector<std::shared_ptr<Subscriber>> m_subscribers;
+    std::atomic<size_t> m_subscriber_count{0};
+    size_t m_lanes = 0;
+    uint64_t m_next_id = 1;
+
+    // Every queued event is counted as published, and as settled once it
+    // has been handled or discarded; flush() waits for the two to meet.
+    std::atomic<uint64_t> m_published{0};
+    std::atomic<uint64_t> m_settled{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::mutex m_idle_mutex;
+    std::condition_variable m_idle;
+
+    // Last, so the dispatchers stop before the rest is destroyed.
+    opencog::ThreadPool m_pool;
+
+    void schedule(const std::shared_ptr<Subscriber>& subscriber, Lane& lane);
+    void drain(const std::shared_ptr<Subscriber>& subscriber, Lane& lane);
+    void settle(uint64_t count);
+};
+
+} // namespace marketplace
+} // namespace gnc
+
+#endif // GNC_MARKETPLACE_EVENT_BUS_HPP
@@ -9,10 +9,93 @@
 
 #include "inventory.hpp"
 
+#include <map>
+
 namespace gnc {
 namespace marketplace {
 
-// Inventory management implementation (integrated into marketplace_engine.cpp)
+bool InventoryManager::update(const std::string& product_id,
+                              const std::string& variant_id,
+                              int quantity_change)
+{
+    m_inventory.upsert(key(product_id, variant_id), [&](InventoryItem& item) {
+        item.product_id = product_id;
+        item.variant_id = variant_id;
+        item.quantity_available += quantity_change;
+        item.last_stock_check = std::chrono::system_clock::now();
+    });
+    return true;
+}
+
+InventoryItem InventoryManager::get(const std::string& product_id,
+                                    const std::string& variant_id) const
+{
+    return m_inventory.find(key(product_id, variant_id)).value_or(InventoryItem{});
+}
+
+bool InventoryManager::check_available(const std::string& product_id,
+                                       const std::string& variant_id,
+                                       int quantity) const
+{
+    int available = 0;
+    m_inventory.visit(key(product_id, variant_id), [&](const InventoryItem& item) {
+        available = item.quantity_available;
+    });
+    return available >= quantity;
+}
+
+bool InventoryManager::reserve(const std::vector<OrderItem>& items)
+{
+    // An order may list the same product twice; check the total.
+    std::map<std::string, int> wanted;
+    for (const auto& item : items) {
+        if (item.quantity < 0) return false;
+        wanted[key(item.product_id, item.variant_id)] += item.quantity;
+    }
+
+    std::vector<std::string> keys;
+    keys.reserve(wanted.size());
+    for (const auto& [k, quantity] : wanted)
+        keys.push_back(k);
+
+    return m_inventory.update_all(keys, [&](std::vector<InventoryItem*>& stock) {
+        auto quantity = wanted.begin();
+        for (auto* item : stock) {
+            int available = item ? item->quantity_available : 0;
+            if (available < quantity->second) return false;
+            ++quantity;
+        }
+
+        auto now = std::chrono::system_clock::now();
+        quantity = wanted.begin();
+        for (auto* item : stock) {
+            // Only a zero quantity can have no entry here.
+            if (item) {
+                item->quantity_available -= quantity->second;
+                item->last_stock_check = now;
+            }
+            ++quantity;
+        }
+        return true;
+    });
+}
+
+void InventoryManager::release(const std::vector<OrderItem>& items)
+{
+    for (const auto& item : items)
+        update(item.product_id, item.variant_id, item.quantity);
+}
+
+std::vector<InventoryItem> InventoryManager::get_low_stock() const
+{
+    std::vector<InventoryItem> results;
+    m_inventory.for_each([&](const std::string&, const InventoryItem& item) {
+        if (item.quantity_available <= item.reorder_level) {
+            results.push_back(item);
+        }
+    });
+    return results;
+}
 
 } // namespace marketplace
 } // namespace gnc
@@ -11,11 +11,62 @@
 #define GNC_MARKETPLACE_INVENTORY_HPP
 
 #include "marketplace_types.hpp"
+#include "sharded_map.hpp"
 
 namespace gnc {
 namespace marketplace {
 
-// Inventory management functions (currently integrated into MarketplaceEngine)
+/**
+ * InventoryManager - stock levels per product and variant. Safe to use
+ * from any thread.
+ */
+class InventoryManager
+{
+public:
+    /**
+     * Add quantity_change (which may be negative) to the stock available,
+     * creating the entry if needed. Always succeeds.
+     */
+    bool update(const std::string& product_id,
+                const std::string& variant_id,
+                int quantity_change);
+
+    /**
+     * The stock entry, or an empty InventoryItem if there is none.
+     */
+    InventoryItem get(const std::string& product_id,
+                      const std::string& variant_id) const;
+
+    bool check_available(const std::string& product_id,
+                         const std::string& variant_id,
+                         int quantity) const;
+
+    /**
+     * Take the stock for every item of an order, or none of it.
+     *
+     * Fails without changing anything if an item has a negative quantity
+     * or the stock of any product and variant, summed over the items,
+     * is short. The check and the decrement happen under the same locks,
+     * so concurrent orders can never sell more than is available.
+     */
+    bool reserve(const std::vector<OrderItem>& items);
+
+    /**
+     * Return the stock taken by reserve() for these items.
+     */
+    void release(const std::vector<OrderItem>& items);
+
+    std::vector<InventoryItem> get_low_stock() const;
+
+private:
+    ShardedMap<std::string, InventoryItem> m_inventory;
+
+    // The length prefix keeps ("a:b", "") and ("a", "b") apart.
+    static std::string key(const std::string& product_id, const std::string& variant_id)
+    {
+        return std::to_string(product_id.size()) + ":" + product_id + variant_id;
+    }
+};
 
 } // namespace marketplace
 } // namespace gnc
@@ -9,237 +9,37 @@
 
 #include "marketplace_engine.hpp"
 #include "../opencog/gnc-cognitive/cognitive_engine.hpp"
-#include <random>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
 namespace gnc {
 namespace marketplace {
 
-// Helper class implementations
-class ProductManager
-{
-public:
-    std::string create(const ProductInfo& product) {
-        auto id = generate_id();
-        m_products[id] = product;
-        m_products[id].id = id;
-        return id;
-    }
-
-    bool update(const std::string& id, const ProductInfo& product) {
-        if (m_products.find(id) == m_products.end()) return false;
-        m_products[id] = product;
-        return true;
-    }
-
-    ProductInfo get(const std::string& id) const {
-        auto it = m_products.find(id);
-        return (it != m_products.end()) ? it->second : ProductInfo{};
-    }
-
-    std::vector<ProductInfo> list(const std::string& seller_id, 
-                                 const std::string& category_id,
-                                 ProductStatus status) const {
-        std::vector<ProductInfo> results;
-        for (const auto& [id, product] : m_products) {
-            bool matches = true;
-            if (!seller_id.empty() && product.seller_id != seller_id) matches = false;
-            if (!category_id.empty() && product.category_id != category_id) matches = false;
-            if (product.status != status) matches = false;
-            if (matches) results.push_back(product);
-        }
-        return results;
-    }
-
-    std::vector<ProductInfo> search(const std::string& query) const {
-        std::vector<ProductInfo> results;
-        for (const auto& [id, product] : m_products) {
-            if (product.name.find(query) != std::string::npos ||
-                product.description.find(query) != std::string::npos) {
-                results.push_back(product);
-            }
-        }
-        return results;
-    }
-
-private:
-    std::map<std::string, ProductInfo> m_products;
-    
-    std::string generate_id() const {
-        static int counter = 1000;
-        return "PROD-" + std::to_string(counter++);
-    }
-};
-
-class OrderManager
-{
-public:
-    std::string create(const OrderInfo& order) {
-        auto id = generate_id();
-        m_orders[id] = order;
-        m_orders[id].id = id;
-        return id;
-    }
-
-    bool update_status(const std::string& id, OrderStatus status) {
-        auto it = m_orders.find(id);
-        if (it == m_orders.end()) return false;
-        it->second.status = status;
-        it->second.updated_at = std::chrono::system_clock::now();
-        return true;
-    }
-
-    OrderInfo get(const std::string& id) const {
-        auto it = m_orders.find(id);
-        return (it != m_orders.end()) ? it->second : OrderInfo{};
-    }
-
-    std::vector<OrderInfo> list(const std::string& customer_id,
-                               const std::string& seller_id,
-                               OrderStatus status) const {
-        std::vector<OrderInfo> results;
-        for (const auto& [id, order] : m_orders) {
-            bool matches = true;
-            if (!customer_id.empty() && order.customer_id != customer_id) matches = false;
-            if (!seller_id.empty() && order.seller_id != seller_id) matches = false;
-            if (order.status != status && status != OrderStatus::PENDING) matches = false;
-            if (matches) results.push_back(order);
-        }
-        return results;
-    }
-
-private:
-    std::map<std::string, OrderInfo> m_orders;
-    
-    std::string generate_id() const {
-        static int counter = 2000;
-        return "ORDER-" + std::to_string(counter++);
-    }
-};
-
-class StorefrontManager
-{
-public:
-    std::string save(const StorefrontInfo& storefront) {
-        auto id = storefront.id.empty() ? generate_id() : storefront.id;
-        m_storefronts[id] = storefront;
-        m_storefronts[id].id = id;
-        return id;
-    }
-
-    StorefrontInfo get(const std::string& id) const {
-        auto it = m_storefronts.find(id);
-        return (it != m_storefronts.end()) ? it->second : StorefrontInfo{};
-    }
-
-    StorefrontInfo get_by_seller(const std::string& seller_id) const {
-        for (const auto& [id, store] : m_storefronts) {
-            if (store.seller_id == seller_id) return store;
-        }
-        return StorefrontInfo{};
-    }
-
-    std::vector<StorefrontInfo> list() const {
-        std::vector<StorefrontInfo> results;
-        for (const auto& [id, store] : m_storefronts) {
-            results.push_back(store);
-        }
-        return results;
-    }
-
-private:
-    std::map<std::string, StorefrontInfo> m_storefronts;
-    
-    std::string generate_id() const {
-        static int counter = 3000;
-        return "STORE-" + std::to_string(counter++);
-    }
-};
-
-class InventoryManager
-{
-public:
-    bool update(const std::string& product_id, 
-               const std::string& variant_id,
-               int quantity_change) {
-        auto key = product_id + (variant_id.empty() ? "" : ":" + variant_id);
-        m_inventory[key].quantity_available += quantity_change;
-        m_inventory[key].last_stock_check = std::chrono::system_clock::now();
-        return true;
-    }
-
-    InventoryItem get(const std::string& product_id,
-                     const std::string& variant_id) const {
-        auto key = product_id + (variant_id.empty() ? "" : ":" + variant_id);
-        auto it = m_inventory.find(key);
-        return (it != m_inventory.end()) ? it->second : InventoryItem{};
-    }
-
-    bool check_available(const std::string& product_id,
-                        const std::string& variant_id,
-                        int quantity) const {
-        auto item = get(product_id, variant_id);
-        return item.quantity_available >= quantity;
-    }
-
-    std::vector<InventoryItem> get_low_stock() const {
-        std::vector<InventoryItem> results;
-        for (const auto& [key, item] : m_inventory) {
-            if (item.quantity_available <= item.reorder_level) {
-                results.push_back(item);
-            }
-        }
-        return results;
-    }
-
-private:
-    std::map<std::string, InventoryItem> m_inventory;
-};
-
-class CustomerManager
-{
-public:
-    std::string save(const CustomerInfo& customer) {
-        auto id = customer.id.empty() ? generate_id() : customer.id;
-        m_customers[id] = customer;
-        m_customers[id].id = id;
-        return id;
-    }
-
-    CustomerInfo get(const std::string& id) const {
-        auto it = m_customers.find(id);
-        return (it != m_customers.end()) ? it->second : CustomerInfo{};
-    }
-
-private:
-    std::map<std::string, CustomerInfo> m_customers;
-    
-    std::string generate_id() const {
-        static int counter = 4000;
-        return "CUST-" + std::to_string(counter++);
-    }
-};
-
 // MarketplaceEngine implementation
 
 MarketplaceEngine::MarketplaceEngine()
     : m_initialized(false)
+    , m_next_id(1)
     , m_product_manager(std::make_unique<ProductManager>())
     , m_order_manager(std::make_unique<OrderManager>())
     , m_storefront_manager(std::make_unique<StorefrontManager>())
     , m_inventory_manager(std::make_unique<InventoryManager>())
     , m_customer_manager(std::make_unique<CustomerManager>())
+    , m_analytics_manager(std::make_unique<AnalyticsManager>())
+    , m_event_bus(std::make_unique<EventBus>())
 {
 }
 
 MarketplaceEngine::~MarketplaceEngine()
 {
     shutdown();
+    m_event_bus.reset();    // delivers what is queued
 }
 
 bool MarketplaceEngine::initialize()
 {
+    std::lock_guard<std::mutex> lock(m_state_mutex);
     if (m_initialized) return true;
     
     // Initialize OpenCog cognitive engine for AI features
@@ -249,15 +49,16 @@ bool MarketplaceEngine::initialize()
     }
     
     m_initialized = true;
-    notify_event("marketplace.initialized", "{}");
+    notify_event(MarketplaceEventType::MARKETPLACE_INITIALIZED);
     return true;
 }
 
 void MarketplaceEngine::shutdown()
 {
+    std::lock_guard<std::mutex> lock(m_state_mutex);
     if (!m_initialized) return;
     m_initialized = false;
-    notify_event("marketplace.shutdown", "{}");
+    notify_event(MarketplaceEventType::MARKETPLACE_SHUTDOWN);
 }
 
 // Product Management
@@ -269,7 +70,7 @@ std::string MarketplaceEngine::create_product(const ProductInfo& product)
     // Initialize inventory
     m_inventory_manager->update(id, "", product.stock_quantity);
     
-    notify_event("product.created", id);
+    notify_event(MarketplaceEventType::PRODUCT_CREATED, id);
     return id;
 }
 
@@ -277,20 +78,18 @@ bool MarketplaceEngine::update_product(const std::string& product_id, const Prod
 {
     bool success = m_product_manager->update(product_id, product);
     if (success) {
-        notify_event("product.updated", product_id);
+        notify_event(MarketplaceEventType::PRODUCT_UPDATED, product_id);
     }
     return success;
 }
 
 bool MarketplaceEngine::delete_product(const std::string& product_id)
 {
-    auto product = m_product_manager->get(product_id);
-    if (product.id.empty()) return false;
-    
-    product.status = ProductStatus::ARCHIVED;
-    bool success = m_product_manager->update(product_id, product);
+    bool success = m_product_manager->modify(product_id, [](ProductInfo& product) {
+        product.status = ProductStatus::ARCHIVED;
+    });
     if (success) {
-        notify_event("product.deleted", product_id);
+        notify_event(MarketplaceEventType::PRODUCT_DELETED, product_id);
     }
     return success;
 }
@@ -306,66 +105,96 @@ std::vector<ProductInfo> MarketplaceEngine::list_products(
     ProductStatus status,
     int limit, int offset) const
 {
-    auto products = m_product_manager->list(seller_id, category_id, status);
-    
-    // Apply pagination
-    if (offset >= static_cast<int>(products.size())) return {};
-    auto start = products.begin() + offset;
-    auto end = (offset + limit < static_cast<int>(products.size())) 
-               ? start + limit : products.end();
+    if (limit <= 0 || offset < 0) return {};
     
-    return std::vector<ProductInfo>(start, end);
+    // Only the requested page is copied
+    auto page = m_product_manager->slice(seller_id, category_id, status,
+                                         static_cast<size_t>(offset),
+                                         static_cast<size_t>(limit));
+    std::vector<ProductInfo> products;
+    products.reserve(page.size());
+    for (const auto& product : page) {
+        products.push_back(*product);
+    }
+    return products;
+}
+
+Page<ProductInfo> MarketplaceEngine::query_products(const std::string& seller_id,
+                                                    const std::string& category_id,
+                                                    ProductStatus status,
+                                                    size_t limit,
+                                                    const std::string& cursor) const
+{
+    return m_product_manager->page(seller_id, category_id, status, limit, cursor);
 }
 
 std::vector<ProductInfo> MarketplaceEngine::search_products(
     const std::string& query,
     const std::string& category_id,
     double min_price,
-    double max_price) const
+    double max_price,
+    int limit) const
 {
-    auto products = m_product_manager->search(query);
+    if (limit <= 0) return {};
     
-    // Apply filters
-    std::vector<ProductInfo> filtered;
-    for (const auto& product : products) {
-        bool matches = true;
-        if (!category_id.empty() && product.category_id != category_id) matches = false;
-        if (min_price > 0 && product.base_price < min_price) matches = false;
-        if (max_price > 0 && product.base_price > max_price) matches = false;
-        if (matches) filtered.push_back(product);
+    // Category and price filters are applied inside the index
+    auto matches = m_product_manager->search(query, category_id, min_price, max_price,
+                                             static_cast<size_t>(limit));
+    std::vector<ProductInfo> products;
+    products.reserve(matches.size());
+    for (const auto& product : matches) {
+        products.push_back(*product);
     }
-    
-    return filtered;
+    return products;
 }
 
 // Order Management
 
 std::string MarketplaceEngine::create_order(const OrderInfo& order)
 {
-    // Check inventory availability
-    for (const auto& item : order.items) {
-        if (!m_inventory_manager->check_available(item.product_id, item.variant_id, item.quantity)) {
-            return "";  // Out of stock
-        }
-    }
-    
-    auto id = m_order_manager->create(order);
-    
-    // Reserve inventory
-    for (const auto& item : order.items) {
-        m_inventory_manager->update(item.product_id, item.variant_id, -item.quantity);
+    if (!SalesCounters::counts_status(order.status))
+        return "";
+
+    // Take the stock for every item at once, or fail
+    if (!m_inventory_manager->reserve(order.items)) {
+        return "";  // Out of stock
     }
     
-    notify_event("order.created", id);
+    // Published under the order's lock, ahead of any change to it
+    auto id = m_order_manager->create(order, [this](const OrderInfo& created) {
+        notify_order_event(MarketplaceEventType::ORDER_CREATED, created.id, created.status,
+                           created.total_amount);
+    });
+    m_analytics_manager->record_order(order);
     return id;
 }
 
 bool MarketplaceEngine::update_order_status(const std::string& order_id, OrderStatus status)
 {
-    bool success = m_order_manager->update_status(order_id, status);
-    if (success) {
-        notify_event("order.status_changed", order_id);
-    }
+    if (!SalesCounters::counts_status(status))
+        return false;
+    if (status == OrderStatus::CANCELLED)
+        return cancel_order(order_id, "");
+    if (status == OrderStatus::REFUNDED)
+        return refund_order(order_id, m_order_manager->get(order_id).total_amount);
+
+    // Reopening a cancelled order takes its stock again, or fails. The
+    // status is checked again under the order's lock; if it changed in
+    // between, the stock goes back.
+    auto current = m_order_manager->get(order_id);
+    bool reopening = current.status == OrderStatus::CANCELLED;
+    if (reopening && !m_inventory_manager->reserve(current.items))
+        return false;
+
+    bool success = modify_order(order_id, [&](OrderInfo& order) {
+        if ((order.status == OrderStatus::CANCELLED) != reopening ||
+            order.status == OrderStatus::REFUNDED)
+            return false;
+        order.status = status;
+        return true;
+    });
+    if (!success && reopening)
+        m_inventory_manager->release(current.items);
     return success;
 }
 
@@ -382,47 +211,70 @@ std::vector<OrderInfo> MarketplaceEngine::list_orders(
     return m_order_manager->list(customer_id, seller_id, status);
 }
 
+Page<OrderInfo> MarketplaceEngine::query_orders(const std::string& customer_id,
+                                                const std::string& seller_id,
+                                                OrderStatus status,
+                                                size_t limit,
+                                                const std::string& cursor) const
+{
+    return m_order_manager->page(customer_id, seller_id, status, limit, cursor);
+}
+
 bool MarketplaceEngine::process_payment(const std::string& order_id,
                                        PaymentMethod method,
                                        const std::string& transaction_id)
 {
-    auto order = m_order_manager->get(order_id);
-    if (order.id.empty()) return false;
-    
-    order.payment_method = method;
-    order.payment_transaction_id = transaction_id;
-    order.payment_date = std::chrono::system_clock::now();
-    
-    bool success = update_order_status(order_id, OrderStatus::PAID);
-    if (success) {
-        notify_event("order.payment_processed", order_id);
-    }
-    return success;
+    // Only a pending order can be paid: a cancelled one has given its
+    // stock back, and a refunded one must not become refundable again.
+    return modify_order(order_id, [&](OrderInfo& order) {
+        if (order.status != OrderStatus::PENDING)
+            return false;
+        order.payment_method = method;
+        order.payment_transaction_id = transaction_id;
+        order.payment_date = std::chrono::system_clock::now();
+        order.status = OrderStatus::PAID;
+        return true;
+    }, nullptr, MarketplaceEventType::ORDER_PAYMENT_PROCESSED);
 }
 
 bool MarketplaceEngine::cancel_order(const std::string& order_id, const std::string& reason)
 {
-    auto order = m_order_manager->get(order_id);
-    if (order.id.empty()) return false;
-    
-    // Restore inventory
-    for (const auto& item : order.items) {
-        m_inventory_manager->update(item.product_id, item.variant_id, item.quantity);
-    }
-    
-    bool success = update_order_status(order_id, OrderStatus::CANCELLED);
-    if (success) {
-        notify_event("order.cancelled", order_id);
-    }
+    // Only the call that moves the order to CANCELLED restores its
+    // stock, so cancelling twice cannot put it back twice.
+    OrderInfo before;
+    bool success = modify_order(order_id, [&](OrderInfo& order) {
+        if (order.status == OrderStatus::CANCELLED || order.status == OrderStatus::REFUNDED)
+            return false;
+        order.status = OrderStatus::CANCELLED;
+        return true;
+    }, &before, MarketplaceEventType::ORDER_CANCELLED);
+    if (success)
+        m_inventory_manager->release(before.items);
     return success;
 }
 
 bool MarketplaceEngine::refund_order(const std::string& order_id, double amount)
 {
-    bool success = update_order_status(order_id, OrderStatus::REFUNDED);
-    if (success) {
-        notify_event("order.refunded", order_id);
-    }
+    // Only a paid order can be refunded, once, and by no more than it
+    // cost; the checks and the change of status are made together.
+    OrderInfo before;
+    bool success = modify_order(order_id, [amount](OrderInfo& order) {
+        switch (order.status) {
+            case OrderStatus::PAID:
+            case OrderStatus::PROCESSING:
+            case OrderStatus::SHIPPED:
+            case OrderStatus::DELIVERED:
+                break;
+            default:
+                return false;
+        }
+        if (!(amount > 0.0 && amount <= order.total_amount))
+            return false;
+        order.status = OrderStatus::REFUNDED;
+        return true;
+    }, &before, MarketplaceEventType::ORDER_REFUNDED, amount);
+    if (success)
+        m_analytics_manager->record_refund(before, amount);
     return success;
 }
 
@@ -475,7 +327,7 @@ std::vector<OrderInfo> MarketplaceEngine::get_customer_orders(const std::string&
 std::string MarketplaceEngine::save_storefront(const StorefrontInfo& storefront)
 {
     auto id = m_storefront_manager->save(storefront);
-    notify_event("storefront.saved", id);
+    notify_event(MarketplaceEventType::STOREFRONT_SAVED, id);
     return id;
 }
 
@@ -504,6 +356,26 @@ std::vector<StorefrontInfo> MarketplaceEngine::list_storefronts(int limit, int o
 
 // Analytics & Reporting
 
+namespace {
+
+/**
+ * The counters every analytics entry reports.
+ */
+void add_sales(AnalyticsData& analytics, const SalesCounters& sales)
+{
+    analytics.metrics["total_revenue"] = sales.revenue;
+    analytics.metrics["average_order_value"] = sales.orders > 0 ? sales.revenue / sales.orders : 0.0;
+    analytics.metrics["cancelled_amount"] = sales.cancelled;
+    analytics.metrics["refunded_amount"] = sales.refunded;
+    analytics.metrics["net_revenue"] = sales.net_revenue();
+    analytics.counts["total_orders"] = static_cast<int>(sales.orders);
+    analytics.counts["units_sold"] = static_cast<int>(sales.units);
+    analytics.counts["cancelled_orders"] = static_cast<int>(sales.in_status(OrderStatus::CANCELLED));
+    analytics.counts["refunded_orders"] = static_cast<int>(sales.in_status(OrderStatus::REFUNDED));
+}
+
+} // namespace
+
 AnalyticsData MarketplaceEngine::get_sales_analytics(
     const std::string& seller_id,
     const std::chrono::system_clock::time_point& start_date,
@@ -512,46 +384,47 @@ AnalyticsData MarketplaceEngine::get_sales_analytics(
     AnalyticsData analytics;
     analytics.timestamp = std::chrono::system_clock::now();
     
-    auto orders = list_orders("", seller_id, OrderStatus::PENDING);
-    
-    double total_revenue = 0.0;
-    int total_orders = 0;
-    
-    for (const auto& order : orders) {
-        if (order.created_at >= start_date && order.created_at <= end_date) {
-            total_revenue += order.total_amount;
-            total_orders++;
-        }
+    // Adds up the seller's daily counters in the range
+    add_sales(analytics, m_analytics_manager->seller_between(seller_id, start_date, end_date));
+    if (!seller_id.empty()) {
+        analytics.dimensions["seller_id"] = seller_id;
     }
     
-    analytics.metrics["total_revenue"] = total_revenue;
-    analytics.metrics["average_order_value"] = total_orders > 0 ? total_revenue / total_orders : 0.0;
-    analytics.counts["total_orders"] = total_orders;
-    
     return analytics;
 }
 
 std::vector<AnalyticsData> MarketplaceEngine::get_product_performance(const std::string& seller_id) const
 {
-    // Placeholder implementation
-    return {};
+    std::vector<AnalyticsData> performance;
+    auto now = std::chrono::system_clock::now();
+    
+    for (const auto& product_id : m_analytics_manager->seller_products(seller_id)) {
+        AnalyticsData analytics;
+        analytics.timestamp = now;
+        analytics.dimensions["product_id"] = product_id;
+        analytics.dimensions["seller_id"] = seller_id;
+        add_sales(analytics, m_analytics_manager->product_totals(product_id));
+        performance.push_back(std::move(analytics));
+    }
+    
+    std::sort(performance.begin(), performance.end(),
+             [](const AnalyticsData& a, const AnalyticsData& b) {
+                 return a.metrics.at("total_revenue") > b.metrics.at("total_revenue");
+             });
+    
+    return performance;
 }
 
 AnalyticsData MarketplaceEngine::get_customer_analytics(const std::string& customer_id) const
 {
     AnalyticsData analytics;
     analytics.timestamp = std::chrono::system_clock::now();
+    if (customer_id.empty()) return analytics;
     
-    auto orders = get_customer_orders(customer_id);
-    
-    double total_spent = 0.0;
-    for (const auto& order : orders) {
-        total_spent += order.total_amount;
-    }
-    
-    analytics.metrics["total_spent"] = total_spent;
-    analytics.metrics["average_order_value"] = orders.size() > 0 ? total_spent / orders.size() : 0.0;
-    analytics.counts["total_orders"] = static_cast<int>(orders.size());
+    auto sales = m_analytics_manager->customer_totals(customer_id);
+    add_sales(analytics, sales);
+    analytics.metrics["total_spent"] = sales.revenue;
+    analytics.dimensions["customer_id"] = customer_id;
     
     return analytics;
 }
@@ -643,26 +516,45 @@ bool MarketplaceEngine::sync_with_gnucash()
 
 void MarketplaceEngine::subscribe_events(MarketplaceEventCallback callback)
 {
-    m_event_callbacks.push_back(callback);
+    if (!callback) return;
+    m_event_bus->subscribe([callback = std::move(callback)](
+                               const std::vector<MarketplaceEvent>& events) {
+        for (const auto& event : events) {
+            callback(event_name(event.type), event.subject_id.empty() ? "{}" : event.subject_id);
+        }
+    });
+}
+
+uint64_t MarketplaceEngine::subscribe_event_batches(MarketplaceEventHandler handler,
+                                                    const EventSubscriberOptions& options)
+{
+    return m_event_bus->subscribe(std::move(handler), options);
+}
+
+bool MarketplaceEngine::unsubscribe_events(uint64_t subscription_id)
+{
+    return m_event_bus->unsubscribe(subscription_id);
+}
+
+void MarketplaceEngine::flush_events()
+{
+    m_event_bus->flush();
 }
 
 MarketplaceEngine::Stats MarketplaceEngine::get_stats() const
 {
     Stats stats{};
     
-    auto products = m_product_manager->list("", "", ProductStatus::ACTIVE);
-    stats.total_products = products.size();
-    stats.active_products = products.size();
+    stats.total_products = m_product_manager->count("", "", ProductStatus::ACTIVE);
+    stats.active_products = stats.total_products;
     
-    auto orders = m_order_manager->list("", "", OrderStatus::PENDING);
-    stats.total_orders = orders.size();
+    auto sales = m_analytics_manager->seller_totals("");
+    stats.total_orders = static_cast<size_t>(sales.orders);
+    stats.pending_orders = static_cast<size_t>(sales.in_status(OrderStatus::PENDING));
+    stats.total_revenue = sales.revenue;
+    stats.average_order_value = sales.orders > 0 ? sales.revenue / sales.orders : 0.0;
     
-    double total_revenue = 0.0;
-    for (const auto& order : orders) {
-        total_revenue += order.total_amount;
-    }
-    stats.total_revenue = total_revenue;
-    stats.average_order_value = stats.total_orders > 0 ? total_revenue / stats.total_orders : 0.0;
+    stats.total_customers = m_customer_manager->count();
     
     stats.active_storefronts = m_storefront_manager->list().size();
     
@@ -671,21 +563,62 @@ MarketplaceEngine::Stats MarketplaceEngine::get_stats() const
 
 // Private helpers
 
-void MarketplaceEngine::notify_event(const std::string& event_type, const std::string& event_data)
-{
-    for (const auto& callback : m_event_callbacks) {
-        callback(event_type, event_data);
+void MarketplaceEngine::notify_event(MarketplaceEventType type, const std::string& subject_id)
+{
+    if (!m_event_bus->has_subscribers()) return;
+    MarketplaceEvent event;
+    event.type = type;
+    event.subject_id = subject_id;
+    event.time = std::chrono::system_clock::now();
+    m_event_bus->publish(std::move(event));
+}
+
+void MarketplaceEngine::notify_order_event(MarketplaceEventType type, const std::string& order_id,
+                                           OrderStatus status, double amount)
+{
+    if (!m_event_bus->has_subscribers()) return;
+    MarketplaceEvent event;
+    event.type = type;
+    event.subject_id = order_id;
+    event.order_status = status;
+    event.amount = amount;
+    event.time = std::chrono::system_clock::now();
+    m_event_bus->publish(std::move(event));
+}
+
+bool MarketplaceEngine::modify_order(const std::string& order_id,
+                                     const std::function<bool(OrderInfo&)>& fn,
+                                     OrderInfo* before,
+                                     std::optional<MarketplaceEventType> event,
+                                     std::optional<double> amount)
+{
+    // Every change of status goes through here, so the analytics count it.
+    OrderInfo old;
+    OrderStatus status = OrderStatus::PENDING;
+    bool changed = m_order_manager->modify(order_id, [&](OrderInfo& order) {
+        old = order;
+        if (!fn(order)) return false;
+        status = order.status;
+        notify_order_event(MarketplaceEventType::ORDER_STATUS_CHANGED, order_id, status,
+                           order.total_amount);
+        if (event)
+            notify_order_event(*event, order_id, status, amount.value_or(order.total_amount));
+        return true;
+    });
+    if (changed) {
+        m_analytics_manager->record_status(old, status);
     }
+    if (before) {
+        *before = std::move(old);
+    }
+    return changed;
 }
 
 std::string MarketplaceEngine::generate_id(const std::string& prefix)
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(100000, 999999);
-    
     std::ostringstream oss;
-    oss << prefix << "-" << std::setfill('0') << std::setw(6) << dis(gen);
+    oss << prefix << "-" << std::setfill('0') << std::setw(6)
+        << m_next_id.fetch_add(1, std::memory_order_relaxed);
     return oss.str();
 }
 
@@ -12,25 +12,37 @@
 #define GNC_MARKETPLACE_ENGINE_HPP
 
 #include "marketplace_types.hpp"
+#include "analytics.hpp"
+#include "event_bus.hpp"
 #include "product.hpp"
 #include "order.hpp"
 #include "storefront.hpp"
 #include "inventory.hpp"
 #include "customer.hpp"
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <vector>
 
 namespace gnc {
 namespace marketplace {
 
 /**
- * Callback for marketplace events.
+ * Callback for marketplace events, by name with the subject's id as data.
  */
 using MarketplaceEventCallback = std::function<void(const std::string& event_type, 
                                                      const std::string& event_data)>;
 
+/**
+ * Handler for batches of typed marketplace events.
+ */
+using MarketplaceEventHandler = EventBus::Handler;
+
 /**
  * MarketplaceEngine - Main interface for marketplace operations.
  *
@@ -42,6 +54,10 @@ using MarketplaceEventCallback = std::function<void(const std::string& event_typ
  * - Storefront configuration
  * - Integration with GnuCash accounting
  * - AI-powered recommendations and analytics
+ *
+ * All operations may be called concurrently. Each manager keeps its data
+ * in a ShardedMap, and create_order() takes the stock for all its items
+ * in one step, so concurrent checkouts cannot oversell.
  */
 class MarketplaceEngine
 {
@@ -89,32 +105,52 @@ public:
     ProductInfo get_product(const std::string& product_id) const;
 
     /**
-     * List products with filters.
+     * List products with filters, in creation order.
      */
     std::vector<ProductInfo> list_products(const std::string& seller_id = "",
                                           const std::string& category_id = "",
                                           ProductStatus status = ProductStatus::ACTIVE,
                                           int limit = 50, int offset = 0) const;
 
+    /**
+     * Page through the products list_products() would return, starting
+     * after cursor (empty for the first page). Each page costs the same
+     * however deep it is and however large the catalog.
+     */
+    Page<ProductInfo> query_products(const std::string& seller_id,
+                                     const std::string& category_id,
+                                     ProductStatus status,
+                                     size_t limit,
+                                     const std::string& cursor = "") const;
+
     /**
      * Search products by query.
+     *
+     * Returns up to limit products, best match first, that contain every
+     * word of the query in their name or description, ignoring case; the
+     * last word also matches as a prefix. Archived products are not found.
      */
     std::vector<ProductInfo> search_products(const std::string& query,
                                             const std::string& category_id = "",
                                             double min_price = 0.0,
-                                            double max_price = 0.0) const;
+                                            double max_price = 0.0,
+                                            int limit = 50) const;
 
     // =========================================
     // Order Management
     // =========================================
 
     /**
-     * Create a new order.
+     * Create a new order. Returns an empty id if the stock is short or
+     * the order's status is not an OrderStatus value.
      */
     std::string create_order(const OrderInfo& order);
 
     /**
-     * Update order status.
+     * Update order status. Cancelling goes through cancel_order(), so the
+     * stock comes back; reopening a cancelled order takes it again and
+     * fails if there is not enough. Refunding goes through refund_order()
+     * for the whole total, and a refunded order keeps its status.
      */
     bool update_order_status(const std::string& order_id, OrderStatus status);
 
@@ -130,6 +166,16 @@ public:
                                       const std::string& seller_id = "",
                                       OrderStatus status = OrderStatus::PENDING) const;
 
+    /**
+     * Page through the orders list_orders() would return, starting after
+     * cursor (empty for the first page).
+     */
+    Page<OrderInfo> query_orders(const std::string& customer_id,
+                                 const std::string& seller_id,
+                                 OrderStatus status,
+                                 size_t limit,
+                                 const std::string& cursor = "") const;
+
     /**
      * Process order payment.
      */
@@ -143,7 +189,10 @@ public:
     bool cancel_order(const std::string& order_id, const std::string& reason);
 
     /**
-     * Issue refund for an order.
+     * Refund a paid, processing, shipped or delivered order and mark it
+     * REFUNDED. Fails if the order is in any other state, including
+     * already refunded, or if amount is not more than zero and at most
+     * the order total.
      */
     bool refund_order(const std::string& order_id, double amount);
 
@@ -224,14 +273,16 @@ public:
     // =========================================
 
     /**
-     * Get sales analytics for a period.
+     * Get sales analytics for a period: the orders of a seller (empty
+     * for all) created on the days from start_date to end_date, in UTC.
      */
     AnalyticsData get_sales_analytics(const std::string& seller_id,
                                      const std::chrono::system_clock::time_point& start_date,
                                      const std::chrono::system_clock::time_point& end_date) const;
 
     /**
-     * Get product performance metrics.
+     * Get product performance metrics: one entry per product the seller
+     * has had orders for, highest revenue first.
      */
     std::vector<AnalyticsData> get_product_performance(const std::string& seller_id) const;
 
@@ -285,10 +336,29 @@ public:
     // =========================================
 
     /**
-     * Subscribe to marketplace events.
+     * Subscribe to marketplace events. The callback runs on an event
+     * thread, one event at a time, some time after the change.
      */
     void subscribe_events(MarketplaceEventCallback callback);
 
+    /**
+     * Subscribe to batches of typed events, queued and delivered as
+     * options say. Returns the subscription id, or 0 if refused.
+     */
+    uint64_t subscribe_event_batches(MarketplaceEventHandler handler,
+                                     const EventSubscriberOptions& options = {});
+
+    /**
+     * End a subscription. Returns false if there is no such subscription.
+     */
+    bool unsubscribe_events(uint64_t subscription_id);
+
+    /**
+     * Wait until every event so far has reached its subscribers. Must
+     * not be called from an event handler.
+     */
+    void flush_events();
+
     /**
      * Get marketplace statistics.
      */
@@ -307,20 +377,36 @@ public:
     Stats get_stats() const;
 
 private:
-    bool m_initialized;
+    std::atomic<bool> m_initialized;
+    std::mutex m_state_mutex;           // serialises initialize/shutdown
+    std::atomic<uint64_t> m_next_id;    // for generate_id()
 
     // Component managers
-    std::unique_ptr<class ProductManager> m_product_manager;
-    std::unique_ptr<class OrderManager> m_order_manager;
-    std::unique_ptr<class StorefrontManager> m_storefront_manager;
-    std::unique_ptr<class InventoryManager> m_inventory_manager;
-    std::unique_ptr<class CustomerManager> m_customer_manager;
+    std::unique_ptr<ProductManager> m_product_manager;
+    std::unique_ptr<OrderManager> m_order_manager;
+    std::unique_ptr<StorefrontManager> m_storefront_manager;
+    std::unique_ptr<InventoryManager> m_inventory_manager;
+    std::unique_ptr<CustomerManager> m_customer_manager;
+    std::unique_ptr<AnalyticsManager> m_analytics_manager;
 
-    // Event subscribers
-    std::vector<MarketplaceEventCallback> m_event_callbacks;
+    // Last, so handlers still running at destruction find the managers
+    std::unique_ptr<EventBus> m_event_bus;
 
     // Internal helpers
-    void notify_event(const std::string& event_type, const std::string& event_data);
+
+    // Change an order with fn, which returns false to leave it alone.
+    // On a change, ORDER_STATUS_CHANGED and then event, if any, are
+    // published before the order's lock is released, so subscribers get
+    // the changes to one order in the order they were made. event
+    // carries amount, or the order total if there is none.
+    bool modify_order(const std::string& order_id,
+                      const std::function<bool(OrderInfo&)>& fn,
+                      OrderInfo* before = nullptr,
+                      std::optional<MarketplaceEventType> event = std::nullopt,
+                      std::optional<double> amount = std::nullopt);
+    void notify_event(MarketplaceEventType type, const std::string& subject_id = "");
+    void notify_order_event(MarketplaceEventType type, const std::string& order_id,
+                            OrderStatus status, double amount);
     std::string generate_id(const std::string& prefix);
 };
 
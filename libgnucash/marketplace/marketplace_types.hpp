@@ -150,11 +150,11 @@ struct OrderItem
     std::string product_id;
     std::string variant_id;
     std::string product_name;
-    int quantity;
-    double unit_price;
-    double total_price;
-    double tax_amount;
-    double discount_amount;
+    int quantity = 0;
+    double unit_price = 0.0;
+    double total_price = 0.0;
+    double tax_amount = 0.0;
+    double discount_amount = 0.0;
 };
 
 /**
@@ -178,15 +178,15 @@ struct OrderInfo
     std::string id;
     std::string customer_id;
     std::string seller_id;
-    OrderStatus status;
+    OrderStatus status = OrderStatus::PENDING;
     std::vector<OrderItem> items;
     
     // Pricing
-    double subtotal;
-    double tax_amount;
-    double shipping_cost;
-    double discount_amount;
-    double total_amount;
+    double subtotal = 0.0;
+    double tax_amount = 0.0;
+    double shipping_cost = 0.0;
+    double discount_amount = 0.0;
+    double total_amount = 0.0;
     std::string currency;
     
     // Payment
@@ -334,6 +334,18 @@ struct MarketplaceTransaction
     std::chrono::system_clock::time_point transaction_date;
 };
 
+/**
+ * One page of a listing. The items are shared read-only snapshots, so a
+ * page costs no deep copies and stays valid while the records change.
+ * Pass next_cursor to get the following page; it is empty on the last.
+ */
+template<typename T>
+struct Page
+{
+    std::vector<std::shared_ptr<const T>> items;
+    std::string next_cursor;
+};
+
 } // namespace marketplace
 } // namespace gnc
 
@@ -12,7 +12,113 @@
 namespace gnc {
 namespace marketplace {
 
-// Order management implementation (integrated into marketplace_engine.cpp)
+OrderManager::OrderManager()
+    : m_index([](const OrderInfo& order, std::vector<RecordIndex<OrderInfo>::Key>& keys) {
+          // PENDING doubles as "any status" in queries, so every order is
+          // filed under it as well as under its own status.
+          for (auto status : {OrderStatus::PENDING, order.status}) {
+              keys.push_back({posting('c', "", status), 0});
+              keys.push_back({posting('c', order.customer_id, status), 0});
+              keys.push_back({posting('s', order.seller_id, status), 0});
+              if (status == order.status) break;
+          }
+      })
+{
+}
+
+std::string OrderManager::create(const OrderInfo& order,
+                                 const std::function<void(const OrderInfo&)>& created)
+{
+    uint64_t seq = m_next_id.fetch_add(1, std::memory_order_relaxed);
+    auto id = "ORDER-" + std::to_string(seq);
+    auto info = std::make_shared<OrderInfo>(order);
+    info->id = id;
+    // The index is updated under the shard lock, so it sees the changes
+    // to one order in the order they were made.
+    m_orders.upsert(id, [&](Record& record) {
+        record.seq = seq;
+        record.info = info;
+        m_index.put(seq, info);
+        if (created) created(*info);
+    });
+    return id;
+}
+
+bool OrderManager::update_status(const std::string& id, OrderStatus status)
+{
+    return modify(id, [status](OrderInfo& order) {
+        order.status = status;
+        return true;
+    });
+}
+
+bool OrderManager::modify(const std::string& id, const std::function<bool(OrderInfo&)>& fn)
+{
+    bool changed = false;
+    m_orders.update(id, [&](Record& record) {
+        auto info = std::make_shared<OrderInfo>(*record.info);
+        changed = fn(*info);
+        if (!changed) return;
+        info->updated_at = std::chrono::system_clock::now();
+        record.info = info;
+        m_index.put(record.seq, info);
+    });
+    return changed;
+}
+
+OrderInfo OrderManager::get(const std::string& id) const
+{
+    OrderInfo order;
+    m_orders.visit(id, [&](const Record& record) { order = *record.info; });
+    return order;
+}
+
+std::vector<OrderInfo> OrderManager::list(const std::string& customer_id,
+                                          const std::string& seller_id,
+                                          OrderStatus status) const
+{
+    std::vector<OrderInfo> results;
+    std::string cursor;
+    do {
+        auto next = page(customer_id, seller_id, status, 256, cursor);
+        for (const auto& order : next.items)
+            results.push_back(*order);
+        cursor = std::move(next.next_cursor);
+    } while (!cursor.empty());
+    return results;
+}
+
+Page<OrderInfo> OrderManager::page(const std::string& customer_id,
+                                   const std::string& seller_id,
+                                   OrderStatus status,
+                                   size_t limit, const std::string& cursor) const
+{
+    if (customer_id.empty())
+        return m_index.page(posting('s', seller_id, status), limit, cursor);
+    // A customer has few orders, so the seller is checked on each.
+    return m_index.page(posting('c', customer_id, status), limit, cursor,
+                        [&](const OrderInfo& order) {
+                            return seller_id.empty() || order.seller_id == seller_id;
+                        });
+}
+
+size_t OrderManager::count(const std::string& seller_id, OrderStatus status) const
+{
+    return m_index.count(posting('s', seller_id, status));
+}
+
+std::string OrderManager::posting(char field, const std::string& value, OrderStatus status)
+{
+    // An empty customer or seller means all orders, whichever field is
+    // named, so both spell that list the same way.
+    std::string key = std::to_string(static_cast<int>(status));
+    if (!value.empty()) {
+        key += '\x1f';
+        key += field;
+        key += value;
+    }
+    return key;
+}
 
 } // namespace marketplace
 } // namespace gnc
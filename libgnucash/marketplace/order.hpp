@@ -11,11 +11,88 @@
 #define GNC_MARKETPLACE_ORDER_HPP
 
 #include "marketplace_types.hpp"
+#include "record_index.hpp"
+#include "sharded_map.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
 
 namespace gnc {
 namespace marketplace {
 
-// Order management functions (currently integrated into MarketplaceEngine)
+/**
+ * OrderManager - stored orders. Safe to use from any thread.
+ *
+ * Orders are kept as shared snapshots, found by id through a ShardedMap
+ * and listed through a RecordIndex: by customer and by seller, each with
+ * and without status, in creation order.
+ */
+class OrderManager
+{
+public:
+    OrderManager();
+
+    /**
+     * Store a new order and return its generated id. If given, created
+     * is called with the stored order before any other change to it can
+     * be made.
+     */
+    std::string create(const OrderInfo& order,
+                       const std::function<void(const OrderInfo&)>& created = {});
+
+    /**
+     * Set the status of an order. Returns false if it does not exist.
+     */
+    bool update_status(const std::string& id, OrderStatus status);
+
+    /**
+     * Change an order in place with fn(OrderInfo&), which returns false
+     * to leave it as it was. Runs atomically with respect to other
+     * updates, so fn can check the current status before changing it.
+     * Returns false if the order does not exist or fn refused.
+     */
+    bool modify(const std::string& id, const std::function<bool(OrderInfo&)>& fn);
+
+    /**
+     * The order, or an empty OrderInfo if it does not exist.
+     */
+    OrderInfo get(const std::string& id) const;
+
+    /**
+     * Orders for a customer and seller (empty matches any), in creation
+     * order. PENDING matches every status.
+     */
+    std::vector<OrderInfo> list(const std::string& customer_id,
+                               const std::string& seller_id,
+                               OrderStatus status) const;
+
+    /**
+     * The page of list() that follows cursor, without copying the orders.
+     */
+    Page<OrderInfo> page(const std::string& customer_id,
+                         const std::string& seller_id,
+                         OrderStatus status,
+                         size_t limit, const std::string& cursor) const;
+
+    /**
+     * Number of orders list() would return for a seller alone.
+     */
+    size_t count(const std::string& seller_id, OrderStatus status) const;
+
+private:
+    struct Record
+    {
+        uint64_t seq = 0;
+        std::shared_ptr<const OrderInfo> info;
+    };
+
+    ShardedMap<std::string, Record> m_orders;
+    RecordIndex<OrderInfo> m_index;
+    std::atomic<uint64_t> m_next_id{2000};
+
+    static std::string posting(char field, const std::string& value, OrderStatus status);
+};
 
 } // namespace marketplace
 } // namespace gnc
@@ -9,10 +9,119 @@
 
 #include "product.hpp"
 
+#include <climits>
+
 namespace gnc {
 namespace marketplace {
 
-// Product management implementation (integrated into marketplace_engine.cpp)
+ProductManager::ProductManager()
+    : m_index([](const ProductInfo& product, std::vector<RecordIndex<ProductInfo>::Key>& keys) {
+          keys.push_back({posting("", "", product.status), 0});
+          keys.push_back({posting(product.seller_id, "", product.status), 0});
+          keys.push_back({posting("", product.category_id, product.status), 0});
+          keys.push_back({posting(product.seller_id, product.category_id, product.status), 0});
+      })
+{
+}
+
+std::string ProductManager::create(const ProductInfo& product)
+{
+    uint64_t seq = m_next_id.fetch_add(1, std::memory_order_relaxed);
+    auto id = "PROD-" + std::to_string(seq);
+    auto info = std::make_shared<ProductInfo>(product);
+    info->id = id;
+    // The indices are updated under the shard lock, so they see the
+    // changes to one product in the order they were made.
+    m_products.upsert(id, [&](Record& record) {
+        record.seq = seq;
+        record.info = info;
+        m_index.put(seq, info);
+        m_search.put(seq, info);
+    });
+    return id;
+}
+
+bool ProductManager::update(const std::string& id, const ProductInfo& product)
+{
+    return modify(id, [&](ProductInfo& stored) {
+        stored = product;
+        stored.id = id;
+    });
+}
+
+bool ProductManager::modify(const std::string& id, const std::function<void(ProductInfo&)>& fn)
+{
+    return m_products.update(id, [&](Record& record) {
+        auto info = std::make_shared<ProductInfo>(*record.info);
+        fn(*info);
+        record.info = info;
+        m_index.put(record.seq, info);
+        m_search.put(record.seq, info);
+    });
+}
+
+ProductInfo ProductManager::get(const std::string& id) const
+{
+    ProductInfo product;
+    m_products.visit(id, [&](const Record& record) { product = *record.info; });
+    return product;
+}
+
+std::vector<ProductInfo> ProductManager::list(const std::string& seller_id,
+                                              const std::string& category_id,
+                                              ProductStatus status) const
+{
+    std::vector<ProductInfo> results;
+    m_index.range(posting(seller_id, category_id, status), LLONG_MIN, LLONG_MAX,
+                  [&](const ProductInfo& product) { results.push_back(product); });
+    return results;
+}
+
+std::vector<std::shared_ptr<const ProductInfo>> ProductManager::slice(
+    const std::string& seller_id,
+    const std::string& category_id,
+    ProductStatus status,
+    size_t offset, size_t limit) const
+{
+    return m_index.slice(posting(seller_id, category_id, status), offset, limit);
+}
+
+Page<ProductInfo> ProductManager::page(const std::string& seller_id,
+                                       const std::string& category_id,
+                                       ProductStatus status,
+                                       size_t limit, const std::string& cursor) const
+{
+    return m_index.page(posting(seller_id, category_id, status), limit, cursor);
+}
+
+size_t ProductManager::count(const std::string& seller_id,
+                             const std::string& category_id,
+                             ProductStatus status) const
+{
+    return m_index.count(posting(seller_id, category_id, status));
+}
+
+std::vector<std::shared_ptr<const ProductInfo>> ProductManager::search(
+    const std::string& query,
+    const std::string& category_id,
+    double min_price, double max_price,
+    size_t limit) const
+{
+    return m_search.search(query, category_id, min_price, max_price, limit);
+}
+
+std::string ProductManager::posting(const std::string& seller_id,
+                                    const std::string& category_id,
+                                    ProductStatus status)
+{
+    // Fields are split by a unit separator, which ids do not contain.
+    std::string key = std::to_string(static_cast<int>(status));
+    if (!seller_id.empty())
+        key += "\x1f" "s" + seller_id;
+    if (!category_id.empty())
+        key += "\x1f" "c" + category_id;
+    return key;
+}
 
 } // namespace marketplace
 } // namespace gnc
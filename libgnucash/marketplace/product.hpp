@@ -11,11 +11,108 @@
 #define GNC_MARKETPLACE_PRODUCT_HPP
 
 #include "marketplace_types.hpp"
+#include "product_search.hpp"
+#include "record_index.hpp"
+#include "sharded_map.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
 
 namespace gnc {
 namespace marketplace {
 
-// Product management functions (currently integrated into MarketplaceEngine)
+/**
+ * ProductManager - the product catalog. Safe to use from any thread.
+ *
+ * Products are kept as shared snapshots, found by id through a
+ * ShardedMap and listed through a RecordIndex with one posting list per
+ * combination of status with seller and category, so every listing
+ * filter is a single ordered walk. A ProductSearchIndex answers text
+ * searches.
+ */
+class ProductManager
+{
+public:
+    ProductManager();
+
+    /**
+     * Store a new product and return its generated id.
+     */
+    std::string create(const ProductInfo& product);
+
+    /**
+     * Replace a product, keeping its id. Returns false if it does not exist.
+     */
+    bool update(const std::string& id, const ProductInfo& product);
+
+    /**
+     * Change a product in place with fn(ProductInfo&), atomically with
+     * respect to other updates. Returns false if it does not exist.
+     */
+    bool modify(const std::string& id, const std::function<void(ProductInfo&)>& fn);
+
+    /**
+     * The product, or an empty ProductInfo if it does not exist.
+     */
+    ProductInfo get(const std::string& id) const;
+
+    /**
+     * Products with the given status, seller and category (empty matches
+     * any), in creation order.
+     */
+    std::vector<ProductInfo> list(const std::string& seller_id,
+                                 const std::string& category_id,
+                                 ProductStatus status) const;
+
+    /**
+     * Products offset to offset + limit of list(), without copying them.
+     */
+    std::vector<std::shared_ptr<const ProductInfo>> slice(const std::string& seller_id,
+                                                          const std::string& category_id,
+                                                          ProductStatus status,
+                                                          size_t offset, size_t limit) const;
+
+    /**
+     * The page of list() that follows cursor.
+     */
+    Page<ProductInfo> page(const std::string& seller_id,
+                           const std::string& category_id,
+                           ProductStatus status,
+                           size_t limit, const std::string& cursor) const;
+
+    /**
+     * Number of products list() would return.
+     */
+    size_t count(const std::string& seller_id,
+                 const std::string& category_id,
+                 ProductStatus status) const;
+
+    /**
+     * Up to limit products matching every word of query, best first; see
+     * ProductSearchIndex::search().
+     */
+    std::vector<std::shared_ptr<const ProductInfo>> search(const std::string& query,
+                                                           const std::string& category_id,
+                                                           double min_price, double max_price,
+                                                           size_t limit) const;
+
+private:
+    struct Record
+    {
+        uint64_t seq = 0;
+        std::shared_ptr<const ProductInfo> info;
+    };
+
+    ShardedMap<std::string, Record> m_products;
+    RecordIndex<ProductInfo> m_index;
+    ProductSearchIndex m_search;
+    std::atomic<uint64_t> m_next_id{1000};
+
+    static std::string posting(const std::string& seller_id,
+                               const std::string& category_id,
+                               ProductStatus status);
+};
 
 } // namespace marketplace
 } // namespace gnc
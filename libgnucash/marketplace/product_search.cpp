@@ -0,0 +1,392 @@
+/*
+ * libgnucash/marketplace/product_search.cpp
+ *
+ * Full-text search over the product catalog
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "product_search.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace gnc {
+namespace marketplace {
+
+namespace {
+
+/**
+ * The first entry of the sorted range [first, last) whose key is not
+ * below id. Searching forward from the previous hit by doubling steps
+ * costs O(log distance), so stepping through a list with ascending ids
+ * costs no more than a merge when the ids are dense and no more than
+ * binary searches when they are sparse.
+ */
+template<typename It, typename Id, typename Key>
+It gallop(It first, It last, Id id, Key key)
+{
+    auto below = [&](const auto& entry, Id value) { return key(entry) < value; };
+    for (std::ptrdiff_t step = 1; last - first > step; step *= 2) {
+        if (!(key(first[step]) < id))
+            return std::lower_bound(first, first + step + 1, id, below);
+        first += step + 1;
+    }
+    return std::lower_bound(first, last, id, below);
+}
+
+bool is_term_byte(unsigned char c)
+{
+    return std::isalnum(c) || c >= 0x80;
+}
+
+} // namespace
+
+std::vector<std::string> ProductSearchIndex::tokenize(const std::string& text)
+{
+    std::vector<std::string> terms;
+    std::string term;
+    for (unsigned char c : text) {
+        if (is_term_byte(c)) {
+            term += static_cast<char>(c < 0x80 ? std::tolower(c) : c);
+        } else if (!term.empty()) {
+            terms.push_back(std::move(term));
+            term.clear();
+        }
+    }
+    if (!term.empty())
+        terms.push_back(std::move(term));
+    return terms;
+}
+
+void ProductSearchIndex::put(uint64_t seq, Ptr product)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto found = m_doc_of.find(seq);
+    if (found != m_doc_of.end()) {
+        remove(found->second);
+        m_doc_of.erase(found);
+    }
+    if (product && product->status != ProductStatus::ARCHIVED)
+        add(seq, std::move(product));
+
+    size_t removed = m_docs.size() - m_live;
+    if (removed > 1024 && removed > m_live)
+        compact();
+}
+
+size_t ProductSearchIndex::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_live;
+}
+
+std::vector<ProductSearchIndex::Ptr> ProductSearchIndex::search(const std::string& query,
+                                                                const std::string& category_id,
+                                                                double min_price,
+                                                                double max_price,
+                                                                size_t limit) const
+{
+    auto tokens = tokenize(query);
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    if (limit == 0 || m_live == 0) return {};
+    if (tokens.empty())
+        return browse(category_id, min_price, max_price, limit);
+
+    // One group of terms per query word: the word itself, or for the
+    // last word every term it is a prefix of. A product must match a
+    // term from each group.
+    struct Group
+    {
+        std::vector<const Term*> terms;
+        size_t postings = 0;
+    };
+    std::vector<Group> groups;
+    std::sort(tokens.begin(), tokens.end() - 1);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        bool last = i + 1 == tokens.size();
+        if (!last && i > 0 && tokens[i] == tokens[i - 1]) continue;
+        Group group;
+        for (auto it = m_terms.lower_bound(tokens[i]);
+             it != m_terms.end() && it->first.compare(0, tokens[i].size(), tokens[i]) == 0;
+             ++it) {
+            if (!last && it->first.size() != tokens[i].size()) break;
+            if (it->second.live == 0) continue;
+            group.terms.push_back(&it->second);
+            group.postings += it->second.postings.size();
+        }
+        if (group.terms.empty()) return {};
+        groups.push_back(std::move(group));
+    }
+    std::sort(groups.begin(), groups.end(),
+              [](const Group& a, const Group& b) { return a.postings < b.postings; });
+
+    const double n = static_cast<double>(m_live);
+    const double average_length = m_total_length / n;
+    auto idf = [&](const Term& term) {
+        double df = term.live;
+        return std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+    };
+    auto weight = [&](double term_idf, const Posting& posting) {
+        double norm = 1.0 - BM25_B + BM25_B * m_docs[posting.doc].length / average_length;
+        return term_idf * posting.frequency * (BM25_K1 + 1.0) /
+               (posting.frequency + BM25_K1 * norm);
+    };
+    auto posting_doc = [](const Posting& posting) { return posting.doc; };
+
+    const std::vector<DocId>* category = nullptr;
+    if (!category_id.empty()) {
+        auto it = m_categories.find(category_id);
+        if (it == m_categories.end()) return {};
+        category = &it->second;
+    }
+
+    // Candidates are kept sorted by DocId. They start from the shortest
+    // list, the price range's, the category's or the rarest group's, and
+    // every other list is intersected into them by galloping through it.
+    std::vector<std::pair<DocId, double>> candidates;
+    size_t first = 0;
+    size_t shortest = groups[0].postings;
+    if (category)
+        shortest = std::min(shortest, category->size());
+    if ((min_price > 0 || max_price > 0) &&
+        prices_between(min_price, max_price, shortest, candidates)) {
+        std::sort(candidates.begin(), candidates.end());
+    } else if (category && category->size() < groups[0].postings) {
+        candidates.clear();
+        for (DocId doc : *category) {
+            if (m_docs[doc].product)
+                candidates.emplace_back(doc, 0.0);
+        }
+        category = nullptr;
+    } else {
+        candidates.clear();
+        for (const Term* term : groups[0].terms) {
+            double term_idf = idf(*term);
+            for (const auto& posting : term->postings) {
+                if (m_docs[posting.doc].product)
+                    candidates.emplace_back(posting.doc, weight(term_idf, posting));
+            }
+        }
+        if (groups[0].terms.size() > 1) {
+            // Prefix terms can share a product: merge its entries.
+            std::sort(candidates.begin(), candidates.end());
+            size_t kept = 0;
+            for (const auto& candidate : candidates) {
+                if (kept > 0 && candidates[kept - 1].first == candidate.first)
+                    candidates[kept - 1].second += candidate.second;
+                else
+                    candidates[kept++] = candidate;
+            }
+            candidates.resize(kept);
+        }
+        first = 1;
+    }
+
+    for (size_t g = first; g < groups.size() && !candidates.empty(); ++g) {
+        const auto& group = groups[g];
+        std::vector<double> idfs;
+        std::vector<std::vector<Posting>::const_iterator> cursors;
+        for (const Term* term : group.terms) {
+            idfs.push_back(idf(*term));
+            cursors.push_back(term->postings.begin());
+        }
+        size_t kept = 0;
+        for (const auto& [doc, score] : candidates) {
+            bool matched = false;
+            double total = score;
+            for (size_t t = 0; t < group.terms.size(); ++t) {
+                const auto& postings = group.terms[t]->postings;
+                cursors[t] = gallop(cursors[t], postings.end(), doc, posting_doc);
+                if (cursors[t] == postings.end() || cursors[t]->doc != doc) continue;
+                matched = true;
+                total += weight(idfs[t], *cursors[t]);
+            }
+            if (matched)
+                candidates[kept++] = {doc, total};
+        }
+        candidates.resize(kept);
+    }
+
+    size_t kept = 0;
+    auto in_category = category ? category->begin() : std::vector<DocId>::const_iterator{};
+    for (const auto& candidate : candidates) {
+        DocId doc = candidate.first;
+        if (category) {
+            in_category = gallop(in_category, category->end(), doc, [](DocId d) { return d; });
+            if (in_category == category->end() || *in_category != doc) continue;
+        }
+        if (in_price_range(doc, min_price, max_price))
+            candidates[kept++] = candidate;
+    }
+    candidates.resize(kept);
+    return best(candidates, limit);
+}
+
+std::vector<ProductSearchIndex::Ptr> ProductSearchIndex::browse(const std::string& category_id,
+                                                                double min_price,
+                                                                double max_price,
+                                                                size_t limit) const
+{
+    std::vector<std::pair<DocId, double>> hits;
+    auto consider = [&](DocId doc) {
+        if (m_docs[doc].product && in_price_range(doc, min_price, max_price))
+            hits.emplace_back(doc, 0.0);
+    };
+
+    if (!category_id.empty()) {
+        auto it = m_categories.find(category_id);
+        if (it == m_categories.end()) return {};
+        for (DocId doc : it->second)
+            consider(doc);
+    } else if (min_price > 0 || max_price > 0) {
+        // Only the products in the price range are visited.
+        prices_between(min_price, max_price, m_docs.size(), hits);
+    } else {
+        for (DocId doc = 0; doc < m_docs.size(); ++doc)
+            consider(doc);
+    }
+    return best(hits, limit);
+}
+
+std::vector<ProductSearchIndex::Ptr> ProductSearchIndex::best(
+    std::vector<std::pair<DocId, double>>& hits, size_t limit) const
+{
+    auto before = [this](const std::pair<DocId, double>& a, const std::pair<DocId, double>& b) {
+        if (a.second != b.second) return a.second > b.second;
+        return m_docs[a.first].seq < m_docs[b.first].seq;
+    };
+    size_t count = std::min(limit, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + count, hits.end(), before);
+
+    std::vector<Ptr> results;
+    results.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        results.push_back(m_docs[hits[i].first].product);
+    return results;
+}
+
+bool ProductSearchIndex::prices_between(double min_price, double max_price, size_t limit,
+                                        std::vector<std::pair<DocId, double>>& docs) const
+{
+    double low = min_price > 0 ? min_price : -std::numeric_limits<double>::infinity();
+    auto it = m_prices.lower_bound({low, 0});
+    for (; it != m_prices.end() && (max_price <= 0 || it->first <= max_price); ++it) {
+        if (docs.size() == limit) return false;
+        docs.emplace_back(it->second, 0.0);
+    }
+    return true;
+}
+
+bool ProductSearchIndex::in_price_range(DocId doc, double min_price, double max_price) const
+{
+    double price = m_docs[doc].price;
+    if (min_price > 0 && price < min_price) return false;
+    if (max_price > 0 && price > max_price) return false;
+    return true;
+}
+
+std::vector<std::pair<std::string, double>> ProductSearchIndex::weighted_terms(
+    const ProductInfo& product, double& length)
+{
+    std::unordered_map<std::string, double> frequency;
+    length = 0.0;
+    for (auto& term : tokenize(product.name)) {
+        frequency[std::move(term)] += NAME_WEIGHT;
+        length += NAME_WEIGHT;
+    }
+    for (auto& term : tokenize(product.description)) {
+        frequency[std::move(term)] += 1.0;
+        length += 1.0;
+    }
+    return {frequency.begin(), frequency.end()};
+}
+
+void ProductSearchIndex::add(uint64_t seq, Ptr product)
+{
+    auto doc = static_cast<DocId>(m_docs.size());
+    double length = 0.0;
+    auto terms = weighted_terms(*product, length);
+
+    for (const auto& [text, frequency] : terms) {
+        auto& term = m_terms[text];
+        term.postings.push_back({doc, static_cast<float>(frequency)});
+        ++term.live;
+    }
+    if (!product->category_id.empty())
+        m_categories[product->category_id].push_back(doc);
+    m_prices.emplace(product->base_price, doc);
+
+    double price = product->base_price;
+    m_docs.push_back({seq, std::move(product), length, price});
+    m_doc_of[seq] = doc;
+    ++m_live;
+    m_total_length += length;
+}
+
+void ProductSearchIndex::remove(DocId doc)
+{
+    auto& entry = m_docs[doc];
+    double length = 0.0;
+    for (const auto& [text, frequency] : weighted_terms(*entry.product, length)) {
+        auto it = m_terms.find(text);
+        if (it != m_terms.end())
+            --it->second.live;
+    }
+    m_prices.erase({entry.product->base_price, doc});
+    // The category and term postings keep doc until compact().
+    entry.product.reset();
+    --m_live;
+    m_total_length -= entry.length;
+}
+
+void ProductSearchIndex::compact()
+{
+    const DocId gone = std::numeric_limits<DocId>::max();
+    std::vector<DocId> renumbered(m_docs.size(), gone);
+    std::vector<Doc> docs;
+    docs.reserve(m_live);
+    for (DocId doc = 0; doc < m_docs.size(); ++doc) {
+        if (!m_docs[doc].product) continue;
+        renumbered[doc] = static_cast<DocId>(docs.size());
+        docs.push_back(std::move(m_docs[doc]));
+    }
+    m_docs = std::move(docs);
+
+    // Renumbering keeps the order, so every list stays sorted.
+    for (auto it = m_terms.begin(); it != m_terms.end();) {
+        auto& postings = it->second.postings;
+        size_t kept = 0;
+        for (const auto& posting : postings) {
+            if (renumbered[posting.doc] != gone)
+                postings[kept++] = {renumbered[posting.doc], posting.frequency};
+        }
+        postings.resize(kept);
+        postings.shrink_to_fit();
+        it = postings.empty() ? m_terms.erase(it) : std::next(it);
+    }
+    for (auto it = m_categories.begin(); it != m_categories.end();) {
+        auto& docs_in = it->second;
+        size_t kept = 0;
+        for (DocId doc : docs_in) {
+            if (renumbered[doc] != gone)
+                docs_in[kept++] = renumbered[doc];
+        }
+        docs_in.resize(kept);
+        it = docs_in.empty() ? m_categories.erase(it) : std::next(it);
+    }
+
+    m_prices.clear();
+    m_doc_of.clear();
+    for (DocId doc = 0; doc < m_docs.size(); ++doc) {
+        m_prices.emplace(m_docs[doc].product->base_price, doc);
+        m_doc_of[m_docs[doc].seq] = doc;
+    }
+}
+
+} // namespace marketplace
+} // namespace gnc
@@ -0,0 +1,141 @@
+/*
+ * libgnucash/marketplace/product_search.hpp
+ *
+ * Full-text search over the product catalog
+ *
+ * An inverted index from normalised terms of product names and
+ * descriptions to the products containing them, with BM25 ranking, a
+ * posting list per category and a sorted price index. Products are
+ * filed and unfiled as the catalog changes, so a search only touches
+ * the postings of its own terms.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_MARKETPLACE_PRODUCT_SEARCH_HPP
+#define GNC_MARKETPLACE_PRODUCT_SEARCH_HPP
+
+#include "marketplace_types.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gnc {
+namespace marketplace {
+
+/**
+ * ProductSearchIndex - ranked keyword search over products. Safe to use
+ * from any thread.
+ *
+ * Text is split into runs of letters and digits and lowercased; bytes of
+ * multi-byte UTF-8 characters count as letters. A search finds the
+ * products that contain every term of the query, the last term also
+ * matching as a prefix so that partly typed words work. Name terms
+ * weigh NAME_WEIGHT times description terms.
+ *
+ * Archived products are not searchable.
+ */
+class ProductSearchIndex
+{
+public:
+    using Ptr = std::shared_ptr<const ProductInfo>;
+
+    static constexpr double NAME_WEIGHT = 2.0;
+    static constexpr double BM25_K1 = 1.2;
+    static constexpr double BM25_B = 0.75;
+
+    /**
+     * File product under seq, replacing the product filed there before.
+     * A null or archived product only removes.
+     */
+    void put(uint64_t seq, Ptr product);
+
+    /**
+     * Up to limit products matching query, best first, with equal scores
+     * in creation order. An empty category or zero price bound does not
+     * filter. A query without terms matches every product, in creation
+     * order.
+     */
+    std::vector<Ptr> search(const std::string& query,
+                            const std::string& category_id,
+                            double min_price, double max_price,
+                            size_t limit) const;
+
+    /**
+     * Number of searchable products.
+     */
+    size_t size() const;
+
+    /**
+     * The normalised terms of text, in order, with repeats.
+     */
+    static std::vector<std::string> tokenize(const std::string& text);
+
+private:
+    using DocId = uint32_t;
+
+    struct Doc
+    {
+        uint64_t seq;
+        Ptr product;        // null once removed
+        double length;      // weighted number of terms
+        double price;
+    };
+
+    struct Posting
+    {
+        DocId doc;
+        float frequency;    // weighted
+    };
+
+    struct Term
+    {
+        std::vector<Posting> postings;  // by DocId, removed docs included
+        uint32_t live = 0;              // postings of docs not removed
+    };
+
+    mutable std::shared_mutex m_mutex;
+
+    // A changed product is refiled under a new DocId, so postings are
+    // only ever appended. Removed docs stay in the postings until there
+    // are as many as live ones, then compact() drops them.
+    std::vector<Doc> m_docs;
+    std::unordered_map<uint64_t, DocId> m_doc_of;
+    size_t m_live = 0;
+    double m_total_length = 0.0;
+
+    std::map<std::string, Term> m_terms;    // ordered for prefix lookups
+    std::unordered_map<std::string, std::vector<DocId>> m_categories;
+    std::set<std::pair<double, DocId>> m_prices;
+
+    void add(uint64_t seq, Ptr product);
+    void remove(DocId doc);
+    void compact();
+
+    static std::vector<std::pair<std::string, double>> weighted_terms(const ProductInfo& product,
+                                                                       double& length);
+    bool in_price_range(DocId doc, double min_price, double max_price) const;
+    /**
+     * Append the products priced within the bounds to docs, in price
+     * order. Stops and returns false once docs holds limit entries.
+     */
+    bool prices_between(double min_price, double max_price, size_t limit,
+                        std::vector<std::pair<DocId, double>>& docs) const;
+    /** The first limit hits, best score first and then oldest, in order. */
+    std::vector<Ptr> best(std::vector<std::pair<DocId, double>>& hits, size_t limit) const;
+    std::vector<Ptr> browse(const std::string& category_id,
+                            double min_price, double max_price, size_t limit) const;
+};
+
+} // namespace marketplace
+} // namespace gnc
+
+#endif // GNC_MARKETPLACE_PRODUCT_SEARCH_HPP
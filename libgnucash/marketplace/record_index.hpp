@@ -0,0 +1,194 @@
+/*
+ * libgnucash/marketplace/record_index.hpp
+ *
+ * Secondary indices over immutable record snapshots
+ *
+ * Records are stored as shared pointers to const snapshots and filed
+ * under any number of posting lists, each a set ordered by a sort key
+ * and then by the record's sequence number. A query walks one posting
+ * list from a cursor, so its cost depends on the page size and the
+ * logarithm of the list, not on how many records there are, and the
+ * page shares the snapshots instead of copying them.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_MARKETPLACE_RECORD_INDEX_HPP
+#define GNC_MARKETPLACE_RECORD_INDEX_HPP
+
+#include "marketplace_types.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gnc {
+namespace marketplace {
+
+/**
+ * RecordIndex - posting lists of T snapshots. Safe to use from any thread.
+ *
+ * The KeyFn names the posting lists a record belongs to, with the sort
+ * key it takes in each; records with equal sort keys are ordered by
+ * sequence number, which callers hand out in creation order.
+ */
+template<typename T>
+class RecordIndex
+{
+public:
+    using Ptr = std::shared_ptr<const T>;
+
+    struct Key
+    {
+        std::string posting;
+        int64_t order;
+    };
+
+    using KeyFn = std::function<void(const T&, std::vector<Key>&)>;
+
+    explicit RecordIndex(KeyFn keys)
+        : m_keys(std::move(keys))
+    {}
+
+    /**
+     * File record under seq, replacing and unfiling the record that was
+     * there. A null record only removes.
+     */
+    void put(uint64_t seq, Ptr record)
+    {
+        std::vector<Key> keys;
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_records.find(seq);
+        if (it != m_records.end()) {
+            m_keys(*it->second, keys);
+            for (const auto& key : keys)
+                unfile(key, seq);
+            keys.clear();
+        }
+        if (!record) {
+            if (it != m_records.end())
+                m_records.erase(it);
+            return;
+        }
+        m_keys(*record, keys);
+        for (const auto& key : keys)
+            m_postings[key.posting].emplace(key.order, seq);
+        m_records[seq] = std::move(record);
+    }
+
+    /**
+     * Up to limit records of a posting list following cursor, which is
+     * empty for the first page. The page's next_cursor continues it.
+     * With a filter, records it rejects are skipped; they still cost a
+     * step each, so it suits lists the filter keeps most of.
+     */
+    Page<T> page(const std::string& posting, size_t limit, const std::string& cursor,
+                 const std::function<bool(const T&)>& filter = nullptr) const
+    {
+        Page<T> result;
+        Entry after{INT64_MIN, 0};
+        bool resume = !cursor.empty();
+        if (resume && !decode(cursor, after))
+            return result;
+
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto list = m_postings.find(posting);
+        if (list == m_postings.end()) return result;
+        auto it = resume ? list->second.upper_bound(after) : list->second.begin();
+        auto last = it;
+        for (; it != list->second.end() && result.items.size() < limit; ++it) {
+            const auto& record = m_records.at(it->second);
+            if (filter && !filter(*record)) continue;
+            result.items.push_back(record);
+            last = it;
+        }
+        if (!result.items.empty() && it != list->second.end())
+            result.next_cursor = encode(*last);
+        return result;
+    }
+
+    /**
+     * Records offset to offset + limit of a posting list. Reaching the
+     * offset walks the list, so deep pages should use page() instead.
+     */
+    std::vector<Ptr> slice(const std::string& posting, size_t offset, size_t limit) const
+    {
+        std::vector<Ptr> result;
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto list = m_postings.find(posting);
+        if (list == m_postings.end() || offset >= list->second.size()) return result;
+        auto it = std::next(list->second.begin(), static_cast<std::ptrdiff_t>(offset));
+        for (; it != list->second.end() && result.size() < limit; ++it)
+            result.push_back(m_records.at(it->second));
+        return result;
+    }
+
+    /**
+     * Call fn(const T&) for every record of a posting list whose sort key
+     * is in [low, high], in order, under a shared lock.
+     */
+    template<typename Fn>
+    void range(const std::string& posting, int64_t low, int64_t high, Fn&& fn) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto list = m_postings.find(posting);
+        if (list == m_postings.end()) return;
+        for (auto it = list->second.lower_bound(Entry{low, 0});
+             it != list->second.end() && it->first <= high; ++it)
+            fn(*m_records.at(it->second));
+    }
+
+    size_t count(const std::string& posting) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto list = m_postings.find(posting);
+        return list == m_postings.end() ? 0 : list->second.size();
+    }
+
+private:
+    using Entry = std::pair<int64_t, uint64_t>;     // sort key, sequence
+
+    mutable std::shared_mutex m_mutex;
+    KeyFn m_keys;
+    std::unordered_map<uint64_t, Ptr> m_records;
+    std::unordered_map<std::string, std::set<Entry>> m_postings;
+
+    void unfile(const Key& key, uint64_t seq)
+    {
+        auto list = m_postings.find(key.posting);
+        if (list == m_postings.end()) return;
+        list->second.erase(Entry{key.order, seq});
+        if (list->second.empty())
+            m_postings.erase(list);
+    }
+
+    static std::string encode(const Entry& entry)
+    {
+        return std::to_string(entry.first) + ":" + std::to_string(entry.second);
+    }
+
+    static bool decode(const std::string& cursor, Entry& entry)
+    {
+        char* end = nullptr;
+        entry.first = std::strtoll(cursor.c_str(), &end, 10);
+        if (end == cursor.c_str() || *end != ':') return false;
+        const char* seq = end + 1;
+        entry.second = std::strtoull(seq, &end, 10);
+        return end != seq && *end == '\0';
+    }
+};
+
+} // namespace marketplace
+} // namespace gnc
+
+#endif // GNC_MARKETPLACE_RECORD_INDEX_HPP
@@ -0,0 +1,212 @@
+/*
+ * libgnucash/marketplace/sharded_map.hpp
+ *
+ * Hash map split into independently locked shards
+ *
+ * Each key lives in one of a fixed number of shards, each an
+ * unordered_map behind its own shared_mutex. Readers of different keys
+ * never contend, and writers only contend when their keys share a shard.
+ * update_all() locks several shards in index order, so operations that
+ * must see a consistent set of keys cannot deadlock with each other.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_MARKETPLACE_SHARDED_MAP_HPP
+#define GNC_MARKETPLACE_SHARDED_MAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace gnc {
+namespace marketplace {
+
+/**
+ * ShardedMap - a concurrent map from Key to Value.
+ *
+ * Values are only reached through callbacks that run under the shard
+ * lock, or copied out, so no reference outlives its lock. Callbacks must
+ * not call back into the same map.
+ */
+template<typename Key, typename Value, size_t Shards = 16,
+         typename Hash = std::hash<Key>>
+class ShardedMap
+{
+public:
+    static_assert(Shards > 0, "ShardedMap needs at least one shard");
+
+    /**
+     * Insert or replace the value for key.
+     */
+    void insert_or_assign(const Key& key, Value value)
+    {
+        auto& shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.map.insert_or_assign(key, std::move(value));
+    }
+
+    /**
+     * Insert value unless key is present. Returns true if it was inserted.
+     */
+    bool insert(const Key& key, Value value)
+    {
+        auto& shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.emplace(key, std::move(value)).second;
+    }
+
+    /**
+     * A copy of the value for key, if present.
+     */
+    std::optional<Value> find(const Key& key) const
+    {
+        auto& shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) return std::nullopt;
+        return it->second;
+    }
+
+    bool contains(const Key& key) const
+    {
+        auto& shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.count(key) > 0;
+    }
+
+    /**
+     * Call fn(const Value&) under a shared lock. Returns false if key is
+     * absent.
+     */
+    template<typename Fn>
+    bool visit(const Key& key, Fn&& fn) const
+    {
+        auto& shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) return false;
+        fn(it->second);
+        return true;
+    }
+
+    /**
+     * Call fn(Value&) under an exclusive lock. Returns false if key is
+     * absent.
+     */
+    template<typename Fn>
+    bool update(const Key& key, Fn&& fn)
+    {
+        auto& shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) return false;
+        fn(it->second);
+        return true;
+    }
+
+    /**
+     * Call fn(Value&) under an exclusive lock, first inserting a
+     * default-constructed value if key is absent.
+     */
+    template<typename Fn>
+    void upsert(const Key& key, Fn&& fn)
+    {
+        auto& shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        fn(shard.map[key]);
+    }
+
+    /**
+     * Lock the shards of all keys at once and call fn(values), where
+     * values[i] points to the value for keys[i] or is nullptr if absent.
+     * Returns what fn returns. No other writer sees a state between
+     * fn's changes to different keys.
+     */
+    template<typename Fn>
+    bool update_all(const std::vector<Key>& keys, Fn&& fn)
+    {
+        std::vector<size_t> indices;
+        indices.reserve(keys.size());
+        for (const auto& key : keys)
+            indices.push_back(shard_index(key));
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        locks.reserve(indices.size());
+        for (size_t index : indices)
+            locks.emplace_back(m_shards[index].mutex);
+
+        std::vector<Value*> values;
+        values.reserve(keys.size());
+        for (const auto& key : keys) {
+            auto& map = m_shards[shard_index(key)].map;
+            auto it = map.find(key);
+            values.push_back(it == map.end() ? nullptr : &it->second);
+        }
+        return fn(values);
+    }
+
+    /**
+     * Call fn(const Key&, const Value&) for every entry, one shard at a
+     * time under its shared lock. Entries changed meanwhile in shards
+     * not yet visited are seen in their new state.
+     */
+    template<typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        for (const auto& shard : m_shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            for (const auto& [key, value] : shard.map)
+                fn(key, value);
+        }
+    }
+
+    size_t size() const
+    {
+        size_t total = 0;
+        for (const auto& shard : m_shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            total += shard.map.size();
+        }
+        return total;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct alignas(CACHE_LINE) Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, Value, Hash> map;
+    };
+
+    std::array<Shard, Shards> m_shards;
+
+    size_t shard_index(const Key& key) const
+    {
+        // Mix the hash so keys with a shared prefix and sequential
+        // suffix, like generated ids, spread over the shards.
+        size_t h = Hash{}(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h % Shards;
+    }
+
+    Shard& shard_for(const Key& key) { return m_shards[shard_index(key)]; }
+    const Shard& shard_for(const Key& key) const { return m_shards[shard_index(key)]; }
+};
+
+} // namespace marketplace
+} // namespace gnc
+
+#endif // GNC_MARKETPLACE_SHARDED_MAP_HPP
@@ -9,10 +9,67 @@
 
 #include "storefront.hpp"
 
+#include <algorithm>
+
 namespace gnc {
 namespace marketplace {
 
-// Storefront management implementation (integrated into marketplace_engine.cpp)
+std::string StorefrontManager::save(const StorefrontInfo& storefront)
+{
+    auto id = storefront.id.empty() ? generate_id() : storefront.id;
+    m_storefronts.upsert(id, [&](StorefrontInfo& stored) {
+        bool existed = !stored.id.empty();
+        std::unique_lock<std::shared_mutex> lock(m_seller_mutex);
+        if (existed) {
+            auto sellers = m_by_seller.find(stored.seller_id);
+            if (sellers != m_by_seller.end()) {
+                sellers->second.erase(id);
+                if (sellers->second.empty())
+                    m_by_seller.erase(sellers);
+            }
+        }
+        m_by_seller[storefront.seller_id].insert(id);
+        stored = storefront;
+        stored.id = id;
+    });
+    return id;
+}
+
+StorefrontInfo StorefrontManager::get(const std::string& id) const
+{
+    return m_storefronts.find(id).value_or(StorefrontInfo{});
+}
+
+StorefrontInfo StorefrontManager::get_by_seller(const std::string& seller_id) const
+{
+    // The lowest id wins if a seller has several, as before.
+    std::string id;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_seller_mutex);
+        auto sellers = m_by_seller.find(seller_id);
+        if (sellers == m_by_seller.end()) return StorefrontInfo{};
+        id = *sellers->second.begin();
+    }
+    // The storefront may have changed seller since the lookup.
+    auto store = get(id);
+    return store.seller_id == seller_id ? store : StorefrontInfo{};
+}
+
+std::vector<StorefrontInfo> StorefrontManager::list() const
+{
+    std::vector<StorefrontInfo> results;
+    m_storefronts.for_each([&](const std::string&, const StorefrontInfo& store) {
+        results.push_back(store);
+    });
+    std::sort(results.begin(), results.end(),
+              [](const StorefrontInfo& a, const StorefrontInfo& b) { return a.id < b.id; });
+    return results;
+}
+
+std::string StorefrontManager::generate_id()
+{
+    return "STORE-" + std::to_string(m_next_id.fetch_add(1, std::memory_order_relaxed));
+}
 
 } // namespace marketplace
 } // namespace gnc
@@ -11,11 +11,46 @@
 #define GNC_MARKETPLACE_STOREFRONT_HPP
 
 #include "marketplace_types.hpp"
+#include "sharded_map.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace gnc {
 namespace marketplace {
 
-// Storefront management functions (currently integrated into MarketplaceEngine)
+/**
+ * StorefrontManager - seller storefronts. Safe to use from any thread.
+ */
+class StorefrontManager
+{
+public:
+    /**
+     * Store a storefront, generating an id if it has none. Returns the id.
+     */
+    std::string save(const StorefrontInfo& storefront);
+
+    StorefrontInfo get(const std::string& id) const;
+    StorefrontInfo get_by_seller(const std::string& seller_id) const;
+
+    /**
+     * All storefronts, ordered by id.
+     */
+    std::vector<StorefrontInfo> list() const;
+
+private:
+    ShardedMap<std::string, StorefrontInfo> m_storefronts;
+    std::atomic<uint64_t> m_next_id{3000};
+
+    // Storefront ids by seller, updated under the storefront's shard lock
+    mutable std::shared_mutex m_seller_mutex;
+    std::unordered_map<std::string, std::set<std::string>> m_by_seller;
+
+    std::string generate_id();
+};
 
 } // namespace marketplace
 } // namespace gnc
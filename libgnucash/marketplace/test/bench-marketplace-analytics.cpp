@@ -0,0 +1,111 @@
+/*
+ * libgnucash/marketplace/test/bench-marketplace-analytics.cpp
+ *
+ * Analytics latency benchmark for MarketplaceEngine
+ *
+ * Grows an order book spread over 1000 sellers, 10000 customers, 5000
+ * products and the last 90 days from 10k orders to the given size, ten
+ * times per step, cancelling one order in ten. At each size it times the
+ * calls a dashboard polls: marketplace stats, a seller's sales over 30
+ * days, a customer's analytics and a seller's product performance. With
+ * the rollups kept up to date as orders change, each should stay flat as
+ * the order book grows.
+ *
+ * Usage: bench-marketplace-analytics [max_orders [queries]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../marketplace_engine.hpp"
+#include "../../opencog/test/bench-common.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace gnc::marketplace;
+using namespace gnc::bench;
+
+namespace {
+
+const size_t SELLERS = 1000;
+const size_t CUSTOMERS = 10000;
+const size_t PRODUCTS = 5000;
+const size_t DAYS = 90;
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t max_orders = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    if (max_orders < 10000 || queries == 0) {
+        std::fprintf(stderr, "Usage: %s [max_orders (>= 10000) [queries]]\n", argv[0]);
+        return 1;
+    }
+
+    MarketplaceEngine engine;
+    std::vector<std::string> products;
+    for (size_t p = 0; p < PRODUCTS; ++p) {
+        ProductInfo product;
+        product.seller_id = "SELLER-" + std::to_string(p % SELLERS);
+        product.name = "Product " + std::to_string(p);
+        product.base_price = 1.0 + p % 100;
+        product.currency = "USD";
+        product.status = ProductStatus::ACTIVE;
+        product.stock_quantity = 0;
+        products.push_back(engine.create_product(product));
+    }
+
+    auto day = std::chrono::hours(24);
+    auto now = std::chrono::system_clock::now();
+    size_t orders = 0;
+    volatile double sink = 0;
+
+    for (size_t target = 10000; target <= max_orders; target *= 10) {
+        auto start = Clock::now();
+        for (; orders < target; ++orders) {
+            size_t p = orders % PRODUCTS;
+            OrderInfo order;
+            order.customer_id = "CUST-" + std::to_string(orders % CUSTOMERS);
+            order.seller_id = "SELLER-" + std::to_string(p % SELLERS);
+            order.status = OrderStatus::PENDING;
+            OrderItem item;
+            item.product_id = products[p];
+            item.quantity = 0;      // no stock to reserve
+            item.unit_price = 1.0 + p % 100;
+            item.total_price = item.unit_price;
+            order.items.push_back(item);
+            order.total_amount = item.total_price;
+            order.created_at = now - (orders % DAYS) * day;
+            auto id = engine.create_order(order);
+            if (orders % 10 == 0)
+                engine.cancel_order(id, "bench");
+        }
+        std::printf("%zu orders (built in %.2f s)\n", orders, seconds_since(start));
+
+        report("marketplace stats", time_queries(queries, [&](size_t) {
+            sink = sink + engine.get_stats().total_revenue;
+        }), queries, "query");
+
+        report("seller sales, 30 days", time_queries(queries, [&](size_t q) {
+            auto seller = "SELLER-" + std::to_string(q % SELLERS);
+            sink = sink + engine.get_sales_analytics(seller, now - 30 * day, now)
+                              .metrics["total_revenue"];
+        }), queries, "query");
+
+        report("customer analytics", time_queries(queries, [&](size_t q) {
+            auto customer = "CUST-" + std::to_string(q % CUSTOMERS);
+            sink = sink + engine.get_customer_analytics(customer).metrics["total_spent"];
+        }), queries, "query");
+
+        report("seller product performance", time_queries(queries, [&](size_t q) {
+            auto seller = "SELLER-" + std::to_string(q % SELLERS);
+            sink = sink + engine.get_product_performance(seller).size();
+        }), queries, "query");
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * libgnucash/marketplace/test/bench-marketplace-checkout.cpp
+ *
+ * Checkout stress benchmark for MarketplaceEngine
+ *
+ * Buyer threads place orders of one to three lines against a small
+ * catalog whose stock covers about half the demand, so products sell
+ * out while orders are still racing for them. For 1, 2, 4, ... threads
+ * it reports checkout throughput, how many orders succeeded, and the
+ * oversell count: units sold beyond a product's initial stock, which
+ * must be zero, and products whose remaining stock disagrees with what
+ * was sold.
+ *
+ * Usage: bench-marketplace-checkout [orders [max_threads [products]]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../marketplace_engine.hpp"
+#include "../../opencog/test/bench-common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace gnc::marketplace;
+using namespace gnc::bench;
+
+namespace {
+
+struct Result
+{
+    double secs;
+    size_t placed;
+    size_t succeeded;
+    long long oversold;
+    size_t inconsistent;
+};
+
+Result run(size_t threads, size_t orders, size_t products)
+{
+    MarketplaceEngine engine;
+
+    // Orders average two lines of two units, spread evenly over products.
+    const int stock = static_cast<int>(std::max<size_t>(1, orders * 2 / products));
+    std::vector<std::string> ids;
+    for (size_t p = 0; p < products; ++p) {
+        ProductInfo product;
+        product.seller_id = "SELLER-BENCH";
+        product.name = "Bench product " + std::to_string(p);
+        product.base_price = 10.0;
+        product.currency = "USD";
+        product.status = ProductStatus::ACTIVE;
+        product.stock_quantity = stock;
+        ids.push_back(engine.create_product(product));
+    }
+
+    std::vector<std::vector<long long>> sold(threads, std::vector<long long>(products, 0));
+    std::vector<size_t> succeeded(threads, 0);
+    size_t per_thread = orders / threads;
+
+    auto start = Clock::now();
+    std::vector<std::thread> buyers;
+    for (size_t t = 0; t < threads; ++t) {
+        buyers.emplace_back([&, t]() {
+            std::mt19937 rng(static_cast<unsigned>(t + 1));
+            std::uniform_int_distribution<size_t> pick(0, products - 1);
+            std::uniform_int_distribution<int> lines(1, 3), units(1, 3);
+            for (size_t i = 0; i < per_thread; ++i) {
+                OrderInfo order;
+                order.customer_id = "CUST-BENCH";
+                order.seller_id = "SELLER-BENCH";
+                order.status = OrderStatus::PENDING;
+                std::vector<size_t> picked;
+                for (int l = lines(rng); l > 0; --l) {
+                    OrderItem item;
+                    picked.push_back(pick(rng));
+                    item.product_id = ids[picked.back()];
+                    item.quantity = units(rng);
+                    order.items.push_back(item);
+                }
+                if (engine.create_order(order).empty()) continue;
+                ++succeeded[t];
+                for (size_t l = 0; l < picked.size(); ++l)
+                    sold[t][picked[l]] += order.items[l].quantity;
+            }
+        });
+    }
+    for (auto& buyer : buyers)
+        buyer.join();
+    double secs = seconds_since(start);
+
+    Result result{secs, per_thread * threads, 0, 0, 0};
+    for (size_t t = 0; t < threads; ++t)
+        result.succeeded += succeeded[t];
+    for (size_t p = 0; p < products; ++p) {
+        long long total = 0;
+        for (size_t t = 0; t < threads; ++t)
+            total += sold[t][p];
+        if (total > stock)
+            result.oversold += total - stock;
+        if (engine.get_inventory(ids[p]).quantity_available != stock - total)
+            ++result.inconsistent;
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t orders = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+    size_t products = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+    if (orders == 0 || max_threads == 0 || products == 0) {
+        std::fprintf(stderr, "Usage: %s [orders [max_threads [products]]]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%zu orders over %zu products, %u hardware threads\n", orders, products,
+                std::thread::hardware_concurrency());
+    bool clean = true;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        Result r = run(threads, orders, products);
+        std::printf("%3zu threads %9.3f ms %10.0f orders/s %8zu succeeded "
+                    "%4lld oversold %4zu inconsistent\n",
+                    threads, r.secs * 1e3, r.placed / r.secs, r.succeeded,
+                    r.oversold, r.inconsistent);
+        clean = clean && r.oversold == 0 && r.inconsistent == 0;
+    }
+    return clean ? 0 : 1;
+}
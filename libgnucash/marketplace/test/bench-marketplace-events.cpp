@@ -0,0 +1,138 @@
+/*
+ * libgnucash/marketplace/test/bench-marketplace-events.cpp
+ *
+ * Checkout latency benchmark for MarketplaceEngine with slow subscribers
+ *
+ * Places a burst of orders while a subscriber that costs 50 us per call,
+ * like a round trip to an accounting service, listens to the events. It
+ * times create_order and then how long the subscriber takes to catch up:
+ * with no subscriber, with a per-event callback and a small queue (which
+ * fills, so backpressure paces checkout), with the same subscriber taking
+ * batches, and with a per-event callback that drops what does not fit.
+ *
+ * Usage: bench-marketplace-events [orders]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../marketplace_engine.hpp"
+#include "../../opencog/test/bench-common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace gnc::marketplace;
+using namespace gnc::bench;
+
+namespace {
+
+const auto CALL_COST = std::chrono::microseconds(50);
+
+void busy_wait(Clock::duration duration)
+{
+    auto until = Clock::now() + duration;
+    while (Clock::now() < until) {}
+}
+
+/**
+ * Place orders, then wait for the events to be delivered, and print the
+ * checkout latency and the catch-up time.
+ */
+void run(const char* label, size_t orders, std::atomic<size_t>& delivered,
+         const std::function<void(MarketplaceEngine&)>& subscribe)
+{
+    MarketplaceEngine engine;
+    subscribe(engine);
+
+    ProductInfo product;
+    product.seller_id = "SELLER-1";
+    product.name = "Widget";
+    product.base_price = 10.0;
+    product.currency = "USD";
+    product.status = ProductStatus::ACTIVE;
+    product.stock_quantity = static_cast<int>(orders);
+    auto product_id = engine.create_product(product);
+
+    OrderInfo order;
+    order.customer_id = "CUST-1";
+    order.seller_id = "SELLER-1";
+    order.status = OrderStatus::PENDING;
+    OrderItem item;
+    item.product_id = product_id;
+    item.quantity = 1;
+    item.unit_price = 10.0;
+    item.total_price = 10.0;
+    order.items.push_back(item);
+    order.total_amount = 10.0;
+
+    std::vector<double> latencies;
+    latencies.reserve(orders);
+    auto start = Clock::now();
+    for (size_t i = 0; i < orders; ++i) {
+        auto placed = Clock::now();
+        engine.create_order(order);
+        latencies.push_back(seconds_since(placed) * 1e6);
+    }
+    double placing = seconds_since(start);
+    engine.flush_events();
+    double catching_up = seconds_since(start) - placing;
+
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("  %-34s %8.2f us/order  p99 %8.2f us  caught up after %6.3f s  "
+                "%zu events delivered\n",
+                label, placing * 1e6 / orders, latencies[latencies.size() * 99 / 100],
+                catching_up, delivered.load());
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t orders = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    if (orders == 0) {
+        std::fprintf(stderr, "Usage: %s [orders]\n", argv[0]);
+        return 1;
+    }
+    std::printf("%zu orders, subscriber costs %lld us per call\n", orders,
+                static_cast<long long>(CALL_COST.count()));
+
+    std::atomic<size_t> delivered{0};
+    run("no subscriber", orders, delivered, [](MarketplaceEngine&) {});
+
+    delivered = 0;
+    run("per-event callback, blocking", orders, delivered, [&](MarketplaceEngine& engine) {
+        engine.subscribe_events([&](const std::string&, const std::string&) {
+            busy_wait(CALL_COST);
+            ++delivered;
+        });
+    });
+
+    delivered = 0;
+    run("batches of up to 256, blocking", orders, delivered, [&](MarketplaceEngine& engine) {
+        EventSubscriberOptions options;
+        options.max_batch = 256;
+        engine.subscribe_event_batches([&](const std::vector<MarketplaceEvent>& events) {
+            busy_wait(CALL_COST);
+            delivered += events.size();
+        }, options);
+    });
+
+    delivered = 0;
+    run("per-event callback, dropping", orders, delivered, [&](MarketplaceEngine& engine) {
+        EventSubscriberOptions options;
+        options.max_batch = 1;
+        options.overflow = EventOverflow::DROP;
+        engine.subscribe_event_batches([&](const std::vector<MarketplaceEvent>& events) {
+            busy_wait(CALL_COST);
+            delivered += events.size();
+        }, options);
+    });
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * libgnucash/marketplace/test/bench-marketplace-listing.cpp
+ *
+ * Listing latency benchmark for MarketplaceEngine
+ *
+ * Grows a catalog of products spread over 1000 sellers and 50 categories
+ * from 10k to the given size, ten times per step, with an order per ten
+ * products. At each size it times the listing calls dashboards make: a
+ * first page of the whole catalog, a seller's page, a seller's page in
+ * one category, a page 500 deep through the cursor, and a customer's
+ * order history. With secondary indices each should stay flat as the
+ * catalog grows.
+ *
+ * Usage: bench-marketplace-listing [max_products [queries]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../marketplace_engine.hpp"
+#include "../../opencog/test/bench-common.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace gnc::marketplace;
+using namespace gnc::bench;
+
+namespace {
+
+const size_t SELLERS = 1000;
+const size_t CATEGORIES = 50;
+const size_t CUSTOMERS = 10000;
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t max_products = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    if (max_products < 10000 || queries == 0) {
+        std::fprintf(stderr, "Usage: %s [max_products (>= 10000) [queries]]\n", argv[0]);
+        return 1;
+    }
+
+    MarketplaceEngine engine;
+    std::string first_product;
+    size_t products = 0;
+    volatile size_t sink = 0;
+
+    for (size_t target = 10000; target <= max_products; target *= 10) {
+        auto start = Clock::now();
+        for (; products < target; ++products) {
+            ProductInfo product;
+            product.seller_id = "SELLER-" + std::to_string(products % SELLERS);
+            product.category_id = "CAT-" + std::to_string(products % CATEGORIES);
+            product.name = "Product " + std::to_string(products);
+            product.base_price = 1.0 + products % 100;
+            product.currency = "USD";
+            product.status = ProductStatus::ACTIVE;
+            product.stock_quantity = 100;
+            auto id = engine.create_product(product);
+            if (first_product.empty()) first_product = id;
+
+            if (products % 10 == 0) {
+                OrderInfo order;
+                order.customer_id = "CUST-" + std::to_string(products / 10 % CUSTOMERS);
+                order.seller_id = product.seller_id;
+                order.status = OrderStatus::PENDING;
+                OrderItem item;
+                item.product_id = first_product;
+                item.quantity = 0;
+                order.items.push_back(item);
+                order.total_amount = product.base_price;
+                engine.create_order(order);
+            }
+        }
+        std::printf("%zu products, %zu orders (built in %.2f s)\n", products, products / 10,
+                    seconds_since(start));
+
+        report("first page of catalog", time_queries(queries, [&](size_t) {
+            sink = sink + engine.query_products("", "", ProductStatus::ACTIVE, 20).items.size();
+        }), queries, "query");
+
+        report("seller page", time_queries(queries, [&](size_t q) {
+            auto seller = "SELLER-" + std::to_string(q % SELLERS);
+            sink = sink + engine.query_products(seller, "", ProductStatus::ACTIVE, 20).items.size();
+        }), queries, "query");
+
+        report("seller + category page", time_queries(queries, [&](size_t q) {
+            auto seller = "SELLER-" + std::to_string(q % SELLERS);
+            auto category = "CAT-" + std::to_string(q % CATEGORIES);
+            sink = sink + engine.query_products(seller, category, ProductStatus::ACTIVE, 20)
+                              .items.size();
+        }), queries, "query");
+
+        // Walk 500 pages once, then time fetching the page after that.
+        auto deep = engine.query_products("", "", ProductStatus::ACTIVE, 20);
+        for (int p = 0; p < 500 && !deep.next_cursor.empty(); ++p)
+            deep = engine.query_products("", "", ProductStatus::ACTIVE, 20, deep.next_cursor);
+        report("page 500 by cursor", time_queries(queries, [&](size_t) {
+            sink = sink + engine.query_products("", "", ProductStatus::ACTIVE, 20,
+                                                deep.next_cursor).items.size();
+        }), queries, "query");
+
+        report("customer order history", time_queries(queries, [&](size_t q) {
+            auto customer = "CUST-" + std::to_string(q % CUSTOMERS);
+            sink = sink + engine.get_customer_orders(customer).size();
+        }), queries, "query");
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * libgnucash/marketplace/test/bench-marketplace-search.cpp
+ *
+ * Query latency benchmark for MarketplaceEngine::search_products
+ *
+ * Builds a catalog whose names and descriptions draw words from a
+ * Zipf-distributed vocabulary, then times searches for a common word, a
+ * rare word, two words, a typed prefix, a common word within a category
+ * or a price range, and a price range alone. For comparison it times the
+ * substring scan over every name and description that search_products
+ * used before the index.
+ *
+ * Usage: bench-marketplace-search [products [queries]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../marketplace_engine.hpp"
+#include "../../opencog/test/bench-common.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace gnc::marketplace;
+using namespace gnc::bench;
+
+namespace {
+
+const size_t VOCABULARY = 5000;
+const size_t CATEGORIES = 100;
+
+/** Pronounceable, distinct words: two to four syllables from the rank. */
+std::string make_word(size_t rank)
+{
+    static const char* syllables[] = {"ka", "lo", "mi", "ne", "su", "ta", "ri", "po",
+                                      "de", "va", "zo", "bu", "chi", "fen", "gor", "hal"};
+    std::string word;
+    size_t n = rank + 16;
+    do {
+        word += syllables[n % 16];
+        n /= 16;
+    } while (n > 0);
+    return word;
+}
+
+void report(const char* label, double secs, size_t queries, size_t found)
+{
+    std::printf("  %-30s %10.2f us/query %8.1f results\n", label, secs * 1e6 / queries,
+                static_cast<double>(found) / queries);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t products = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    if (products == 0 || queries == 0) {
+        std::fprintf(stderr, "Usage: %s [products [queries]]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> words;
+    std::vector<double> weights;
+    for (size_t r = 0; r < VOCABULARY; ++r) {
+        words.push_back(make_word(r));
+        weights.push_back(1.0 / (r + 1));
+    }
+    std::mt19937 rng(7);
+    std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+    auto text = [&](size_t count) {
+        std::string s;
+        for (size_t i = 0; i < count; ++i)
+            s += (i ? " " : "") + words[zipf(rng)];
+        return s;
+    };
+
+    MarketplaceEngine engine;
+    std::vector<std::pair<std::string, std::string>> texts;     // for the scan
+    auto start = Clock::now();
+    for (size_t p = 0; p < products; ++p) {
+        ProductInfo product;
+        product.seller_id = "SELLER-" + std::to_string(p % 1000);
+        product.category_id = "CAT-" + std::to_string(p % CATEGORIES);
+        product.name = text(3);
+        product.description = text(12);
+        product.base_price = 1.0 + static_cast<double>(rng() % 50000) / 100.0;
+        product.currency = "USD";
+        product.status = ProductStatus::ACTIVE;
+        product.stock_quantity = 10;
+        texts.emplace_back(product.name, product.description);
+        engine.create_product(product);
+    }
+    std::printf("%zu products indexed in %.2f s\n", products, seconds_since(start));
+
+    auto run_queries = [&](const char* label, auto&& query) {
+        size_t found = 0;
+        auto begin = Clock::now();
+        for (size_t q = 0; q < queries; ++q)
+            found += query(q);
+        report(label, seconds_since(begin), queries, found);
+    };
+    auto common = [&](size_t q) { return words[q % 10]; };
+    auto rare = [&](size_t q) { return words[1000 + q * 7 % 4000]; };
+    auto middling = [&](size_t q) { return words[100 + q * 3 % 400]; };
+
+    run_queries("common word", [&](size_t q) {
+        return engine.search_products(common(q), "", 0, 0, 20).size();
+    });
+    run_queries("rare word", [&](size_t q) {
+        return engine.search_products(rare(q), "", 0, 0, 20).size();
+    });
+    run_queries("common + middling word", [&](size_t q) {
+        return engine.search_products(common(q) + " " + middling(q), "", 0, 0, 20).size();
+    });
+    run_queries("prefix of a middling word", [&](size_t q) {
+        return engine.search_products(middling(q).substr(0, 4), "", 0, 0, 20).size();
+    });
+    run_queries("common word in a category", [&](size_t q) {
+        return engine.search_products(common(q), "CAT-" + std::to_string(q % CATEGORIES),
+                                      0, 0, 20).size();
+    });
+    run_queries("common word, price 10-20", [&](size_t q) {
+        return engine.search_products(common(q), "", 10.0, 20.0, 20).size();
+    });
+    run_queries("price 10-11 alone", [&](size_t) {
+        return engine.search_products("", "", 10.0, 11.0, 20).size();
+    });
+
+    // The substring scan is slow enough that a few queries tell.
+    size_t scans = std::min<size_t>(queries, 20);
+    size_t found = 0;
+    start = Clock::now();
+    for (size_t q = 0; q < scans; ++q) {
+        auto word = rare(q);
+        for (const auto& [name, description] : texts)
+            found += name.find(word) != std::string::npos ||
+                     description.find(word) != std::string::npos;
+    }
+    report("rare word, substring scan", seconds_since(start), scans, found);
+    return 0;
+}
@@ -10,13 +10,22 @@
 #include <gtest/gtest.h>
 #include "../marketplace_engine.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
 using namespace gnc::marketplace;
 
 class MarketplaceTest : public ::testing::Test
 {
 protected:
     void SetUp() override {
-        engine = &marketplace_engine();
+        engine = std::make_unique<MarketplaceEngine>();
         engine->initialize();
     }
 
@@ -24,7 +33,36 @@ protected:
         engine->shutdown();
     }
 
-    MarketplaceEngine* engine;
+    /**
+     * Shut the engine down and deliver its last events. Tests whose
+     * subscribers capture locals call this at the end, while they live.
+     */
+    void shutdown_engine() {
+        engine->shutdown();
+        engine->flush_events();
+    }
+
+    /**
+     * Create an active product priced in USD and return its id.
+     */
+    std::string add_product(const std::string& name, const std::string& category_id = "",
+                            double price = 10.0, int stock = 10,
+                            const std::string& seller_id = "SELLER-001",
+                            const std::string& description = "")
+    {
+        ProductInfo product;
+        product.seller_id = seller_id;
+        product.category_id = category_id;
+        product.name = name;
+        product.description = description;
+        product.base_price = price;
+        product.currency = "USD";
+        product.status = ProductStatus::ACTIVE;
+        product.stock_quantity = stock;
+        return engine->create_product(product);
+    }
+
+    std::unique_ptr<MarketplaceEngine> engine;
 };
 
 TEST_F(MarketplaceTest, Initialization)
@@ -224,6 +262,798 @@ TEST_F(MarketplaceTest, GetStats)
     EXPECT_GE(stats.total_revenue, 0.0);
 }
 
+// ============================================================================
+// Concurrency Tests
+// ============================================================================
+
+static OrderInfo order_for(const std::vector<std::pair<std::string, int>>& lines)
+{
+    OrderInfo order;
+    order.customer_id = "CUST-001";
+    order.seller_id = "SELLER-001";
+    order.status = OrderStatus::PENDING;
+    for (const auto& [product_id, quantity] : lines) {
+        OrderItem item;
+        item.product_id = product_id;
+        item.quantity = quantity;
+        item.unit_price = 10.0;
+        item.total_price = 10.0 * quantity;
+        order.items.push_back(item);
+    }
+    return order;
+}
+
+TEST_F(MarketplaceTest, ConcurrentCheckoutNeverOversells)
+{
+    auto product_id = add_product("Stocked Product", "", 10.0, 100);
+
+    std::atomic<int> sold{0};
+    std::vector<std::thread> buyers;
+    for (int t = 0; t < 8; ++t) {
+        buyers.emplace_back([&]() {
+            for (int i = 0; i < 50; ++i) {
+                if (!engine->create_order(order_for({{product_id, 1}})).empty())
+                    ++sold;
+            }
+        });
+    }
+    for (auto& buyer : buyers)
+        buyer.join();
+
+    EXPECT_EQ(sold.load(), 100);
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 0);
+}
+
+TEST_F(MarketplaceTest, MultiItemOrderIsAllOrNothing)
+{
+    auto plenty = add_product("Stocked Product", "", 10.0, 5);
+    auto scarce = add_product("Stocked Product", "", 10.0, 1);
+
+    EXPECT_TRUE(engine->create_order(order_for({{plenty, 2}, {scarce, 2}})).empty());
+    EXPECT_EQ(engine->get_inventory(plenty).quantity_available, 5);
+    EXPECT_EQ(engine->get_inventory(scarce).quantity_available, 1);
+
+    // Lines for the same product are checked against the stock together.
+    EXPECT_TRUE(engine->create_order(order_for({{plenty, 3}, {plenty, 3}})).empty());
+    EXPECT_TRUE(engine->create_order(order_for({{plenty, -1}})).empty());
+    EXPECT_TRUE(engine->create_order(order_for({{"PROD-MISSING", 1}})).empty());
+    EXPECT_EQ(engine->get_inventory(plenty).quantity_available, 5);
+
+    EXPECT_FALSE(engine->create_order(order_for({{plenty, 2}, {scarce, 1}, {plenty, 3}})).empty());
+    EXPECT_EQ(engine->get_inventory(plenty).quantity_available, 0);
+    EXPECT_EQ(engine->get_inventory(scarce).quantity_available, 0);
+}
+
+TEST_F(MarketplaceTest, ConcurrentCancelRestoresStockOnce)
+{
+    auto product_id = add_product("Stocked Product", "", 10.0, 10);
+    auto order_id = engine->create_order(order_for({{product_id, 4}}));
+    ASSERT_FALSE(order_id.empty());
+
+    std::atomic<int> cancelled{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            if (engine->cancel_order(order_id, "duplicate click"))
+                ++cancelled;
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(cancelled.load(), 1);
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 10);
+    EXPECT_EQ(engine->get_order(order_id).status, OrderStatus::CANCELLED);
+}
+
+TEST_F(MarketplaceTest, StatusChangesMoveStockLikeCancel)
+{
+    auto product_id = add_product("Stocked Product", "", 10.0, 10);
+    auto order_id = engine->create_order(order_for({{product_id, 4}}));
+    ASSERT_FALSE(order_id.empty());
+
+    ASSERT_TRUE(engine->update_order_status(order_id, OrderStatus::CANCELLED));
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 10);
+    EXPECT_FALSE(engine->update_order_status(order_id, OrderStatus::CANCELLED));
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 10);
+
+    // Reopening takes the stock again, and only while there is enough.
+    ASSERT_TRUE(engine->update_order_status(order_id, OrderStatus::PENDING));
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 6);
+    ASSERT_TRUE(engine->cancel_order(order_id, "test"));
+    engine->update_inventory(product_id, "", -8);
+    EXPECT_FALSE(engine->update_order_status(order_id, OrderStatus::PENDING));
+    EXPECT_EQ(engine->get_order(order_id).status, OrderStatus::CANCELLED);
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 2);
+}
+
+TEST_F(MarketplaceTest, VariantStockIsKeptApart)
+{
+    engine->update_inventory("PROD-1:RED", "", 5);
+    engine->update_inventory("PROD-1", "RED", 7);
+
+    EXPECT_EQ(engine->get_inventory("PROD-1:RED", "").quantity_available, 5);
+    EXPECT_EQ(engine->get_inventory("PROD-1", "RED").quantity_available, 7);
+}
+
+TEST_F(MarketplaceTest, GeneratedIdsAreUnique)
+{
+    std::mutex mutex;
+    std::set<std::string> ids;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 250; ++i) {
+                auto id = add_product("Stocked Product", "", 10.0, 1);
+                std::lock_guard<std::mutex> lock(mutex);
+                ids.insert(id);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(ids.size(), 1000u);
+    EXPECT_EQ(engine->list_products("SELLER-001", "", ProductStatus::ACTIVE, 2000).size(), 1000u);
+}
+
+TEST_F(MarketplaceTest, PaymentDetailsAreStored)
+{
+    auto product_id = add_product("Stocked Product", "", 10.0, 1);
+    auto order_id = engine->create_order(order_for({{product_id, 1}}));
+
+    EXPECT_TRUE(engine->process_payment(order_id, PaymentMethod::BANK_TRANSFER, "TX-42"));
+    auto order = engine->get_order(order_id);
+    EXPECT_EQ(order.status, OrderStatus::PAID);
+    EXPECT_EQ(order.payment_method, PaymentMethod::BANK_TRANSFER);
+    EXPECT_EQ(order.payment_transaction_id, "TX-42");
+}
+
+// ============================================================================
+// Index and Paging Tests
+// ============================================================================
+
+static std::vector<std::string> names_of(const std::vector<ProductInfo>& products)
+{
+    std::vector<std::string> names;
+    for (const auto& product : products)
+        names.push_back(product.name);
+    return names;
+}
+
+TEST_F(MarketplaceTest, ListingsFollowUpdates)
+{
+    auto a = add_product("a", "books", 10.0, 10, "S1");
+    add_product("b", "books", 10.0, 10, "S2");
+    auto c = add_product("c", "games", 10.0, 10, "S1");
+    add_product("d", "books", 10.0, 10, "S1");
+
+    using Names = std::vector<std::string>;
+    EXPECT_EQ(names_of(engine->list_products("S1")), (Names{"a", "c", "d"}));
+    EXPECT_EQ(names_of(engine->list_products("", "books")), (Names{"a", "b", "d"}));
+    EXPECT_EQ(names_of(engine->list_products("S1", "books")), (Names{"a", "d"}));
+    EXPECT_EQ(names_of(engine->list_products("", "", ProductStatus::ACTIVE, 2, 1)),
+              (Names{"b", "c"}));
+
+    EXPECT_TRUE(engine->delete_product(a));
+    auto moved = engine->get_product(c);
+    moved.category_id = "books";
+    EXPECT_TRUE(engine->update_product(c, moved));
+
+    EXPECT_EQ(names_of(engine->list_products("S1", "books")), (Names{"c", "d"}));
+    EXPECT_TRUE(engine->list_products("S1", "games").empty());
+    EXPECT_EQ(names_of(engine->list_products("S1", "", ProductStatus::ARCHIVED)), (Names{"a"}));
+    EXPECT_EQ(engine->get_stats().total_products, 3u);
+}
+
+TEST_F(MarketplaceTest, CursorPagesCoverListingOnce)
+{
+    for (int i = 0; i < 25; ++i)
+        add_product(std::to_string(i), "", 10.0, 10, i % 2 ? "odd" : "even");
+
+    std::vector<std::string> seen;
+    std::vector<size_t> sizes;
+    std::string cursor;
+    do {
+        auto page = engine->query_products("even", "", ProductStatus::ACTIVE, 5, cursor);
+        sizes.push_back(page.items.size());
+        for (const auto& product : page.items)
+            seen.push_back(product->name);
+        cursor = page.next_cursor;
+    } while (!cursor.empty());
+
+    EXPECT_EQ(sizes, (std::vector<size_t>{5, 5, 3}));
+    ASSERT_EQ(seen.size(), 13u);
+    for (size_t i = 0; i < seen.size(); ++i)
+        EXPECT_EQ(seen[i], std::to_string(2 * i));
+
+    // A page keeps its snapshots when the products change afterwards.
+    auto first = engine->query_products("even", "", ProductStatus::ACTIVE, 1);
+    ASSERT_EQ(first.items.size(), 1u);
+    engine->delete_product(first.items[0]->id);
+    EXPECT_EQ(first.items[0]->status, ProductStatus::ACTIVE);
+    EXPECT_EQ(engine->query_products("even", "", ProductStatus::ACTIVE, 100).items.size(), 12u);
+
+    EXPECT_TRUE(engine->query_products("even", "", ProductStatus::ACTIVE, 5, "bogus").items.empty());
+}
+
+TEST_F(MarketplaceTest, OrderQueriesUseCustomerSellerStatusAndDate)
+{
+    auto product_id = add_product("Stocked Product", "", 10.0, 100);
+    auto day = std::chrono::hours(24);
+    auto base = std::chrono::system_clock::now() - 10 * day;
+
+    std::vector<std::string> ids;
+    for (int i = 0; i < 6; ++i) {
+        auto order = order_for({{product_id, 1}});
+        order.customer_id = i % 2 ? "CUST-B" : "CUST-A";
+        order.seller_id = i < 3 ? "SELLER-X" : "SELLER-Y";
+        order.total_amount = 10.0 * (i + 1);
+        order.created_at = base + i * day;
+        ids.push_back(engine->create_order(order));
+    }
+    engine->update_order_status(ids[2], OrderStatus::SHIPPED);
+
+    EXPECT_EQ(engine->get_customer_orders("CUST-A").size(), 3u);
+    EXPECT_EQ(engine->list_orders("CUST-A", "SELLER-X").size(), 2u);
+    auto shipped = engine->list_orders("", "SELLER-X", OrderStatus::SHIPPED);
+    ASSERT_EQ(shipped.size(), 1u);
+    EXPECT_EQ(shipped[0].id, ids[2]);
+
+    auto page = engine->query_orders("CUST-B", "", OrderStatus::PENDING, 2);
+    ASSERT_EQ(page.items.size(), 2u);
+    EXPECT_EQ(page.items[0]->id, ids[1]);
+    auto rest = engine->query_orders("CUST-B", "", OrderStatus::PENDING, 2, page.next_cursor);
+    ASSERT_EQ(rest.items.size(), 1u);
+    EXPECT_EQ(rest.items[0]->id, ids[5]);
+    EXPECT_TRUE(rest.next_cursor.empty());
+
+    // Days 1 to 4 of SELLER-X, which only has orders on days 0 to 2.
+    auto sales = engine->get_sales_analytics("SELLER-X", base + day, base + 4 * day);
+    EXPECT_EQ(sales.counts["total_orders"], 2);
+    EXPECT_DOUBLE_EQ(sales.metrics["total_revenue"], 50.0);
+}
+
+TEST_F(MarketplaceTest, StorefrontBySellerFollowsSave)
+{
+    StorefrontInfo store;
+    store.seller_id = "SELLER-1";
+    store.name = "First";
+    auto id = engine->save_storefront(store);
+    EXPECT_EQ(engine->get_storefront_by_seller("SELLER-1").name, "First");
+
+    store.id = id;
+    store.seller_id = "SELLER-2";
+    engine->save_storefront(store);
+    EXPECT_TRUE(engine->get_storefront_by_seller("SELLER-1").id.empty());
+    EXPECT_EQ(engine->get_storefront_by_seller("SELLER-2").id, id);
+}
+
+// ============================================================================
+// Search Tests
+// ============================================================================
+
+TEST_F(MarketplaceTest, SearchMatchesEveryWordIgnoringCaseAndPunctuation)
+{
+    add_product("USB-C Cable", "cables", 9.0, 10, "SELLER-001", "Braided, 2m");
+    add_product("Mechanical Keyboard", "input", 80.0, 10, "SELLER-001", "RGB backlit");
+    add_product("Wireless Mouse", "input", 25.0, 10, "SELLER-001", "Pairs over USB");
+
+    using Names = std::vector<std::string>;
+    EXPECT_EQ(names_of(engine->search_products("usb c")), (Names{"USB-C Cable"}));
+    EXPECT_EQ(names_of(engine->search_products("BRAIDED cable")), (Names{"USB-C Cable"}));
+    EXPECT_EQ(engine->search_products("usb").size(), 2u);
+    EXPECT_TRUE(engine->search_products("usb keyboard").empty());
+
+    // Only the last word matches as a prefix.
+    EXPECT_EQ(names_of(engine->search_products("mech")), (Names{"Mechanical Keyboard"}));
+    EXPECT_EQ(names_of(engine->search_products("rgb back")), (Names{"Mechanical Keyboard"}));
+    EXPECT_TRUE(engine->search_products("mech keyboard").empty());
+}
+
+TEST_F(MarketplaceTest, SearchRanksNameMatchesAndRareWordsFirst)
+{
+    add_product("Desk lamp", "", 30.0, 10, "SELLER-001", "Warm light for a wooden desk");
+    add_product("Wooden desk", "", 200.0, 10, "SELLER-001", "Oak desk with drawers");
+    add_product("Desk organiser", "", 15.0, 10, "SELLER-001", "Bamboo");
+
+    auto results = engine->search_products("desk");
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].name, "Wooden desk");
+
+    results = engine->search_products("wooden desk");
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].name, "Wooden desk");
+    EXPECT_EQ(results[1].name, "Desk lamp");
+
+    EXPECT_EQ(engine->search_products("desk", "", 0.0, 0.0, 1).size(), 1u);
+}
+
+TEST_F(MarketplaceTest, SearchFiltersByCategoryAndPrice)
+{
+    for (int i = 0; i < 20; ++i) {
+        add_product("Notebook " + std::to_string(i), i % 2 ? "odd" : "even", 1.0 + i, 10,
+                    "SELLER-001", "Paper");
+    }
+
+    auto results = engine->search_products("notebook", "odd", 5.0, 10.0);
+    std::vector<double> prices;
+    for (const auto& product : results)
+        prices.push_back(product.base_price);
+    std::sort(prices.begin(), prices.end());
+    EXPECT_EQ(prices, (std::vector<double>{6.0, 8.0, 10.0}));
+
+    // Without words the filters alone select, in creation order.
+    using Names = std::vector<std::string>;
+    EXPECT_EQ(names_of(engine->search_products("", "", 18.0, 0.0)),
+              (Names{"Notebook 17", "Notebook 18", "Notebook 19"}));
+    EXPECT_EQ(engine->search_products("", "even").size(), 10u);
+    EXPECT_TRUE(engine->search_products("notebook", "missing").empty());
+}
+
+TEST_F(MarketplaceTest, SearchNarrowFiltersGiveTheSameMatches)
+{
+    // Every product is a widget, so the category or the price range is
+    // the shortest list and the words are intersected into it.
+    for (int i = 0; i < 300; ++i) {
+        add_product("Widget " + std::to_string(i), "cat-" + std::to_string(i % 10), i + 1.0,
+                    10, "SELLER-001", i % 2 ? "blue" : "red");
+    }
+
+    auto prices_of = [](const std::vector<ProductInfo>& products) {
+        std::vector<double> prices;
+        for (const auto& product : products)
+            prices.push_back(product.base_price);
+        std::sort(prices.begin(), prices.end());
+        return prices;
+    };
+    using Prices = std::vector<double>;
+    EXPECT_EQ(prices_of(engine->search_products("widget", "cat-3", 100.0, 150.0)),
+              (Prices{104, 114, 124, 134, 144}));
+    EXPECT_EQ(prices_of(engine->search_products("widget", "", 100.0, 105.0)),
+              (Prices{100, 101, 102, 103, 104, 105}));
+    EXPECT_EQ(prices_of(engine->search_products("blue wid", "", 100.0, 105.0)),
+              (Prices{100, 102, 104}));
+    EXPECT_EQ(engine->search_products("widget", "cat-3").size(), 30u);
+    EXPECT_TRUE(engine->search_products("red widget", "cat-3").empty());
+}
+
+TEST_F(MarketplaceTest, SearchFollowsUpdatesAndDeletes)
+{
+    auto lamp = add_product("Desk lamp", "lights", 30.0);
+    auto chair = add_product("Office chair", "furniture", 120.0);
+
+    auto renamed = engine->get_product(lamp);
+    renamed.name = "Floor lamp";
+    renamed.category_id = "floor";
+    ASSERT_TRUE(engine->update_product(lamp, renamed));
+    EXPECT_TRUE(engine->search_products("desk").empty());
+    EXPECT_EQ(engine->search_products("floor lamp", "floor").size(), 1u);
+    EXPECT_TRUE(engine->search_products("lamp", "lights").empty());
+
+    ASSERT_TRUE(engine->delete_product(chair));
+    EXPECT_TRUE(engine->search_products("chair").empty());
+
+    // Enough updates to make the index drop its stale entries.
+    for (int i = 0; i < 3000; ++i) {
+        renamed.name = "Floor lamp v" + std::to_string(i);
+        renamed.base_price = 30.0 + i % 7;
+        engine->update_product(lamp, renamed);
+    }
+    auto results = engine->search_products("floor lamp", "floor", 0.0, 40.0);
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].name, "Floor lamp v2999");
+    EXPECT_TRUE(engine->search_products("v2998").empty());
+    EXPECT_EQ(engine->search_products("", "", 30.0, 40.0).size(), 1u);
+}
+
+// ============================================================================
+// Analytics Tests
+// ============================================================================
+
+TEST_F(MarketplaceTest, RollupsFollowTheOrderLifecycle)
+{
+    auto lamp = add_product("Stocked Product", "", 10.0, 100);
+    auto chair = add_product("Stocked Product", "", 10.0, 100);
+
+    auto place = [&](const std::string& customer,
+                     const std::vector<std::pair<std::string, int>>& lines) {
+        auto order = order_for(lines);
+        order.customer_id = customer;
+        order.total_amount = 0.0;
+        for (const auto& item : order.items)
+            order.total_amount += item.total_price;
+        order.created_at = std::chrono::system_clock::now();
+        return engine->create_order(order);
+    };
+    auto both = place("CUST-A", {{lamp, 1}, {chair, 3}});      // 40
+    auto lamps = place("CUST-A", {{lamp, 2}});                 // 20
+    auto chairs = place("CUST-B", {{chair, 1}});               // 10
+
+    engine->process_payment(both, PaymentMethod::CREDIT_CARD, "TX-1");
+    ASSERT_TRUE(engine->cancel_order(lamps, "changed mind"));
+    ASSERT_TRUE(engine->refund_order(both, 8.0));
+
+    auto day = std::chrono::hours(24);
+    auto now = std::chrono::system_clock::now();
+    auto sales = engine->get_sales_analytics("SELLER-001", now - day, now + day);
+    EXPECT_EQ(sales.counts["total_orders"], 3);
+    EXPECT_EQ(sales.counts["units_sold"], 7);
+    EXPECT_EQ(sales.counts["cancelled_orders"], 1);
+    EXPECT_EQ(sales.counts["refunded_orders"], 1);
+    EXPECT_DOUBLE_EQ(sales.metrics["total_revenue"], 70.0);
+    EXPECT_DOUBLE_EQ(sales.metrics["net_revenue"], 70.0 - 20.0 - 8.0);
+    EXPECT_EQ(engine->get_sales_analytics("SELLER-001", now + 2 * day, now + 3 * day)
+                  .counts["total_orders"], 0);
+
+    auto customer = engine->get_customer_analytics("CUST-A");
+    EXPECT_EQ(customer.counts["total_orders"], 2);
+    EXPECT_DOUBLE_EQ(customer.metrics["total_spent"], 60.0);
+
+    // The refund is split between the products by their share of the order.
+    auto products = engine->get_product_performance("SELLER-001");
+    ASSERT_EQ(products.size(), 2u);
+    EXPECT_EQ(products[0].dimensions["product_id"], chair);
+    EXPECT_DOUBLE_EQ(products[0].metrics["total_revenue"], 40.0);
+    EXPECT_EQ(products[0].counts["units_sold"], 4);
+    EXPECT_DOUBLE_EQ(products[0].metrics["refunded_amount"], 6.0);
+    EXPECT_EQ(products[1].dimensions["product_id"], lamp);
+    EXPECT_DOUBLE_EQ(products[1].metrics["net_revenue"], 30.0 - 20.0 - 2.0);
+    EXPECT_TRUE(engine->get_product_performance("SELLER-NONE").empty());
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.total_orders, 3u);
+    EXPECT_EQ(stats.pending_orders, 1u);
+    EXPECT_DOUBLE_EQ(stats.total_revenue, 70.0);
+    EXPECT_DOUBLE_EQ(stats.average_order_value, 70.0 / 3);
+
+    // Reopening a cancelled order takes it out of the cancellations.
+    ASSERT_TRUE(engine->update_order_status(lamps, OrderStatus::PROCESSING));
+    sales = engine->get_sales_analytics("", now - day, now + day);
+    EXPECT_EQ(sales.counts["cancelled_orders"], 0);
+    EXPECT_DOUBLE_EQ(sales.metrics["cancelled_amount"], 0.0);
+}
+
+TEST_F(MarketplaceTest, RefundsNeedAPaidOrderAndAValidAmount)
+{
+    auto product_id = add_product("Stocked Product", "", 10.0, 100);
+    auto place = [&]() {
+        auto order = order_for({{product_id, 2}});
+        order.total_amount = 20.0;
+        order.created_at = std::chrono::system_clock::now();
+        return engine->create_order(order);
+    };
+
+    auto paid = place();
+    EXPECT_FALSE(engine->refund_order(paid, 5.0));      // not paid yet
+    engine->process_payment(paid, PaymentMethod::CREDIT_CARD, "TX-1");
+    EXPECT_FALSE(engine->refund_order(paid, 0.0));
+    EXPECT_FALSE(engine->refund_order(paid, -5.0));
+    EXPECT_FALSE(engine->refund_order(paid, 20.01));
+    EXPECT_EQ(engine->get_order(paid).status, OrderStatus::PAID);
+
+    ASSERT_TRUE(engine->refund_order(paid, 20.0));
+    EXPECT_FALSE(engine->refund_order(paid, 20.0));
+    EXPECT_FALSE(engine->update_order_status(paid, OrderStatus::REFUNDED));
+    EXPECT_FALSE(engine->update_order_status(paid, OrderStatus::PAID));
+    EXPECT_EQ(engine->get_order(paid).status, OrderStatus::REFUNDED);
+
+    auto cancelled = place();
+    engine->process_payment(cancelled, PaymentMethod::CREDIT_CARD, "TX-2");
+    ASSERT_TRUE(engine->cancel_order(cancelled, "test"));
+    EXPECT_FALSE(engine->refund_order(cancelled, 10.0));
+    EXPECT_EQ(engine->get_order(cancelled).status, OrderStatus::CANCELLED);
+
+    auto shipped = place();
+    engine->update_order_status(shipped, OrderStatus::SHIPPED);
+    EXPECT_TRUE(engine->update_order_status(shipped, OrderStatus::REFUNDED));
+
+    auto day = std::chrono::hours(24);
+    auto now = std::chrono::system_clock::now();
+    auto sales = engine->get_sales_analytics("SELLER-001", now - day, now + day);
+    EXPECT_EQ(sales.counts["refunded_orders"], 2);
+    EXPECT_DOUBLE_EQ(sales.metrics["refunded_amount"], 40.0);
+}
+
+TEST_F(MarketplaceTest, UnknownStatusesAreRejected)
+{
+    auto product_id = add_product("Stocked Product", "", 10.0, 10);
+    EXPECT_EQ(OrderInfo{}.status, OrderStatus::PENDING);
+    auto order = order_for({{product_id, 1}});
+
+    auto unknown = static_cast<OrderStatus>(SalesCounters::STATUS_COUNT);
+    order.status = unknown;
+    EXPECT_TRUE(engine->create_order(order).empty());
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 10);
+
+    order.status = OrderStatus::PENDING;
+    auto order_id = engine->create_order(order);
+    ASSERT_FALSE(order_id.empty());
+    EXPECT_FALSE(engine->update_order_status(order_id, unknown));
+    EXPECT_EQ(engine->get_order(order_id).status, OrderStatus::PENDING);
+    EXPECT_EQ(SalesCounters{}.in_status(unknown), 0);
+}
+
+TEST_F(MarketplaceTest, OnlyPendingOrdersCanBePaid)
+{
+    auto product_id = add_product("Last Unit", "", 10.0, 1);
+    auto order = order_for({{product_id, 1}});
+    order.total_amount = 10.0;
+    order.created_at = std::chrono::system_clock::now();
+
+    auto cancelled = engine->create_order(order);
+    ASSERT_TRUE(engine->cancel_order(cancelled, "test"));
+    EXPECT_FALSE(engine->process_payment(cancelled, PaymentMethod::CREDIT_CARD, "TX-1"));
+    EXPECT_EQ(engine->get_order(cancelled).status, OrderStatus::CANCELLED);
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 1);
+
+    // The unit the cancelled order gave back can still be sold once.
+    auto refunded = engine->create_order(order);
+    ASSERT_FALSE(refunded.empty());
+    EXPECT_TRUE(engine->process_payment(refunded, PaymentMethod::CREDIT_CARD, "TX-2"));
+    EXPECT_FALSE(engine->process_payment(refunded, PaymentMethod::CREDIT_CARD, "TX-3"));
+    EXPECT_EQ(engine->get_order(refunded).payment_transaction_id, "TX-2");
+    EXPECT_EQ(engine->get_inventory(product_id).quantity_available, 0);
+
+    ASSERT_TRUE(engine->refund_order(refunded, 10.0));
+    EXPECT_FALSE(engine->process_payment(refunded, PaymentMethod::CREDIT_CARD, "TX-4"));
+    EXPECT_EQ(engine->get_order(refunded).status, OrderStatus::REFUNDED);
+    EXPECT_FALSE(engine->refund_order(refunded, 10.0));
+}
+
+TEST_F(MarketplaceTest, DateRangesCountWholeDays)
+{
+    using namespace std::chrono;
+    auto product_id = add_product("Stocked Product", "", 10.0, 100);
+    // Noon UTC on a day well after the epoch.
+    auto day = hours(24);
+    auto noon = system_clock::time_point(duration_cast<system_clock::duration>(day * 20000 + hours(12)));
+
+    for (int i = 0; i < 5; ++i) {
+        auto order = order_for({{product_id, 1}});
+        order.total_amount = 10.0;
+        order.created_at = noon + i * day;
+        engine->create_order(order);
+    }
+
+    // Any time within a day takes in all of that day's orders.
+    auto sales = engine->get_sales_analytics("SELLER-001", noon + day + hours(11),
+                                            noon + 2 * day - hours(11));
+    EXPECT_EQ(sales.counts["total_orders"], 2);
+    EXPECT_DOUBLE_EQ(sales.metrics["total_revenue"], 20.0);
+    EXPECT_EQ(engine->get_sales_analytics("", noon - 10 * day, noon + 10 * day)
+                  .counts["total_orders"], 5);
+    EXPECT_EQ(engine->get_sales_analytics("", noon + day, noon).counts["total_orders"], 0);
+}
+
+TEST_F(MarketplaceTest, ConcurrentUpdatesAddUp)
+{
+    auto product_id = add_product("Stocked Product", "", 10.0, 100000);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < 200; ++i) {
+                auto order = order_for({{product_id, 1}});
+                order.seller_id = "SELLER-" + std::to_string(t % 2);
+                order.total_amount = 10.0;
+                order.created_at = std::chrono::system_clock::now();
+                auto id = engine->create_order(order);
+                if (i % 4 == 0)
+                    engine->cancel_order(id, "test");
+                else if (i % 4 == 1)
+                    engine->update_order_status(id, OrderStatus::SHIPPED);
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.total_orders, 800u);
+    EXPECT_EQ(stats.pending_orders, 400u);
+    EXPECT_DOUBLE_EQ(stats.total_revenue, 8000.0);
+    auto day = std::chrono::hours(24);
+    auto now = std::chrono::system_clock::now();
+    auto sales = engine->get_sales_analytics("SELLER-1", now - day, now + day);
+    EXPECT_EQ(sales.counts["total_orders"], 400);
+    EXPECT_EQ(sales.counts["cancelled_orders"], 100);
+    EXPECT_DOUBLE_EQ(sales.metrics["net_revenue"], 3000.0);
+}
+
+// ============================================================================
+// Event Tests
+// ============================================================================
+
+TEST_F(MarketplaceTest, CallbacksGetEveryEventOfAnOrderInOrder)
+{
+    std::mutex mutex;
+    std::vector<std::pair<std::string, std::string>> seen;
+    engine->subscribe_events([&](const std::string& type, const std::string& data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen.emplace_back(type, data);
+    });
+
+    auto product_id = add_product("Stocked Product", "", 10.0, 10);
+    auto order_id = engine->create_order(order_for({{product_id, 1}}));
+    engine->process_payment(order_id, PaymentMethod::CREDIT_CARD, "TX-1");
+    engine->cancel_order(order_id, "test");
+    engine->flush_events();
+
+    using Events = std::vector<std::pair<std::string, std::string>>;
+    EXPECT_EQ(seen, (Events{{"product.created", product_id},
+                            {"order.created", order_id},
+                            {"order.status_changed", order_id},
+                            {"order.payment_processed", order_id},
+                            {"order.status_changed", order_id},
+                            {"order.cancelled", order_id}}));
+    shutdown_engine();
+}
+
+TEST_F(MarketplaceTest, RacingStatusChangesArriveInTheOrderMade)
+{
+    std::mutex mutex;
+    std::map<std::string, OrderStatus> last_seen;
+    engine->subscribe_event_batches([&](const std::vector<MarketplaceEvent>& events) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& event : events) {
+            if (event.type == MarketplaceEventType::ORDER_STATUS_CHANGED)
+                last_seen[event.subject_id] = event.order_status;
+        }
+    });
+
+    auto product_id = add_product("Stocked Product", "", 10.0, 100);
+    std::vector<std::string> order_ids;
+    for (int i = 0; i < 20; ++i)
+        order_ids.push_back(engine->create_order(order_for({{product_id, 1}})));
+
+    const OrderStatus statuses[] = {OrderStatus::PAID, OrderStatus::PROCESSING,
+                                    OrderStatus::SHIPPED, OrderStatus::DELIVERED};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < 50; ++round) {
+                for (const auto& order_id : order_ids)
+                    engine->update_order_status(order_id, statuses[(t + round) % 4]);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    engine->flush_events();
+
+    // Out of order, an earlier change could arrive last.
+    for (const auto& order_id : order_ids)
+        EXPECT_EQ(last_seen[order_id], engine->get_order(order_id).status) << order_id;
+    shutdown_engine();
+}
+
+TEST_F(MarketplaceTest, SlowSubscriberDoesNotHoldUpCheckout)
+{
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic<int> orders{0};
+    EventSubscriberOptions options;
+    options.max_batch = 16;
+    engine->subscribe_event_batches([&](const std::vector<MarketplaceEvent>& events) {
+        released.wait();
+        EXPECT_LE(events.size(), 16u);
+        for (const auto& event : events) {
+            if (event.type == MarketplaceEventType::ORDER_CREATED) {
+                EXPECT_DOUBLE_EQ(event.amount, 10.0);
+                ++orders;
+            }
+        }
+    }, options);
+
+    // Delivered synchronously, the first event would never return.
+    auto product_id = add_product("Stocked Product", "", 10.0, 100);
+    for (int i = 0; i < 100; ++i) {
+        auto order = order_for({{product_id, 1}});
+        order.total_amount = 10.0;
+        ASSERT_FALSE(engine->create_order(order).empty());
+    }
+    EXPECT_EQ(orders.load(), 0);
+
+    release.set_value();
+    engine->flush_events();
+    EXPECT_EQ(orders.load(), 100);
+    shutdown_engine();
+}
+
+TEST(MarketplaceEventTest, FullQueuesBlockOrDropPerSubscriber)
+{
+    EventBus bus;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic<int> dropping_seen{0};
+    std::vector<double> blocking_seen;
+
+    EventSubscriberOptions dropping;
+    dropping.capacity = 4;
+    dropping.max_batch = 1;
+    dropping.overflow = EventOverflow::DROP;
+    ASSERT_NE(bus.subscribe([&](const std::vector<MarketplaceEvent>& events) {
+        released.wait();
+        dropping_seen += static_cast<int>(events.size());
+    }, dropping), 0u);
+
+    EventSubscriberOptions blocking;
+    blocking.capacity = 2;
+    ASSERT_NE(bus.subscribe([&](const std::vector<MarketplaceEvent>& events) {
+        for (const auto& event : events)
+            blocking_seen.push_back(event.amount);
+    }, blocking), 0u);
+
+    // The blocking subscriber keeps up, so publishing never waits long;
+    // the stalled dropping one keeps what fits in its queue.
+    for (int i = 0; i < 1000; ++i) {
+        MarketplaceEvent event;
+        event.type = MarketplaceEventType::ORDER_CREATED;
+        event.subject_id = "ORDER-1";
+        event.amount = i;
+        bus.publish(event);
+    }
+    release.set_value();
+    bus.flush();
+
+    ASSERT_EQ(blocking_seen.size(), 1000u);
+    EXPECT_TRUE(std::is_sorted(blocking_seen.begin(), blocking_seen.end()));
+    EXPECT_LE(dropping_seen.load(), 5);
+    EXPECT_EQ(dropping_seen.load() + static_cast<int>(bus.dropped()), 1000);
+
+    EventSubscriberOptions invalid;
+    invalid.lanes = 0;
+    EXPECT_EQ(bus.subscribe([](const std::vector<MarketplaceEvent>&) {}, invalid), 0u);
+}
+
+TEST(MarketplaceEventTest, LanesKeepEachOrderInOrder)
+{
+    EventBus bus(4);
+    std::mutex mutex;
+    std::map<std::string, std::vector<double>> seen;
+    EventSubscriberOptions options;
+    options.lanes = 4;
+    options.capacity = 8;
+    options.max_batch = 3;
+    auto id = bus.subscribe([&](const std::vector<MarketplaceEvent>& events) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& event : events)
+            seen[event.subject_id].push_back(event.amount);
+    }, options);
+    ASSERT_NE(id, 0u);
+
+    std::vector<std::thread> publishers;
+    for (int t = 0; t < 4; ++t) {
+        publishers.emplace_back([&bus, t]() {
+            // Each publisher owns ten orders, as a checkout thread would.
+            for (int step = 0; step < 50; ++step) {
+                for (int order = 0; order < 10; ++order) {
+                    MarketplaceEvent event;
+                    event.subject_id = "ORDER-" + std::to_string(t * 10 + order);
+                    event.amount = step;
+                    bus.publish(event);
+                }
+            }
+        });
+    }
+    for (auto& publisher : publishers)
+        publisher.join();
+    bus.flush();
+
+    ASSERT_EQ(seen.size(), 40u);
+    for (const auto& [order, steps] : seen) {
+        ASSERT_EQ(steps.size(), 50u) << order;
+        EXPECT_TRUE(std::is_sorted(steps.begin(), steps.end())) << order;
+    }
+
+    EXPECT_TRUE(bus.unsubscribe(id));
+    EXPECT_FALSE(bus.unsubscribe(id));
+    bus.publish(MarketplaceEvent{});
+    bus.flush();
+    EXPECT_EQ(seen.count(""), 0u);
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
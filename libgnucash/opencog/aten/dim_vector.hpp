@@ -0,0 +1,170 @@
+/*
+ * opencog/aten/dim_vector.hpp
+ *
+ * Fixed-capacity inline storage for tensor shapes and strides
+ *
+ * Based on ATen's DimVector: financial tensors rarely go past four
+ * dimensions (entity, period, currency, metric), so sizes live in the
+ * object itself and building or copying a shape never touches the heap.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_ATEN_DIM_VECTOR_HPP
+#define GNC_ATEN_DIM_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace gnc {
+namespace aten {
+
+/**
+ * Maximum number of dimensions a tensor may have.
+ */
+constexpr size_t MAX_DIMS = 6;
+
+/**
+ * DimVector - a std::vector<size_t> look-alike holding at most MAX_DIMS
+ * values inline. Growing past MAX_DIMS throws std::invalid_argument.
+ */
+class DimVector
+{
+public:
+    using value_type = size_t;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = size_t&;
+    using const_reference = const size_t&;
+    using iterator = size_t*;
+    using const_iterator = const size_t*;
+
+    DimVector() = default;
+
+    explicit DimVector(size_t count, size_t value = 0)
+    {
+        resize(count, value);
+    }
+
+    DimVector(std::initializer_list<size_t> dims)
+    {
+        assign(dims.begin(), dims.end());
+    }
+
+    DimVector(const std::vector<size_t>& dims)
+    {
+        assign(dims.begin(), dims.end());
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    static constexpr size_t capacity() { return MAX_DIMS; }
+
+    size_t* data() { return m_dims; }
+    const size_t* data() const { return m_dims; }
+
+    iterator begin() { return m_dims; }
+    iterator end() { return m_dims + m_size; }
+    const_iterator begin() const { return m_dims; }
+    const_iterator end() const { return m_dims + m_size; }
+
+    size_t& operator[](size_t idx) { return m_dims[idx]; }
+    const size_t& operator[](size_t idx) const { return m_dims[idx]; }
+
+    size_t& at(size_t idx)
+    {
+        if (idx >= m_size)
+            throw std::out_of_range("Dimension index out of range");
+        return m_dims[idx];
+    }
+
+    const size_t& at(size_t idx) const
+    {
+        if (idx >= m_size)
+            throw std::out_of_range("Dimension index out of range");
+        return m_dims[idx];
+    }
+
+    size_t& front() { return m_dims[0]; }
+    const size_t& front() const { return m_dims[0]; }
+    size_t& back() { return m_dims[m_size - 1]; }
+    const size_t& back() const { return m_dims[m_size - 1]; }
+
+    void clear() { m_size = 0; }
+
+    void resize(size_t count, size_t value = 0)
+    {
+        check_capacity(count);
+        if (count > m_size)
+            std::fill(m_dims + m_size, m_dims + count, value);
+        m_size = count;
+    }
+
+    void push_back(size_t value)
+    {
+        check_capacity(m_size + 1);
+        m_dims[m_size++] = value;
+    }
+
+    void pop_back() { --m_size; }
+
+    iterator insert(const_iterator pos, size_t value)
+    {
+        check_capacity(m_size + 1);
+        size_t idx = pos - m_dims;
+        std::copy_backward(m_dims + idx, m_dims + m_size, m_dims + m_size + 1);
+        m_dims[idx] = value;
+        ++m_size;
+        return m_dims + idx;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        size_t idx = pos - m_dims;
+        std::copy(m_dims + idx + 1, m_dims + m_size, m_dims + idx);
+        --m_size;
+        return m_dims + idx;
+    }
+
+    std::vector<size_t> to_vector() const
+    {
+        return std::vector<size_t>(begin(), end());
+    }
+
+    friend bool operator==(const DimVector& a, const DimVector& b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+    friend bool operator!=(const DimVector& a, const DimVector& b)
+    {
+        return !(a == b);
+    }
+
+private:
+    size_t m_dims[MAX_DIMS] = {};
+    size_t m_size = 0;
+
+    static void check_capacity(size_t count)
+    {
+        if (count > MAX_DIMS)
+            throw std::invalid_argument("Tensor has too many dimensions");
+    }
+
+    template<typename It>
+    void assign(It first, It last)
+    {
+        check_capacity(std::distance(first, last));
+        m_size = std::copy(first, last, m_dims) - m_dims;
+    }
+};
+
+} // namespace aten
+} // namespace gnc
+
+#endif // GNC_ATEN_DIM_VECTOR_HPP
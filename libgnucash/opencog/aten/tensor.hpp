@@ -24,6 +24,9 @@
 #include <string>
 #include <sstream>
 
+#include "dim_vector.hpp"
+#include "tensor_kernels.hpp"
+
 namespace gnc {
 namespace aten {
 
@@ -51,12 +54,12 @@ enum class DeviceType
 /**
  * Shape of a tensor (dimensions).
  */
-using Shape = std::vector<size_t>;
+using Shape = DimVector;
 
 /**
  * Strides for tensor indexing.
  */
-using Strides = std::vector<size_t>;
+using Strides = DimVector;
 
 /**
  * TensorStorage - underlying data storage for tensors.
@@ -103,6 +106,12 @@ private:
  * - Matrix operations
  * - Aggregations (sum, mean, etc.)
  * - Broadcasting
+ *
+ * Copying a tensor, reshape(), transpose() and slice() all return views
+ * that share the same storage; clone() makes an independent copy. Views
+ * made by transpose() and slice() may not be contiguous, in which case
+ * data() cannot be walked as a flat array; contiguous() returns a tensor
+ * for which it can.
  */
 template<typename T = double>
 class Tensor
@@ -259,6 +268,12 @@ public:
     size_t size() const { return compute_size(m_shape); }
     size_t size(size_t dim) const { return m_shape.at(dim); }
     bool empty() const { return size() == 0; }
+    bool is_contiguous() const { return m_contiguous; }
+
+    /**
+     * Number of tensors, this one included, sharing this tensor's storage.
+     */
+    long storage_use_count() const { return m_storage.use_count(); }
 
     T* data() { return m_storage ? m_storage->data() + m_offset : nullptr; }
     const T* data() const { return m_storage ? m_storage->data() + m_offset : nullptr; }
@@ -270,12 +285,12 @@ public:
     /**
      * Access element by multi-dimensional index.
      */
-    T& at(const std::vector<size_t>& indices)
+    T& at(const Shape& indices)
     {
         return (*m_storage)[compute_offset(indices)];
     }
 
-    const T& at(const std::vector<size_t>& indices) const
+    const T& at(const Shape& indices) const
     {
         return (*m_storage)[compute_offset(indices)];
     }
@@ -287,27 +302,27 @@ public:
     {
         if (idx >= size())
             throw std::out_of_range("Index out of range");
-        return (*m_storage)[m_offset + idx];
+        return (*this)[idx];
     }
 
     const T& at(size_t idx) const
     {
         if (idx >= size())
             throw std::out_of_range("Index out of range");
-        return (*m_storage)[m_offset + idx];
+        return (*this)[idx];
     }
 
     /**
-     * Access element by flat index.
+     * Access element by flat (row-major) index.
      */
     T& operator[](size_t idx)
     {
-        return (*m_storage)[m_offset + idx];
+        return (*m_storage)[m_contiguous ? m_offset + idx : flat_offset(idx)];
     }
 
     const T& operator[](size_t idx) const
     {
-        return (*m_storage)[m_offset + idx];
+        return (*m_storage)[m_contiguous ? m_offset + idx : flat_offset(idx)];
     }
 
     /**
@@ -315,12 +330,12 @@ public:
      */
     T& operator()(size_t i, size_t j)
     {
-        return at({i, j});
+        return (*m_storage)[m_offset + i * m_strides[0] + j * m_strides[1]];
     }
 
     const T& operator()(size_t i, size_t j) const
     {
-        return at({i, j});
+        return (*m_storage)[m_offset + i * m_strides[0] + j * m_strides[1]];
     }
 
     // =========================================
@@ -328,12 +343,33 @@ public:
     // =========================================
 
     /**
-     * Reshape tensor to new dimensions.
+     * Independent copy of the tensor's elements, laid out contiguously.
+     */
+    Tensor clone() const
+    {
+        Tensor result(m_shape);
+        result.copy_(*this);
+        return result;
+    }
+
+    /**
+     * The tensor itself if it is contiguous, otherwise a contiguous copy.
+     */
+    Tensor contiguous() const
+    {
+        return m_contiguous ? *this : clone();
+    }
+
+    /**
+     * Reshape tensor to new dimensions. Returns a view unless the tensor
+     * is not contiguous, in which case the elements are copied first.
      */
     Tensor reshape(const Shape& new_shape) const
     {
         if (compute_size(new_shape) != size())
             throw std::invalid_argument("Cannot reshape: size mismatch");
+        if (!m_contiguous)
+            return clone().reshape(new_shape);
 
         Tensor result;
         result.m_shape = new_shape;
@@ -352,25 +388,54 @@ public:
     }
 
     /**
-     * Transpose (swap last two dimensions).
+     * Transpose (swap last two dimensions). Returns a view.
      */
     Tensor transpose() const
     {
         if (ndim() < 2)
             throw std::invalid_argument("Cannot transpose tensor with less than 2 dimensions");
 
-        Shape new_shape = m_shape;
-        std::swap(new_shape[ndim()-2], new_shape[ndim()-1]);
+        Tensor result(*this);
+        std::swap(result.m_shape[ndim()-2], result.m_shape[ndim()-1]);
+        std::swap(result.m_strides[ndim()-2], result.m_strides[ndim()-1]);
+        result.m_contiguous = result.check_contiguous();
+        return result;
+    }
+
+    /**
+     * Elements [start, end) along dimension dim. Returns a view.
+     */
+    Tensor slice(size_t dim, size_t start, size_t end) const
+    {
+        if (dim >= ndim())
+            throw std::invalid_argument("Invalid dimension for slice");
+        end = std::min(end, m_shape[dim]);
+        if (start > end)
+            throw std::out_of_range("Slice start past end");
+
+        Tensor result(*this);
+        result.m_shape[dim] = end - start;
+        result.m_offset += start * m_strides[dim];
+        result.m_contiguous = result.check_contiguous();
+        return result;
+    }
 
-        Tensor result(new_shape);
-        size_t rows = m_shape[ndim()-2];
-        size_t cols = m_shape[ndim()-1];
+    /**
+     * Row i of the outermost dimension, with that dimension removed.
+     * Returns a view.
+     */
+    Tensor select(size_t i) const
+    {
+        if (ndim() < 2)
+            throw std::invalid_argument("select requires at least 2 dimensions");
+        if (i >= m_shape[0])
+            throw std::out_of_range("Index out of range");
 
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                result.at({j, i}) = at({i, j});
-            }
-        }
+        Tensor result(*this);
+        result.m_shape.erase(result.m_shape.begin());
+        result.m_strides.erase(result.m_strides.begin());
+        result.m_offset += i * m_strides[0];
+        result.m_contiguous = result.check_contiguous();
         return result;
     }
 
@@ -418,6 +483,46 @@ public:
     Tensor& operator*=(const Tensor& other) { return inplace_binary_op(other, std::multiplies<T>()); }
     Tensor& operator/=(const Tensor& other) { return inplace_binary_op(other, std::divides<T>()); }
 
+    // =========================================
+    // In-place Operations
+    // =========================================
+    //
+    // These write into the tensor's storage without allocating. Views and
+    // copies that share the storage see the change.
+
+    /**
+     * this += alpha * other.
+     */
+    Tensor& add_(const Tensor& other, T alpha = T{1})
+    {
+        return inplace_binary_op(other, [alpha](T x, T y) { return x + alpha * y; });
+    }
+
+    Tensor& sub_(const Tensor& other) { return inplace_binary_op(other, std::minus<T>()); }
+    Tensor& mul_(const Tensor& other) { return inplace_binary_op(other, std::multiplies<T>()); }
+    Tensor& div_(const Tensor& other) { return inplace_binary_op(other, std::divides<T>()); }
+
+    Tensor& add_(T scalar) { return inplace_unary_op([scalar](T x) { return x + scalar; }); }
+    Tensor& mul_(T scalar) { return inplace_unary_op([scalar](T x) { return x * scalar; }); }
+    Tensor& div_(T scalar) { return inplace_unary_op([scalar](T x) { return x / scalar; }); }
+    Tensor& fill_(T value) { return inplace_unary_op([value](T) { return value; }); }
+    Tensor& zero_() { return fill_(T{0}); }
+
+    Tensor& relu_() { return inplace_unary_op([](T x) { return x > T{0} ? x : T{0}; }); }
+
+    Tensor& clamp_(T min_val, T max_val)
+    {
+        return inplace_unary_op([min_val, max_val](T x) { return std::max(min_val, std::min(max_val, x)); });
+    }
+
+    /**
+     * Copy other's elements into this tensor, which must have the same shape.
+     */
+    Tensor& copy_(const Tensor& other)
+    {
+        return inplace_binary_op(other, [](T, T y) { return y; });
+    }
+
     // =========================================
     // Mathematical Functions
     // =========================================
@@ -517,18 +622,10 @@ public:
         size_t k = m_shape[1];
         size_t n = other.m_shape[1];
 
-        Tensor result({m, n});
-
-        for (size_t i = 0; i < m; ++i) {
-            for (size_t j = 0; j < n; ++j) {
-                T sum = T{0};
-                for (size_t l = 0; l < k; ++l) {
-                    sum += at({i, l}) * other.at({l, j});
-                }
-                result.at({i, j}) = sum;
-            }
-        }
-
+        Tensor lhs = contiguous();
+        Tensor rhs = other.contiguous();
+        Tensor result(Shape{m, n});
+        kernels::gemm(lhs.data(), rhs.data(), result.data(), m, k, n);
         return result;
     }
 
@@ -556,10 +653,10 @@ public:
         if (ndim() != 1 || other.ndim() != 1)
             throw std::invalid_argument("outer requires 1D tensors");
 
-        Tensor result({size(), other.size()});
+        Tensor result(Shape{size(), other.size()});
         for (size_t i = 0; i < size(); ++i) {
             for (size_t j = 0; j < other.size(); ++j) {
-                result.at({i, j}) = (*this)[i] * other[j];
+                result(i, j) = (*this)[i] * other[j];
             }
         }
         return result;
@@ -606,6 +703,7 @@ private:
     Strides m_strides;
     size_t m_offset;
     storage_ptr m_storage;
+    bool m_contiguous = true;
 
     static size_t compute_size(const Shape& shape)
     {
@@ -624,7 +722,7 @@ private:
         return strides;
     }
 
-    size_t compute_offset(const std::vector<size_t>& indices) const
+    size_t compute_offset(const Shape& indices) const
     {
         size_t offset = m_offset;
         for (size_t i = 0; i < indices.size(); ++i)
@@ -632,12 +730,44 @@ private:
         return offset;
     }
 
+    /**
+     * Storage offset of the idx'th element in row-major order.
+     */
+    size_t flat_offset(size_t idx) const
+    {
+        size_t offset = m_offset;
+        for (size_t d = ndim(); d-- > 0;) {
+            offset += (idx % m_shape[d]) * m_strides[d];
+            idx /= m_shape[d];
+        }
+        return offset;
+    }
+
+    bool check_contiguous() const
+    {
+        size_t stride = 1;
+        for (size_t d = ndim(); d-- > 0;) {
+            if (m_shape[d] != 1 && m_strides[d] != stride)
+                return false;
+            stride *= m_shape[d];
+        }
+        return true;
+    }
+
     template<typename Op>
     Tensor unary_op(Op op) const
     {
         Tensor result(m_shape);
-        for (size_t i = 0; i < size(); ++i)
-            result[i] = op((*this)[i]);
+        T* out = result.data();
+        size_t n = size();
+        if (m_contiguous) {
+            const T* in = data();
+            for (size_t i = 0; i < n; ++i)
+                out[i] = op(in[i]);
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = op((*this)[i]);
+        }
         return result;
     }
 
@@ -648,19 +778,51 @@ private:
             throw std::invalid_argument("Shape mismatch in binary operation");
 
         Tensor result(m_shape);
-        for (size_t i = 0; i < size(); ++i)
-            result[i] = op((*this)[i], other[i]);
+        T* out = result.data();
+        size_t n = size();
+        if (m_contiguous && other.m_contiguous) {
+            const T* a = data();
+            const T* b = other.data();
+            for (size_t i = 0; i < n; ++i)
+                out[i] = op(a[i], b[i]);
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = op((*this)[i], other[i]);
+        }
         return result;
     }
 
+    template<typename Op>
+    Tensor& inplace_unary_op(Op op)
+    {
+        size_t n = size();
+        if (m_contiguous) {
+            T* p = data();
+            for (size_t i = 0; i < n; ++i)
+                p[i] = op(p[i]);
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                (*this)[i] = op((*this)[i]);
+        }
+        return *this;
+    }
+
     template<typename Op>
     Tensor& inplace_binary_op(const Tensor& other, Op op)
     {
         if (m_shape != other.m_shape)
             throw std::invalid_argument("Shape mismatch in binary operation");
 
-        for (size_t i = 0; i < size(); ++i)
-            (*this)[i] = op((*this)[i], other[i]);
+        size_t n = size();
+        if (m_contiguous && other.m_contiguous) {
+            T* a = data();
+            const T* b = other.data();
+            for (size_t i = 0; i < n; ++i)
+                a[i] = op(a[i], b[i]);
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                (*this)[i] = op((*this)[i], other[i]);
+        }
         return *this;
     }
 
@@ -0,0 +1,263 @@
+/*
+ * opencog/aten/tensor_kernels.hpp
+ *
+ * Raw-pointer compute kernels used by Tensor and tensor ops
+ *
+ * The kernels work on contiguous row-major buffers, which is how every
+ * Tensor stores its data. Loops are arranged so that the innermost one
+ * walks memory with unit stride and no aliasing, which lets the compiler
+ * vectorize it; no intrinsics are needed, so the same code runs on any
+ * target.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_ATEN_TENSOR_KERNELS_HPP
+#define GNC_ATEN_TENSOR_KERNELS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "../cogutil/thread_pool.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GNC_ATEN_RESTRICT __restrict__
+#elif defined(_MSC_VER)
+#define GNC_ATEN_RESTRICT __restrict
+#else
+#define GNC_ATEN_RESTRICT
+#endif
+
+namespace gnc {
+namespace aten {
+namespace kernels {
+
+/**
+ * Tile sizes for gemm. A KC x NC block of B (256 KiB of doubles) stays in
+ * L2 while every row of A streams past it.
+ */
+constexpr size_t GEMM_KC = 128;
+constexpr size_t GEMM_NC = 256;
+
+/**
+ * Multiply-add count below which gemm never goes to the thread pool;
+ * smaller products finish before a worker would pick them up.
+ */
+constexpr size_t GEMM_PARALLEL_THRESHOLD = size_t{1} << 21;
+
+/**
+ * Run fn(begin, end) over [0, count) split into contiguous ranges, one
+ * per pool worker and one for the caller. Ranges are multiples of grain
+ * so kernels keep whole tiles. Runs inline when threading would not pay
+ * off.
+ */
+template<typename Fn>
+void parallel_range(size_t count, size_t grain, size_t work, Fn&& fn)
+{
+    auto& pool = opencog::default_thread_pool();
+    size_t chunks = grain ? (count + grain - 1) / grain : 1;
+    size_t nthreads = std::min(pool.size() + 1, chunks);
+    if (work < GEMM_PARALLEL_THRESHOLD || nthreads < 2) {
+        fn(size_t{0}, count);
+        return;
+    }
+
+    size_t per_thread = (chunks + nthreads - 1) / nthreads * grain;
+    pool.parallel_for(0, count, per_thread, fn);
+}
+
+/**
+ * c[rows, j] += a[rows, l] * b[l, j] for one KC x NC tile of b.
+ * Four rows of c are updated per pass over a row of b, so each loaded
+ * element of b is used four times.
+ */
+template<typename T>
+void gemm_tile(const T* GNC_ATEN_RESTRICT a, const T* GNC_ATEN_RESTRICT b,
+               T* GNC_ATEN_RESTRICT c, size_t row_begin, size_t row_end,
+               size_t k, size_t n, size_t l_begin, size_t l_end,
+               size_t j_begin, size_t j_end)
+{
+    size_t i = row_begin;
+    for (; i + 4 <= row_end; i += 4) {
+        T* c0 = c + i * n;
+        T* c1 = c0 + n;
+        T* c2 = c1 + n;
+        T* c3 = c2 + n;
+        const T* a0 = a + i * k;
+        for (size_t l = l_begin; l < l_end; ++l) {
+            const T* brow = b + l * n;
+            T v0 = a0[l];
+            T v1 = a0[k + l];
+            T v2 = a0[2 * k + l];
+            T v3 = a0[3 * k + l];
+            for (size_t j = j_begin; j < j_end; ++j) {
+                T bv = brow[j];
+                c0[j] += v0 * bv;
+                c1[j] += v1 * bv;
+                c2[j] += v2 * bv;
+                c3[j] += v3 * bv;
+            }
+        }
+    }
+    for (; i < row_end; ++i) {
+        T* crow = c + i * n;
+        const T* arow = a + i * k;
+        for (size_t l = l_begin; l < l_end; ++l) {
+            const T* brow = b + l * n;
+            T v = arow[l];
+            for (size_t j = j_begin; j < j_end; ++j)
+                crow[j] += v * brow[j];
+        }
+    }
+}
+
+/**
+ * c = a * b for rows [row_begin, row_end) of row-major a (m x k),
+ * b (k x n) and c (m x n). Those rows of c must already be zero.
+ */
+template<typename T>
+void gemm_rows(const T* a, const T* b, T* c, size_t row_begin,
+               size_t row_end, size_t k, size_t n)
+{
+    for (size_t jj = 0; jj < n; jj += GEMM_NC) {
+        size_t j_end = std::min(n, jj + GEMM_NC);
+        for (size_t ll = 0; ll < k; ll += GEMM_KC) {
+            size_t l_end = std::min(k, ll + GEMM_KC);
+            gemm_tile(a, b, c, row_begin, row_end, k, n, ll, l_end, jj, j_end);
+        }
+    }
+}
+
+/**
+ * c = a * b for row-major a (m x k), b (k x n) and zero-filled c (m x n).
+ * Large products are split by rows across threads.
+ */
+template<typename T>
+void gemm(const T* a, const T* b, T* c, size_t m, size_t k, size_t n)
+{
+    parallel_range(m, 4, m * k * n, [=](size_t begin, size_t end) {
+        gemm_rows(a, b, c, begin, end, k, n);
+    });
+}
+
+/**
+ * Batched gemm: c[i] = a[i] * b[i] for batch contiguous matrices.
+ * Batches are spread across threads; a single batch falls back to gemm's
+ * own row split.
+ */
+template<typename T>
+void gemm_batched(const T* a, const T* b, T* c, size_t batch, size_t m,
+                  size_t k, size_t n)
+{
+    if (batch == 1) {
+        gemm(a, b, c, m, k, n);
+        return;
+    }
+    parallel_range(batch, 1, batch * m * k * n, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            gemm_rows(a + i * m * k, b + i * k * n, c + i * m * n, 0, m, k, n);
+    });
+}
+
+/**
+ * Independent partial sums kept by dot(). Floating-point addition is not
+ * associative, so the compiler will not split a single running sum into
+ * vector lanes itself; eight explicit ones map onto SIMD registers.
+ */
+constexpr size_t DOT_LANES = 8;
+
+/**
+ * Dot product of two contiguous vectors of length n.
+ */
+template<typename T>
+T dot(const T* GNC_ATEN_RESTRICT a, const T* GNC_ATEN_RESTRICT b, size_t n)
+{
+    T acc[DOT_LANES] = {};
+    size_t i = 0;
+    for (; i + DOT_LANES <= n; i += DOT_LANES)
+        for (size_t l = 0; l < DOT_LANES; ++l)
+            acc[l] += a[i + l] * b[i + l];
+    for (; i < n; ++i)
+        acc[0] += a[i] * b[i];
+    T sum{};
+    for (size_t l = 0; l < DOT_LANES; ++l)
+        sum += acc[l];
+    return sum;
+}
+
+/**
+ * Scale v to unit length in place and return its original length.
+ * A zero vector is left as it is.
+ */
+template<typename T>
+T normalize(T* v, size_t n)
+{
+    T norm = std::sqrt(dot(v, v, n));
+    if (norm > T{0})
+        for (size_t i = 0; i < n; ++i)
+            v[i] /= norm;
+    return norm;
+}
+
+/**
+ * Cosine similarity of two contiguous vectors; 0 if either is zero.
+ */
+template<typename T>
+T cosine(const T* a, const T* b, size_t n)
+{
+    T norm_a = dot(a, a, n);
+    T norm_b = dot(b, b, n);
+    if (norm_a == T{0} || norm_b == T{0})
+        return T{0};
+    return dot(a, b, n) / (std::sqrt(norm_a) * std::sqrt(norm_b));
+}
+
+/**
+ * out[q * rows + r] = dot(queries[q], matrix[r]) for a row-major matrix
+ * (rows x dim) and a block of row-major queries (nq x dim). With unit
+ * length rows and queries these are cosine similarities. Rows are split
+ * across threads; each row is scored against every query while it is
+ * in cache.
+ */
+template<typename T>
+void dot_rows(const T* matrix, size_t rows, size_t dim, const T* queries,
+              size_t nq, T* out)
+{
+    parallel_range(rows, 64, rows * dim * nq, [=](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const T* row = matrix + r * dim;
+            for (size_t q = 0; q < nq; ++q)
+                out[q * rows + r] = dot(queries + q * dim, row, dim);
+        }
+    });
+}
+
+/**
+ * Indices of the k largest of n scores that are at least threshold,
+ * largest first.
+ */
+template<typename T>
+std::vector<size_t> top_k(const T* scores, size_t n, size_t k, T threshold)
+{
+    std::vector<size_t> idx;
+    idx.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        if (scores[i] >= threshold)
+            idx.push_back(i);
+    k = std::min(k, idx.size());
+    std::partial_sort(idx.begin(), idx.begin() + k, idx.end(),
+                      [scores](size_t a, size_t b) {
+                          return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+                      });
+    idx.resize(k);
+    return idx;
+}
+
+} // namespace kernels
+} // namespace aten
+} // namespace gnc
+
+#endif // GNC_ATEN_TENSOR_KERNELS_HPP
@@ -17,6 +17,103 @@ namespace gnc {
 namespace aten {
 namespace ops {
 
+// =========================================
+// Fused element-wise evaluation
+// =========================================
+//
+// Chaining operators, as in (a - b) * s + c, makes a temporary tensor
+// and a pass over memory for every operator. The functions below take
+// the whole chain as one callable and evaluate it in a single pass with
+// no intermediate storage. When every operand is contiguous the loop
+// runs over raw pointers so the compiler can vectorize it.
+
+namespace detail {
+
+template<typename... Inputs>
+void check_same_shape(const Shape& shape, const Inputs&... inputs)
+{
+    if (((inputs.shape() != shape) || ...))
+        throw std::invalid_argument("Shape mismatch in fused operation");
+}
+
+template<typename... Inputs>
+bool all_contiguous(const Inputs&... inputs)
+{
+    return (inputs.is_contiguous() && ...);
+}
+
+template<typename T, typename Fn, typename... Ptrs>
+void fused_loop(T* out, size_t n, Fn& fn, const Ptrs*... inputs)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = fn(inputs[i]...);
+}
+
+template<typename T, typename Fn, typename... Ptrs>
+T fused_sum_loop(size_t n, Fn& fn, const Ptrs*... inputs)
+{
+    T sum = T{0};
+    for (size_t i = 0; i < n; ++i)
+        sum += fn(inputs[i]...);
+    return sum;
+}
+
+} // namespace detail
+
+/**
+ * result[i] = fn(a[i], rest[i]...) for tensors of the same shape.
+ */
+template<typename T, typename Fn, typename... Rest>
+Tensor<T> fused(Fn fn, const Tensor<T>& a, const Rest&... rest)
+{
+    detail::check_same_shape(a.shape(), rest...);
+    Tensor<T> result(a.shape());
+    T* out = result.data();
+    size_t n = a.size();
+    if (detail::all_contiguous(a, rest...)) {
+        detail::fused_loop(out, n, fn, a.data(), rest.data()...);
+    } else {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = fn(a[i], rest[i]...);
+    }
+    return result;
+}
+
+/**
+ * In place: out[i] = fn(out[i], rest[i]...) for tensors of the same shape.
+ */
+template<typename T, typename Fn, typename... Rest>
+Tensor<T>& fused_(Tensor<T>& out, Fn fn, const Rest&... rest)
+{
+    detail::check_same_shape(out.shape(), rest...);
+    size_t n = out.size();
+    if (detail::all_contiguous(out, rest...)) {
+        T* p = out.data();
+        detail::fused_loop(p, n, fn, static_cast<const T*>(p), rest.data()...);
+    } else {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = fn(out[i], rest[i]...);
+    }
+    return out;
+}
+
+/**
+ * Sum over i of fn(a[i], rest[i]...) for tensors of the same shape.
+ */
+template<typename T, typename Fn, typename... Rest>
+T fused_sum(Fn fn, const Tensor<T>& a, const Rest&... rest)
+{
+    detail::check_same_shape(a.shape(), rest...);
+    size_t n = a.size();
+    if (detail::all_contiguous(a, rest...))
+        return detail::fused_sum_loop<T>(n, fn, a.data(), rest.data()...);
+
+    T sum = T{0};
+    for (size_t i = 0; i < n; ++i)
+        sum += fn(a[i], rest[i]...);
+    return sum;
+}
+
 /**
  * Concatenate tensors along a dimension.
  */
@@ -110,10 +207,11 @@ Tensor<T> softmax(const Tensor<T>& tensor, size_t dim = 0)
     // Find max for numerical stability
     T max_val = tensor.max();
 
-    Tensor<T> exp_tensor = (tensor - max_val).exp();
+    Tensor<T> exp_tensor = fused([max_val](T x) { return std::exp(x - max_val); },
+                                 tensor);
     T sum = exp_tensor.sum();
 
-    return exp_tensor / sum;
+    return exp_tensor.div_(sum);
 }
 
 /**
@@ -122,11 +220,7 @@ Tensor<T> softmax(const Tensor<T>& tensor, size_t dim = 0)
 template<typename T>
 Tensor<T> sigmoid(const Tensor<T>& tensor)
 {
-    Tensor<T> result(tensor.shape());
-    for (size_t i = 0; i < tensor.size(); ++i) {
-        result[i] = T{1} / (T{1} + std::exp(-tensor[i]));
-    }
-    return result;
+    return fused([](T x) { return T{1} / (T{1} + std::exp(-x)); }, tensor);
 }
 
 /**
@@ -144,11 +238,7 @@ Tensor<T> relu(const Tensor<T>& tensor)
 template<typename T>
 Tensor<T> tanh(const Tensor<T>& tensor)
 {
-    Tensor<T> result(tensor.shape());
-    for (size_t i = 0; i < tensor.size(); ++i) {
-        result[i] = std::tanh(tensor[i]);
-    }
-    return result;
+    return fused([](T x) { return std::tanh(x); }, tensor);
 }
 
 /**
@@ -160,7 +250,7 @@ Tensor<T> normalize(const Tensor<T>& tensor)
     T m = tensor.mean();
     T s = tensor.std();
     if (s == T{0}) s = T{1};
-    return (tensor - m) / s;
+    return fused([m, s](T x) { return (x - m) / s; }, tensor);
 }
 
 /**
@@ -173,7 +263,7 @@ Tensor<T> min_max_scale(const Tensor<T>& tensor)
     T max_val = tensor.max();
     T range = max_val - min_val;
     if (range == T{0}) range = T{1};
-    return (tensor - min_val) / range;
+    return fused([min_val, range](T x) { return (x - min_val) / range; }, tensor);
 }
 
 /**
@@ -192,20 +282,13 @@ Tensor<T> bmm(const Tensor<T>& a, const Tensor<T>& b)
     size_t k = a.shape()[2];
     size_t n = b.shape()[2];
 
-    Tensor<T> result({batch, m, n});
-
-    for (size_t b_idx = 0; b_idx < batch; ++b_idx) {
-        for (size_t i = 0; i < m; ++i) {
-            for (size_t j = 0; j < n; ++j) {
-                T sum = T{0};
-                for (size_t l = 0; l < k; ++l) {
-                    sum += a.at({b_idx, i, l}) * b.at({b_idx, l, j});
-                }
-                result.at({b_idx, i, j}) = sum;
-            }
-        }
-    }
+    if (b.shape()[1] != k)
+        throw std::invalid_argument("bmm shape mismatch");
 
+    Tensor<T> lhs = a.contiguous();
+    Tensor<T> rhs = b.contiguous();
+    Tensor<T> result(Shape{batch, m, n});
+    kernels::gemm_batched(lhs.data(), rhs.data(), result.data(), batch, m, k, n);
     return result;
 }
 
@@ -215,9 +298,11 @@ Tensor<T> bmm(const Tensor<T>& a, const Tensor<T>& b)
 template<typename T>
 T cosine_similarity(const Tensor<T>& a, const Tensor<T>& b)
 {
-    T dot = a.flatten().dot(b.flatten());
-    T norm_a = a.pow(2).sum();
-    T norm_b = b.pow(2).sum();
+    auto flat_a = a.flatten();
+    auto flat_b = b.flatten();
+    T dot = fused_sum([](T x, T y) { return x * y; }, flat_a, flat_b);
+    T norm_a = fused_sum([](T x) { return x * x; }, flat_a);
+    T norm_b = fused_sum([](T x) { return x * x; }, flat_b);
     return dot / (std::sqrt(norm_a) * std::sqrt(norm_b));
 }
 
@@ -227,7 +312,7 @@ T cosine_similarity(const Tensor<T>& a, const Tensor<T>& b)
 template<typename T>
 T euclidean_distance(const Tensor<T>& a, const Tensor<T>& b)
 {
-    return (a - b).pow(2).sum();
+    return fused_sum([](T x, T y) { return (x - y) * (x - y); }, a, b);
 }
 
 /**
@@ -309,6 +394,12 @@ Tensor<T> randn(const Shape& shape, T mean = T{0}, T stddev = T{1})
 }
 
 } // namespace ops
+
+/**
+ * Older spelling of the ops namespace.
+ */
+namespace tensor_ops = ops;
+
 } // namespace aten
 } // namespace gnc
 
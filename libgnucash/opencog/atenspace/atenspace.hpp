@@ -13,8 +13,12 @@
 
 #include "../atomspace/atomspace.hpp"
 #include "tensor_atom.hpp"
+#include "embedding_index.hpp"
 #include "../aten/tensor_ops.hpp"
 
+#include <mutex>
+#include <shared_mutex>
+
 namespace gnc {
 namespace atenspace {
 
@@ -31,6 +35,8 @@ struct EmbeddingConfig
     size_t structural_dim = 16;     // Structural embedding dimension
     size_t financial_dim = 32;      // Financial metrics dimension
     double learning_rate = 0.01;
+    size_t ann_min_size = 4096;     // Atoms per type before search goes approximate
+    size_t ann_probes = 8;          // Index lists scanned per approximate search
 };
 
 /**
@@ -41,22 +47,35 @@ struct EmbeddingConfig
  * - Semantic similarity search
  * - Neural attention mechanisms
  * - Embedding-based inference
+ *
+ * Embeddings read and written through the space are guarded by one
+ * reader/writer lock, so learn_embedding() can run on several threads
+ * alongside lookups. Changing a TensorNode's embeddings directly while
+ * other threads use the space is not safe.
  */
 class ATenSpace : public AtomSpace
 {
 public:
-    ATenSpace() = default;
+    ATenSpace()
+    {
+        apply_index_options();
+    }
+
     explicit ATenSpace(const EmbeddingConfig& config)
         : m_config(config)
-    {}
+    {
+        apply_index_options();
+    }
 
     /**
      * Add a tensor-enabled node.
+     * If an equivalent node already exists, returns the existing one.
      */
     std::shared_ptr<TensorNode> add_tensor_node(AtomType type, const std::string& name)
     {
         auto node = create_tensor_node(type, name);
-        add_atom(node);
+        if (auto existing = std::dynamic_pointer_cast<TensorNode>(add_atom(node)))
+            return existing;
         return node;
     }
 
@@ -73,7 +92,8 @@ public:
     /**
      * Add a tensor-enabled link with variadic arguments.
      */
-    template<typename... Handles>
+    template<typename... Handles,
+             typename = std::enable_if_t<(std::is_convertible_v<Handles, Handle> && ...)>>
     std::shared_ptr<TensorLink> add_tensor_link(AtomType type, Handles&&... handles)
     {
         HandleSeq outgoing{std::forward<Handles>(handles)...};
@@ -82,13 +102,16 @@ public:
 
     /**
      * Set embedding for a node.
+     * Throws std::invalid_argument if the node is in the space and the
+     * embedding's dimension differs from the others of its type.
      */
     void set_embedding(const Handle& atom, EmbeddingType type, const DoubleTensor& tensor)
     {
         auto* tn = dynamic_cast<TensorNode*>(atom.get());
         if (tn) {
+            std::unique_lock<std::shared_mutex> lock(m_embedding_mutex);
+            m_indexes->check_dimension(atom, type, tensor.size());
             tn->set_embedding(type, tensor);
-            update_embedding_index(atom, type);
         }
     }
 
@@ -99,7 +122,7 @@ public:
     {
         auto* tn = dynamic_cast<TensorNode*>(atom.get());
         if (tn) {
-            auto emb = tn->get_embedding(type);
+            auto emb = read_embedding(*tn, type);
             if (emb) {
                 return emb->tensor();
             }
@@ -127,9 +150,10 @@ public:
         }
 
         // Normalize
-        double norm = std::sqrt(embedding.pow(2).sum());
+        double norm = std::sqrt(ops::fused_sum([](double x) { return x * x; },
+                                               embedding));
         if (norm > 0)
-            return embedding / norm;
+            embedding.div_(norm);
         return embedding;
     }
 
@@ -261,6 +285,10 @@ public:
 
     /**
      * Find atoms similar to a query embedding.
+     *
+     * Searches the embedding index, which is exact up to
+     * EmbeddingConfig::ann_min_size atoms of the type and approximate
+     * beyond that. Only embeddings of the query's dimension are compared.
      */
     std::vector<std::pair<Handle, double>> find_similar(
         const DoubleTensor& query_embedding,
@@ -268,28 +296,15 @@ public:
         size_t top_k = 10,
         double threshold = 0.0) const
     {
-        std::vector<std::pair<Handle, double>> results;
-
-        for_each([&](const Handle& atom) {
-            auto* tn = dynamic_cast<TensorNode*>(atom.get());
-            if (!tn) return;
-
-            auto emb = tn->get_embedding(type);
-            if (!emb) return;
-
-            double sim = compute_similarity(query_embedding, emb->tensor());
-            if (sim >= threshold)
-                results.emplace_back(atom, sim);
-        });
-
-        // Sort by similarity
-        std::sort(results.begin(), results.end(),
-                  [](const auto& a, const auto& b) { return a.second > b.second; });
-
-        if (results.size() > top_k)
-            results.resize(top_k);
+        return m_indexes->index(type).search(query_embedding, top_k, threshold);
+    }
 
-        return results;
+    /**
+     * Get the embedding index used by find_similar().
+     */
+    const EmbeddingIndex& embedding_index(EmbeddingType type) const
+    {
+        return m_indexes->index(type);
     }
 
     /**
@@ -317,7 +332,7 @@ public:
                 continue;
             }
 
-            auto emb = tn->get_embedding(EmbeddingType::SEMANTIC);
+            auto emb = read_embedding(*tn, EmbeddingType::SEMANTIC);
             if (!emb) {
                 scores.push_back(0.0);
                 continue;
@@ -348,7 +363,7 @@ public:
                 continue;
             }
 
-            auto emb = atom->get_embedding(type);
+            auto emb = read_embedding(*atom, type);
             if (!emb) {
                 scores.push_back(0.0);
                 continue;
@@ -383,8 +398,9 @@ public:
         size_t emb_dim = m_config.semantic_dim;
         for (const auto& atom : atoms) {
             auto* tn = dynamic_cast<TensorNode*>(atom.get());
-            if (tn && tn->has_embedding(EmbeddingType::SEMANTIC)) {
-                emb_dim = tn->get_embedding(EmbeddingType::SEMANTIC)->dimension();
+            if (!tn) continue;
+            if (auto emb = read_embedding(*tn, EmbeddingType::SEMANTIC)) {
+                emb_dim = emb->dimension();
                 break;
             }
         }
@@ -395,7 +411,7 @@ public:
             auto* tn = dynamic_cast<TensorNode*>(atoms[i].get());
             if (!tn) continue;
 
-            auto emb = tn->get_embedding(EmbeddingType::SEMANTIC);
+            auto emb = read_embedding(*tn, EmbeddingType::SEMANTIC);
             if (!emb) continue;
 
             for (size_t j = 0; j < emb_dim; ++j) {
@@ -419,8 +435,9 @@ public:
         // Get embedding dimension from first atom with embedding
         size_t emb_dim = 0;
         for (const auto& atom : atoms) {
-            if (atom && atom->has_embedding(type)) {
-                emb_dim = atom->get_embedding(type)->dimension();
+            if (!atom) continue;
+            if (auto emb = read_embedding(*atom, type)) {
+                emb_dim = emb->dimension();
                 break;
             }
         }
@@ -434,7 +451,7 @@ public:
         for (size_t i = 0; i < atoms.size(); ++i) {
             if (!atoms[i]) continue;
 
-            auto emb = atoms[i]->get_embedding(type);
+            auto emb = read_embedding(*atoms[i], type);
             if (!emb) continue;
 
             for (size_t j = 0; j < emb_dim; ++j) {
@@ -469,19 +486,23 @@ public:
 
     /**
      * Learn embedding from context (simplified skip-gram style).
+     * Calls are serialized with each other and with the other embedding
+     * updates made through the space.
      */
     void learn_embedding(const Handle& target, const HandleSeq& context)
     {
         auto* tn = dynamic_cast<TensorNode*>(target.get());
         if (!tn) return;
 
+        std::unique_lock<std::shared_mutex> lock(m_embedding_mutex);
+
         // Initialize embedding if not exists
         if (!tn->has_embedding(EmbeddingType::SEMANTIC)) {
             tn->set_embedding(EmbeddingType::SEMANTIC,
                 generate_semantic_embedding(tn->name()));
         }
 
-        // Average context embeddings
+        // Sum the context embeddings
         DoubleTensor context_sum({m_config.semantic_dim}, 0.0);
         size_t count = 0;
 
@@ -489,20 +510,25 @@ public:
             auto* ctx_tn = dynamic_cast<TensorNode*>(ctx.get());
             if (!ctx_tn) continue;
 
-            auto emb = ctx_tn->get_embedding(EmbeddingType::SEMANTIC);
+            auto* emb = ctx_tn->embedding_tensor(EmbeddingType::SEMANTIC);
             if (!emb) continue;
 
-            context_sum += emb->tensor();
+            context_sum += *emb;
             ++count;
         }
 
         if (count == 0) return;
-        auto context_avg = context_sum / static_cast<double>(count);
 
-        // Update target embedding (gradient step)
-        auto target_emb = tn->get_embedding(EmbeddingType::SEMANTIC)->tensor();
-        auto update = (context_avg - target_emb) * m_config.learning_rate;
-        tn->set_embedding(EmbeddingType::SEMANTIC, target_emb + update);
+        // Gradient step towards the context average, in one fused pass
+        auto* target_emb = tn->embedding_tensor(EmbeddingType::SEMANTIC);
+        if (target_emb->storage_use_count() > 1)
+            *target_emb = target_emb->clone(); // don't change tensors sharing it
+        double lr = m_config.learning_rate;
+        double n = static_cast<double>(count);
+        ops::fused_(*target_emb, [lr, n](double target, double sum) {
+            return target + (sum / n - target) * lr;
+        }, context_sum);
+        tn->notify_embedding_changed(EmbeddingType::SEMANTIC);
     }
 
     /**
@@ -513,34 +539,67 @@ public:
     /**
      * Set embedding configuration.
      */
-    void set_config(const EmbeddingConfig& config) { m_config = config; }
+    void set_config(const EmbeddingConfig& config)
+    {
+        m_config = config;
+        apply_index_options();
+    }
+
+protected:
+    /**
+     * Index the embeddings of TensorNodes as they are added. Throws
+     * std::invalid_argument if one has the wrong dimension for its type;
+     * the node stays in the space but isn't indexed.
+     */
+    void atom_added(const Handle& atom) override
+    {
+        if (auto* tn = dynamic_cast<TensorNode*>(atom.get())) {
+            tn->set_embedding_listener(m_indexes);
+            m_indexes->insert(atom, *tn);
+        }
+    }
+
+    void atom_removed(const Handle& atom) override
+    {
+        m_indexes->erase(atom);
+    }
+
+    void atoms_cleared() override
+    {
+        m_indexes->clear();
+    }
 
 private:
     EmbeddingConfig m_config;
 
-    // Embedding index for fast similarity search
-    std::unordered_map<EmbeddingType, std::vector<Handle>> m_embedding_index;
+    // Embedding indexes for fast similarity search
+    std::shared_ptr<EmbeddingIndexSet> m_indexes = std::make_shared<EmbeddingIndexSet>();
 
-    void update_embedding_index(const Handle& atom, EmbeddingType type)
+    // Guards node embeddings read or written through the space
+    mutable std::shared_mutex m_embedding_mutex;
+
+    std::optional<TensorEmbedding> read_embedding(const TensorNode& node,
+                                                  EmbeddingType type) const
     {
-        auto& index = m_embedding_index[type];
-        if (std::find(index.begin(), index.end(), atom) == index.end())
-            index.push_back(atom);
+        std::shared_lock<std::shared_mutex> lock(m_embedding_mutex);
+        return node.get_embedding(type);
+    }
+
+    void apply_index_options()
+    {
+        EmbeddingIndex::Options options;
+        options.min_ann_size = m_config.ann_min_size;
+        options.probes = m_config.ann_probes;
+        m_indexes->set_options(options);
     }
 
     double compute_similarity(const DoubleTensor& a, const DoubleTensor& b) const
     {
         if (a.size() != b.size()) return 0.0;
 
-        double dot = 0.0, norm_a = 0.0, norm_b = 0.0;
-        for (size_t i = 0; i < a.size(); ++i) {
-            dot += a[i] * b[i];
-            norm_a += a[i] * a[i];
-            norm_b += b[i] * b[i];
-        }
-
-        if (norm_a == 0 || norm_b == 0) return 0.0;
-        return dot / (std::sqrt(norm_a) * std::sqrt(norm_b));
+        auto ca = a.contiguous();
+        auto cb = b.contiguous();
+        return kernels::cosine(ca.data(), cb.data(), ca.size());
     }
 };
 
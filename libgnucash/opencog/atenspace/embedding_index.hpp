@@ -0,0 +1,542 @@
+/*
+ * opencog/atenspace/embedding_index.hpp
+ *
+ * EmbeddingIndex - cosine similarity index over atom embeddings
+ *
+ * Embeddings are stored unit-length in one contiguous row-major matrix,
+ * so a similarity is a plain dot product over adjacent memory. Small
+ * indexes are searched exhaustively. Once an index grows past
+ * min_ann_size it is partitioned IVF-style: rows are clustered around
+ * about sqrt(n) centroids with spherical k-means, and a search only scans
+ * the lists of the centroids nearest the query.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_ATENSPACE_EMBEDDING_INDEX_HPP
+#define GNC_ATENSPACE_EMBEDDING_INDEX_HPP
+
+#include "tensor_atom.hpp"
+#include "../aten/tensor_kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace gnc {
+namespace atenspace {
+
+using namespace gnc::opencog;
+using namespace gnc::aten;
+
+/**
+ * EmbeddingIndex - similarity search over the embeddings of one type.
+ *
+ * All rows share the dimension of the first embedding added; adding one
+ * of any other dimension throws std::invalid_argument. Thread-safe:
+ * searches share a lock, updates take it exclusively.
+ */
+class EmbeddingIndex
+{
+public:
+    struct Options
+    {
+        size_t min_ann_size = 4096;     // Search exhaustively below this size
+        size_t probes = 8;              // Lists scanned per approximate search
+    };
+
+    using Result = std::vector<std::pair<Handle, double>>;
+
+    EmbeddingIndex() = default;
+    explicit EmbeddingIndex(const Options& options) : m_options(options) {}
+
+    EmbeddingIndex(const EmbeddingIndex&) = delete;
+    EmbeddingIndex& operator=(const EmbeddingIndex&) = delete;
+
+    void set_options(const Options& options)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_options = options;
+    }
+
+    size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return m_atoms.size();
+    }
+
+    size_t dimension() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return m_dim;
+    }
+
+    /**
+     * Throw std::invalid_argument unless upsert() would take an embedding
+     * of dimension dim for atom: it matches the rows, or atom is the only
+     * row and would replace it.
+     */
+    void check_dimension(const Handle& atom, size_t dim) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        if (!accepts_locked(atom, dim))
+            throw dimension_error(atom, dim);
+    }
+
+    /**
+     * Add an atom's embedding, or replace it if the atom is indexed.
+     * Throws std::invalid_argument if the dimension doesn't match the
+     * other rows.
+     */
+    void upsert(const Handle& atom, const DoubleTensor& embedding)
+    {
+        if (!atom) return;
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+        if (!accepts_locked(atom, embedding.size()))
+            throw dimension_error(atom, embedding.size());
+        if (embedding.size() != m_dim)
+            erase_locked(atom->uuid());     // the only row changes dimension
+        if (m_atoms.empty())
+            m_dim = embedding.size();
+        if (m_dim == 0)
+            return;
+
+        size_t row;
+        auto it = m_row_of.find(atom->uuid());
+        if (it != m_row_of.end()) {
+            row = it->second;
+        } else {
+            row = m_atoms.size();
+            m_atoms.push_back(atom);
+            m_row_of.emplace(atom->uuid(), row);
+            m_rows.resize(m_rows.size() + m_dim);
+            m_list_of.push_back(NO_LIST);
+        }
+
+        double* dest = &m_rows[row * m_dim];
+        for (size_t i = 0; i < m_dim; ++i)
+            dest[i] = embedding[i];
+        normalize(dest, m_dim);
+
+        size_t n = m_atoms.size();
+        if (n >= m_options.min_ann_size && n >= 2 * m_trained_size)
+            train();
+        else if (!m_centroids.empty())
+            assign(row, nearest_centroid(dest));
+    }
+
+    /**
+     * Remove an atom from the index.
+     */
+    void erase(const Handle& atom)
+    {
+        if (!atom) return;
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        erase_locked(atom->uuid());
+    }
+
+    void clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_dim = 0;
+        m_rows.clear();
+        m_atoms.clear();
+        m_row_of.clear();
+        m_centroids.clear();
+        m_lists.clear();
+        m_list_of.clear();
+        m_trained_size = 0;
+    }
+
+    /**
+     * The top_k atoms with cosine similarity to query of at least
+     * threshold, most similar first. Approximate once the index is large
+     * enough to be partitioned.
+     */
+    Result search(const DoubleTensor& query, size_t top_k,
+                  double threshold = -std::numeric_limits<double>::infinity()) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return search_locked(query, top_k, threshold, use_ann());
+    }
+
+    /**
+     * Like search() but always compares against every row.
+     */
+    Result search_exact(const DoubleTensor& query, size_t top_k,
+                        double threshold = -std::numeric_limits<double>::infinity()) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return search_locked(query, top_k, threshold, false);
+    }
+
+    /**
+     * search_exact() for a block of queries, scored in one pass over the
+     * rows. Queries of the wrong dimension get no results.
+     */
+    std::vector<Result> search_exact(const std::vector<DoubleTensor>& queries, size_t top_k,
+                                     double threshold = -std::numeric_limits<double>::infinity()) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        std::vector<Result> results(queries.size());
+        if (top_k == 0 || m_atoms.empty())
+            return results;
+
+        std::vector<size_t> block;
+        std::vector<double> packed;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (queries[i].size() != m_dim) continue;
+            block.push_back(i);
+            packed.resize(block.size() * m_dim);
+            pack_query(queries[i], &packed[(block.size() - 1) * m_dim]);
+        }
+
+        size_t n = m_atoms.size();
+        std::vector<double> scores(block.size() * n);
+        kernels::dot_rows(m_rows.data(), n, m_dim, packed.data(), block.size(),
+                          scores.data());
+        for (size_t b = 0; b < block.size(); ++b)
+            results[block[b]] = collect(&scores[b * n], top_k, threshold);
+        return results;
+    }
+
+private:
+    static constexpr size_t NO_LIST = static_cast<size_t>(-1);
+    static constexpr int KMEANS_ITERATIONS = 8;
+    static constexpr size_t KMEANS_SAMPLES_PER_LIST = 32;
+
+    using Scored = std::pair<double, size_t>;   // similarity, row
+
+    mutable std::shared_mutex m_mutex;
+    Options m_options;
+    size_t m_dim = 0;
+    std::vector<double> m_rows;                 // size() x m_dim, unit length
+    std::vector<Handle> m_atoms;                // atom of each row
+    std::unordered_map<UUID, size_t> m_row_of;
+    std::vector<double> m_centroids;            // lists x m_dim, unit length
+    std::vector<std::vector<size_t>> m_lists;   // rows nearest each centroid
+    std::vector<size_t> m_list_of;              // list of each row
+    size_t m_trained_size = 0;
+
+    static double dot(const double* a, const double* b, size_t n)
+    {
+        return kernels::dot(a, b, n);
+    }
+
+    static void normalize(double* v, size_t n)
+    {
+        kernels::normalize(v, n);
+    }
+
+    bool use_ann() const
+    {
+        return !m_centroids.empty() && m_atoms.size() >= m_options.min_ann_size;
+    }
+
+    const double* row_data(size_t row) const { return &m_rows[row * m_dim]; }
+
+    size_t nearest_centroid(const double* v) const
+    {
+        size_t best = 0;
+        double best_score = -std::numeric_limits<double>::infinity();
+        for (size_t c = 0; c < m_lists.size(); ++c) {
+            double score = dot(v, &m_centroids[c * m_dim], m_dim);
+            if (score > best_score) {
+                best_score = score;
+                best = c;
+            }
+        }
+        return best;
+    }
+
+    void unassign(size_t row)
+    {
+        size_t list = m_list_of[row];
+        if (list == NO_LIST) return;
+        auto& rows = m_lists[list];
+        auto it = std::find(rows.begin(), rows.end(), row);
+        if (it != rows.end()) {
+            *it = rows.back();
+            rows.pop_back();
+        }
+        m_list_of[row] = NO_LIST;
+    }
+
+    void assign(size_t row, size_t list)
+    {
+        if (m_list_of[row] == list) return;
+        unassign(row);
+        m_lists[list].push_back(row);
+        m_list_of[row] = list;
+    }
+
+    bool accepts_locked(const Handle& atom, size_t dim) const
+    {
+        return m_atoms.empty() || dim == m_dim ||
+               (m_atoms.size() == 1 && m_atoms[0]->uuid() == atom->uuid());
+    }
+
+    std::invalid_argument dimension_error(const Handle& atom, size_t dim) const
+    {
+        return std::invalid_argument("EmbeddingIndex: embedding of dimension " +
+                                     std::to_string(dim) + " for atom " +
+                                     std::to_string(atom->uuid()) +
+                                     " doesn't match the indexed dimension " +
+                                     std::to_string(m_dim));
+    }
+
+    void erase_locked(UUID uuid)
+    {
+        auto it = m_row_of.find(uuid);
+        if (it == m_row_of.end()) return;
+
+        size_t row = it->second;
+        size_t last = m_atoms.size() - 1;
+        m_row_of.erase(it);
+        unassign(row);
+
+        if (row != last) {
+            // Move the last row into the hole.
+            std::copy(row_data(last), row_data(last) + m_dim, &m_rows[row * m_dim]);
+            m_atoms[row] = std::move(m_atoms[last]);
+            m_row_of[m_atoms[row]->uuid()] = row;
+            size_t list = m_list_of[last];
+            if (list != NO_LIST)
+                std::replace(m_lists[list].begin(), m_lists[list].end(), last, row);
+            m_list_of[row] = list;
+        }
+        m_atoms.pop_back();
+        m_list_of.pop_back();
+        m_rows.resize(m_rows.size() - m_dim);
+        if (m_atoms.empty())
+            clear_partitions();
+    }
+
+    void clear_partitions()
+    {
+        m_centroids.clear();
+        m_lists.clear();
+        std::fill(m_list_of.begin(), m_list_of.end(), NO_LIST);
+        m_trained_size = 0;
+    }
+
+    /**
+     * Spherical k-means on a strided sample of the rows, then assign
+     * every row to its nearest centroid.
+     */
+    void train()
+    {
+        size_t n = m_atoms.size();
+        size_t nlists = std::max<size_t>(1, static_cast<size_t>(std::sqrt(double(n))));
+        size_t step = std::max<size_t>(1, n / (nlists * KMEANS_SAMPLES_PER_LIST));
+        std::vector<size_t> sample;
+        for (size_t row = 0; row < n; row += step)
+            sample.push_back(row);
+
+        m_centroids.assign(nlists * m_dim, 0.0);
+        for (size_t c = 0; c < nlists; ++c) {
+            const double* src = row_data(sample[c * sample.size() / nlists]);
+            std::copy(src, src + m_dim, &m_centroids[c * m_dim]);
+        }
+        m_lists.assign(nlists, {});
+
+        std::vector<double> sums(nlists * m_dim);
+        std::vector<size_t> counts(nlists);
+        for (int iter = 0; iter < KMEANS_ITERATIONS; ++iter) {
+            std::fill(sums.begin(), sums.end(), 0.0);
+            std::fill(counts.begin(), counts.end(), 0);
+            for (size_t row : sample) {
+                size_t c = nearest_centroid(row_data(row));
+                const double* src = row_data(row);
+                double* sum = &sums[c * m_dim];
+                for (size_t i = 0; i < m_dim; ++i)
+                    sum[i] += src[i];
+                ++counts[c];
+            }
+            for (size_t c = 0; c < nlists; ++c) {
+                if (counts[c] == 0) continue;  // keep the old centroid
+                double* centroid = &m_centroids[c * m_dim];
+                std::copy(&sums[c * m_dim], &sums[c * m_dim] + m_dim, centroid);
+                normalize(centroid, m_dim);
+            }
+        }
+
+        std::fill(m_list_of.begin(), m_list_of.end(), NO_LIST);
+        for (size_t row = 0; row < n; ++row) {
+            size_t c = nearest_centroid(row_data(row));
+            m_lists[c].push_back(row);
+            m_list_of[row] = c;
+        }
+        m_trained_size = n;
+    }
+
+    static void push_top_k(std::vector<Scored>& heap, size_t top_k, Scored item)
+    {
+        auto worse = [](const Scored& a, const Scored& b) { return a.first > b.first; };
+        if (heap.size() < top_k) {
+            heap.push_back(item);
+            std::push_heap(heap.begin(), heap.end(), worse);
+        } else if (item.first > heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end(), worse);
+            heap.back() = item;
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+    }
+
+    void pack_query(const DoubleTensor& query, double* dest) const
+    {
+        for (size_t i = 0; i < m_dim; ++i)
+            dest[i] = query[i];
+        normalize(dest, m_dim);
+    }
+
+    /** Top-k of a full row of scores. */
+    Result collect(const double* scores, size_t top_k, double threshold) const
+    {
+        Result results;
+        for (size_t row : kernels::top_k(scores, m_atoms.size(), top_k, threshold))
+            results.emplace_back(m_atoms[row], scores[row]);
+        return results;
+    }
+
+    Result search_locked(const DoubleTensor& query, size_t top_k,
+                         double threshold, bool approximate) const
+    {
+        if (top_k == 0 || m_atoms.empty() || query.size() != m_dim)
+            return {};
+
+        std::vector<double> q(m_dim);
+        pack_query(query, q.data());
+
+        if (!approximate) {
+            std::vector<double> scores(m_atoms.size());
+            kernels::dot_rows(m_rows.data(), m_atoms.size(), m_dim, q.data(), 1,
+                              scores.data());
+            return collect(scores.data(), top_k, threshold);
+        }
+
+        std::vector<Scored> heap;
+        heap.reserve(top_k + 1);
+        auto consider = [&](size_t row) {
+            double sim = dot(q.data(), row_data(row), m_dim);
+            if (sim >= threshold)
+                push_top_k(heap, top_k, {sim, row});
+        };
+
+        std::vector<Scored> lists(m_lists.size());
+        for (size_t c = 0; c < m_lists.size(); ++c)
+            lists[c] = {dot(q.data(), &m_centroids[c * m_dim], m_dim), c};
+        size_t probes = std::min(std::max<size_t>(1, m_options.probes), lists.size());
+        std::partial_sort(lists.begin(), lists.begin() + probes, lists.end(),
+                          [](const Scored& a, const Scored& b) { return a.first > b.first; });
+        for (size_t p = 0; p < probes; ++p)
+            for (size_t row : m_lists[lists[p].second])
+                consider(row);
+
+        std::sort(heap.begin(), heap.end(),
+                  [](const Scored& a, const Scored& b) { return a.first > b.first; });
+        Result results;
+        results.reserve(heap.size());
+        for (const auto& [sim, row] : heap)
+            results.emplace_back(m_atoms[row], sim);
+        return results;
+    }
+};
+
+/**
+ * EmbeddingIndexSet - one EmbeddingIndex per EmbeddingType, kept current
+ * by listening to the TensorNodes it is attached to. Only nodes inserted
+ * and not erased since are indexed; changes to other nodes still pointing
+ * at the set are ignored.
+ */
+class EmbeddingIndexSet : public EmbeddingListener
+{
+public:
+    static constexpr size_t NUM_TYPES = static_cast<size_t>(EmbeddingType::ATTENTION) + 1;
+
+    EmbeddingIndex& index(EmbeddingType type) { return m_indexes[static_cast<size_t>(type)]; }
+    const EmbeddingIndex& index(EmbeddingType type) const
+    {
+        return m_indexes[static_cast<size_t>(type)];
+    }
+
+    void set_options(const EmbeddingIndex::Options& options)
+    {
+        for (auto& index : m_indexes)
+            index.set_options(options);
+    }
+
+    /**
+     * Index every embedding of a node. Throws std::invalid_argument, and
+     * indexes nothing, if one of them has the wrong dimension.
+     */
+    void insert(const Handle& atom, const TensorNode& node)
+    {
+        std::lock_guard<std::mutex> lock(m_members_mutex);
+        for (const auto& [type, emb] : node.embeddings())
+            index(type).check_dimension(atom, emb.tensor().size());
+        m_members.insert(atom->uuid());
+        for (const auto& [type, emb] : node.embeddings())
+            index(type).upsert(atom, emb.tensor());
+    }
+
+    void erase(const Handle& atom)
+    {
+        std::lock_guard<std::mutex> lock(m_members_mutex);
+        m_members.erase(atom->uuid());
+        for (auto& index : m_indexes)
+            index.erase(atom);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_members_mutex);
+        m_members.clear();
+        for (auto& index : m_indexes)
+            index.clear();
+    }
+
+    /**
+     * Throw std::invalid_argument if atom is indexed and an embedding of
+     * type and dimension dim couldn't be indexed for it.
+     */
+    void check_dimension(const Handle& atom, EmbeddingType type, size_t dim) const
+    {
+        std::lock_guard<std::mutex> lock(m_members_mutex);
+        if (m_members.count(atom->uuid()))
+            index(type).check_dimension(atom, dim);
+    }
+
+    void embedding_changed(TensorNode& node, EmbeddingType type) override
+    {
+        std::lock_guard<std::mutex> lock(m_members_mutex);
+        if (!m_members.count(node.uuid()))
+            return;
+        Handle atom = node.shared_from_this();
+        if (auto* tensor = node.embedding_tensor(type))
+            index(type).upsert(atom, *tensor);
+        else
+            index(type).erase(atom);
+    }
+
+private:
+    std::array<EmbeddingIndex, NUM_TYPES> m_indexes;
+    mutable std::mutex m_members_mutex;
+    std::unordered_set<UUID> m_members;         // atoms of the owning space
+};
+
+} // namespace atenspace
+} // namespace gnc
+
+#endif // GNC_ATENSPACE_EMBEDDING_INDEX_HPP
@@ -15,6 +15,7 @@
 
 #include "../atomspace/atom.hpp"
 #include "../aten/tensor.hpp"
+#include <memory>
 #include <optional>
 
 namespace gnc {
@@ -79,6 +80,19 @@ private:
     DoubleTensor m_tensor;
 };
 
+class TensorNode;
+
+/**
+ * EmbeddingListener - notified when a TensorNode's embedding changes,
+ * so indexes over the embeddings can stay current.
+ */
+class EmbeddingListener
+{
+public:
+    virtual ~EmbeddingListener() = default;
+    virtual void embedding_changed(TensorNode& node, EmbeddingType type) = 0;
+};
+
 /**
  * TensorNode - a Node with tensor embeddings.
  */
@@ -95,6 +109,7 @@ public:
     void set_embedding(EmbeddingType type, const DoubleTensor& tensor)
     {
         m_embeddings[type] = TensorEmbedding(type, tensor);
+        notify_embedding_changed(type);
     }
 
     /**
@@ -108,6 +123,39 @@ public:
         return std::nullopt;
     }
 
+    /**
+     * Get an embedding's tensor for in-place updates, or nullptr.
+     */
+    DoubleTensor* embedding_tensor(EmbeddingType type)
+    {
+        auto it = m_embeddings.find(type);
+        return it != m_embeddings.end() ? &it->second.tensor() : nullptr;
+    }
+
+    /**
+     * Tell the listener that an embedding was changed in place through
+     * embedding_tensor().
+     */
+    void notify_embedding_changed(EmbeddingType type)
+    {
+        if (auto listener = m_listener.lock())
+            listener->embedding_changed(*this, type);
+    }
+
+    /**
+     * Set the listener told about embedding changes. Only a weak
+     * reference is kept; pass an empty pointer to detach.
+     */
+    void set_embedding_listener(const std::weak_ptr<EmbeddingListener>& listener)
+    {
+        m_listener = listener;
+    }
+
+    std::shared_ptr<EmbeddingListener> embedding_listener() const
+    {
+        return m_listener.lock();
+    }
+
     /**
      * Check if has embedding.
      */
@@ -151,6 +199,7 @@ public:
 
 private:
     std::unordered_map<EmbeddingType, TensorEmbedding> m_embeddings;
+    std::weak_ptr<EmbeddingListener> m_listener;
 };
 
 /**
@@ -188,7 +188,10 @@ public:
     Node(AtomType type, const std::string& name)
         : Atom(type)
         , m_name(name)
-    {}
+    {
+        m_hash = std::hash<AtomType>{}(m_type);
+        m_hash ^= std::hash<std::string>{}(m_name) + 0x9e3779b9 + (m_hash << 6) + (m_hash >> 2);
+    }
 
     bool is_node() const override { return true; }
     bool is_link() const override { return false; }
@@ -216,12 +219,7 @@ public:
         return std::string(type_name()) + ":\"" + m_name + "\"";
     }
 
-    size_t hash() const override
-    {
-        size_t h = std::hash<AtomType>{}(m_type);
-        h ^= std::hash<std::string>{}(m_name) + 0x9e3779b9 + (h << 6) + (h >> 2);
-        return h;
-    }
+    size_t hash() const override { return m_hash; }
 
     bool operator==(const Atom& other) const override
     {
@@ -232,6 +230,7 @@ public:
 
 private:
     std::string m_name;
+    size_t m_hash;      // Atoms are immutable, so computed once
 };
 
 /**
@@ -246,17 +245,20 @@ public:
     Link(AtomType type, const HandleSeq& outgoing)
         : Atom(type)
         , m_outgoing(outgoing)
+        , m_hash(compute_hash())
     {}
 
     Link(AtomType type, HandleSeq&& outgoing)
         : Atom(type)
         , m_outgoing(std::move(outgoing))
+        , m_hash(compute_hash())
     {}
 
     template<typename... Handles>
     Link(AtomType type, Handles&&... handles)
         : Atom(type)
         , m_outgoing{std::forward<Handles>(handles)...}
+        , m_hash(compute_hash())
     {}
 
     bool is_node() const override { return false; }
@@ -300,15 +302,7 @@ public:
         return result;
     }
 
-    size_t hash() const override
-    {
-        size_t h = std::hash<AtomType>{}(m_type);
-        for (const auto& atom : m_outgoing) {
-            if (atom)
-                h ^= atom->hash() + 0x9e3779b9 + (h << 6) + (h >> 2);
-        }
-        return h;
-    }
+    size_t hash() const override { return m_hash; }
 
     bool operator==(const Atom& other) const override
     {
@@ -328,6 +322,17 @@ public:
 
 private:
     HandleSeq m_outgoing;
+    size_t m_hash;      // Atoms are immutable, so computed once
+
+    size_t compute_hash() const
+    {
+        size_t h = std::hash<AtomType>{}(m_type);
+        for (const auto& atom : m_outgoing) {
+            if (atom)
+                h ^= atom->hash() + 0x9e3779b9 + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
 };
 
 /**
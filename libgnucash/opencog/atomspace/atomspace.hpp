@@ -11,15 +11,21 @@
 #ifndef GNC_OPENCOG_ATOMSPACE_HPP
 #define GNC_OPENCOG_ATOMSPACE_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
 #include <shared_mutex>
 #include <mutex>
 #include <functional>
 #include <optional>
+#include <type_traits>
+#include <vector>
 
 #include "atom.hpp"
 #include "atom_types.hpp"
+#include "flat_table.hpp"
 
 namespace gnc {
 namespace opencog {
@@ -62,6 +68,21 @@ struct AtomEqual
  * - Transaction patterns and relationships
  * - Learned categorization rules
  * - Predictions and anomalies
+ *
+ * Storage is split into shards, each with its own lock, so threads
+ * adding different atoms rarely wait on each other. Atoms and the type
+ * index are sharded by atom hash; the UUID and incoming-set indexes by
+ * UUID. The shards own the atoms' Handles; the other indexes hold plain
+ * Atom pointers in flat open-addressing tables, so indexing an atom
+ * costs a few dozen bytes and no allocations. A writer holds its atom
+ * shard while it updates UUID shards, never the other way round, so an
+ * atom is in every index or none. Operations spanning all shards, such
+ * as for_each(), lock one shard at a time and may or may not see atoms
+ * added concurrently.
+ *
+ * Subclasses that keep their own indexes over the atoms override
+ * atom_added(), atom_removed() and atoms_cleared(), which every add,
+ * remove and clear calls, including those made through an AtomSpace&.
  */
 class AtomSpace
 {
@@ -70,7 +91,7 @@ public:
     using AtomPredicate = std::function<bool(const Handle&)>;
 
     AtomSpace() = default;
-    ~AtomSpace() = default;
+    virtual ~AtomSpace() = default;
 
     // Non-copyable
     AtomSpace(const AtomSpace&) = delete;
@@ -99,7 +120,8 @@ public:
     /**
      * Add a link with variadic arguments.
      */
-    template<typename... Handles>
+    template<typename... Handles,
+             typename = std::enable_if_t<(std::is_convertible_v<Handles, Handle> && ...)>>
     Handle add_link(AtomType type, Handles&&... handles)
     {
         HandleSeq outgoing{std::forward<Handles>(handles)...};
@@ -114,26 +136,41 @@ public:
     {
         if (!atom) return nullptr;
 
-        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        auto& shard = atom_shard(*atom);
 
-        // Check if atom already exists
-        auto it = m_atoms.find(atom);
-        if (it != m_atoms.end())
-            return *it;
+        // Most adds of shared nodes find them already present
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            if (auto* existing = shard.atoms.find(*atom))
+                return *existing;
+        }
 
-        // Add the atom
-        m_atoms.insert(atom);
-        m_by_type[atom->type()].insert(atom);
-        m_by_uuid[atom->uuid()] = atom;
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
 
-        // Track incoming set for links
-        if (atom->is_link()) {
-            for (const auto& target : atom->outgoing()) {
-                if (target)
-                    m_incoming[target->uuid()].insert(atom);
-            }
+        // Check if atom already exists
+        auto [entry, inserted] = shard.atoms.insert(*atom, Handle(atom));
+        if (!inserted)
+            return *entry;
+
+        Atom* ptr = atom.get();
+        shard.by_type[atom->type()].insert(ptr, std::move(ptr));
+        {
+            auto& ushard = uuid_shard(atom->uuid());
+            std::unique_lock<std::shared_mutex> ulock(ushard.mutex);
+            ushard.by_uuid.insert(atom->uuid(), {atom->uuid(), atom.get()});
         }
 
+        // Track incoming set for links
+        for_each_target(*atom, [&](const Atom& target) {
+            auto& ushard = uuid_shard(target.uuid());
+            std::unique_lock<std::shared_mutex> ulock(ushard.mutex);
+            auto* incoming = ushard.incoming.insert(target.uuid(), {target.uuid(), {}}).first;
+            incoming->links.push_back(atom.get());
+        });
+
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        lock.unlock();
+        atom_added(atom);
         return atom;
     }
 
@@ -145,28 +182,45 @@ public:
     {
         if (!atom) return false;
 
-        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        auto& shard = atom_shard(*atom);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
 
-        auto it = m_atoms.find(atom);
-        if (it == m_atoms.end())
+        auto* entry = shard.atoms.find(*atom);
+        if (!entry)
             return false;
+        Handle stored = *entry;     // the equivalent atom actually indexed
 
         // Remove from type index
-        m_by_type[atom->type()].erase(atom);
+        shard.by_type[stored->type()].erase(stored.get());
 
         // Remove from UUID index
-        m_by_uuid.erase(atom->uuid());
+        {
+            auto& ushard = uuid_shard(stored->uuid());
+            std::unique_lock<std::shared_mutex> ulock(ushard.mutex);
+            ushard.by_uuid.erase(stored->uuid());
+        }
 
         // Remove from incoming sets
-        if (atom->is_link()) {
-            for (const auto& target : atom->outgoing()) {
-                if (target)
-                    m_incoming[target->uuid()].erase(atom);
+        for_each_target(*stored, [&](const Atom& target) {
+            auto& ushard = uuid_shard(target.uuid());
+            std::unique_lock<std::shared_mutex> ulock(ushard.mutex);
+            auto* incoming = ushard.incoming.find(target.uuid());
+            if (!incoming) return;
+            auto& links = incoming->links;
+            auto it = std::find(links.begin(), links.end(), stored.get());
+            if (it != links.end()) {
+                *it = links.back();
+                links.pop_back();
             }
-        }
+            if (links.empty())
+                ushard.incoming.erase(target.uuid());
+        });
 
         // Remove the atom itself
-        m_atoms.erase(it);
+        shard.atoms.erase(*stored);
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        lock.unlock();
+        atom_removed(stored);
         return true;
     }
 
@@ -175,9 +229,10 @@ public:
      */
     Handle get_atom(UUID uuid) const
     {
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
-        auto it = m_by_uuid.find(uuid);
-        return (it != m_by_uuid.end()) ? it->second : nullptr;
+        const auto& ushard = uuid_shard(uuid);
+        std::shared_lock<std::shared_mutex> lock(ushard.mutex);
+        auto* entry = ushard.by_uuid.find(uuid);
+        return entry ? entry->atom->shared_from_this() : nullptr;
     }
 
     /**
@@ -185,10 +240,7 @@ public:
      */
     Handle get_node(AtomType type, const std::string& name) const
     {
-        auto temp = create_node(type, name);
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
-        auto it = m_atoms.find(temp);
-        return (it != m_atoms.end()) ? *it : nullptr;
+        return find_existing(create_node(type, name));
     }
 
     /**
@@ -196,10 +248,7 @@ public:
      */
     Handle get_link(AtomType type, const HandleSeq& outgoing) const
     {
-        auto temp = create_link(type, outgoing);
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
-        auto it = m_atoms.find(temp);
-        return (it != m_atoms.end()) ? *it : nullptr;
+        return find_existing(create_link(type, outgoing));
     }
 
     /**
@@ -207,12 +256,15 @@ public:
      */
     HandleSeq get_atoms_by_type(AtomType type, bool subclasses = false) const
     {
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
         HandleSeq result;
 
-        auto it = m_by_type.find(type);
-        if (it != m_by_type.end()) {
-            result.insert(result.end(), it->second.begin(), it->second.end());
+        for (const auto& shard : m_atom_shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.by_type.find(type);
+            if (it != shard.by_type.end())
+                it->second.for_each([&](Atom* atom) {
+                    result.push_back(atom->shared_from_this());
+                });
         }
 
         // TODO: Add subclass handling if needed
@@ -228,12 +280,30 @@ public:
     {
         if (!atom) return {};
 
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
-        auto it = m_incoming.find(atom->uuid());
-        if (it == m_incoming.end())
+        const auto& ushard = uuid_shard(atom->uuid());
+        std::shared_lock<std::shared_mutex> lock(ushard.mutex);
+        auto* incoming = ushard.incoming.find(atom->uuid());
+        if (!incoming)
             return {};
 
-        return HandleSeq(it->second.begin(), it->second.end());
+        HandleSeq result;
+        result.reserve(incoming->links.size());
+        for (Atom* link : incoming->links)
+            result.push_back(link->shared_from_this());
+        return result;
+    }
+
+    /**
+     * Get the number of links pointing to an atom, without copying them.
+     */
+    size_t get_incoming_size(const Handle& atom) const
+    {
+        if (!atom) return 0;
+
+        const auto& ushard = uuid_shard(atom->uuid());
+        std::shared_lock<std::shared_mutex> lock(ushard.mutex);
+        auto* incoming = ushard.incoming.find(atom->uuid());
+        return incoming ? incoming->links.size() : 0;
     }
 
     /**
@@ -255,11 +325,13 @@ public:
      */
     HandleSeq find_atoms(const AtomPredicate& predicate) const
     {
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
         HandleSeq result;
-        for (const auto& atom : m_atoms) {
-            if (predicate(atom))
-                result.push_back(atom);
+        for (const auto& shard : m_atom_shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            shard.atoms.for_each([&](const Handle& atom) {
+                if (predicate(atom))
+                    result.push_back(atom);
+            });
         }
         return result;
     }
@@ -269,8 +341,7 @@ public:
      */
     size_t size() const
     {
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
-        return m_atoms.size();
+        return m_size.load(std::memory_order_relaxed);
     }
 
     /**
@@ -278,9 +349,14 @@ public:
      */
     size_t size(AtomType type) const
     {
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
-        auto it = m_by_type.find(type);
-        return (it != m_by_type.end()) ? it->second.size() : 0;
+        size_t count = 0;
+        for (const auto& shard : m_atom_shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.by_type.find(type);
+            if (it != shard.by_type.end())
+                count += it->second.size();
+        }
+        return count;
     }
 
     /**
@@ -288,9 +364,7 @@ public:
      */
     bool contains(const Handle& atom) const
     {
-        if (!atom) return false;
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
-        return m_atoms.find(atom) != m_atoms.end();
+        return find_existing(atom) != nullptr;
     }
 
     /**
@@ -298,11 +372,24 @@ public:
      */
     void clear()
     {
-        std::unique_lock<std::shared_mutex> lock(m_mutex);
-        m_atoms.clear();
-        m_by_type.clear();
-        m_by_uuid.clear();
-        m_incoming.clear();
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        locks.reserve(2 * NUM_SHARDS);
+        for (auto& shard : m_atom_shards)
+            locks.emplace_back(shard.mutex);
+        for (auto& ushard : m_uuid_shards)
+            locks.emplace_back(ushard.mutex);
+
+        for (auto& shard : m_atom_shards) {
+            shard.atoms.clear();
+            shard.by_type.clear();
+        }
+        for (auto& ushard : m_uuid_shards) {
+            ushard.by_uuid.clear();
+            ushard.incoming.clear();
+        }
+        m_size.store(0, std::memory_order_relaxed);
+        locks.clear();
+        atoms_cleared();
     }
 
     /**
@@ -310,9 +397,10 @@ public:
      */
     void for_each(const std::function<void(const Handle&)>& func) const
     {
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
-        for (const auto& atom : m_atoms)
-            func(atom);
+        for (const auto& shard : m_atom_shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            shard.atoms.for_each(func);
+        }
     }
 
     /**
@@ -328,37 +416,176 @@ public:
 
     Stats get_stats() const
     {
-        std::shared_lock<std::shared_mutex> lock(m_mutex);
         Stats stats;
-        stats.total_atoms = m_atoms.size();
+        stats.total_atoms = 0;
         stats.total_nodes = 0;
         stats.total_links = 0;
 
-        for (const auto& atom : m_atoms) {
-            if (atom->is_node())
-                ++stats.total_nodes;
-            else
-                ++stats.total_links;
+        for (const auto& shard : m_atom_shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            stats.total_atoms += shard.atoms.size();
+            shard.atoms.for_each([&](const Handle& atom) {
+                if (atom->is_node())
+                    ++stats.total_nodes;
+                else
+                    ++stats.total_links;
+            });
+
+            for (const auto& [type, atoms] : shard.by_type)
+                stats.by_type[type] += atoms.size();
         }
 
-        for (const auto& [type, atoms] : m_by_type)
-            stats.by_type[type] = atoms.size();
-
         return stats;
     }
 
+protected:
+    /**
+     * Called after an atom has been added, with no shard locked. Not
+     * called when an equivalent atom was already present.
+     */
+    virtual void atom_added(const Handle& /* atom */) {}
+
+    /**
+     * Called after an atom has been removed, with no shard locked. atom
+     * is the instance that was stored, which may differ from the one
+     * passed to remove_atom().
+     */
+    virtual void atom_removed(const Handle& /* atom */) {}
+
+    /**
+     * Called after clear() has removed every atom, with no shard locked.
+     */
+    virtual void atoms_cleared() {}
+
 private:
-    mutable std::shared_mutex m_mutex;
+    static constexpr size_t NUM_SHARDS = 64;
+
+    /** Atoms by content, owning their Handles. */
+    struct AtomTraits
+    {
+        using Entry = Handle;
+        using Key = Atom;
+        static bool is_empty(const Handle& h) { return !h; }
+        static size_t hash(const Atom& atom) { return mix_hash(atom.hash()); }
+        static size_t hash_entry(const Handle& h) { return mix_hash(h->hash()); }
+        static bool matches(const Handle& h, const Atom& atom)
+        {
+            return h.get() == &atom || *h == atom;
+        }
+    };
+
+    /** Atoms by identity. */
+    struct AtomRefTraits
+    {
+        using Entry = Atom*;
+        using Key = Atom*;
+        static bool is_empty(Atom* atom) { return !atom; }
+        static size_t hash(Atom* atom) { return mix_hash(reinterpret_cast<size_t>(atom)); }
+        static size_t hash_entry(Atom* atom) { return hash(atom); }
+        static bool matches(Atom* entry, Atom* atom) { return entry == atom; }
+    };
+
+    /** Entries keyed by UUID; UUIDs start at 1, so 0 marks a free slot. */
+    template<typename E>
+    struct UUIDTraits
+    {
+        using Entry = E;
+        using Key = UUID;
+        static bool is_empty(const E& e) { return e.uuid == 0; }
+        static size_t hash(UUID uuid) { return mix_hash(uuid); }
+        static size_t hash_entry(const E& e) { return mix_hash(e.uuid); }
+        static bool matches(const E& e, UUID uuid) { return e.uuid == uuid; }
+    };
+
+    struct UUIDEntry
+    {
+        UUID uuid = 0;
+        Atom* atom = nullptr;
+    };
+
+    /** Links pointing to one atom, in no particular order. */
+    struct IncomingEntry
+    {
+        UUID uuid = 0;
+        std::vector<Atom*> links;
+    };
 
-    // Primary storage
-    AtomSet m_atoms;
+    /**
+     * Atoms whose hash falls in this shard, with their type index.
+     */
+    struct alignas(64) AtomShard
+    {
+        mutable std::shared_mutex mutex;
+        FlatTable<AtomTraits> atoms;
+        std::unordered_map<AtomType, FlatTable<AtomRefTraits>> by_type;
+    };
+
+    /**
+     * UUID lookup and incoming sets for atoms whose UUID falls in this
+     * shard.
+     */
+    struct alignas(64) UUIDShard
+    {
+        mutable std::shared_mutex mutex;
+        FlatTable<UUIDTraits<UUIDEntry>> by_uuid;
+
+        // Incoming set index (which links point to each atom)
+        FlatTable<UUIDTraits<IncomingEntry>> incoming;
+    };
 
-    // Indexes
-    std::unordered_map<AtomType, AtomSet> m_by_type;
-    std::unordered_map<UUID, Handle> m_by_uuid;
+    std::array<AtomShard, NUM_SHARDS> m_atom_shards;
+    std::array<UUIDShard, NUM_SHARDS> m_uuid_shards;
+    std::atomic<size_t> m_size{0};
 
-    // Incoming set index (which links point to each atom)
-    std::unordered_map<UUID, AtomSet> m_incoming;
+    static size_t shard_index(size_t key)
+    {
+        // Fold high bits in; the low bits of a combined hash are weak
+        key ^= key >> 29;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 32;
+        return key & (NUM_SHARDS - 1);
+    }
+
+    AtomShard& atom_shard(const Atom& atom)
+    {
+        return m_atom_shards[shard_index(atom.hash())];
+    }
+
+    const AtomShard& atom_shard(const Atom& atom) const
+    {
+        return m_atom_shards[shard_index(atom.hash())];
+    }
+
+    UUIDShard& uuid_shard(UUID uuid) { return m_uuid_shards[shard_index(uuid)]; }
+    const UUIDShard& uuid_shard(UUID uuid) const { return m_uuid_shards[shard_index(uuid)]; }
+
+    Handle find_existing(const Handle& atom) const
+    {
+        if (!atom) return nullptr;
+        const auto& shard = atom_shard(*atom);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto* entry = shard.atoms.find(*atom);
+        return entry ? *entry : nullptr;
+    }
+
+    /**
+     * Call fn once for each distinct non-null atom in a link's outgoing
+     * set, so a link appears once in each incoming set.
+     */
+    template<typename Fn>
+    static void for_each_target(const Atom& atom, Fn&& fn)
+    {
+        if (!atom.is_link()) return;
+        const auto& outgoing = atom.outgoing();
+        for (size_t i = 0; i < outgoing.size(); ++i) {
+            if (!outgoing[i]) continue;
+            bool seen = false;
+            for (size_t j = 0; j < i && !seen; ++j)
+                seen = outgoing[j] && outgoing[j]->uuid() == outgoing[i]->uuid();
+            if (!seen)
+                fn(*outgoing[i]);
+        }
+    }
 };
 
 } // namespace opencog
@@ -0,0 +1,169 @@
+/*
+ * opencog/atomspace/flat_table.hpp
+ *
+ * FlatTable - open-addressing hash table for the AtomSpace indexes
+ *
+ * Entries live directly in one array, probed linearly, and are removed
+ * by shifting later entries back rather than leaving tombstones. An
+ * index entry costs its own size over the load factor, with no per-entry
+ * allocation, where std::unordered_set spends a heap node and a bucket
+ * pointer on each.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_OPENCOG_FLAT_TABLE_HPP
+#define GNC_OPENCOG_FLAT_TABLE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace gnc {
+namespace opencog {
+
+/**
+ * FlatTable - a hash set of Traits::Entry looked up by Traits::Key.
+ *
+ * Traits supplies:
+ *   using Entry, Key;
+ *   static bool is_empty(const Entry&);       // default Entry is empty
+ *   static size_t hash(const Key&);
+ *   static size_t hash_entry(const Entry&);
+ *   static bool matches(const Entry&, const Key&);
+ *
+ * Not thread-safe; the AtomSpace guards each table with its shard lock.
+ * Pointers to entries are invalidated by insert() and erase().
+ */
+template<typename Traits>
+class FlatTable
+{
+public:
+    using Entry = typename Traits::Entry;
+    using Key = typename Traits::Key;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    Entry* find(const Key& key)
+    {
+        if (m_slots.empty()) return nullptr;
+        for (size_t i = Traits::hash(key) & mask(); ; i = (i + 1) & mask()) {
+            Entry& slot = m_slots[i];
+            if (Traits::is_empty(slot)) return nullptr;
+            if (Traits::matches(slot, key)) return &slot;
+        }
+    }
+
+    const Entry* find(const Key& key) const
+    {
+        return const_cast<FlatTable*>(this)->find(key);
+    }
+
+    /**
+     * Insert entry unless one with the same key is present. Returns the
+     * entry in the table and whether it was inserted.
+     */
+    std::pair<Entry*, bool> insert(const Key& key, Entry&& entry)
+    {
+        if ((m_size + 1) * 4 > m_slots.size() * 3)
+            grow();
+        size_t i = Traits::hash(key) & mask();
+        for (; !Traits::is_empty(m_slots[i]); i = (i + 1) & mask())
+            if (Traits::matches(m_slots[i], key))
+                return {&m_slots[i], false};
+        m_slots[i] = std::move(entry);
+        ++m_size;
+        return {&m_slots[i], true};
+    }
+
+    /**
+     * Remove the entry with key. Returns true if there was one.
+     */
+    bool erase(const Key& key)
+    {
+        Entry* slot = find(key);
+        if (!slot) return false;
+
+        // Shift back later entries of the probe run that may no longer
+        // be reachable from their home slot.
+        size_t hole = slot - m_slots.data();
+        for (size_t i = (hole + 1) & mask(); !Traits::is_empty(m_slots[i]);
+             i = (i + 1) & mask()) {
+            size_t home = Traits::hash_entry(m_slots[i]) & mask();
+            if (((i - home) & mask()) >= ((i - hole) & mask())) {
+                m_slots[hole] = std::move(m_slots[i]);
+                hole = i;
+            }
+        }
+        m_slots[hole] = Entry();
+        --m_size;
+        if (m_size == 0)
+            clear();
+        return true;
+    }
+
+    void clear()
+    {
+        std::vector<Entry>().swap(m_slots);
+        m_size = 0;
+    }
+
+    /**
+     * Call fn on every entry.
+     */
+    template<typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        for (const auto& slot : m_slots)
+            if (!Traits::is_empty(slot))
+                fn(slot);
+    }
+
+    template<typename Fn>
+    void for_each(Fn&& fn)
+    {
+        for (auto& slot : m_slots)
+            if (!Traits::is_empty(slot))
+                fn(slot);
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 8;
+
+    std::vector<Entry> m_slots;     // capacity is a power of two
+    size_t m_size = 0;
+
+    size_t mask() const { return m_slots.size() - 1; }
+
+    void grow()
+    {
+        std::vector<Entry> old(std::max(MIN_CAPACITY, m_slots.size() * 2));
+        old.swap(m_slots);
+        for (auto& entry : old) {
+            if (Traits::is_empty(entry)) continue;
+            size_t i = Traits::hash_entry(entry) & mask();
+            while (!Traits::is_empty(m_slots[i]))
+                i = (i + 1) & mask();
+            m_slots[i] = std::move(entry);
+        }
+    }
+};
+
+/**
+ * Mix the bits of a key so linear probing works on its low bits.
+ */
+inline size_t mix_hash(size_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+} // namespace opencog
+} // namespace gnc
+
+#endif // GNC_OPENCOG_FLAT_TABLE_HPP
@@ -16,6 +16,7 @@
 #include <condition_variable>
 #include <optional>
 #include <chrono>
+#include <stdexcept>
 
 namespace gnc {
 namespace opencog {
@@ -23,6 +24,9 @@ namespace opencog {
 /**
  * A thread-safe concurrent queue.
  * Multiple threads can push and pop from this queue safely.
+ *
+ * Unbounded, and pop() can wait for an item. Where a bounded queue that
+ * never blocks will do, MpmcQueue avoids the lock.
  */
 template<typename T>
 class ConcurrentQueue
@@ -78,6 +82,39 @@ public:
         return item;
     }
 
+    /**
+     * Pop an item into item, blocking if empty.
+     * Returns false instead of throwing once the queue is cancelled and
+     * drained.
+     */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return !m_queue.empty() || m_cancelled; });
+
+        if (m_queue.empty())
+            return false;
+
+        item = std::move(m_queue.front());
+        m_queue.pop();
+        return true;
+    }
+
+    /**
+     * Try to pop an item into item without blocking.
+     * Returns false if queue is empty.
+     */
+    bool try_pop(T& item)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.empty())
+            return false;
+
+        item = std::move(m_queue.front());
+        m_queue.pop();
+        return true;
+    }
+
     /**
      * Try to pop an item from the queue without blocking.
      * Returns std::nullopt if queue is empty.
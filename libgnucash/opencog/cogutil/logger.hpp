@@ -4,6 +4,12 @@
  * Logging utilities for OpenCog subsystem
  * Based on OpenCog cogutil patterns
  *
+ * The level is checked before anything is formatted, so a disabled call
+ * costs one relaxed load. In asynchronous mode a call only copies its
+ * arguments into a ring owned by the calling thread, and a sink thread
+ * formats them and hands the messages to the callback; hot loops never
+ * take a lock or build a string to log.
+ *
  * Copyright (C) 2024 GnuCash Developers
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
@@ -11,10 +17,37 @@
 #ifndef GNC_OPENCOG_LOGGER_HPP
 #define GNC_OPENCOG_LOGGER_HPP
 
-#include <string>
-#include <sstream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Most verbose level compiled in, as the number of a LogLevel. Calls
+ * through the GNC_COG_* macros above it generate no code at all, and
+ * their arguments are never evaluated. Release builds keep up to INFO.
+ */
+#ifndef GNC_COG_MAX_LOG_LEVEL
+#ifdef NDEBUG
+#define GNC_COG_MAX_LOG_LEVEL 3
+#else
+#define GNC_COG_MAX_LOG_LEVEL 5
+#endif
+#endif
 
 namespace gnc {
 namespace opencog {
@@ -32,101 +65,451 @@ enum class LogLevel
     FINE = 5
 };
 
+namespace detail {
+
+/** How a log argument is kept until it is formatted: C strings by value. */
+template<typename T>
+using log_arg_t = std::conditional_t<
+    std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>,
+    std::string, std::decay_t<T>>;
+
+/**
+ * Arguments that can be formatted later on another thread: values that
+ * cannot change or dangle once copied.
+ */
+template<typename T>
+constexpr bool deferrable_v = std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+                              std::is_same_v<T, std::string>;
+
+template<typename... Args>
+std::string format_message(const Args&... args)
+{
+    std::ostringstream oss;
+    (oss << ... << args);
+    return oss.str();
+}
+
+} // namespace detail
+
+/**
+ * One message on its way to the sink. Arguments that are plain values
+ * are stored inline and formatted when the message is taken; anything
+ * else is formatted up front by the logging thread.
+ */
+class LogRecord
+{
+public:
+    static constexpr size_t ARG_BYTES = 96;
+
+    LogLevel level = LogLevel::NONE;
+    std::string component;
+
+    LogRecord() = default;
+    ~LogRecord() { discard(); }
+
+    LogRecord(const LogRecord&) = delete;
+    LogRecord& operator=(const LogRecord&) = delete;
+
+    template<typename... Args>
+    void set_message(Args&&... args)
+    {
+        discard();
+        using Stored = std::tuple<detail::log_arg_t<Args>...>;
+        if constexpr ((detail::deferrable_v<detail::log_arg_t<Args>> && ...) &&
+                      sizeof(Stored) <= ARG_BYTES &&
+                      alignof(Stored) <= alignof(std::max_align_t)) {
+            new (m_args) Stored(std::forward<Args>(args)...);
+            m_render = [](void* stored, std::string* out) {
+                auto* values = static_cast<Stored*>(stored);
+                if (out)
+                    *out = std::apply([](const auto&... v) {
+                        return detail::format_message(v...);
+                    }, *values);
+                values->~Stored();
+            };
+        } else {
+            m_message = detail::format_message(args...);
+        }
+    }
+
+    /**
+     * The formatted message. Leaves the record empty.
+     */
+    std::string take_message()
+    {
+        std::string message;
+        if (m_render) {
+            m_render(m_args, &message);
+            m_render = nullptr;
+        } else {
+            message = std::move(m_message);
+        }
+        return message;
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char m_args[ARG_BYTES];
+    void (*m_render)(void*, std::string*) = nullptr;
+    std::string m_message;
+
+    void discard()
+    {
+        if (m_render) {
+            m_render(m_args, nullptr);
+            m_render = nullptr;
+        }
+        m_message.clear();
+    }
+};
+
+/**
+ * LogRing - the records of one thread, lock-free between that thread
+ * and one consumer at a time.
+ */
+class LogRing
+{
+public:
+    static constexpr size_t CAPACITY = 256;
+
+    /**
+     * Slot for the next record, or nullptr if the ring is full. Only the
+     * owning thread calls this and commit().
+     */
+    LogRecord* slot()
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == CAPACITY)
+            return nullptr;
+        return &m_slots[tail % CAPACITY];
+    }
+
+    void commit()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1);
+    }
+
+    /**
+     * Pass every committed record to fn, oldest first. Consumers must be
+     * serialised by the caller.
+     */
+    template<typename Fn>
+    void drain(Fn&& fn)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t tail = m_tail.load();
+        for (; head != tail; ++head) {
+            fn(m_slots[head % CAPACITY]);
+            m_head.store(head + 1, std::memory_order_release);
+        }
+    }
+
+    bool empty() const { return m_head.load() == m_tail.load(); }
+
+    /** Set once the owning thread has exited. */
+    std::atomic<bool> orphaned{false};
+    /** Set once the logger is gone, so the thread drops the ring. */
+    std::atomic<bool> closed{false};
+
+private:
+    std::array<LogRecord, CAPACITY> m_slots;
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
 /**
  * Logger for the OpenCog cognitive subsystem.
  * Integrates with GnuCash's qof logging system.
+ *
+ * By default messages reach the callback synchronously, under a mutex.
+ * After start_async() they are queued per thread and delivered by a sink
+ * thread at least every SINK_INTERVAL, in order for each thread but not
+ * across threads. A full ring is drained by the thread that filled it,
+ * so nothing is dropped.
  */
 class Logger
 {
 public:
     using LogCallback = std::function<void(LogLevel, const std::string&, const std::string&)>;
 
+    static constexpr std::chrono::milliseconds SINK_INTERVAL{5};
+
+    Logger()
+        : m_level(LogLevel::INFO)
+        , m_id(next_id())
+    {}
+
+    ~Logger()
+    {
+        stop_async();
+        std::lock_guard<std::mutex> lock(m_rings_mutex);
+        for (auto& ring : m_rings)
+            ring->closed = true;
+    }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
     static Logger& instance()
     {
         static Logger logger;
         return logger;
     }
 
-    void set_level(LogLevel level) { m_level = level; }
-    LogLevel get_level() const { return m_level; }
+    static Logger& get() { return instance(); }
+
+    void set_level(LogLevel level) { m_level.store(level, std::memory_order_relaxed); }
+    LogLevel get_level() const { return m_level.load(std::memory_order_relaxed); }
+
+    /**
+     * True if a message at level would be passed on.
+     */
+    bool should_log(LogLevel level) const
+    {
+        return level <= m_level.load(std::memory_order_relaxed);
+    }
 
     void set_callback(LogCallback callback)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> lock(m_sink_mutex);
         m_callback = std::move(callback);
     }
 
-    void log(LogLevel level, const std::string& component, const std::string& message)
+    void log(LogLevel level, std::string_view component, const std::string& message)
     {
-        if (level > m_level)
-            return;
+        if (should_log(level))
+            write(level, component, message);
+    }
 
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_callback)
-            m_callback(level, component, message);
+    template<typename... Args>
+    void error(std::string_view component, Args&&... args)
+    {
+        if (should_log(LogLevel::ERROR))
+            write(LogLevel::ERROR, component, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
-    void error(const std::string& component, Args&&... args)
+    void warn(std::string_view component, Args&&... args)
     {
-        log(LogLevel::ERROR, component, format(std::forward<Args>(args)...));
+        if (should_log(LogLevel::WARN))
+            write(LogLevel::WARN, component, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
-    void warn(const std::string& component, Args&&... args)
+    void info(std::string_view component, Args&&... args)
     {
-        log(LogLevel::WARN, component, format(std::forward<Args>(args)...));
+        if (should_log(LogLevel::INFO))
+            write(LogLevel::INFO, component, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
-    void info(const std::string& component, Args&&... args)
+    void debug(std::string_view component, Args&&... args)
     {
-        log(LogLevel::INFO, component, format(std::forward<Args>(args)...));
+        if (should_log(LogLevel::DEBUG))
+            write(LogLevel::DEBUG, component, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
-    void debug(const std::string& component, Args&&... args)
+    void fine(std::string_view component, Args&&... args)
     {
-        log(LogLevel::DEBUG, component, format(std::forward<Args>(args)...));
+        if (should_log(LogLevel::FINE))
+            write(LogLevel::FINE, component, std::forward<Args>(args)...);
     }
 
+    /**
+     * Pass a message on without checking the level; callers check
+     * should_log() first.
+     */
     template<typename... Args>
-    void fine(const std::string& component, Args&&... args)
+    void write(LogLevel level, std::string_view component, Args&&... args)
     {
-        log(LogLevel::FINE, component, format(std::forward<Args>(args)...));
+        if (!m_async.load()) {
+            std::string message = detail::format_message(args...);
+            std::lock_guard<std::mutex> lock(m_sink_mutex);
+            if (m_callback)
+                m_callback(level, std::string(component), message);
+            return;
+        }
+
+        LogRing& ring = thread_ring();
+        LogRecord* record = ring.slot();
+        if (!record) {
+            flush();
+            record = ring.slot();
+        }
+        record->level = level;
+        record->component = component;
+        record->set_message(std::forward<Args>(args)...);
+        ring.commit();
+
+        // Raced with stop_async(): deliver it now rather than strand it.
+        if (!m_async.load())
+            flush();
     }
 
-private:
-    Logger() : m_level(LogLevel::INFO) {}
+    /**
+     * Start the sink thread and queue messages from now on.
+     */
+    void start_async()
+    {
+        std::lock_guard<std::mutex> lock(m_control_mutex);
+        if (m_sink.joinable()) return;
+        m_stopping = false;
+        m_async = true;
+        m_sink = std::thread([this] { run_sink(); });
+    }
 
-    template<typename... Args>
-    std::string format(Args&&... args)
+    /**
+     * Deliver every queued message and return to synchronous logging.
+     */
+    void stop_async()
     {
-        std::ostringstream oss;
-        (oss << ... << std::forward<Args>(args));
-        return oss.str();
+        std::lock_guard<std::mutex> lock(m_control_mutex);
+        if (!m_sink.joinable()) return;
+        m_async = false;
+        {
+            std::lock_guard<std::mutex> wake_lock(m_wake_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_sink.join();
+        flush();
     }
 
-    LogLevel m_level;
+    bool is_async() const { return m_async.load(); }
+
+    /**
+     * Deliver every message queued so far, on the calling thread.
+     */
+    void flush()
+    {
+        std::vector<std::shared_ptr<LogRing>> rings;
+        {
+            std::lock_guard<std::mutex> lock(m_rings_mutex);
+            rings = m_rings;
+        }
+
+        std::lock_guard<std::mutex> lock(m_sink_mutex);
+        for (auto& ring : rings) {
+            ring->drain([this](LogRecord& record) {
+                std::string message = record.take_message();
+                if (m_callback)
+                    m_callback(record.level, record.component, message);
+            });
+        }
+
+        // Forget the rings of threads that have exited, once empty.
+        std::lock_guard<std::mutex> rings_lock(m_rings_mutex);
+        for (size_t i = 0; i < m_rings.size(); ) {
+            if (m_rings[i]->orphaned && m_rings[i]->empty()) {
+                m_rings[i] = std::move(m_rings.back());
+                m_rings.pop_back();
+            } else {
+                ++i;
+            }
+        }
+    }
+
+private:
+    std::atomic<LogLevel> m_level;
+    const uint64_t m_id;
+
     LogCallback m_callback;
-    std::mutex m_mutex;
+    std::mutex m_sink_mutex;        // callback and ring consumers
+
+    std::atomic<bool> m_async{false};
+    std::mutex m_control_mutex;
+    std::thread m_sink;
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    std::mutex m_rings_mutex;
+    std::vector<std::shared_ptr<LogRing>> m_rings;
+
+    static uint64_t next_id()
+    {
+        static std::atomic<uint64_t> id{0};
+        return ++id;
+    }
+
+    /**
+     * The calling thread's ring for this logger, registered on first use.
+     * Loggers are told apart by id, since a new one may reuse an address.
+     */
+    LogRing& thread_ring()
+    {
+        struct ThreadRings
+        {
+            std::vector<std::pair<uint64_t, std::shared_ptr<LogRing>>> rings;
+            ~ThreadRings()
+            {
+                for (auto& entry : rings)
+                    entry.second->orphaned = true;
+            }
+        };
+        static thread_local ThreadRings local;
+
+        auto& rings = local.rings;
+        for (size_t i = 0; i < rings.size(); ) {
+            if (rings[i].first == m_id)
+                return *rings[i].second;
+            if (rings[i].second->closed) {
+                rings[i] = std::move(rings.back());
+                rings.pop_back();
+            } else {
+                ++i;
+            }
+        }
+
+        auto ring = std::make_shared<LogRing>();
+        {
+            std::lock_guard<std::mutex> lock(m_rings_mutex);
+            m_rings.push_back(ring);
+        }
+        rings.emplace_back(m_id, ring);
+        return *ring;
+    }
+
+    void run_sink()
+    {
+        std::unique_lock<std::mutex> lock(m_wake_mutex);
+        while (!m_stopping) {
+            m_wake.wait_for(lock, SINK_INTERVAL, [this] { return m_stopping; });
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
 };
 
-// Convenience macros
+// Convenience macros. Levels above GNC_COG_MAX_LOG_LEVEL compile to
+// nothing, and arguments are only evaluated if the level is enabled.
+#define GNC_COG_LOG_AT(level, component, ...) \
+    do { \
+        if constexpr (static_cast<int>(level) <= GNC_COG_MAX_LOG_LEVEL) { \
+            auto& gnc_cog_logger_ = gnc::opencog::Logger::instance(); \
+            if (gnc_cog_logger_.should_log(level)) \
+                gnc_cog_logger_.write(level, component, __VA_ARGS__); \
+        } \
+    } while (0)
+
 #define GNC_COG_LOG(level, component, ...) \
     gnc::opencog::Logger::instance().log(level, component, __VA_ARGS__)
 
 #define GNC_COG_ERROR(component, ...) \
-    gnc::opencog::Logger::instance().error(component, __VA_ARGS__)
+    GNC_COG_LOG_AT(gnc::opencog::LogLevel::ERROR, component, __VA_ARGS__)
 
 #define GNC_COG_WARN(component, ...) \
-    gnc::opencog::Logger::instance().warn(component, __VA_ARGS__)
+    GNC_COG_LOG_AT(gnc::opencog::LogLevel::WARN, component, __VA_ARGS__)
 
 #define GNC_COG_INFO(component, ...) \
-    gnc::opencog::Logger::instance().info(component, __VA_ARGS__)
+    GNC_COG_LOG_AT(gnc::opencog::LogLevel::INFO, component, __VA_ARGS__)
 
 #define GNC_COG_DEBUG(component, ...) \
-    gnc::opencog::Logger::instance().debug(component, __VA_ARGS__)
+    GNC_COG_LOG_AT(gnc::opencog::LogLevel::DEBUG, component, __VA_ARGS__)
+
+#define GNC_COG_FINE(component, ...) \
+    GNC_COG_LOG_AT(gnc::opencog::LogLevel::FINE, component, __VA_ARGS__)
 
 } // namespace opencog
 } // namespace gnc
@@ -0,0 +1,149 @@
+/*
+ * opencog/cogutil/mpmc_queue.hpp
+ *
+ * Bounded lock-free multi-producer multi-consumer queue
+ *
+ * A ring of cells, each with a sequence number that says whether the cell
+ * is ready to be written or read at the current lap, after Dmitry Vyukov's
+ * bounded MPMC queue. Producers and consumers each claim a position with
+ * one compare-and-swap and then touch only their own cell, so neither side
+ * ever waits for the other and there is no lock to contend for.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_OPENCOG_MPMC_QUEUE_HPP
+#define GNC_OPENCOG_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace gnc {
+namespace opencog {
+
+/**
+ * MpmcQueue - a fixed-capacity FIFO that any number of threads may push
+ * to and pop from concurrently.
+ *
+ * try_push() fails when the queue is full and try_pop() when it is empty;
+ * neither blocks. Callers that need to wait use ConcurrentQueue instead.
+ * T must be default-constructible and move-assignable.
+ */
+template<typename T>
+class MpmcQueue
+{
+public:
+    /**
+     * Create a queue for at least capacity items. The capacity is rounded
+     * up to a power of two.
+     */
+    explicit MpmcQueue(size_t capacity)
+    {
+        if (capacity == 0)
+            throw std::invalid_argument("MpmcQueue: capacity must be positive");
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    bool try_push(const T& item)
+    {
+        T copy(item);
+        return try_push(std::move(copy));
+    }
+
+    /**
+     * Push an item unless the queue is full. The item is only moved from
+     * if this returns true.
+     */
+    bool try_push(T&& item)
+    {
+        size_t pos = m_enqueue.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[pos & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t lap = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (lap == 0) {
+                if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(item);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lap < 0) {
+                return false;   // the cell still holds an item a lap behind
+            } else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Pop the oldest item into item unless the queue is empty.
+     */
+    bool try_pop(T& item)
+    {
+        size_t pos = m_dequeue.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[pos & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t lap = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (lap == 0) {
+                if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = std::move(cell.value);
+                    cell.value = T();
+                    cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lap < 0) {
+                return false;   // nothing written to this cell yet
+            } else {
+                pos = m_dequeue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+    /**
+     * Number of items, exact only while no other thread is using the queue.
+     */
+    size_t size() const
+    {
+        size_t tail = m_enqueue.load(std::memory_order_acquire);
+        size_t head = m_dequeue.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct alignas(CACHE_LINE) Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+
+    // On separate cache lines so producers and consumers do not contend.
+    alignas(CACHE_LINE) std::atomic<size_t> m_enqueue{0};
+    alignas(CACHE_LINE) std::atomic<size_t> m_dequeue{0};
+};
+
+} // namespace opencog
+} // namespace gnc
+
+#endif // GNC_OPENCOG_MPMC_QUEUE_HPP
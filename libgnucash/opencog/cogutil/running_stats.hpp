@@ -0,0 +1,257 @@
+/*
+ * opencog/cogutil/running_stats.hpp
+ *
+ * Streaming estimators: running mean/variance, EWMA and Holt-Winters
+ *
+ * Each estimator takes one observation at a time in O(1) and keeps only
+ * a few numbers of state, so statistics over a growing series never need
+ * the series itself.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_OPENCOG_RUNNING_STATS_HPP
+#define GNC_OPENCOG_RUNNING_STATS_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace gnc {
+namespace opencog {
+
+/**
+ * RunningStats - count, mean and variance by Welford's method.
+ *
+ * Observations can also be removed again, which undoes add() exactly up
+ * to rounding, and two summaries can be merged.
+ */
+class RunningStats
+{
+public:
+    void add(double x)
+    {
+        ++m_count;
+        double delta = x - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (x - m_mean);
+    }
+
+    /**
+     * Remove an observation added earlier.
+     */
+    void remove(double x)
+    {
+        if (m_count == 0) return;
+        if (--m_count == 0) {
+            clear();
+            return;
+        }
+        double delta = x - m_mean;
+        m_mean -= delta / m_count;
+        m_m2 -= delta * (x - m_mean);
+        if (m_m2 < 0.0) m_m2 = 0.0;
+    }
+
+    /**
+     * Combine with the summary of another set of observations.
+     */
+    void merge(const RunningStats& other)
+    {
+        if (other.m_count == 0) return;
+        size_t count = m_count + other.m_count;
+        double delta = other.m_mean - m_mean;
+        m_m2 += other.m_m2 + delta * delta * m_count * other.m_count / count;
+        m_mean += delta * other.m_count / count;
+        m_count = count;
+    }
+
+    void clear()
+    {
+        m_count = 0;
+        m_mean = 0.0;
+        m_m2 = 0.0;
+    }
+
+    size_t count() const { return m_count; }
+    double mean() const { return m_mean; }
+
+    /** Population variance. */
+    double variance() const { return m_count ? m_m2 / m_count : 0.0; }
+
+    /** Sample variance. */
+    double sample_variance() const { return m_count > 1 ? m_m2 / (m_count - 1) : 0.0; }
+
+    double stddev() const { return std::sqrt(variance()); }
+
+    /**
+     * Standard score of x, or 0 while the spread is zero.
+     */
+    double z_score(double x) const
+    {
+        double sd = stddev();
+        return sd > 0.0 ? (x - m_mean) / sd : 0.0;
+    }
+
+private:
+    size_t m_count = 0;
+    double m_mean = 0.0;
+    double m_m2 = 0.0;      // sum of squared deviations from the mean
+};
+
+/**
+ * Ewma - exponentially weighted moving average and variance.
+ *
+ * Recent observations weigh more; alpha is the weight of the newest.
+ */
+class Ewma
+{
+public:
+    explicit Ewma(double alpha = 0.3)
+        : m_alpha(alpha)
+    {
+        if (alpha <= 0.0 || alpha > 1.0)
+            throw std::invalid_argument("Ewma: alpha must be in (0, 1]");
+    }
+
+    void add(double x)
+    {
+        if (!m_count++) {
+            m_mean = x;
+            return;
+        }
+        double delta = x - m_mean;
+        m_mean += m_alpha * delta;
+        m_variance = (1.0 - m_alpha) * (m_variance + m_alpha * delta * delta);
+    }
+
+    size_t count() const { return m_count; }
+    double mean() const { return m_mean; }
+    double variance() const { return m_variance; }
+    double stddev() const { return std::sqrt(m_variance); }
+
+private:
+    double m_alpha;
+    size_t m_count = 0;
+    double m_mean = 0.0;
+    double m_variance = 0.0;
+};
+
+/**
+ * HoltWinters - additive level, trend and seasonal smoothing.
+ *
+ * With a season length of 0 this is Holt's linear method, started from
+ * the first two observations. Otherwise the first season initialises the
+ * seasonal terms; until then forecasts follow level and trend only. The
+ * one-step forecast errors are kept as RunningStats for prediction
+ * intervals.
+ */
+class HoltWinters
+{
+public:
+    HoltWinters(double alpha = 0.3, double beta = 0.1, double gamma = 0.1,
+                size_t season_length = 0)
+        : m_alpha(alpha)
+        , m_beta(beta)
+        , m_gamma(gamma)
+        , m_season(season_length, 0.0)
+    {
+        if (alpha <= 0.0 || alpha > 1.0 || beta < 0.0 || beta > 1.0 ||
+            gamma < 0.0 || gamma > 1.0)
+            throw std::invalid_argument("HoltWinters: smoothing factors must be in [0, 1]");
+        if (season_length == 1)
+            throw std::invalid_argument("HoltWinters: a season needs at least two periods");
+    }
+
+    void add(double x)
+    {
+        size_t t = m_count++;
+        if (t == 0) {
+            m_level = x;
+            m_first = x;
+            if (!m_season.empty())
+                m_season[0] = x;
+            return;
+        }
+
+        if (t == 1 && m_season.empty()) {
+            m_trend = x - m_level;
+            m_level = x;
+            return;
+        }
+
+        if (t < m_season.size()) {
+            // Still in the first season: collect it, and track a plain
+            // level and trend meanwhile.
+            m_season[t] = x;
+            double level = m_level;
+            m_level = x;
+            m_trend = m_beta * (x - level) + (1.0 - m_beta) * m_trend;
+            if (t + 1 == m_season.size()) {
+                double mean = 0.0;
+                for (double s : m_season) mean += s;
+                mean /= m_season.size();
+                for (double& s : m_season) s -= mean;
+                m_level = mean;
+                m_trend = (x - m_first) / t;
+            }
+            return;
+        }
+
+        double season = m_season.empty() ? 0.0 : m_season[t % m_season.size()];
+        m_errors.add(x - (m_level + m_trend + season));
+
+        double level = m_level;
+        m_level = m_alpha * (x - season) + (1.0 - m_alpha) * (m_level + m_trend);
+        m_trend = m_beta * (m_level - level) + (1.0 - m_beta) * m_trend;
+        if (!m_season.empty())
+            m_season[t % m_season.size()] =
+                m_gamma * (x - m_level) + (1.0 - m_gamma) * season;
+    }
+
+    /**
+     * Forecast of the observation steps ahead of the last one (steps >= 1).
+     */
+    double forecast(size_t steps) const
+    {
+        if (m_count == 0) return 0.0;
+        double value = m_level + m_trend * steps;
+        if (!m_season.empty() && m_count >= m_season.size())
+            value += m_season[(m_count + steps - 1) % m_season.size()];
+        return value;
+    }
+
+    /**
+     * Forecasts for 1..horizon steps ahead.
+     */
+    std::vector<double> forecast_range(size_t horizon) const
+    {
+        std::vector<double> values(horizon);
+        for (size_t i = 0; i < horizon; ++i)
+            values[i] = forecast(i + 1);
+        return values;
+    }
+
+    size_t count() const { return m_count; }
+    double level() const { return m_level; }
+    double trend() const { return m_trend; }
+
+    /** One-step forecast errors seen so far. */
+    const RunningStats& errors() const { return m_errors; }
+
+private:
+    double m_alpha, m_beta, m_gamma;
+    std::vector<double> m_season;
+    size_t m_count = 0;
+    double m_level = 0.0;
+    double m_trend = 0.0;
+    double m_first = 0.0;
+    RunningStats m_errors;
+};
+
+} // namespace opencog
+} // namespace gnc
+
+#endif // GNC_OPENCOG_RUNNING_STATS_HPP
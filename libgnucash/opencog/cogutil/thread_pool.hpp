@@ -0,0 +1,300 @@
+/*
+ * opencog/cogutil/thread_pool.hpp
+ *
+ * Work-stealing thread pool with futures and parallel_for
+ *
+ * Tasks posted from outside the pool go through a lock-free MpmcQueue.
+ * Tasks posted by a worker go to that worker's own deque, which it works
+ * through newest first while idle workers steal the oldest ones, so
+ * nested parallel work stays on the thread whose caches already hold it.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_OPENCOG_THREAD_POOL_HPP
+#define GNC_OPENCOG_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "mpmc_queue.hpp"
+
+namespace gnc {
+namespace opencog {
+
+/**
+ * ThreadPool - a fixed set of worker threads that run posted tasks.
+ *
+ * Destroying the pool runs every task still queued, then joins the
+ * workers.
+ */
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    /** Tasks from outside the pool that can wait before posting runs them inline. */
+    static constexpr size_t QUEUE_CAPACITY = 1024;
+
+    /**
+     * Start threads workers, or one per hardware thread if 0.
+     */
+    explicit ThreadPool(size_t threads = 0)
+        : m_injected(QUEUE_CAPACITY)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threads; ++i)
+            m_locals.push_back(std::make_unique<LocalQueue>());
+        m_workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            m_workers.emplace_back([this, i] { run(i); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto& worker : m_workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return m_workers.size(); }
+
+    /**
+     * True on one of this pool's worker threads.
+     */
+    bool in_worker() const { return context().pool == this; }
+
+    /**
+     * Run a task on the pool. If the queue for outside tasks is full the
+     * task runs on the calling thread before post() returns.
+     */
+    void post(Task task)
+    {
+        auto& ctx = context();
+        m_pending.fetch_add(1);
+        if (ctx.pool == this) {
+            auto& local = *m_locals[ctx.index];
+            std::lock_guard<std::mutex> lock(local.mutex);
+            local.tasks.push_back(std::move(task));
+        } else if (!m_injected.try_push(std::move(task))) {
+            m_pending.fetch_sub(1);
+            task();
+            return;
+        }
+        wake_one();
+    }
+
+    /**
+     * Run fn(args...) on the pool. The future holds its result or the
+     * exception it threw.
+     */
+    template<typename Fn, typename... Args>
+    auto submit(Fn&& fn, Args&&... args)
+        -> std::future<std::invoke_result_t<std::decay_t<Fn>, std::decay_t<Args>...>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<Fn>, std::decay_t<Args>...>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            [fn = std::forward<Fn>(fn),
+             args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(fn), std::move(args));
+            });
+        auto future = task->get_future();
+        post([task] { (*task)(); });
+        return future;
+    }
+
+    /**
+     * Call fn(chunk_begin, chunk_end) for [begin, end) cut into chunks of
+     * grain, concurrently, and return when all have run.
+     *
+     * Chunks are handed out in order from a shared counter, to the
+     * calling thread as well as to up to max_parallelism - 1 pool tasks
+     * (0 for the whole pool). The caller never waits for a task to start,
+     * so parallel_for can be nested inside pool tasks. The first
+     * exception thrown by fn is rethrown after every chunk has run.
+     */
+    template<typename Fn>
+    void parallel_for(size_t begin, size_t end, size_t grain, Fn&& fn,
+                      size_t max_parallelism = 0)
+    {
+        if (begin >= end) return;
+        if (grain == 0) grain = 1;
+        size_t chunks = (end - begin + grain - 1) / grain;
+        size_t tasks = std::min(chunks, size() + 1);
+        if (max_parallelism)
+            tasks = std::min(tasks, max_parallelism);
+        if (tasks < 2) {
+            fn(begin, end);
+            return;
+        }
+
+        // Tasks that start after the loop is over only read the counter,
+        // so the state is shared with them and fn is not.
+        struct State
+        {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+            std::exception_ptr error;
+        };
+        auto state = std::make_shared<State>();
+        auto* body = &fn;
+
+        auto work = [state, body, begin, end, grain, chunks]() {
+            for (size_t c = state->next++; c < chunks; c = state->next++) {
+                size_t chunk_begin = begin + c * grain;
+                try {
+                    (*body)(chunk_begin, std::min(end, chunk_begin + grain));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (!state->error)
+                        state->error = std::current_exception();
+                }
+                if (++state->done == chunks) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->finished.notify_all();
+                }
+            }
+        };
+
+        for (size_t t = 1; t < tasks; ++t)
+            post(work);
+        work();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&] { return state->done.load() == chunks; });
+        if (state->error)
+            std::rethrow_exception(state->error);
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct alignas(CACHE_LINE) LocalQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    struct WorkerContext
+    {
+        const ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<LocalQueue>> m_locals;
+    MpmcQueue<Task> m_injected;
+
+    std::atomic<size_t> m_pending{0};   // posted and not yet taken
+    std::atomic<size_t> m_sleeping{0};
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    static WorkerContext& context()
+    {
+        static thread_local WorkerContext ctx;
+        return ctx;
+    }
+
+    void wake_one()
+    {
+        // m_pending was raised first, so a worker going to sleep after
+        // this load sees the task in its wait predicate.
+        if (m_sleeping.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            m_wake.notify_one();
+        }
+    }
+
+    void run(size_t index)
+    {
+        context() = WorkerContext{this, index};
+        Task task;
+        for (;;) {
+            if (take(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            ++m_sleeping;
+            m_wake.wait(lock, [this] { return m_pending.load() > 0 || m_stopping; });
+            --m_sleeping;
+            if (m_stopping && m_pending.load() == 0)
+                return;
+        }
+    }
+
+    /**
+     * Own newest task, else the oldest outside task, else steal the
+     * oldest task of another worker.
+     */
+    bool take(size_t index, Task& task)
+    {
+        if (pop_local(index, task, false) || m_injected.try_pop(task)) {
+            m_pending.fetch_sub(1);
+            return true;
+        }
+        for (size_t k = 1; k < m_locals.size(); ++k) {
+            if (pop_local((index + k) % m_locals.size(), task, true)) {
+                m_pending.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool pop_local(size_t index, Task& task, bool oldest)
+    {
+        auto& local = *m_locals[index];
+        std::lock_guard<std::mutex> lock(local.mutex);
+        if (local.tasks.empty()) return false;
+        if (oldest) {
+            task = std::move(local.tasks.front());
+            local.tasks.pop_front();
+        } else {
+            task = std::move(local.tasks.back());
+            local.tasks.pop_back();
+        }
+        return true;
+    }
+};
+
+/**
+ * Pool shared by the tensor kernels, the pattern matcher and anything
+ * else without a pool of its own.
+ */
+inline ThreadPool& default_thread_pool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace opencog
+} // namespace gnc
+
+#endif // GNC_OPENCOG_THREAD_POOL_HPP
@@ -21,6 +21,41 @@ namespace opencog {
 namespace {
     // Singleton instance
     std::unique_ptr<CognitiveEngine> g_engine;
+
+    // Occurrences of a description that make a transaction recurring
+    constexpr size_t RECURRING_MIN_COUNT = 3;
+
+    // Name the typical gap between the dates of a recurring transaction.
+    std::string recurrence(std::vector<int64_t> days)
+    {
+        if (days.size() < 2)
+            return "periodic";
+        std::sort(days.begin(), days.end());
+        std::vector<int64_t> gaps;
+        for (size_t i = 1; i < days.size(); ++i)
+            gaps.push_back(days[i] - days[i - 1]);
+        std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+        int64_t gap = gaps[gaps.size() / 2];
+        if (gap <= 1) return "daily";
+        if (gap <= 10) return "weekly";
+        if (gap <= 45) return "monthly";
+        return "periodic";
+    }
+
+    // (EvaluationLink has-description (ListLink $txn $desc)), as written
+    // by import_transaction.
+    Pattern description_pattern()
+    {
+        Pattern pattern;
+        pattern.add_variable("txn", AtomTypes::TRANSACTION_NODE)
+               .add_variable("desc", AtomTypes::CONCEPT_NODE)
+               .set_body(create_link(AtomTypes::EVALUATION_LINK,
+                   create_node(AtomTypes::PREDICATE_NODE, "has-description"),
+                   create_link(AtomTypes::LIST_LINK,
+                       create_node(AtomTypes::VARIABLE_NODE, "txn"),
+                       create_node(AtomTypes::VARIABLE_NODE, "desc"))));
+        return pattern;
+    }
 }
 
 CognitiveEngine& cognitive_engine()
@@ -32,6 +67,7 @@ CognitiveEngine& cognitive_engine()
 
 CognitiveEngine::CognitiveEngine()
     : m_initialized(false)
+    , m_atomspace(m_transactions)
 {
 }
 
@@ -187,6 +223,26 @@ void CognitiveEngine::import_transaction(const std::string& guid, const std::str
             m_atomspace.add_node(AtomTypes::PREDICATE_NODE, "credit"),
             m_atomspace.add_link(AtomTypes::LIST_LINK, txn_node, credit_node));
     }
+
+    m_transactions.set(txn_node, amount, TransactionColumns::parse_day(date), description,
+                       debit_account);
+}
+
+bool CognitiveEngine::remove_transaction(const std::string& guid)
+{
+    auto txn_node = m_atomspace.get_node(AtomTypes::TRANSACTION_NODE, guid);
+    if (!txn_node)
+        return false;
+
+    // The transaction's links, and the links holding those, such as the
+    // EvaluationLink around a ListLink.
+    for (const auto& link : m_atomspace.get_incoming(txn_node)) {
+        for (const auto& parent : m_atomspace.get_incoming(link))
+            m_atomspace.remove_atom(parent);
+        m_atomspace.remove_atom(link);
+    }
+    m_atomspace.remove_atom(txn_node);
+    return true;
 }
 
 void CognitiveEngine::import_vendor(const std::string& name, const std::string& category)
@@ -306,37 +362,31 @@ std::vector<SpendingPattern> CognitiveEngine::detect_spending_patterns()
 {
     std::vector<SpendingPattern> patterns;
 
-    // Find all transactions
-    auto transactions = m_atomspace.get_atoms_by_type(AtomTypes::TRANSACTION_NODE);
-
-    // Group by vendor/description
-    Counter<std::string> vendor_counts;
-    for (const auto& txn : transactions) {
-        // Get description
-        auto incoming = m_atomspace.get_incoming_by_type(txn, AtomTypes::EVALUATION_LINK);
-        for (const auto& link : incoming) {
-            auto pred = link->outgoing_atom(0);
-            if (pred && pred->name() == "has-description") {
-                auto list = link->outgoing_atom(1);
-                if (list && list->arity() >= 2) {
-                    auto desc = list->outgoing_atom(1);
-                    if (desc)
-                        vendor_counts.increment(desc->name());
-                }
-            }
-        }
+    // Dates of the transactions of each recurring vendor/description
+    const auto& descriptions = m_transactions.descriptions();
+    const auto& days = m_transactions.days();
+    std::vector<std::vector<int64_t>> dates(m_transactions.description_count());
+    for (size_t row = 0; row < descriptions.size(); ++row) {
+        auto id = descriptions[row];
+        if (m_transactions.description_stats(id).count() >= RECURRING_MIN_COUNT &&
+            days[row] != TransactionColumns::NO_DAY)
+            dates[id].push_back(days[row]);
     }
 
     // Identify recurring patterns
-    for (const auto& [desc, count] : vendor_counts) {
-        if (count >= 3) {  // At least 3 occurrences
-            SpendingPattern pattern;
-            pattern.name = desc;
-            pattern.description = "Recurring transaction: " + desc;
-            pattern.frequency = (count >= 12) ? "monthly" : (count >= 52) ? "weekly" : "periodic";
-            pattern.confidence = std::min(1.0, count / 10.0);
-            patterns.push_back(pattern);
-        }
+    for (TransactionColumns::DescriptionId id = 0; id < dates.size(); ++id) {
+        const auto& stats = m_transactions.description_stats(id);
+        if (stats.count() < RECURRING_MIN_COUNT)
+            continue;
+
+        const auto& desc = m_transactions.description_name(id);
+        SpendingPattern pattern;
+        pattern.name = desc;
+        pattern.description = "Recurring transaction: " + desc;
+        pattern.average_amount = stats.mean();
+        pattern.frequency = recurrence(dates[id]);
+        pattern.confidence = std::min(1.0, stats.count() / 10.0);
+        patterns.push_back(pattern);
     }
 
     m_detected_patterns = patterns;
@@ -346,67 +396,63 @@ std::vector<SpendingPattern> CognitiveEngine::detect_spending_patterns()
 std::vector<Handle> CognitiveEngine::find_recurring_transactions()
 {
     PatternMatcher matcher(m_atomspace);
-    return matcher.find_by_type(AtomTypes::TRANSACTION_NODE);
+    auto matches = matcher.match_parallel(description_pattern());
+
+    Counter<std::string> description_counts;
+    for (const auto& bindings : matches)
+        description_counts.increment(bindings.at("desc")->name());
+
+    std::vector<Handle> recurring;
+    for (const auto& bindings : matches)
+        if (description_counts.count(bindings.at("desc")->name()) >= RECURRING_MIN_COUNT)
+            recurring.push_back(bindings.at("txn"));
+    return recurring;
 }
 
 std::vector<Handle> CognitiveEngine::detect_anomalies(double threshold)
 {
     std::vector<Handle> anomalies;
 
-    auto transactions = m_atomspace.get_atoms_by_type(AtomTypes::TRANSACTION_NODE);
-
-    // Calculate statistics for anomaly detection
-    std::vector<double> amounts;
-    for (const auto& txn : transactions) {
-        auto incoming = m_atomspace.get_incoming_by_type(txn, AtomTypes::EVALUATION_LINK);
-        for (const auto& link : incoming) {
-            auto pred = link->outgoing_atom(0);
-            if (pred && pred->name() == "has-amount") {
-                auto list = link->outgoing_atom(1);
-                if (list && list->arity() >= 2) {
-                    auto amt = list->outgoing_atom(1);
-                    if (amt) {
-                        try {
-                            amounts.push_back(std::stod(amt->name()));
-                        } catch (...) {}
-                    }
-                }
-            }
-        }
-    }
-
-    if (amounts.size() < 2)
+    const auto& amounts = m_transactions.amounts();
+    const auto& stats = m_transactions.amount_stats();
+    if (amounts.size() < 2 || stats.stddev() == 0.0)
         return anomalies;
 
-    // Calculate mean and standard deviation
-    double sum = 0, sq_sum = 0;
-    for (double amt : amounts) {
-        sum += amt;
-        sq_sum += amt * amt;
-    }
-    double mean = sum / amounts.size();
-    double variance = sq_sum / amounts.size() - mean * mean;
-    double stddev = std::sqrt(variance);
-
     // Find anomalies (transactions outside threshold * stddev)
-    size_t idx = 0;
-    for (const auto& txn : transactions) {
-        if (idx < amounts.size()) {
-            double z_score = std::abs(amounts[idx] - mean) / stddev;
-            if (z_score > threshold) {
-                anomalies.push_back(txn);
-
-                // Mark as anomaly in AtomSpace
-                m_atomspace.add_link(AtomTypes::ANOMALY_LINK, txn,
-                    m_atomspace.add_node(AtomTypes::NUMBER_NODE, std::to_string(z_score)));
-            }
+    const auto& transactions = m_transactions.transactions();
+    for (size_t row = 0; row < amounts.size(); ++row) {
+        double z_score = std::abs(stats.z_score(amounts[row]));
+        if (z_score > threshold) {
+            anomalies.push_back(transactions[row]);
+
+            // Mark as anomaly in AtomSpace
+            m_atomspace.add_link(AtomTypes::ANOMALY_LINK, transactions[row],
+                m_atomspace.add_node(AtomTypes::NUMBER_NODE, std::to_string(z_score)));
         }
-        ++idx;
     }
 
     return anomalies;
 }
 
+double CognitiveEngine::anomaly_score(double amount, const std::string& description,
+                                      const std::string& category) const
+{
+    auto usable = [](const RunningStats& stats) {
+        return stats.count() >= RECURRING_MIN_COUNT && stats.stddev() > 0.0;
+    };
+    if (auto id = m_transactions.description_id(description)) {
+        const auto& stats = m_transactions.description_stats(*id);
+        if (usable(stats))
+            return stats.z_score(amount);
+    }
+    if (auto id = m_transactions.category_id(category)) {
+        const auto& stats = m_transactions.category_stats(*id);
+        if (usable(stats))
+            return stats.z_score(amount);
+    }
+    return m_transactions.amount_stats().z_score(amount);
+}
+
 double CognitiveEngine::predict_cash_flow(int days_ahead)
 {
     // Simple prediction based on recent patterns
@@ -20,6 +20,7 @@
 #include "../atomspace/atomspace.hpp"
 #include "../pattern/pattern_match.hpp"
 #include "../cogutil/counter.hpp"
+#include "transaction_columns.hpp"
 
 namespace gnc {
 namespace opencog {
@@ -77,6 +78,31 @@ struct SpendingPattern
     double confidence;
 };
 
+/**
+ * KnowledgeSpace - the engine's AtomSpace.
+ *
+ * Keeps TransactionColumns in step with the atoms: removing a
+ * TransactionNode, or clearing the space, drops the matching rows, whether
+ * it is done by the engine or through CognitiveEngine::atomspace().
+ */
+class KnowledgeSpace : public AtomSpace
+{
+public:
+    explicit KnowledgeSpace(TransactionColumns& columns) : m_columns(columns) {}
+
+protected:
+    void atom_removed(const Handle& atom) override
+    {
+        if (atom->type() == AtomTypes::TRANSACTION_NODE)
+            m_columns.erase(atom);
+    }
+
+    void atoms_cleared() override { m_columns.clear(); }
+
+private:
+    TransactionColumns& m_columns;
+};
+
 /**
  * CognitiveEngine - the main interface to GnuCash AI capabilities.
  *
@@ -122,6 +148,11 @@ public:
     AtomSpace& atomspace() { return m_atomspace; }
     const AtomSpace& atomspace() const { return m_atomspace; }
 
+    /**
+     * Get the amounts, dates and descriptions of imported transactions.
+     */
+    const TransactionColumns& transactions() const { return m_transactions; }
+
     /**
      * Import account structure into the knowledge base.
      */
@@ -135,6 +166,12 @@ public:
                            const std::string& date, double amount,
                            const std::string& debit_account, const std::string& credit_account);
 
+    /**
+     * Remove a transaction and the links describing it.
+     * Returns true if the transaction was known.
+     */
+    bool remove_transaction(const std::string& guid);
+
     /**
      * Import a vendor/payee.
      */
@@ -176,6 +213,15 @@ public:
      */
     std::vector<Handle> detect_anomalies(double threshold = 2.0);
 
+    /**
+     * Z-score of an amount against earlier transactions with the same
+     * description, else against those in the same category (the debit
+     * account), else against all transactions, taking the first with
+     * enough history. Runs in constant time from running statistics.
+     */
+    double anomaly_score(double amount, const std::string& description = "",
+                         const std::string& category = "") const;
+
     // =========================================
     // Predictions
     // =========================================
@@ -238,7 +284,8 @@ public:
 
 private:
     bool m_initialized;
-    AtomSpace m_atomspace;
+    TransactionColumns m_transactions;
+    KnowledgeSpace m_atomspace;
 
     // Categorization learning
     Counter<std::string> m_category_counts;
@@ -0,0 +1,124 @@
+/*
+ * opencog/gnc-cognitive/engine_bridge.cpp
+ *
+ * EngineBridge implementation
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "engine_bridge.hpp"
+
+#include <Account.h>
+#include <Split.h>
+#include <Transaction.h>
+#include <gnc-date.h>
+#include <guid.h>
+
+#include <ctime>
+
+namespace gnc {
+namespace opencog {
+
+namespace {
+    std::string guid_string(QofInstance* instance)
+    {
+        char buff[GUID_ENCODING_LENGTH + 1];
+        guid_to_string_buff(qof_instance_get_guid(instance), buff);
+        return buff;
+    }
+
+    AccountRecord account_record(Account* account)
+    {
+        AccountRecord record;
+        record.guid = guid_string(QOF_INSTANCE(account));
+        record.name = xaccAccountGetName(account);
+        record.account_type = xaccAccountTypeEnumAsString(xaccAccountGetType(account));
+
+        Account* parent = gnc_account_get_parent(account);
+        if (parent && !gnc_account_is_root(parent))
+            record.parent_guid = guid_string(QOF_INSTANCE(parent));
+        return record;
+    }
+
+    // The flow of a transaction: its debits in total, from the account of
+    // the largest credit split to the account of the largest debit split.
+    TransactionRecord transaction_record(Transaction* trans, int first_year)
+    {
+        TransactionRecord record;
+        record.guid = guid_string(QOF_INSTANCE(trans));
+        record.description = xaccTransGetDescription(trans);
+
+        time64 date = xaccTransGetDate(trans);
+        struct tm tm;
+        if (gnc_localtime_r(&date, &tm)) {
+            char buff[16];
+            std::strftime(buff, sizeof(buff), "%Y-%m-%d", &tm);
+            record.date = buff;
+            int year = tm.tm_year + 1900;
+            if (year >= first_year)
+                record.period = static_cast<size_t>((year - first_year) * 12 + tm.tm_mon);
+        }
+
+        double largest_debit = 0.0, largest_credit = 0.0;
+        for (GList* node = xaccTransGetSplitList(trans); node; node = node->next) {
+            Split* split = GNC_SPLIT(node->data);
+            Account* account = xaccSplitGetAccount(split);
+            if (!account) continue;
+
+            double value = gnc_numeric_to_double(xaccSplitGetValue(split));
+            if (value > 0.0) {
+                record.amount += value;
+                if (value > largest_debit) {
+                    largest_debit = value;
+                    record.debit_account = guid_string(QOF_INSTANCE(account));
+                }
+            } else if (-value > largest_credit) {
+                largest_credit = -value;
+                record.credit_account = guid_string(QOF_INSTANCE(account));
+            }
+        }
+        return record;
+    }
+}
+
+EngineBridge::EngineBridge(EventFeed& feed, int first_year)
+    : m_feed(feed)
+    , m_first_year(first_year)
+    , m_handler_id(qof_event_register_handler(handle_event, this))
+{
+}
+
+EngineBridge::~EngineBridge()
+{
+    qof_event_unregister_handler(m_handler_id);
+}
+
+void EngineBridge::handle_event(QofInstance* entity, QofEventId event_type,
+                                gpointer handler_data, gpointer)
+{
+    auto bridge = static_cast<EngineBridge*>(handler_data);
+    auto& feed = bridge->m_feed;
+
+    if (GNC_IS_TRANS(entity)) {
+        // A transaction raises MODIFY once its edit is committed; events
+        // while it is open, and from its splits, describe partial edits.
+        Transaction* trans = GNC_TRANS(entity);
+        if (event_type & QOF_EVENT_DESTROY)
+            feed.transaction_destroyed(guid_string(entity));
+        else if ((event_type & QOF_EVENT_MODIFY) && !xaccTransIsOpen(trans))
+            feed.transaction_changed(transaction_record(trans, bridge->m_first_year));
+    } else if (GNC_IS_ACCOUNT(entity)) {
+        // Likewise for accounts. CREATE comes from xaccMallocAccount,
+        // before the account has a name or type; the engines only add
+        // what they are given, so recording it would leave those blanks
+        // behind.
+        Account* account = GNC_ACCOUNT(entity);
+        if ((event_type & QOF_EVENT_MODIFY) && qof_instance_get_editlevel(account) == 0 &&
+            !gnc_account_is_root(account))
+            feed.account_changed(account_record(account));
+    }
+}
+
+} // namespace opencog
+} // namespace gnc
@@ -0,0 +1,53 @@
+/*
+ * opencog/gnc-cognitive/engine_bridge.hpp
+ *
+ * EngineBridge - feeds GnuCash engine events into an EventFeed
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_COGNITIVE_ENGINE_BRIDGE_HPP
+#define GNC_COGNITIVE_ENGINE_BRIDGE_HPP
+
+#include <qofevent.h>
+
+#include "event_feed.hpp"
+
+namespace gnc {
+namespace opencog {
+
+/**
+ * EngineBridge - a QOF event handler for account and transaction changes.
+ *
+ * While it exists, every committed transaction or account edit and every
+ * destroyed transaction is copied into plain records and
+ * queued on the feed. The handler does no analysis itself, so the thread
+ * committing the change only pays for the copy.
+ *
+ * A transaction's period counts months from January of first_year, so
+ * period 13 is February of the following year. Transactions dated before
+ * then get TransactionRecord::NO_PERIOD.
+ */
+class EngineBridge
+{
+public:
+    EngineBridge(EventFeed& feed, int first_year);
+    ~EngineBridge();
+
+    EngineBridge(const EngineBridge&) = delete;
+    EngineBridge& operator=(const EngineBridge&) = delete;
+
+private:
+    EventFeed& m_feed;
+    int m_first_year;
+    gint m_handler_id;
+
+    static void handle_event(QofInstance* entity, QofEventId event_type,
+                             gpointer handler_data, gpointer event_data);
+};
+
+} // namespace opencog
+} // namespace gnc
+
+#endif // GNC_COGNITIVE_ENGINE_BRIDGE_HPP
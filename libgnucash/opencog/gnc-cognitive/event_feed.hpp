@@ -0,0 +1,315 @@
+/*
+ * opencog/gnc-cognitive/event_feed.hpp
+ *
+ * EventFeed - incremental updates of the cognitive engines
+ *
+ * Changes to accounts and transactions are queued as plain records by
+ * whatever thread sees them, normally the GUI thread inside a QOF event
+ * handler (see engine_bridge.hpp). One worker thread drains the queue in
+ * batches and applies them to a CognitiveEngine and, optionally, a
+ * TensorLogicEngine, so the book never has to be re-imported and the
+ * thread raising the events never waits for the analysis.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_COGNITIVE_EVENT_FEED_HPP
+#define GNC_COGNITIVE_EVENT_FEED_HPP
+
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cognitive_engine.hpp"
+#include "../cogutil/concurrent_queue.hpp"
+#include "../cogutil/logger.hpp"
+#include "../tensor-logic/tensor_logic_engine.hpp"
+
+namespace gnc {
+namespace opencog {
+
+/**
+ * An account as captured from the book.
+ */
+struct AccountRecord
+{
+    std::string guid;
+    std::string name;
+    std::string account_type;
+    std::string parent_guid;
+};
+
+/**
+ * A transaction as captured from the book, reduced to one flow.
+ */
+struct TransactionRecord
+{
+    /** Period of a date outside the TensorLogicEngine's periods. */
+    static constexpr size_t NO_PERIOD = std::numeric_limits<size_t>::max();
+
+    std::string guid;
+    std::string description;
+    std::string date;           // YYYY-MM-DD
+    double amount = 0.0;
+    std::string debit_account;
+    std::string credit_account;
+    size_t period = NO_PERIOD;  // TensorLogicEngine period of the date
+};
+
+/**
+ * A change to apply to the engines.
+ */
+struct FeedEvent
+{
+    enum class Kind
+    {
+        ACCOUNT_CHANGED,
+        TRANSACTION_CHANGED,
+        TRANSACTION_DESTROYED
+    };
+
+    Kind kind;
+    AccountRecord account;          // ACCOUNT_CHANGED
+    TransactionRecord transaction;  // TRANSACTION_*; only guid when destroyed
+};
+
+/**
+ * EventFeed - applies queued changes to the engines on a worker thread.
+ *
+ * The engines are not thread-safe. While the feed runs, the worker is
+ * their only writer, and other threads read them inside with_engines(),
+ * which holds the lock the worker takes for each batch.
+ *
+ * A transaction whose period is outside the TensorLogicEngine's periods
+ * only reaches the CognitiveEngine.
+ */
+class EventFeed
+{
+public:
+    /** Largest number of queued events applied under one lock. */
+    static constexpr size_t MAX_BATCH = 256;
+
+    explicit EventFeed(CognitiveEngine& engine,
+                       tensor_logic::TensorLogicEngine* tensor_logic = nullptr)
+        : m_engine(engine)
+        , m_tensor_logic(tensor_logic)
+    {}
+
+    ~EventFeed() { stop(); }
+
+    EventFeed(const EventFeed&) = delete;
+    EventFeed& operator=(const EventFeed&) = delete;
+
+    /**
+     * Start the worker thread.
+     */
+    void start()
+    {
+        if (m_worker.joinable())
+            throw std::logic_error("EventFeed already started");
+        m_worker = std::thread([this] { run(); });
+    }
+
+    /**
+     * Apply everything still queued, then stop the worker. A stopped
+     * feed cannot be restarted.
+     */
+    void stop()
+    {
+        if (!m_worker.joinable()) return;
+        m_queue.cancel();
+        m_worker.join();
+    }
+
+    void account_changed(AccountRecord account)
+    {
+        FeedEvent event{FeedEvent::Kind::ACCOUNT_CHANGED, std::move(account), {}};
+        push(std::move(event));
+    }
+
+    void transaction_changed(TransactionRecord transaction)
+    {
+        FeedEvent event{FeedEvent::Kind::TRANSACTION_CHANGED, {}, std::move(transaction)};
+        push(std::move(event));
+    }
+
+    void transaction_destroyed(const std::string& guid)
+    {
+        FeedEvent event{FeedEvent::Kind::TRANSACTION_DESTROYED, {}, {}};
+        event.transaction.guid = guid;
+        push(std::move(event));
+    }
+
+    /**
+     * Wait until every event queued before the call has been applied.
+     * Without a running worker, apply them on the calling thread.
+     */
+    void flush()
+    {
+        if (!m_worker.joinable()) {
+            std::vector<FeedEvent> batch;
+            FeedEvent event;
+            while (m_queue.try_pop(event)) {
+                batch.push_back(std::move(event));
+                if (batch.size() == MAX_BATCH)
+                    apply_batch(batch);
+            }
+            if (!batch.empty())
+                apply_batch(batch);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_progress_mutex);
+        size_t target = m_queued;
+        m_progress.wait(lock, [&] { return m_done >= target; });
+    }
+
+    /**
+     * Call fn(CognitiveEngine&, TensorLogicEngine*) while no batch is
+     * being applied.
+     */
+    template<typename Fn>
+    auto with_engines(Fn&& fn)
+    {
+        std::lock_guard<std::mutex> lock(m_engine_mutex);
+        return fn(m_engine, m_tensor_logic);
+    }
+
+    /**
+     * Number of batches applied so far.
+     */
+    size_t batches() const
+    {
+        std::lock_guard<std::mutex> lock(m_progress_mutex);
+        return m_batches;
+    }
+
+private:
+    CognitiveEngine& m_engine;
+    tensor_logic::TensorLogicEngine* m_tensor_logic;
+
+    ConcurrentQueue<FeedEvent> m_queue;
+    std::thread m_worker;
+    std::mutex m_engine_mutex;
+
+    mutable std::mutex m_progress_mutex;
+    std::condition_variable m_progress;
+    size_t m_queued = 0;
+    size_t m_done = 0;
+    size_t m_batches = 0;
+
+    // The flow each transaction last added to the tensor network, so a
+    // change or deletion can take it out again.
+    std::unordered_map<std::string, TransactionRecord> m_flows;
+
+    void push(FeedEvent&& event)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_progress_mutex);
+            ++m_queued;
+        }
+        m_queue.push(std::move(event));
+    }
+
+    void run()
+    {
+        std::vector<FeedEvent> batch;
+        FeedEvent event;
+        for (;;) {
+            if (!m_queue.pop(event))
+                return;     // cancelled and drained
+            batch.push_back(std::move(event));
+            while (batch.size() < MAX_BATCH && m_queue.try_pop(event))
+                batch.push_back(std::move(event));
+            apply_batch(batch);
+        }
+    }
+
+    /**
+     * Apply a batch, record the progress and empty the batch.
+     */
+    void apply_batch(std::vector<FeedEvent>& batch)
+    {
+        apply(batch);
+        GNC_COG_DEBUG("event-feed", "applied a batch of ", batch.size(), " events");
+
+        std::lock_guard<std::mutex> lock(m_progress_mutex);
+        m_done += batch.size();
+        ++m_batches;
+        m_progress.notify_all();
+        batch.clear();
+    }
+
+    /**
+     * Apply a batch. A transaction edited several times in one batch is
+     * only updated for its last event.
+     */
+    void apply(const std::vector<FeedEvent>& batch)
+    {
+        std::unordered_map<std::string, size_t> last;
+        for (size_t i = 0; i < batch.size(); ++i)
+            if (batch[i].kind != FeedEvent::Kind::ACCOUNT_CHANGED)
+                last[batch[i].transaction.guid] = i;
+
+        std::lock_guard<std::mutex> lock(m_engine_mutex);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const auto& event = batch[i];
+            switch (event.kind) {
+                case FeedEvent::Kind::ACCOUNT_CHANGED:
+                    apply_account(event.account);
+                    break;
+                case FeedEvent::Kind::TRANSACTION_CHANGED:
+                    if (last[event.transaction.guid] == i)
+                        apply_transaction(event.transaction);
+                    break;
+                case FeedEvent::Kind::TRANSACTION_DESTROYED:
+                    if (last[event.transaction.guid] == i)
+                        remove_transaction(event.transaction.guid);
+                    break;
+            }
+        }
+    }
+
+    void apply_account(const AccountRecord& account)
+    {
+        m_engine.import_account(account.guid, account.name, account.account_type,
+                                account.parent_guid);
+        if (m_tensor_logic && !m_tensor_logic->get_account(account.guid))
+            m_tensor_logic->create_account(account.guid, account.name);
+    }
+
+    void apply_transaction(const TransactionRecord& txn)
+    {
+        remove_transaction(txn.guid);
+        m_engine.import_transaction(txn.guid, txn.description, txn.date, txn.amount,
+                                    txn.debit_account, txn.credit_account);
+        if (m_tensor_logic && !txn.debit_account.empty() && !txn.credit_account.empty() &&
+            txn.period < m_tensor_logic->network().num_periods()) {
+            m_tensor_logic->record_transaction(txn.credit_account, txn.debit_account,
+                                               txn.amount, txn.period);
+            m_flows[txn.guid] = txn;
+        }
+    }
+
+    void remove_transaction(const std::string& guid)
+    {
+        m_engine.remove_transaction(guid);
+        auto it = m_flows.find(guid);
+        if (it == m_flows.end()) return;
+        const auto& txn = it->second;
+        m_tensor_logic->remove_transaction(txn.credit_account, txn.debit_account,
+                                           txn.amount, txn.period);
+        m_flows.erase(it);
+    }
+};
+
+} // namespace opencog
+} // namespace gnc
+
+#endif // GNC_COGNITIVE_EVENT_FEED_HPP
@@ -0,0 +1,275 @@
+/*
+ * opencog/gnc-cognitive/transaction_columns.hpp
+ *
+ * TransactionColumns - numeric transaction values stored column-wise
+ *
+ * The AtomSpace keeps a transaction's structure: its accounts, date and
+ * description as linked atoms. Analytics want the numbers, so
+ * import_transaction also writes them here as packed columns. Scanning
+ * every amount is then a walk over one vector of doubles, with no incoming
+ * sets to search and no node names to parse.
+ *
+ * Atoms here carry only a truth value, with no slots for other values, so
+ * the numbers live beside the atoms rather than on them. The columns are a
+ * cache derived from the atoms: import_transaction writes a row, and the
+ * engine's KnowledgeSpace drops it when the TransactionNode is removed or
+ * the space is cleared. Like the engine itself, they are not meant for
+ * concurrent writers.
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_COGNITIVE_TRANSACTION_COLUMNS_HPP
+#define GNC_COGNITIVE_TRANSACTION_COLUMNS_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../atomspace/atom.hpp"
+#include "../cogutil/running_stats.hpp"
+
+namespace gnc {
+namespace opencog {
+
+/**
+ * TransactionColumns - one row per transaction, keyed by its atom.
+ *
+ * Amounts are doubles and dates are day numbers counted from 1970-01-01.
+ * Descriptions and categories are interned, so grouping by either
+ * compares integers. A category is the account debited, which for
+ * spending is its expense account. Importing a transaction again
+ * overwrites its row.
+ *
+ * Running mean and variance of the amounts, overall, per description and
+ * per category, are kept up to date as rows change, so scoring a new
+ * amount against them costs O(1).
+ */
+class TransactionColumns
+{
+public:
+    using DescriptionId = uint32_t;
+    using CategoryId = uint32_t;
+
+    /** Day number of a transaction without a readable date. */
+    static constexpr int64_t NO_DAY = std::numeric_limits<int64_t>::min();
+
+    /**
+     * Add or update the row of a transaction. Returns its row index.
+     */
+    size_t set(const Handle& txn, double amount, int64_t day,
+               const std::string& description, const std::string& category = "")
+    {
+        DescriptionId id = m_description_groups.intern(description);
+        CategoryId category_id = m_category_groups.intern(category);
+        auto [it, inserted] = m_row_of.emplace(txn->uuid(), m_transactions.size());
+        if (inserted) {
+            m_transactions.push_back(txn);
+            m_amounts.push_back(amount);
+            m_days.push_back(day);
+            m_descriptions.push_back(id);
+            m_categories.push_back(category_id);
+        } else {
+            forget(it->second);
+            m_amounts[it->second] = amount;
+            m_days[it->second] = day;
+            m_descriptions[it->second] = id;
+            m_categories[it->second] = category_id;
+        }
+        m_amount_stats.add(amount);
+        m_description_groups.stats[id].add(amount);
+        m_category_groups.stats[category_id].add(amount);
+        return it->second;
+    }
+
+    /**
+     * Remove the row of a transaction; the last row takes its place.
+     * Returns true if there was one.
+     */
+    bool erase(const Handle& txn)
+    {
+        auto it = txn ? m_row_of.find(txn->uuid()) : m_row_of.end();
+        if (it == m_row_of.end()) return false;
+
+        size_t row = it->second, last = m_transactions.size() - 1;
+        forget(row);
+        m_row_of.erase(it);
+        if (row != last) {
+            m_transactions[row] = std::move(m_transactions[last]);
+            m_amounts[row] = m_amounts[last];
+            m_days[row] = m_days[last];
+            m_descriptions[row] = m_descriptions[last];
+            m_categories[row] = m_categories[last];
+            m_row_of[m_transactions[row]->uuid()] = row;
+        }
+        m_transactions.pop_back();
+        m_amounts.pop_back();
+        m_days.pop_back();
+        m_descriptions.pop_back();
+        m_categories.pop_back();
+        return true;
+    }
+
+    /**
+     * Row of a transaction, if it has one.
+     */
+    std::optional<size_t> row(const Handle& txn) const
+    {
+        if (!txn) return std::nullopt;
+        auto it = m_row_of.find(txn->uuid());
+        if (it == m_row_of.end()) return std::nullopt;
+        return it->second;
+    }
+
+    size_t size() const { return m_transactions.size(); }
+    bool empty() const { return m_transactions.empty(); }
+
+    const HandleSeq& transactions() const { return m_transactions; }
+    const std::vector<double>& amounts() const { return m_amounts; }
+    const std::vector<int64_t>& days() const { return m_days; }
+    const std::vector<DescriptionId>& descriptions() const { return m_descriptions; }
+    const std::vector<CategoryId>& categories() const { return m_categories; }
+
+    /**
+     * Number of distinct descriptions; ids run from 0 to this.
+     */
+    size_t description_count() const { return m_description_groups.names.size(); }
+
+    const std::string& description_name(DescriptionId id) const
+    {
+        return m_description_groups.names.at(id);
+    }
+
+    /**
+     * Running statistics of all amounts.
+     */
+    const RunningStats& amount_stats() const { return m_amount_stats; }
+
+    /**
+     * Running statistics of the amounts with one description.
+     */
+    const RunningStats& description_stats(DescriptionId id) const
+    {
+        return m_description_groups.stats.at(id);
+    }
+
+    /**
+     * Id of a description, if any row has used it.
+     */
+    std::optional<DescriptionId> description_id(const std::string& description) const
+    {
+        return m_description_groups.find(description);
+    }
+
+    /**
+     * Running statistics of the amounts in one category.
+     */
+    const RunningStats& category_stats(CategoryId id) const
+    {
+        return m_category_groups.stats.at(id);
+    }
+
+    /**
+     * Id of a category, if any row has used it.
+     */
+    std::optional<CategoryId> category_id(const std::string& category) const
+    {
+        return m_category_groups.find(category);
+    }
+
+    void clear()
+    {
+        m_transactions.clear();
+        m_amounts.clear();
+        m_days.clear();
+        m_descriptions.clear();
+        m_categories.clear();
+        m_row_of.clear();
+        m_description_groups.clear();
+        m_category_groups.clear();
+        m_amount_stats.clear();
+    }
+
+    /**
+     * Day number of an ISO "YYYY-MM-DD" date, or NO_DAY if it does not
+     * parse.
+     */
+    static int64_t parse_day(const std::string& date)
+    {
+        int year, month, day;
+        char tail;
+        if (std::sscanf(date.c_str(), "%d-%d-%d%c", &year, &month, &day, &tail) != 3 ||
+            month < 1 || month > 12 || day < 1 || day > 31)
+            return NO_DAY;
+
+        // Days from civil, counting years from March so leap days come last.
+        int64_t y = year - (month <= 2);
+        int64_t era = (y >= 0 ? y : y - 399) / 400;
+        int64_t yoe = y - era * 400;
+        int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+private:
+    /** Interned names, with running statistics of the amounts of each. */
+    struct Groups
+    {
+        std::unordered_map<std::string, uint32_t> ids;
+        std::vector<std::string> names;
+        std::vector<RunningStats> stats;
+
+        uint32_t intern(const std::string& name)
+        {
+            auto [it, inserted] = ids.emplace(name, static_cast<uint32_t>(names.size()));
+            if (inserted) {
+                names.push_back(name);
+                stats.emplace_back();
+            }
+            return it->second;
+        }
+
+        std::optional<uint32_t> find(const std::string& name) const
+        {
+            auto it = ids.find(name);
+            if (it == ids.end()) return std::nullopt;
+            return it->second;
+        }
+
+        void clear()
+        {
+            ids.clear();
+            names.clear();
+            stats.clear();
+        }
+    };
+
+    HandleSeq m_transactions;
+    std::vector<double> m_amounts;
+    std::vector<int64_t> m_days;
+    std::vector<DescriptionId> m_descriptions;
+    std::vector<CategoryId> m_categories;
+    std::unordered_map<UUID, size_t> m_row_of;
+
+    Groups m_description_groups;
+    Groups m_category_groups;
+    RunningStats m_amount_stats;
+
+    /** Take a row's amount out of the running statistics. */
+    void forget(size_t row)
+    {
+        m_amount_stats.remove(m_amounts[row]);
+        m_description_groups.stats[m_descriptions[row]].remove(m_amounts[row]);
+        m_category_groups.stats[m_categories[row]].remove(m_amounts[row]);
+    }
+};
+
+} // namespace opencog
+} // namespace gnc
+
+#endif // GNC_COGNITIVE_TRANSACTION_COLUMNS_HPP
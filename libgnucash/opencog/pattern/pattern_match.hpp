@@ -14,8 +14,12 @@
 #include <unordered_map>
 #include <functional>
 #include <optional>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #include "../atomspace/atomspace.hpp"
+#include "../cogutil/thread_pool.hpp"
 
 namespace gnc {
 namespace opencog {
@@ -102,11 +106,28 @@ private:
     HandleSeq m_clauses;
 };
 
+/**
+ * MatchOptions - how PatternMatcher::match_parallel runs a query.
+ */
+struct MatchOptions
+{
+    size_t threads = 0;     // threads at most, caller included; 0 for the whole pool
+    size_t limit = 0;       // stop after this many matches; 0 for all
+    bool ordered = false;   // with a limit, keep the first matches match() finds
+};
+
 /**
  * PatternMatcher - executes pattern matching queries against AtomSpace.
  *
  * The pattern matcher implements graph unification to find subgraphs
- * in the AtomSpace that match a given pattern.
+ * in the AtomSpace that match a given pattern. The body and every
+ * clause must all match, with shared variables bound to the same atom.
+ *
+ * Variables are compiled to integer slots. Clauses are joined one at a
+ * time, always taking next the clause with the fewest candidates given
+ * the atoms bound so far, and candidates for a link come from the
+ * incoming set of an atom it must contain rather than from a scan of its
+ * type wherever possible.
  */
 class PatternMatcher
 {
@@ -134,10 +155,98 @@ public:
      */
     void match(const Pattern& pattern, const MatchCallback& callback)
     {
-        if (!pattern.body()) return;
+        if (!pattern.body() && pattern.clauses().empty()) return;
 
-        Bindings bindings;
-        match_recursive(pattern, pattern.body(), bindings, callback);
+        Query query = compile(pattern);
+        if (!query.satisfiable) return;
+
+        Search search = start_search(query, callback);
+        join(search);
+    }
+
+    /**
+     * Execute a pattern match on several threads.
+     *
+     * The candidates for the first clause joined are cut into chunks
+     * which the calling thread and default_thread_pool() workers claim
+     * in turn, so one expensive chunk does not hold up the rest. Each
+     * chunk collects its own bindings and the chunks are merged in
+     * order: without a limit the result is the same as match(). With a
+     * limit the search stops once enough matches are found; those are
+     * the first ones match() would find if options.ordered is set, and
+     * any of them otherwise.
+     *
+     * The AtomSpace must not be modified while the match runs.
+     */
+    std::vector<Bindings> match_parallel(const Pattern& pattern,
+                                         const MatchOptions& options = MatchOptions())
+    {
+        std::vector<Bindings> results;
+        if (!pattern.body() && pattern.clauses().empty()) return results;
+
+        Query query = compile(pattern);
+        if (!query.satisfiable) return results;
+
+        MatchCallback unused;
+        Search probe = start_search(query, unused);
+        size_t root = static_cast<size_t>(next_clause(probe));
+        HandleSeq roots = candidates(probe, query.clauses[root]);
+        if (roots.empty()) return results;
+
+        auto& pool = default_thread_pool();
+        size_t nthreads = options.threads ? options.threads : pool.size() + 1;
+        size_t chunk = std::max<size_t>(1, roots.size() / (nthreads * CHUNKS_PER_THREAD));
+        size_t nchunks = (roots.size() + chunk - 1) / chunk;
+
+        std::vector<std::vector<Bindings>> found(nchunks);
+        std::atomic<size_t> total{0};
+        std::atomic<size_t> cutoff{nchunks};    // chunks from here on are not needed
+
+        // For ordered limits: chunks finished, and how far from the start
+        // every chunk has finished.
+        std::mutex mutex;
+        std::vector<bool> finished(nchunks);
+        size_t prefix = 0, prefix_count = 0;
+
+        auto enough = [&]() {
+            return options.limit && !options.ordered && total.load() >= options.limit;
+        };
+
+        auto run_chunks = [&](size_t first, size_t last) {
+            for (size_t c = first; c < last && c < cutoff.load() && !enough(); ++c) {
+                auto& out = found[c];
+                MatchCallback collect = [&](const Bindings& bindings) {
+                    out.push_back(bindings);
+                    if (!options.limit) return true;
+                    if (options.ordered) return out.size() < options.limit;
+                    return ++total < options.limit;
+                };
+                Search search = start_search(query, collect);
+                size_t end = std::min(roots.size(), (c + 1) * chunk);
+                for (size_t i = c * chunk; i < end && !enough(); ++i)
+                    if (!join_candidate(search, root, roots[i]))
+                        break;
+
+                if (options.limit && options.ordered) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished[c] = true;
+                    while (prefix < nchunks && finished[prefix] &&
+                           prefix_count < options.limit)
+                        prefix_count += found[prefix++].size();
+                    if (prefix_count >= options.limit)
+                        cutoff = std::min(cutoff.load(), prefix);
+                }
+            }
+        };
+
+        pool.parallel_for(0, nchunks, 1, run_chunks, nthreads);
+
+        for (auto& chunk_results : found)
+            for (auto& bindings : chunk_results)
+                results.push_back(std::move(bindings));
+        if (options.limit && results.size() > options.limit)
+            results.resize(options.limit);
+        return results;
     }
 
     /**
@@ -193,100 +302,306 @@ public:
 
 private:
     /**
-     * Recursive pattern matching implementation.
+     * Term - a pattern atom compiled for matching.
      */
-    bool match_recursive(const Pattern& pattern, const Handle& pat,
-                        Bindings& bindings, const MatchCallback& callback)
+    struct Term
     {
-        if (!pat) return false;
+        enum class Kind { CONSTANT, VARIABLE, LINK };
 
-        // Check if this is a variable node
-        if (pat->is_node() && pat->type() == AtomTypes::VARIABLE_NODE) {
-            const std::string& var_name = pat->name();
+        Kind kind = Kind::CONSTANT;
+        Handle atom;                // CONSTANT: the atom in the AtomSpace
+        size_t slot = 0;            // VARIABLE: index into Search::slots
+        AtomType type = AtomTypes::ATOM;    // VARIABLE or LINK type
+        std::vector<Term> outgoing; // LINK
+    };
 
-            // Check if variable is already bound
-            auto it = bindings.find(var_name);
-            if (it != bindings.end()) {
-                // Variable already bound - this is a constraint
-                return true;
-            }
+    struct Query
+    {
+        std::vector<std::string> names;     // variable name of each slot
+        std::vector<AtomType> types;        // declared type of each slot
+        std::vector<Term> clauses;
+        bool satisfiable = true;            // false if a constant is missing
+    };
+
+    struct Search
+    {
+        const Query& query;
+        const MatchCallback& callback;
+        std::vector<Handle> slots{};        // bound atom of each variable
+        std::vector<size_t> trail{};        // slots bound, in order
+        std::vector<bool> done{};           // clauses already joined
+        std::unordered_map<AtomType, size_t> type_counts{};
+    };
 
-            // Find candidates for this variable
-            AtomType var_type = AtomTypes::ATOM;
-            auto type_it = pattern.variables().find(var_name);
-            if (type_it != pattern.variables().end())
-                var_type = type_it->second;
-
-            HandleSeq candidates;
-            if (var_type == AtomTypes::ATOM) {
-                m_atomspace.for_each([&candidates](const Handle& h) {
-                    candidates.push_back(h);
-                });
-            } else {
-                candidates = m_atomspace.get_atoms_by_type(var_type);
+    /**
+     * Candidate count for a term and, for links, the outgoing position
+     * whose incoming set yields them (-1 to scan the link type).
+     */
+    struct Plan
+    {
+        size_t cost;
+        int anchor;
+    };
+
+    Query compile(const Pattern& pattern)
+    {
+        Query query;
+        std::unordered_map<std::string, size_t> slots;
+        if (pattern.body())
+            query.clauses.push_back(compile_term(pattern, pattern.body(), query, slots));
+        for (const auto& clause : pattern.clauses())
+            query.clauses.push_back(compile_term(pattern, clause, query, slots));
+        return query;
+    }
+
+    Term compile_term(const Pattern& pattern, const Handle& pat, Query& query,
+                      std::unordered_map<std::string, size_t>& slots)
+    {
+        Term term;
+        if (!pat) return term;
+
+        if (pat->is_node() && pat->type() == AtomTypes::VARIABLE_NODE) {
+            auto [it, inserted] = slots.emplace(pat->name(), query.names.size());
+            if (inserted) {
+                auto type_it = pattern.variables().find(pat->name());
+                query.names.push_back(pat->name());
+                query.types.push_back(type_it != pattern.variables().end() ?
+                                      type_it->second : AtomTypes::ATOM);
             }
+            term.kind = Term::Kind::VARIABLE;
+            term.slot = it->second;
+            term.type = query.types[term.slot];
+            return term;
+        }
 
-            // Try each candidate
-            for (const auto& candidate : candidates) {
-                bindings[var_name] = candidate;
-                if (!callback(bindings))
-                    return false;
+        if (pat->is_node()) {
+            term.atom = m_atomspace.get_node(pat->type(), pat->name());
+            query.satisfiable &= term.atom != nullptr;
+            return term;
+        }
+
+        bool constant = true;
+        HandleSeq outgoing;
+        for (const auto& out : pat->outgoing()) {
+            term.outgoing.push_back(compile_term(pattern, out, query, slots));
+            constant &= term.outgoing.back().kind == Term::Kind::CONSTANT;
+            outgoing.push_back(term.outgoing.back().atom);
+        }
+        if (constant) {
+            term.outgoing.clear();
+            term.atom = m_atomspace.get_link(pat->type(), outgoing);
+            query.satisfiable &= term.atom != nullptr;
+            return term;
+        }
+        term.kind = Term::Kind::LINK;
+        term.type = pat->type();
+        return term;
+    }
+
+    /** Chunks of root candidates per worker in match_parallel(). */
+    static constexpr size_t CHUNKS_PER_THREAD = 8;
+
+    static Search start_search(const Query& query, const MatchCallback& callback)
+    {
+        Search search{query, callback};
+        search.slots.resize(query.names.size());
+        search.done.resize(query.clauses.size());
+        return search;
+    }
+
+    /**
+     * The remaining clause with the fewest candidates, or -1 if every
+     * clause is joined.
+     */
+    int next_clause(Search& search)
+    {
+        const auto& clauses = search.query.clauses;
+        int next = -1;
+        size_t best = 0;
+        for (size_t i = 0; i < clauses.size(); ++i) {
+            if (search.done[i]) continue;
+            size_t cost = plan(search, clauses[i]).cost;
+            if (next < 0 || cost < best) {
+                next = static_cast<int>(i);
+                best = cost;
             }
+        }
+        return next;
+    }
 
-            bindings.erase(var_name);
-            return true;
+    /**
+     * Join the remaining clauses, most selective first.
+     */
+    bool join(Search& search)
+    {
+        int next = next_clause(search);
+        if (next < 0)
+            return search.callback(bindings_of(search));
+
+        const Term& clause = search.query.clauses[next];
+        bool more = true;
+        for (const auto& candidate : candidates(search, clause)) {
+            more = join_candidate(search, static_cast<size_t>(next), candidate);
+            if (!more) break;
         }
+        return more;
+    }
 
-        // For non-variable nodes, find exact matches
-        if (pat->is_node()) {
-            Handle match = m_atomspace.get_node(pat->type(), pat->name());
-            if (match)
-                return callback(bindings);
-            return true;
+    /**
+     * Join one candidate for a clause and then the clauses after it.
+     * Returns false if the callback asked to stop.
+     */
+    bool join_candidate(Search& search, size_t clause, const Handle& candidate)
+    {
+        search.done[clause] = true;
+        size_t mark = search.trail.size();
+        bool more = true;
+        if (unify(search, search.query.clauses[clause], candidate))
+            more = join(search);
+        unbind(search, mark);
+        search.done[clause] = false;
+        return more;
+    }
+
+    Bindings bindings_of(const Search& search) const
+    {
+        Bindings bindings;
+        for (size_t slot = 0; slot < search.slots.size(); ++slot)
+            if (search.slots[slot])
+                bindings[search.query.names[slot]] = search.slots[slot];
+        return bindings;
+    }
+
+    size_t type_count(Search& search, AtomType type)
+    {
+        auto [it, inserted] = search.type_counts.emplace(type, 0);
+        if (inserted)
+            it->second = is_base_type(type) ? m_atomspace.size() : m_atomspace.size(type);
+        return it->second;
+    }
+
+    static bool is_base_type(AtomType type)
+    {
+        return type == AtomTypes::ATOM || type == AtomTypes::NODE || type == AtomTypes::LINK;
+    }
+
+    /** The atom a term stands for, if it is already fixed. */
+    static const Handle* fixed_atom(const Search& search, const Term& term)
+    {
+        if (term.kind == Term::Kind::CONSTANT)
+            return &term.atom;
+        if (term.kind == Term::Kind::VARIABLE && search.slots[term.slot])
+            return &search.slots[term.slot];
+        return nullptr;
+    }
+
+    Plan plan(Search& search, const Term& term)
+    {
+        if (fixed_atom(search, term))
+            return {1, -1};
+        if (term.kind == Term::Kind::VARIABLE)
+            return {type_count(search, term.type), -1};
+
+        Plan best{type_count(search, term.type), -1};
+        for (size_t i = 0; i < term.outgoing.size(); ++i) {
+            const Term& child = term.outgoing[i];
+            size_t cost;
+            if (auto* atom = fixed_atom(search, child))
+                cost = m_atomspace.get_incoming_size(*atom);
+            else if (child.kind == Term::Kind::LINK && plan(search, child).anchor >= 0)
+                cost = plan(search, child).cost;
+            else
+                continue;
+            if (cost < best.cost)
+                best = {cost, static_cast<int>(i)};
         }
+        return best;
+    }
 
-        // For links, match the structure
-        if (pat->is_link()) {
-            auto candidates = m_atomspace.get_atoms_by_type(pat->type());
-            for (const auto& candidate : candidates) {
-                if (candidate->arity() != pat->arity())
-                    continue;
-
-                bool matches = true;
-                Bindings local_bindings = bindings;
-
-                for (size_t i = 0; i < pat->arity() && matches; ++i) {
-                    Handle pat_out = pat->outgoing_atom(i);
-                    Handle cand_out = candidate->outgoing_atom(i);
-
-                    if (pat_out && pat_out->is_node() &&
-                        pat_out->type() == AtomTypes::VARIABLE_NODE) {
-                        // Variable - bind or check
-                        const std::string& var_name = pat_out->name();
-                        auto it = local_bindings.find(var_name);
-                        if (it != local_bindings.end()) {
-                            if (!cand_out || *it->second != *cand_out)
-                                matches = false;
-                        } else {
-                            local_bindings[var_name] = cand_out;
-                        }
-                    } else if (pat_out && cand_out) {
-                        // Non-variable - must match exactly
-                        if (*pat_out != *cand_out)
-                            matches = false;
-                    } else if (pat_out || cand_out) {
-                        matches = false;
-                    }
-                }
+    HandleSeq candidates(Search& search, const Term& term)
+    {
+        if (auto* atom = fixed_atom(search, term))
+            return {*atom};
+
+        if (term.kind == Term::Kind::VARIABLE) {
+            if (!is_base_type(term.type))
+                return m_atomspace.get_atoms_by_type(term.type);
+            AtomType type = term.type;
+            return m_atomspace.find_atoms([type](const Handle& h) {
+                return type_matches(type, h);
+            });
+        }
 
-                if (matches) {
-                    if (!callback(local_bindings))
-                        return false;
-                }
+        Plan p = plan(search, term);
+        if (p.anchor < 0)
+            return m_atomspace.get_atoms_by_type(term.type);
+
+        // Links of the right shape holding one of the anchor's candidates
+        // at the anchor's position.
+        size_t pos = static_cast<size_t>(p.anchor);
+        HandleSeq result;
+        for (const auto& source : candidates(search, term.outgoing[pos])) {
+            for (const auto& link : m_atomspace.get_incoming(source)) {
+                if (link->type() == term.type && link->arity() == term.outgoing.size() &&
+                    same_atom(link->outgoing_atom(pos), source))
+                    result.push_back(link);
             }
         }
+        return result;
+    }
+
+    static bool type_matches(AtomType type, const Handle& atom)
+    {
+        if (type == AtomTypes::ATOM) return true;
+        if (type == AtomTypes::NODE) return atom->is_node();
+        if (type == AtomTypes::LINK) return atom->is_link();
+        return atom->type() == type;
+    }
 
-        return true;
+    static bool same_atom(const Handle& a, const Handle& b)
+    {
+        return a == b || (a && b && *a == *b);
+    }
+
+    /**
+     * Match a term against an atom, binding free variables. Bindings
+     * made are left on the trail, also on failure, for unbind().
+     */
+    bool unify(Search& search, const Term& term, const Handle& atom)
+    {
+        switch (term.kind) {
+            case Term::Kind::CONSTANT:
+                return same_atom(term.atom, atom);
+
+            case Term::Kind::VARIABLE: {
+                Handle& bound = search.slots[term.slot];
+                if (bound)
+                    return same_atom(bound, atom);
+                if (!atom || !type_matches(term.type, atom))
+                    return false;
+                bound = atom;
+                search.trail.push_back(term.slot);
+                return true;
+            }
+
+            case Term::Kind::LINK:
+                if (!atom || !atom->is_link() || atom->type() != term.type ||
+                    atom->arity() != term.outgoing.size())
+                    return false;
+                for (size_t i = 0; i < term.outgoing.size(); ++i)
+                    if (!unify(search, term.outgoing[i], atom->outgoing_atom(i)))
+                        return false;
+                return true;
+        }
+        return false;
+    }
+
+    static void unbind(Search& search, size_t mark)
+    {
+        while (search.trail.size() > mark) {
+            search.slots[search.trail.back()] = nullptr;
+            search.trail.pop_back();
+        }
     }
 
     /**
@@ -13,8 +13,12 @@
 
 #include "../aten/tensor.hpp"
 #include "../aten/tensor_ops.hpp"
+#include "../aten/tensor_kernels.hpp"
 #include "../atenspace/atenspace.hpp"
+#include "../cogutil/running_stats.hpp"
 
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -25,6 +29,8 @@ namespace tensor_logic {
 
 using namespace gnc::aten;
 using namespace gnc::atenspace;
+using gnc::opencog::RunningStats;
+using gnc::opencog::HoltWinters;
 
 /**
  * Time scale for multi-scale analysis.
@@ -127,7 +133,7 @@ public:
      */
     DoubleTensor get_balances() const
     {
-        DoubleTensor result({m_num_entities, m_num_periods, m_num_currencies});
+        DoubleTensor result(Shape{m_num_entities, m_num_periods, m_num_currencies});
         for (size_t e = 0; e < m_num_entities; ++e) {
             for (size_t p = 0; p < m_num_periods; ++p) {
                 for (size_t c = 0; c < m_num_currencies; ++c) {
@@ -299,18 +305,15 @@ public:
         auto series = get_time_series(entity, currency, Metrics::BALANCE);
         if (series.size() < 2) return;
 
-        // Compute returns
-        std::vector<double> returns;
+        // Standard deviation of returns
+        RunningStats returns;
         for (size_t i = 1; i < series.size(); ++i) {
             if (series[i-1] != 0)
-                returns.push_back((series[i] - series[i-1]) / std::abs(series[i-1]));
+                returns.add((series[i] - series[i-1]) / std::abs(series[i-1]));
         }
 
-        if (returns.empty()) return;
-
-        // Standard deviation
-        DoubleTensor ret_tensor({returns.size()}, std::move(returns));
-        double vol = ret_tensor.std();
+        if (returns.count() == 0) return;
+        double vol = returns.stddev();
 
         // Set for all periods (rolling window could be used)
         for (size_t p = 0; p < m_num_periods; ++p) {
@@ -423,13 +426,13 @@ public:
     DoubleTensor as_tensor(size_t entity = 0, size_t currency = 0) const
     {
         if (m_accounts.empty())
-            return DoubleTensor({0});
+            return DoubleTensor(Shape{0});
 
         size_t num_accounts = m_accounts.size();
         size_t num_periods = m_accounts.begin()->second->num_periods();
         size_t num_metrics = TensorAccount::Metrics::NUM_METRICS;
 
-        DoubleTensor result({num_accounts, num_periods, num_metrics});
+        DoubleTensor result(Shape{num_accounts, num_periods, num_metrics});
 
         size_t acc_idx = 0;
         for (const auto& [guid, account] : m_accounts) {
@@ -451,61 +454,131 @@ public:
         const TensorAccount& query, size_t top_k = 5) const
     {
         auto query_emb = query.get_embedding();
-        std::vector<std::pair<std::string, double>> results;
+        size_t dim = query_emb.size();
+        if (kernels::normalize(query_emb.data(), dim) == 0.0)
+            dim = 0;    // a zero query is similar to nothing
 
-        for (const auto& [guid, account] : m_accounts) {
-            if (guid == query.guid()) continue;
-
-            auto acc_emb = account->get_embedding();
-            double sim = cosine_similarity(query_emb, acc_emb);
-            results.emplace_back(guid, sim);
-        }
-
-        std::sort(results.begin(), results.end(),
-                  [](const auto& a, const auto& b) { return a.second > b.second; });
+        auto packed = pack_embeddings(dim, query.guid());
+        size_t rows = packed.guids.size();
+        std::vector<double> scores(rows);
+        kernels::dot_rows(packed.rows.data(), rows, dim, query_emb.data(), 1,
+                          scores.data());
 
+        std::vector<std::pair<std::string, double>> results;
+        for (size_t r : kernels::top_k(scores.data(), rows, top_k,
+                                       -std::numeric_limits<double>::infinity()))
+            results.emplace_back(packed.guids[r], scores[r]);
+
+        // Accounts that cannot be compared with the query score 0
+        for (size_t i = 0; i < packed.others.size() && i < top_k; ++i)
+            results.emplace_back(packed.others[i], 0.0);
+        std::stable_sort(results.begin(), results.end(),
+                         [](const auto& a, const auto& b) { return a.second > b.second; });
         if (results.size() > top_k)
             results.resize(top_k);
-
         return results;
     }
 
     /**
      * Cluster accounts by embedding similarity.
+     *
+     * Spherical k-means: every pass scores all accounts against all
+     * centroids as one block. Accounts whose embedding shape differs from
+     * the first account's are dealt round-robin.
      */
     std::vector<std::vector<std::string>> cluster_accounts(size_t num_clusters) const
     {
-        // Simple k-means style clustering
         std::vector<std::vector<std::string>> clusters(num_clusters);
+        if (num_clusters == 0 || m_accounts.empty())
+            return clusters;
 
-        // Assign randomly initially
-        size_t idx = 0;
+        size_t dim = 0;
         for (const auto& [guid, account] : m_accounts) {
-            clusters[idx % num_clusters].push_back(guid);
-            ++idx;
+            dim = account->get_embedding().size();
+            break;
+        }
+        auto packed = pack_embeddings(dim, {});
+        size_t rows = packed.guids.size();
+        size_t k = std::min(num_clusters, rows);
+
+        // Seed with evenly spaced accounts
+        std::vector<double> centroids(k * dim);
+        for (size_t c = 0; c < k; ++c)
+            std::copy_n(&packed.rows[c * rows / k * dim], dim, &centroids[c * dim]);
+
+        std::vector<size_t> assignment(rows, k);
+        std::vector<double> scores(k * rows);
+        for (int iter = 0; iter < CLUSTER_ITERATIONS; ++iter) {
+            kernels::dot_rows(packed.rows.data(), rows, dim, centroids.data(), k,
+                              scores.data());
+            bool changed = false;
+            for (size_t r = 0; r < rows; ++r) {
+                size_t best = 0;
+                for (size_t c = 1; c < k; ++c)
+                    if (scores[c * rows + r] > scores[best * rows + r])
+                        best = c;
+                changed |= assignment[r] != best;
+                assignment[r] = best;
+            }
+            if (!changed) break;
+
+            std::vector<double> sums(k * dim, 0.0);
+            for (size_t r = 0; r < rows; ++r)
+                for (size_t i = 0; i < dim; ++i)
+                    sums[assignment[r] * dim + i] += packed.rows[r * dim + i];
+            for (size_t c = 0; c < k; ++c)
+                if (kernels::normalize(&sums[c * dim], dim) > 0)
+                    std::copy_n(&sums[c * dim], dim, &centroids[c * dim]);
         }
 
+        for (size_t r = 0; r < rows; ++r)
+            clusters[assignment[r]].push_back(packed.guids[r]);
+        for (size_t i = 0; i < packed.others.size(); ++i)
+            clusters[i % num_clusters].push_back(packed.others[i]);
         return clusters;
     }
 
     size_t size() const { return m_accounts.size(); }
 
 private:
+    static constexpr int CLUSTER_ITERATIONS = 20;
+
     std::unordered_map<std::string, std::shared_ptr<TensorAccount>> m_accounts;
 
-    double cosine_similarity(const DoubleTensor& a, const DoubleTensor& b) const
+    /**
+     * Account embeddings of one dimension, unit length, packed row-major
+     * in guid order, plus the guids of accounts with other dimensions.
+     */
+    struct PackedEmbeddings
     {
-        if (a.size() != b.size()) return 0.0;
+        std::vector<std::string> guids;
+        std::vector<double> rows;
+        std::vector<std::string> others;
+    };
 
-        double dot = 0.0, norm_a = 0.0, norm_b = 0.0;
-        for (size_t i = 0; i < a.size(); ++i) {
-            dot += a[i] * b[i];
-            norm_a += a[i] * a[i];
-            norm_b += b[i] * b[i];
+    PackedEmbeddings pack_embeddings(size_t dim, const std::string& skip_guid) const
+    {
+        std::vector<std::string> guids;
+        guids.reserve(m_accounts.size());
+        for (const auto& [guid, account] : m_accounts)
+            if (guid != skip_guid)
+                guids.push_back(guid);
+        std::sort(guids.begin(), guids.end());
+
+        PackedEmbeddings packed;
+        packed.rows.reserve(guids.size() * dim);
+        for (auto& guid : guids) {
+            auto emb = m_accounts.at(guid)->get_embedding();
+            if (dim == 0 || emb.size() != dim) {
+                packed.others.push_back(std::move(guid));
+                continue;
+            }
+            size_t offset = packed.rows.size();
+            packed.rows.insert(packed.rows.end(), emb.data(), emb.data() + dim);
+            kernels::normalize(&packed.rows[offset], dim);
+            packed.guids.push_back(std::move(guid));
         }
-
-        if (norm_a == 0 || norm_b == 0) return 0.0;
-        return dot / (std::sqrt(norm_a) * std::sqrt(norm_b));
+        return packed;
     }
 };
 
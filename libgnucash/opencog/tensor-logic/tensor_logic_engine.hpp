@@ -85,6 +85,7 @@ public:
     void shutdown()
     {
         m_accounts.clear();
+        m_flow_stats.clear();
         m_initialized = false;
     }
 
@@ -157,6 +158,8 @@ public:
                            double amount, size_t period)
     {
         m_network.record_transaction(from_account, to_account, amount, period);
+        m_flow_stats[from_account].add(amount);
+        m_flow_stats[to_account].add(amount);
 
         // Update account flows
         auto from_acc = get_account(from_account);
@@ -173,6 +176,30 @@ public:
         }
     }
 
+    /**
+     * Take back a transaction recorded earlier.
+     */
+    void remove_transaction(const std::string& from_account, const std::string& to_account,
+                            double amount, size_t period)
+    {
+        m_network.remove_transaction(from_account, to_account, amount, period);
+        m_flow_stats[from_account].remove(amount);
+        m_flow_stats[to_account].remove(amount);
+
+        auto from_acc = get_account(from_account);
+        auto to_acc = get_account(to_account);
+
+        if (from_acc) {
+            double current = from_acc->get_metric(0, period, 0, TensorAccount::Metrics::DEBIT_FLOW);
+            from_acc->set_metric(0, period, 0, TensorAccount::Metrics::DEBIT_FLOW, current - amount);
+        }
+
+        if (to_acc) {
+            double current = to_acc->get_metric(0, period, 0, TensorAccount::Metrics::CREDIT_FLOW);
+            to_acc->set_metric(0, period, 0, TensorAccount::Metrics::CREDIT_FLOW, current - amount);
+        }
+    }
+
     // =========================================
     // Multi-Entity Operations
     // =========================================
@@ -216,7 +243,7 @@ public:
         if (!account) return DoubleTensor({1}, 0.0);
 
         // Create comparison matrix (entities x periods)
-        DoubleTensor comparison({account->num_entities(), account->num_periods()});
+        DoubleTensor comparison(Shape{account->num_entities(), account->num_periods()});
 
         for (size_t e = 0; e < account->num_entities(); ++e) {
             auto series = account->get_time_series(e, 0, metric);
@@ -337,6 +364,25 @@ public:
         return m_network.detect_circular_flows();
     }
 
+    /**
+     * Running statistics of the transaction amounts recorded to or from
+     * an account, or nullptr if none were.
+     */
+    const RunningStats* flow_stats(const std::string& guid) const
+    {
+        auto it = m_flow_stats.find(guid);
+        return it != m_flow_stats.end() ? &it->second : nullptr;
+    }
+
+    /**
+     * Z-score of a new transaction amount for an account, in constant time.
+     */
+    double flow_anomaly_score(const std::string& guid, double amount) const
+    {
+        auto* stats = flow_stats(guid);
+        return stats ? stats->z_score(amount) : 0.0;
+    }
+
     /**
      * Detect flow anomalies.
      */
@@ -357,7 +403,7 @@ public:
         TensorForecast forecast;
         forecast.account_guid = guid;
         forecast.horizon = horizon;
-        forecast.method = "exponential_smoothing";
+        forecast.method = "holt_linear";
 
         auto account = get_account(guid);
         if (!account) {
@@ -368,22 +414,15 @@ public:
 
         auto history = account->get_time_series(0, 0, TensorAccount::Metrics::BALANCE);
 
-        // Simple exponential smoothing forecast
-        double alpha = 0.3;
-        double last_value = history[history.size() - 1];
-        double smoothed = last_value;
-
-        // Calculate historical smoothed values
-        for (size_t i = 0; i < history.size(); ++i) {
-            smoothed = alpha * history[i] + (1 - alpha) * smoothed;
-        }
-
-        // Forecast
-        std::vector<double> predictions(horizon, smoothed);
+        // Level and trend smoothing in one pass, then O(horizon) forecasts
+        HoltWinters model(0.3, 0.1);
+        for (size_t i = 0; i < history.size(); ++i)
+            model.add(history[i]);
+        std::vector<double> predictions = model.forecast_range(horizon);
 
-        // Calculate confidence intervals based on historical variance
-        double variance = history.var();
-        double std_error = std::sqrt(variance);
+        // Confidence intervals from the one-step forecast errors
+        double std_error = model.errors().count() >= 2 ? model.errors().stddev()
+                                                       : history.std();
 
         std::vector<double> ci(horizon * 2);
         for (size_t i = 0; i < horizon; ++i) {
@@ -515,6 +554,7 @@ private:
     TensorNetwork m_network;
     TensorAccountSet m_account_set;
     std::unordered_map<std::string, std::shared_ptr<TensorAccount>> m_accounts;
+    std::unordered_map<std::string, RunningStats> m_flow_stats;
 };
 
 /**
@@ -4,6 +4,11 @@
  * Network-Aware Tensor Flow System
  * Models money flows as tensor networks between accounts
  *
+ * Accounts are numbered as they are added and edges are rows of flat
+ * columns, one column of flows per period. The graph algorithms run on
+ * compressed sparse row (outgoing) and column (incoming) indexes over
+ * those numbers, built when first needed after the edge set changes.
+ *
  * Copyright (C) 2024 GnuCash Developers
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
@@ -15,8 +20,10 @@
 #include "../aten/tensor_ops.hpp"
 #include "tensor_account.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <optional>
 #include <unordered_map>
-#include <unordered_set>
 #include <queue>
 
 namespace gnc {
@@ -49,12 +56,21 @@ struct NetworkEdge
  * - Network centrality measures
  * - Flow prediction
  * - Anomaly detection in flow patterns
+ *
+ * Nodes are listed in the order they were added. The sparse indexes are
+ * rebuilt lazily from const members, so concurrent readers need the same
+ * lock as writers.
  */
 class TensorNetwork
 {
 public:
+    using NodeId = uint32_t;
+    using EdgeId = uint32_t;
+
     TensorNetwork(size_t num_periods = 12)
         : m_num_periods(num_periods)
+        , m_period_flows(num_periods)
+        , m_period_counts(num_periods)
     {}
 
     // =========================================
@@ -66,11 +82,7 @@ public:
      */
     void add_node(const std::string& guid, const std::string& name = "")
     {
-        if (m_nodes.find(guid) == m_nodes.end()) {
-            m_nodes[guid] = name.empty() ? guid : name;
-            m_adjacency[guid] = {};
-            m_reverse_adjacency[guid] = {};
-        }
+        intern(guid, name);
     }
 
     /**
@@ -79,30 +91,15 @@ public:
     void add_edge(const std::string& source, const std::string& target,
                   double amount, size_t period = 0)
     {
-        add_node(source);
-        add_node(target);
-
-        std::string edge_key = source + "->" + target;
-
-        if (m_edges.find(edge_key) == m_edges.end()) {
-            NetworkEdge edge;
-            edge.source = source;
-            edge.target = target;
-            edge.flow_tensor = DoubleTensor({m_num_periods}, 0.0);
-            edge.weight_tensor = DoubleTensor({m_num_periods}, 0.0);
-            m_edges[edge_key] = edge;
-
-            m_adjacency[source].insert(target);
-            m_reverse_adjacency[target].insert(source);
-        }
-
-        auto& edge = m_edges[edge_key];
+        NodeId from = intern(source);
+        NodeId to = intern(target);
+        EdgeId e = intern_edge(from, to);
         if (period < m_num_periods) {
-            edge.flow_tensor[period] += amount;
-            edge.weight_tensor[period] += 1.0;
+            m_period_flows[period][e] += amount;
+            m_period_counts[period][e]++;
         }
-        edge.total_flow += amount;
-        edge.transaction_count++;
+        m_total_flows[e] += amount;
+        m_transaction_counts[e]++;
     }
 
     /**
@@ -114,22 +111,40 @@ public:
         add_edge(from_account, to_account, amount, period);
     }
 
+    /**
+     * Take back a transaction recorded earlier. The edge stays, with its
+     * flow and count reduced.
+     */
+    void remove_transaction(const std::string& from_account, const std::string& to_account,
+                            double amount, size_t period)
+    {
+        auto e = find_edge(from_account, to_account);
+        if (!e) return;
+
+        if (period < m_num_periods) {
+            m_period_flows[period][*e] -= amount;
+            if (m_period_counts[period][*e] > 0)
+                m_period_counts[period][*e]--;
+        }
+        m_total_flows[*e] -= amount;
+        if (m_transaction_counts[*e] > 0)
+            m_transaction_counts[*e]--;
+    }
+
     // =========================================
     // Network Properties
     // =========================================
 
-    size_t num_nodes() const { return m_nodes.size(); }
-    size_t num_edges() const { return m_edges.size(); }
+    size_t num_nodes() const { return m_guids.size(); }
+    size_t num_edges() const { return m_sources.size(); }
+    size_t num_periods() const { return m_num_periods; }
 
     /**
      * Get all node GUIDs.
      */
     std::vector<std::string> get_nodes() const
     {
-        std::vector<std::string> nodes;
-        for (const auto& [guid, name] : m_nodes)
-            nodes.push_back(guid);
-        return nodes;
+        return m_guids;
     }
 
     /**
@@ -137,9 +152,9 @@ public:
      */
     std::vector<std::string> get_outgoing(const std::string& node) const
     {
-        auto it = m_adjacency.find(node);
-        if (it == m_adjacency.end()) return {};
-        return std::vector<std::string>(it->second.begin(), it->second.end());
+        auto id = find_node(node);
+        if (!id) return {};
+        return guids_of(outgoing(), *id);
     }
 
     /**
@@ -147,9 +162,30 @@ public:
      */
     std::vector<std::string> get_incoming(const std::string& node) const
     {
-        auto it = m_reverse_adjacency.find(node);
-        if (it == m_reverse_adjacency.end()) return {};
-        return std::vector<std::string>(it->second.begin(), it->second.end());
+        auto id = find_node(node);
+        if (!id) return {};
+        return guids_of(incoming(), *id);
+    }
+
+    /**
+     * Get an edge with its flows, if there is one.
+     */
+    std::optional<NetworkEdge> get_edge(const std::string& source,
+                                        const std::string& target) const
+    {
+        auto e = find_edge(source, target);
+        if (!e) return std::nullopt;
+
+        NetworkEdge edge;
+        edge.source = source;
+        edge.target = target;
+        edge.flow_tensor = flow_of(*e);
+        edge.weight_tensor = DoubleTensor({m_num_periods}, 0.0);
+        for (size_t p = 0; p < m_num_periods; ++p)
+            edge.weight_tensor[p] = m_period_counts[p][*e];
+        edge.total_flow = m_total_flows[*e];
+        edge.transaction_count = m_transaction_counts[*e];
+        return edge;
     }
 
     // =========================================
@@ -161,11 +197,10 @@ public:
      */
     DoubleTensor get_flow(const std::string& source, const std::string& target) const
     {
-        std::string edge_key = source + "->" + target;
-        auto it = m_edges.find(edge_key);
-        if (it == m_edges.end())
+        auto e = find_edge(source, target);
+        if (!e)
             return DoubleTensor({m_num_periods}, 0.0);
-        return it->second.flow_tensor;
+        return flow_of(*e);
     }
 
     /**
@@ -173,14 +208,9 @@ public:
      */
     DoubleTensor get_total_outflow(const std::string& node) const
     {
-        DoubleTensor result({m_num_periods}, 0.0);
-        auto it = m_adjacency.find(node);
-        if (it == m_adjacency.end()) return result;
-
-        for (const auto& target : it->second) {
-            result += get_flow(node, target);
-        }
-        return result;
+        auto id = find_node(node);
+        if (!id) return DoubleTensor({m_num_periods}, 0.0);
+        return sum_flows(outgoing(), *id);
     }
 
     /**
@@ -188,14 +218,9 @@ public:
      */
     DoubleTensor get_total_inflow(const std::string& node) const
     {
-        DoubleTensor result({m_num_periods}, 0.0);
-        auto it = m_reverse_adjacency.find(node);
-        if (it == m_reverse_adjacency.end()) return result;
-
-        for (const auto& source : it->second) {
-            result += get_flow(source, node);
-        }
-        return result;
+        auto id = find_node(node);
+        if (!id) return DoubleTensor({m_num_periods}, 0.0);
+        return sum_flows(incoming(), *id);
     }
 
     /**
@@ -211,21 +236,10 @@ public:
      */
     DoubleTensor get_adjacency_matrix() const
     {
-        std::vector<std::string> nodes = get_nodes();
-        size_t n = nodes.size();
-
-        std::unordered_map<std::string, size_t> node_index;
-        for (size_t i = 0; i < n; ++i)
-            node_index[nodes[i]] = i;
-
+        size_t n = num_nodes();
         DoubleTensor adj({n, n}, 0.0);
-
-        for (const auto& [key, edge] : m_edges) {
-            size_t i = node_index[edge.source];
-            size_t j = node_index[edge.target];
-            adj(i, j) = edge.total_flow;
-        }
-
+        for (EdgeId e = 0; e < num_edges(); ++e)
+            adj(m_sources[e], m_targets[e]) = m_total_flows[e];
         return adj;
     }
 
@@ -234,22 +248,13 @@ public:
      */
     DoubleTensor get_flow_matrix(size_t period) const
     {
-        std::vector<std::string> nodes = get_nodes();
-        size_t n = nodes.size();
-
-        std::unordered_map<std::string, size_t> node_index;
-        for (size_t i = 0; i < n; ++i)
-            node_index[nodes[i]] = i;
-
+        size_t n = num_nodes();
         DoubleTensor flow({n, n}, 0.0);
+        if (period >= m_num_periods) return flow;
 
-        for (const auto& [key, edge] : m_edges) {
-            size_t i = node_index[edge.source];
-            size_t j = node_index[edge.target];
-            if (period < m_num_periods)
-                flow(i, j) = edge.flow_tensor[period];
-        }
-
+        const auto& column = m_period_flows[period];
+        for (EdgeId e = 0; e < num_edges(); ++e)
+            flow(m_sources[e], m_targets[e]) = column[e];
         return flow;
     }
 
@@ -262,21 +267,16 @@ public:
      */
     DoubleTensor degree_centrality() const
     {
-        std::vector<std::string> nodes = get_nodes();
-        size_t n = nodes.size();
+        size_t n = num_nodes();
         if (n == 0) return DoubleTensor({1}, 0.0);
 
-        std::vector<double> centrality(n);
-        for (size_t i = 0; i < n; ++i) {
-            const auto& node = nodes[i];
-            size_t degree = 0;
-            auto it_out = m_adjacency.find(node);
-            if (it_out != m_adjacency.end())
-                degree += it_out->second.size();
-            auto it_in = m_reverse_adjacency.find(node);
-            if (it_in != m_reverse_adjacency.end())
-                degree += it_in->second.size();
-            centrality[i] = static_cast<double>(degree) / (2.0 * (n - 1));
+        const auto& out = outgoing();
+        const auto& in = incoming();
+        std::vector<double> centrality(n, 0.0);
+        if (n > 1) {
+            for (NodeId i = 0; i < n; ++i)
+                centrality[i] = static_cast<double>(out.degree(i) + in.degree(i)) /
+                                (2.0 * (n - 1));
         }
 
         return DoubleTensor({n}, std::move(centrality));
@@ -287,84 +287,63 @@ public:
      */
     DoubleTensor flow_centrality() const
     {
-        std::vector<std::string> nodes = get_nodes();
-        size_t n = nodes.size();
+        size_t n = num_nodes();
         if (n == 0) return DoubleTensor({1}, 0.0);
 
+        // One pass over the edge columns credits both ends.
         double total_flow = 0.0;
-        for (const auto& [key, edge] : m_edges)
-            total_flow += edge.total_flow;
-
-        std::vector<double> centrality(n);
-        for (size_t i = 0; i < n; ++i) {
-            const auto& node = nodes[i];
-            double node_flow = 0.0;
-
-            // Outgoing flow
-            auto it_out = m_adjacency.find(node);
-            if (it_out != m_adjacency.end()) {
-                for (const auto& target : it_out->second) {
-                    std::string key = node + "->" + target;
-                    auto edge_it = m_edges.find(key);
-                    if (edge_it != m_edges.end())
-                        node_flow += edge_it->second.total_flow;
-                }
-            }
-
-            // Incoming flow
-            auto it_in = m_reverse_adjacency.find(node);
-            if (it_in != m_reverse_adjacency.end()) {
-                for (const auto& source : it_in->second) {
-                    std::string key = source + "->" + node;
-                    auto edge_it = m_edges.find(key);
-                    if (edge_it != m_edges.end())
-                        node_flow += edge_it->second.total_flow;
-                }
-            }
-
-            centrality[i] = (total_flow > 0) ? node_flow / total_flow : 0.0;
+        std::vector<double> centrality(n, 0.0);
+        for (EdgeId e = 0; e < num_edges(); ++e) {
+            total_flow += m_total_flows[e];
+            centrality[m_sources[e]] += m_total_flows[e];
+            centrality[m_targets[e]] += m_total_flows[e];
         }
 
+        for (auto& c : centrality)
+            c = (total_flow > 0) ? c / total_flow : 0.0;
+
         return DoubleTensor({n}, std::move(centrality));
     }
 
     /**
      * Compute PageRank-style importance.
+     *
+     * Each iteration is one sparse matrix-vector product over the incoming
+     * index: a node's new rank is gathered from its sources' ranks, each
+     * divided by that source's out-degree.
      */
     DoubleTensor pagerank(double damping = 0.85, size_t iterations = 100) const
     {
-        std::vector<std::string> nodes = get_nodes();
-        size_t n = nodes.size();
+        size_t n = num_nodes();
         if (n == 0) return DoubleTensor({1}, 0.0);
 
-        std::unordered_map<std::string, size_t> node_index;
-        for (size_t i = 0; i < n; ++i)
-            node_index[nodes[i]] = i;
+        const auto& out = outgoing();
+        const auto& in = incoming();
+
+        std::vector<double> inverse_degree(n);
+        for (NodeId i = 0; i < n; ++i) {
+            size_t degree = out.degree(i);
+            inverse_degree[i] = degree ? damping / degree : 0.0;
+        }
 
-        DoubleTensor rank({n}, 1.0 / n);
-        DoubleTensor new_rank({n}, 0.0);
+        std::vector<double> rank(n, 1.0 / n), share(n), new_rank(n);
+        double base = (1.0 - damping) / n;
 
         for (size_t iter = 0; iter < iterations; ++iter) {
-            for (size_t i = 0; i < n; ++i)
-                new_rank[i] = (1.0 - damping) / n;
-
-            for (size_t i = 0; i < n; ++i) {
-                const auto& node = nodes[i];
-                auto it = m_adjacency.find(node);
-                if (it == m_adjacency.end() || it->second.empty())
-                    continue;
-
-                double share = damping * rank[i] / it->second.size();
-                for (const auto& target : it->second) {
-                    size_t j = node_index[target];
-                    new_rank[j] += share;
-                }
+            for (NodeId i = 0; i < n; ++i)
+                share[i] = rank[i] * inverse_degree[i];
+
+            for (NodeId j = 0; j < n; ++j) {
+                double sum = base;
+                for (size_t k = in.offsets[j]; k < in.offsets[j + 1]; ++k)
+                    sum += share[in.nodes[k]];
+                new_rank[j] = sum;
             }
 
             std::swap(rank, new_rank);
         }
 
-        return rank;
+        return DoubleTensor({n}, std::move(rank));
     }
 
     // =========================================
@@ -377,42 +356,38 @@ public:
     std::vector<std::string> shortest_path(const std::string& source,
                                            const std::string& target) const
     {
-        if (m_nodes.find(source) == m_nodes.end() ||
-            m_nodes.find(target) == m_nodes.end())
+        auto from = find_node(source);
+        auto to = find_node(target);
+        if (!from || !to)
             return {};
 
-        std::unordered_map<std::string, std::string> parent;
-        std::queue<std::string> queue;
-        std::unordered_set<std::string> visited;
+        const auto& out = outgoing();
+        std::vector<NodeId> parent(num_nodes(), NO_NODE);
+        std::queue<NodeId> queue;
 
-        queue.push(source);
-        visited.insert(source);
-        parent[source] = "";
+        queue.push(*from);
+        parent[*from] = *from;
 
         while (!queue.empty()) {
-            std::string current = queue.front();
+            NodeId current = queue.front();
             queue.pop();
 
-            if (current == target) {
+            if (current == *to) {
                 // Reconstruct path
                 std::vector<std::string> path;
-                std::string node = target;
-                while (!node.empty()) {
-                    path.push_back(node);
-                    node = parent[node];
+                for (NodeId node = *to; ; node = parent[node]) {
+                    path.push_back(m_guids[node]);
+                    if (node == *from) break;
                 }
                 std::reverse(path.begin(), path.end());
                 return path;
             }
 
-            auto it = m_adjacency.find(current);
-            if (it != m_adjacency.end()) {
-                for (const auto& neighbor : it->second) {
-                    if (visited.find(neighbor) == visited.end()) {
-                        visited.insert(neighbor);
-                        parent[neighbor] = current;
-                        queue.push(neighbor);
-                    }
+            for (size_t k = out.offsets[current]; k < out.offsets[current + 1]; ++k) {
+                NodeId neighbor = out.nodes[k];
+                if (parent[neighbor] == NO_NODE) {
+                    parent[neighbor] = current;
+                    queue.push(neighbor);
                 }
             }
         }
@@ -427,10 +402,13 @@ public:
         const std::string& source, const std::string& target, size_t max_length = 5) const
     {
         std::vector<std::vector<std::string>> all_paths;
-        std::vector<std::string> current_path;
-        std::unordered_set<std::string> visited;
+        auto from = find_node(source);
+        auto to = find_node(target);
+        if (!from || !to) return all_paths;
 
-        find_paths_dfs(source, target, current_path, visited, all_paths, max_length);
+        std::vector<NodeId> current_path;
+        std::vector<char> visited(num_nodes(), 0);
+        find_paths_dfs(*from, *to, current_path, visited, all_paths, max_length);
         return all_paths;
     }
 
@@ -447,28 +425,25 @@ public:
         std::vector<std::pair<std::string, double>> anomalies;
 
         // Calculate flow statistics
-        std::vector<double> all_flows;
-        for (const auto& [key, edge] : m_edges) {
-            for (size_t p = 0; p < m_num_periods; ++p) {
-                if (edge.flow_tensor[p] > 0)
-                    all_flows.push_back(edge.flow_tensor[p]);
-            }
-        }
+        RunningStats stats;
+        for (const auto& column : m_period_flows)
+            for (double flow : column)
+                if (flow > 0)
+                    stats.add(flow);
 
-        if (all_flows.empty()) return anomalies;
-
-        DoubleTensor flow_tensor({all_flows.size()}, std::move(all_flows));
-        double mean = flow_tensor.mean();
-        double stddev = flow_tensor.std();
+        if (stats.count() == 0) return anomalies;
 
         // Find anomalies
-        for (const auto& [key, edge] : m_edges) {
-            for (size_t p = 0; p < m_num_periods; ++p) {
-                double flow = edge.flow_tensor[p];
+        for (size_t p = 0; p < m_num_periods; ++p) {
+            const auto& column = m_period_flows[p];
+            for (EdgeId e = 0; e < num_edges(); ++e) {
+                double flow = column[e];
                 if (flow > 0) {
-                    double z_score = (flow - mean) / stddev;
+                    double z_score = stats.z_score(flow);
                     if (std::abs(z_score) > threshold) {
-                        anomalies.emplace_back(key + "@" + std::to_string(p), z_score);
+                        anomalies.emplace_back(m_guids[m_sources[e]] + "->" +
+                                               m_guids[m_targets[e]] + "@" +
+                                               std::to_string(p), z_score);
                     }
                 }
             }
@@ -485,15 +460,29 @@ public:
 
     /**
      * Detect circular flows (potential issues).
+     *
+     * Lists every simple cycle of 3 to max_cycle_length accounts once, as
+     * a path starting and ending at its first-added account. This is
+     * Johnson's algorithm with the length-bounded blocking of Gupta and
+     * Suzumura: instead of a blocked flag each account keeps the path
+     * length from which it is known not to lead back to the start in time.
      */
     std::vector<std::vector<std::string>> detect_circular_flows(size_t max_cycle_length = 5) const
     {
         std::vector<std::vector<std::string>> cycles;
-
-        for (const auto& [start_node, name] : m_nodes) {
-            std::vector<std::string> path;
-            std::unordered_set<std::string> visited;
-            find_cycles_dfs(start_node, start_node, path, visited, cycles, max_cycle_length);
+        if (max_cycle_length < 3 || num_nodes() == 0) return cycles;
+
+        CycleSearch search(outgoing(), incoming(), max_cycle_length);
+        for (NodeId start = 0; start < num_nodes(); ++start) {
+            search.run(start, [&](const std::vector<NodeId>& path) {
+                if (path.size() < 3) return;
+                std::vector<std::string> cycle;
+                cycle.reserve(path.size() + 1);
+                for (NodeId node : path)
+                    cycle.push_back(m_guids[node]);
+                cycle.push_back(m_guids[start]);
+                cycles.push_back(std::move(cycle));
+            });
         }
 
         return cycles;
@@ -508,19 +497,18 @@ public:
      */
     DoubleTensor generate_node_embeddings(size_t embedding_dim = 32) const
     {
-        std::vector<std::string> nodes = get_nodes();
-        size_t n = nodes.size();
+        size_t n = num_nodes();
         if (n == 0) return DoubleTensor({1, embedding_dim}, 0.0);
 
-        DoubleTensor embeddings({n, embedding_dim});
+        const auto& out = outgoing();
+        const auto& in = incoming();
+        DoubleTensor embeddings(Shape{n, embedding_dim});
 
         // Simple embedding based on flow features
-        for (size_t i = 0; i < n; ++i) {
-            const auto& node = nodes[i];
-
-            auto inflow = get_total_inflow(node);
-            auto outflow = get_total_outflow(node);
-            auto net = get_net_flow(node);
+        for (NodeId i = 0; i < n; ++i) {
+            auto inflow = sum_flows(in, i);
+            auto outflow = sum_flows(out, i);
+            auto net = inflow - outflow;
 
             // Features: normalized flows, statistics
             size_t dim = 0;
@@ -535,10 +523,8 @@ public:
             embeddings.at({i, dim++}) = outflow.std();
 
             // Connectivity
-            auto it_out = m_adjacency.find(node);
-            auto it_in = m_reverse_adjacency.find(node);
-            embeddings.at({i, dim++}) = it_out != m_adjacency.end() ? it_out->second.size() : 0;
-            embeddings.at({i, dim++}) = it_in != m_reverse_adjacency.end() ? it_in->second.size() : 0;
+            embeddings.at({i, dim++}) = out.degree(i);
+            embeddings.at({i, dim++}) = in.degree(i);
 
             // Pad remaining dimensions
             while (dim < embedding_dim) {
@@ -550,62 +536,338 @@ public:
     }
 
 private:
-    size_t m_num_periods;
-    std::unordered_map<std::string, std::string> m_nodes;  // guid -> name
-    std::unordered_map<std::string, NetworkEdge> m_edges;  // "src->tgt" -> edge
-    std::unordered_map<std::string, std::unordered_set<std::string>> m_adjacency;
-    std::unordered_map<std::string, std::unordered_set<std::string>> m_reverse_adjacency;
+    static constexpr NodeId NO_NODE = ~NodeId{0};
 
-    void find_paths_dfs(const std::string& current, const std::string& target,
-                        std::vector<std::string>& path, std::unordered_set<std::string>& visited,
-                        std::vector<std::vector<std::string>>& all_paths, size_t max_length) const
+    /**
+     * Compressed sparse rows: the neighbours of node i, and the edges to
+     * them, are at offsets[i] .. offsets[i + 1].
+     */
+    struct SparseIndex
     {
-        if (path.size() >= max_length) return;
+        std::vector<size_t> offsets;
+        std::vector<NodeId> nodes;
+        std::vector<EdgeId> edges;
 
-        visited.insert(current);
-        path.push_back(current);
+        size_t degree(NodeId i) const { return offsets[i + 1] - offsets[i]; }
+    };
 
-        if (current == target && path.size() > 1) {
-            all_paths.push_back(path);
-        } else {
-            auto it = m_adjacency.find(current);
-            if (it != m_adjacency.end()) {
-                for (const auto& next : it->second) {
-                    if (visited.find(next) == visited.end()) {
-                        find_paths_dfs(next, target, path, visited, all_paths, max_length);
+    /**
+     * State of the bounded cycle search, reused for every start node.
+     */
+    class CycleSearch
+    {
+    public:
+        CycleSearch(const SparseIndex& out, const SparseIndex& in, size_t max_length)
+            : m_out(out)
+            , m_in(in)
+            , m_max_length(max_length)
+            , m_lock(out.offsets.size() - 1, 0)
+            , m_distance(out.offsets.size() - 1, UNREACHED)
+            , m_blocked_by(out.offsets.size() - 1)
+            , m_on_path(out.offsets.size() - 1, 0)
+        {}
+
+        /**
+         * Call emit(path) for each cycle whose lowest node is start.
+         */
+        template<typename Emit>
+        void run(NodeId start, Emit&& emit)
+        {
+            m_start = start;
+            if (!reaches_start()) return;
+            search(start, 0, emit);
+            for (NodeId node : m_touched) {
+                m_lock[node] = 0;
+                m_distance[node] = UNREACHED;
+                m_blocked_by[node].clear();
+            }
+            m_touched.clear();
+        }
+
+    private:
+        static constexpr size_t UNREACHED = ~size_t{0};
+
+        const SparseIndex& m_out;
+        const SparseIndex& m_in;
+        size_t m_max_length;
+        NodeId m_start = 0;
+
+        // A node entered at a path length of lock or more cannot close a
+        // cycle in time; 0 for nodes that cannot at all.
+        std::vector<size_t> m_lock;
+        std::vector<size_t> m_distance;
+        std::vector<std::vector<NodeId>> m_blocked_by;
+        std::vector<char> m_on_path;
+        std::vector<NodeId> m_path;
+        std::vector<NodeId> m_touched;
+
+        /**
+         * Breadth-first search backwards from the start over higher nodes.
+         * Each node's distance back bounds the path length it may be
+         * entered at. Returns false if no cycle can close.
+         */
+        bool reaches_start()
+        {
+            std::vector<NodeId> frontier{m_start}, next;
+            m_distance[m_start] = 0;
+            m_touched.push_back(m_start);
+            for (size_t d = 1; d < m_max_length && !frontier.empty(); ++d) {
+                next.clear();
+                for (NodeId node : frontier) {
+                    for (size_t k = m_in.offsets[node]; k < m_in.offsets[node + 1]; ++k) {
+                        NodeId source = m_in.nodes[k];
+                        if (source <= m_start || m_distance[source] != UNREACHED)
+                            continue;
+                        m_distance[source] = d;
+                        m_lock[source] = m_max_length - d + 1;
+                        m_touched.push_back(source);
+                        next.push_back(source);
                     }
                 }
+                std::swap(frontier, next);
             }
+
+            bool closes = false;
+            for (size_t k = m_out.offsets[m_start]; k < m_out.offsets[m_start + 1]; ++k) {
+                NodeId next_node = m_out.nodes[k];
+                if (next_node > m_start && m_distance[next_node] != UNREACHED)
+                    closes = true;
+            }
+            if (!closes) {
+                for (NodeId node : m_touched) {
+                    m_lock[node] = 0;
+                    m_distance[node] = UNREACHED;
+                }
+                m_touched.clear();
+            }
+            return closes;
         }
 
-        path.pop_back();
-        visited.erase(current);
+        /**
+         * Extend the path by node, entered after length edges. Returns the
+         * length of the shortest way back to the start found, or UNREACHED.
+         */
+        template<typename Emit>
+        size_t search(NodeId node, size_t length, Emit& emit)
+        {
+            size_t back = UNREACHED;
+            m_lock[node] = length;
+            m_on_path[node] = 1;
+            m_path.push_back(node);
+
+            for (size_t k = m_out.offsets[node]; k < m_out.offsets[node + 1]; ++k) {
+                NodeId next = m_out.nodes[k];
+                if (next == m_start) {
+                    emit(m_path);
+                    back = 1;
+                } else if (length + 1 < m_max_length && next > m_start &&
+                           !m_on_path[next] && length + 1 < m_lock[next]) {
+                    size_t rest = search(next, length + 1, emit);
+                    if (rest != UNREACHED)
+                        back = std::min(back, rest + 1);
+                }
+            }
+
+            if (back != UNREACHED)
+                relax(node, back);
+            // Whatever the outcome, a shorter way back found later from a
+            // neighbour may open this node to longer paths.
+            for (size_t k = m_out.offsets[node]; k < m_out.offsets[node + 1]; ++k) {
+                NodeId next = m_out.nodes[k];
+                if (next > m_start && m_distance[next] != UNREACHED)
+                    m_blocked_by[next].push_back(node);
+            }
+
+            m_path.pop_back();
+            m_on_path[node] = 0;
+            return back;
+        }
+
+        /**
+         * Node leads back to the start in back edges: allow entering it
+         * after up to max_length - back edges, and pass that on.
+         */
+        void relax(NodeId node, size_t back)
+        {
+            if (back > m_max_length || m_lock[node] >= m_max_length - back + 1)
+                return;
+            m_lock[node] = m_max_length - back + 1;
+            for (NodeId blocked : m_blocked_by[node])
+                if (!m_on_path[blocked])
+                    relax(blocked, back + 1);
+        }
+    };
+
+    size_t m_num_periods;
+
+    // Nodes
+    std::vector<std::string> m_guids;
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, NodeId> m_node_ids;
+
+    // Edges, one row each
+    std::vector<NodeId> m_sources;
+    std::vector<NodeId> m_targets;
+    std::vector<double> m_total_flows;
+    std::vector<size_t> m_transaction_counts;
+    std::vector<std::vector<double>> m_period_flows;      // [period][edge]
+    std::vector<std::vector<uint32_t>> m_period_counts;   // [period][edge]
+    std::unordered_map<uint64_t, EdgeId> m_edge_ids;      // source << 32 | target
+
+    // Built from the edge rows on first use after they change
+    mutable SparseIndex m_outgoing;
+    mutable SparseIndex m_incoming;
+    mutable bool m_indexed = false;
+
+    NodeId intern(const std::string& guid, const std::string& name = "")
+    {
+        auto [it, inserted] = m_node_ids.emplace(guid, static_cast<NodeId>(m_guids.size()));
+        if (inserted) {
+            m_guids.push_back(guid);
+            m_names.push_back(name.empty() ? guid : name);
+            m_indexed = false;
+        }
+        return it->second;
     }
 
-    void find_cycles_dfs(const std::string& start, const std::string& current,
-                         std::vector<std::string>& path, std::unordered_set<std::string>& visited,
-                         std::vector<std::vector<std::string>>& cycles, size_t max_length) const
+    static uint64_t edge_key(NodeId source, NodeId target)
+    {
+        return (static_cast<uint64_t>(source) << 32) | target;
+    }
+
+    EdgeId intern_edge(NodeId source, NodeId target)
+    {
+        auto [it, inserted] = m_edge_ids.emplace(edge_key(source, target),
+                                                 static_cast<EdgeId>(m_sources.size()));
+        if (inserted) {
+            m_sources.push_back(source);
+            m_targets.push_back(target);
+            m_total_flows.push_back(0.0);
+            m_transaction_counts.push_back(0);
+            for (auto& column : m_period_flows) column.push_back(0.0);
+            for (auto& column : m_period_counts) column.push_back(0);
+            m_indexed = false;
+        }
+        return it->second;
+    }
+
+    std::optional<NodeId> find_node(const std::string& guid) const
+    {
+        auto it = m_node_ids.find(guid);
+        if (it == m_node_ids.end()) return std::nullopt;
+        return it->second;
+    }
+
+    std::optional<EdgeId> find_edge(const std::string& source, const std::string& target) const
+    {
+        auto from = find_node(source);
+        auto to = find_node(target);
+        if (!from || !to) return std::nullopt;
+        auto it = m_edge_ids.find(edge_key(*from, *to));
+        if (it == m_edge_ids.end()) return std::nullopt;
+        return it->second;
+    }
+
+    const SparseIndex& outgoing() const
+    {
+        build_indexes();
+        return m_outgoing;
+    }
+
+    const SparseIndex& incoming() const
+    {
+        build_indexes();
+        return m_incoming;
+    }
+
+    void build_indexes() const
+    {
+        if (m_indexed) return;
+        build_index(m_sources, m_targets, m_outgoing);
+        build_index(m_targets, m_sources, m_incoming);
+        m_indexed = true;
+    }
+
+    /**
+     * Counting sort of the edges by their from node.
+     */
+    void build_index(const std::vector<NodeId>& from, const std::vector<NodeId>& to,
+                     SparseIndex& index) const
+    {
+        size_t n = num_nodes(), m = from.size();
+        index.offsets.assign(n + 1, 0);
+        for (EdgeId e = 0; e < m; ++e)
+            ++index.offsets[from[e] + 1];
+        for (size_t i = 0; i < n; ++i)
+            index.offsets[i + 1] += index.offsets[i];
+
+        index.nodes.resize(m);
+        index.edges.resize(m);
+        std::vector<size_t> fill(index.offsets.begin(), index.offsets.end() - 1);
+        for (EdgeId e = 0; e < m; ++e) {
+            size_t slot = fill[from[e]]++;
+            index.nodes[slot] = to[e];
+            index.edges[slot] = e;
+        }
+    }
+
+    std::vector<std::string> guids_of(const SparseIndex& index, NodeId node) const
+    {
+        std::vector<std::string> guids;
+        guids.reserve(index.degree(node));
+        for (size_t k = index.offsets[node]; k < index.offsets[node + 1]; ++k)
+            guids.push_back(m_guids[index.nodes[k]]);
+        return guids;
+    }
+
+    DoubleTensor flow_of(EdgeId e) const
+    {
+        DoubleTensor flow({m_num_periods}, 0.0);
+        for (size_t p = 0; p < m_num_periods; ++p)
+            flow[p] = m_period_flows[p][e];
+        return flow;
+    }
+
+    DoubleTensor sum_flows(const SparseIndex& index, NodeId node) const
+    {
+        DoubleTensor result({m_num_periods}, 0.0);
+        for (size_t p = 0; p < m_num_periods; ++p) {
+            const auto& column = m_period_flows[p];
+            double sum = 0.0;
+            for (size_t k = index.offsets[node]; k < index.offsets[node + 1]; ++k)
+                sum += column[index.edges[k]];
+            result[p] = sum;
+        }
+        return result;
+    }
+
+    void find_paths_dfs(NodeId current, NodeId target, std::vector<NodeId>& path,
+                        std::vector<char>& visited,
+                        std::vector<std::vector<std::string>>& all_paths,
+                        size_t max_length) const
     {
         if (path.size() >= max_length) return;
 
+        visited[current] = 1;
         path.push_back(current);
 
-        auto it = m_adjacency.find(current);
-        if (it != m_adjacency.end()) {
-            for (const auto& next : it->second) {
-                if (next == start && path.size() > 2) {
-                    std::vector<std::string> cycle = path;
-                    cycle.push_back(start);
-                    cycles.push_back(cycle);
-                } else if (visited.find(next) == visited.end()) {
-                    visited.insert(next);
-                    find_cycles_dfs(start, next, path, visited, cycles, max_length);
-                    visited.erase(next);
-                }
+        if (current == target && path.size() > 1) {
+            std::vector<std::string> found;
+            found.reserve(path.size());
+            for (NodeId node : path)
+                found.push_back(m_guids[node]);
+            all_paths.push_back(std::move(found));
+        } else {
+            const auto& out = outgoing();
+            for (size_t k = out.offsets[current]; k < out.offsets[current + 1]; ++k) {
+                NodeId next = out.nodes[k];
+                if (!visited[next])
+                    find_paths_dfs(next, target, path, visited, all_paths, max_length);
             }
         }
 
         path.pop_back();
+        visited[current] = 0;
     }
 };
 
@@ -0,0 +1,126 @@
+/*
+ * bench-aten-ann.cpp
+ *
+ * Benchmark for the ATenSpace embedding index
+ *
+ * Fills an ATenSpace with clustered semantic embeddings and runs
+ * find_similar() queries, timing the index against the previous full
+ * AtomSpace scan and measuring the recall of the approximate search
+ * against an exact one.
+ *
+ * Usage: bench-aten-ann [atoms [dimension [queries [probes]]]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../atenspace/atenspace.hpp"
+#include "bench-common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace gnc::atenspace;
+using namespace gnc::bench;
+
+namespace {
+
+using Results = std::vector<std::pair<Handle, double>>;
+
+/* The find_similar() implementation before the index. */
+Results scan_similar(const ATenSpace& space, const DoubleTensor& query,
+                     EmbeddingType type, size_t top_k)
+{
+    Results results;
+    space.for_each([&](const Handle& atom) {
+        auto* tn = dynamic_cast<TensorNode*>(atom.get());
+        if (!tn) return;
+        auto emb = tn->get_embedding(type);
+        if (!emb) return;
+        results.emplace_back(atom, ops::cosine_similarity(query, emb->tensor()));
+    });
+    std::sort(results.begin(), results.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+    if (results.size() > top_k)
+        results.resize(top_k);
+    return results;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t dim = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    size_t queries = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200;
+    size_t probes = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 8;
+    if (count == 0 || dim == 0 || queries == 0 || probes == 0) {
+        std::fprintf(stderr, "Usage: %s [atoms [dimension [queries [probes]]]]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    const size_t top_k = 10;
+    const size_t clusters = std::max<size_t>(1, count / 100);
+    EmbeddingConfig config;
+    config.ann_probes = probes;
+    ATenSpace space(config);
+
+    std::mt19937 gen(7);
+    std::normal_distribution<double> noise(0.0, 0.3);
+    std::vector<DoubleTensor> centers;
+    for (size_t c = 0; c < clusters; ++c)
+        centers.push_back(ops::randn<double>(Shape{dim}));
+    auto sample = [&](size_t i) {
+        auto emb = centers[i % clusters].clone();
+        for (size_t j = 0; j < dim; ++j)
+            emb[j] += noise(gen);
+        return emb;
+    };
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        auto node = space.add_tensor_node(AtomTypes::ACCOUNT_NODE,
+                                          "acct-" + std::to_string(i));
+        space.set_embedding(node, EmbeddingType::SEMANTIC, sample(i));
+    }
+    std::printf("%zu atoms of dimension %zu, %zu queries, top %zu, %zu probes\n",
+                count, dim, queries, top_k, probes);
+    std::printf("%-24s %9.3f ms\n", "build", seconds_since(start) * 1e3);
+
+    std::vector<DoubleTensor> query_set;
+    for (size_t q = 0; q < queries; ++q)
+        query_set.push_back(sample(q * 7919));
+
+    std::vector<Results> scanned, indexed, exact;
+    start = Clock::now();
+    for (const auto& q : query_set)
+        scanned.push_back(scan_similar(space, q, EmbeddingType::SEMANTIC, top_k));
+    report("atomspace scan", seconds_since(start), queries, "query");
+
+    const auto& index = space.embedding_index(EmbeddingType::SEMANTIC);
+    start = Clock::now();
+    for (const auto& q : query_set)
+        exact.push_back(index.search_exact(q, top_k));
+    report("index, exact", seconds_since(start), queries, "query");
+
+    start = Clock::now();
+    for (const auto& q : query_set)
+        indexed.push_back(space.find_similar(q, EmbeddingType::SEMANTIC, top_k, -1.0));
+    report("find_similar", seconds_since(start), queries, "query");
+
+    size_t found = 0, wanted = 0;
+    for (size_t q = 0; q < queries; ++q)
+        for (const auto& [atom, sim] : scanned[q]) {
+            ++wanted;
+            found += std::any_of(indexed[q].begin(), indexed[q].end(),
+                                 [&](const auto& hit) { return hit.first == atom; });
+        }
+    std::printf("%-24s %9.3f\n", "recall@10", double(found) / wanted);
+    return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * bench-aten-fused.cpp
+ *
+ * Benchmark for fused element-wise evaluation
+ *
+ * Runs the embedding update from ATenSpace::learn_embedding,
+ * target += (context_avg - target) * lr, over a table of embeddings,
+ * first as a chain of tensor operators and then as one fused pass. The
+ * same is done for the normalize() chain.
+ *
+ * Usage: bench-aten-fused [embeddings [dimension [steps]]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../aten/tensor.hpp"
+#include "../aten/tensor_ops.hpp"
+#include "bench-common.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gnc::aten;
+using namespace gnc::bench;
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    size_t dim = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 128;
+    int steps = argc > 3 ? std::atoi(argv[3]) : 10;
+    if (count == 0 || dim == 0 || steps <= 0) {
+        std::fprintf(stderr, "Usage: %s [embeddings [dimension [steps]]]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    const double lr = 0.01;
+    std::vector<DoubleTensor> targets, contexts;
+    for (size_t i = 0; i < count; ++i) {
+        targets.push_back(ops::randn<double>(Shape{dim}));
+        contexts.push_back(ops::randn<double>(Shape{dim}));
+    }
+    size_t elements = count * dim * steps;
+    std::printf("%zu embeddings of dimension %zu, %d steps\n", count, dim, steps);
+
+    auto start = Clock::now();
+    for (int s = 0; s < steps; ++s)
+        for (size_t i = 0; i < count; ++i) {
+            auto update = (contexts[i] - targets[i]) * lr;
+            targets[i] = targets[i] + update;
+        }
+    report("update, operator chain", seconds_since(start), elements, "element");
+
+    start = Clock::now();
+    for (int s = 0; s < steps; ++s)
+        for (size_t i = 0; i < count; ++i)
+            ops::fused_(targets[i], [lr](double target, double context) {
+                return target + (context - target) * lr;
+            }, contexts[i]);
+    report("update, fused in place", seconds_since(start), elements, "element");
+
+    double check = 0.0;
+    start = Clock::now();
+    for (int s = 0; s < steps; ++s)
+        for (size_t i = 0; i < count; ++i) {
+            double m = targets[i].mean();
+            double sd = targets[i].std();
+            check += ((targets[i] - m) / sd)[0];
+        }
+    report("normalize, operator chain", seconds_since(start), elements, "element");
+
+    start = Clock::now();
+    for (int s = 0; s < steps; ++s)
+        for (size_t i = 0; i < count; ++i)
+            check += ops::normalize(targets[i])[0];
+    report("normalize, fused", seconds_since(start), elements, "element");
+
+    return check == 0.123456789 ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * bench-aten-matmul.cpp
+ *
+ * GFLOP/s benchmark for Tensor::matmul and ops::bmm
+ *
+ * Sizes cover account embedding projections (many rows by a small
+ * embedding dimension), square account-to-account flow matrices and
+ * batches of small per-entity matrices. A naive triple loop over the same
+ * buffers is timed for the smaller shapes as a reference.
+ *
+ * Usage: bench-aten-matmul [repeats]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../aten/tensor.hpp"
+#include "../aten/tensor_ops.hpp"
+#include "bench-common.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace gnc::aten;
+using namespace gnc::bench;
+
+namespace {
+
+double gflops(size_t batch, size_t m, size_t k, size_t n, double secs)
+{
+    return 2.0 * batch * m * k * n / secs / 1e9;
+}
+
+DoubleTensor naive_matmul(const DoubleTensor& a, const DoubleTensor& b)
+{
+    size_t m = a.shape()[0], k = a.shape()[1], n = b.shape()[1];
+    DoubleTensor c(Shape{m, n});
+    const double* pa = a.data();
+    const double* pb = b.data();
+    double* pc = c.data();
+    for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < n; ++j) {
+            double sum = 0.0;
+            for (size_t l = 0; l < k; ++l)
+                sum += pa[i * k + l] * pb[l * n + j];
+            pc[i * n + j] = sum;
+        }
+    return c;
+}
+
+void bench_matmul(const char* label, size_t m, size_t k, size_t n, int repeats)
+{
+    auto a = ops::rand<double>(Shape{m, k}, -1.0, 1.0);
+    auto b = ops::rand<double>(Shape{k, n}, -1.0, 1.0);
+    double check = a.matmul(b).sum(); // warm up
+
+    auto start = Clock::now();
+    for (int r = 0; r < repeats; ++r)
+        check += a.matmul(b)[0];
+    double secs = seconds_since(start) / repeats;
+    std::printf("%-22s %5zux%-5zu * %5zux%-5zu %9.3f ms %8.2f GFLOP/s",
+                label, m, k, k, n, secs * 1e3, gflops(1, m, k, n, secs));
+
+    if (m * k * n <= size_t{1} << 27) {
+        start = Clock::now();
+        check += naive_matmul(a, b)[0];
+        double naive = seconds_since(start);
+        std::printf("  (naive %7.2f GFLOP/s)", gflops(1, m, k, n, naive));
+    }
+    std::printf("%s\n", check == 0.123456789 ? " " : "");
+}
+
+void bench_bmm(const char* label, size_t batch, size_t m, size_t k, size_t n,
+               int repeats)
+{
+    auto a = ops::rand<double>(Shape{batch, m, k}, -1.0, 1.0);
+    auto b = ops::rand<double>(Shape{batch, k, n}, -1.0, 1.0);
+    double check = ops::bmm(a, b).sum(); // warm up
+
+    auto start = Clock::now();
+    for (int r = 0; r < repeats; ++r)
+        check += ops::bmm(a, b)[0];
+    double secs = seconds_since(start) / repeats;
+    std::printf("%-22s %4zu x %4zux%-4zu * %4zux%-4zu %9.3f ms %8.2f GFLOP/s%s\n",
+                label, batch, m, k, k, n, secs * 1e3,
+                gflops(batch, m, k, n, secs), check == 0.123456789 ? " " : "");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int repeats = argc > 1 ? std::atoi(argv[1]) : 5;
+    if (repeats <= 0) {
+        std::fprintf(stderr, "Usage: %s [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    bench_matmul("embedding projection", 1000, 64, 64, repeats);
+    bench_matmul("embedding projection", 10000, 128, 128, repeats);
+    bench_matmul("flow matrix", 100, 100, 100, repeats);
+    bench_matmul("flow matrix", 256, 256, 256, repeats);
+    bench_matmul("flow matrix", 512, 512, 512, repeats);
+    bench_matmul("flow matrix", 1024, 1024, 1024, repeats);
+
+    bench_bmm("entity batch", 64, 32, 32, 32, repeats);
+    bench_bmm("entity batch", 32, 128, 128, 128, repeats);
+    bench_bmm("entity batch", 8, 512, 512, 512, repeats);
+    return 0;
+}
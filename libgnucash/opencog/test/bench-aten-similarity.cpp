@@ -0,0 +1,112 @@
+/*
+ * bench-aten-similarity.cpp
+ *
+ * Benchmark for batched cosine similarity
+ *
+ * Scores queries against a table of embeddings three ways: one pair at a
+ * time on separate tensors, as compute_similarity() did, then with
+ * kernels::dot_rows() over a packed matrix of unit-length rows, one
+ * query and then a block of queries per pass. Each takes the top k.
+ *
+ * Usage: bench-aten-similarity [embeddings [dimension [queries [block]]]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../aten/tensor.hpp"
+#include "../aten/tensor_ops.hpp"
+#include "../aten/tensor_kernels.hpp"
+#include "bench-common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+using namespace gnc::aten;
+using namespace gnc::bench;
+
+namespace {
+
+double pair_similarity(const DoubleTensor& a, const DoubleTensor& b)
+{
+    double dot = 0.0, norm_a = 0.0, norm_b = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        dot += a[i] * b[i];
+        norm_a += a[i] * a[i];
+        norm_b += b[i] * b[i];
+    }
+    if (norm_a == 0 || norm_b == 0) return 0.0;
+    return dot / (std::sqrt(norm_a) * std::sqrt(norm_b));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+    size_t dim = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    size_t queries = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64;
+    size_t block = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 8;
+    if (count == 0 || dim == 0 || queries == 0 || block == 0) {
+        std::fprintf(stderr, "Usage: %s [embeddings [dimension [queries [block]]]]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    const size_t top_k = 10;
+    const double none = -std::numeric_limits<double>::infinity();
+    std::vector<DoubleTensor> table, query_set;
+    for (size_t i = 0; i < count; ++i)
+        table.push_back(ops::randn<double>(Shape{dim}));
+    for (size_t q = 0; q < queries; ++q)
+        query_set.push_back(ops::randn<double>(Shape{dim}));
+    size_t pairs = count * queries;
+    std::printf("%zu embeddings of dimension %zu, %zu queries, block of %zu\n",
+                count, dim, queries, block);
+
+    std::vector<double> matrix(count * dim), packed(queries * dim);
+    for (size_t i = 0; i < count; ++i) {
+        std::copy_n(table[i].data(), dim, &matrix[i * dim]);
+        kernels::normalize(&matrix[i * dim], dim);
+    }
+    for (size_t q = 0; q < queries; ++q) {
+        std::copy_n(query_set[q].data(), dim, &packed[q * dim]);
+        kernels::normalize(&packed[q * dim], dim);
+    }
+
+    double check = 0.0;
+    auto start = Clock::now();
+    for (const auto& query : query_set) {
+        std::vector<std::pair<size_t, double>> results;
+        for (size_t i = 0; i < count; ++i)
+            results.emplace_back(i, pair_similarity(query, table[i]));
+        std::sort(results.begin(), results.end(),
+                  [](const auto& a, const auto& b) { return a.second > b.second; });
+        check += results[0].second;
+    }
+    report("per pair, full sort", seconds_since(start), pairs, "pair");
+
+    std::vector<double> scores(count * block);
+    start = Clock::now();
+    for (size_t q = 0; q < queries; ++q) {
+        kernels::dot_rows(matrix.data(), count, dim, &packed[q * dim], 1, scores.data());
+        check -= scores[kernels::top_k(scores.data(), count, top_k, none)[0]];
+    }
+    report("packed, one query", seconds_since(start), pairs, "pair");
+
+    start = Clock::now();
+    for (size_t q = 0; q < queries; q += block) {
+        size_t nq = std::min(block, queries - q);
+        kernels::dot_rows(matrix.data(), count, dim, &packed[q * dim], nq, scores.data());
+        for (size_t b = 0; b < nq; ++b)
+            check += kernels::top_k(&scores[b * count], count, top_k, none).size();
+    }
+    report("packed, query block", seconds_since(start), pairs, "pair");
+
+    return std::isnan(check) ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * bench-atomspace-ingest.cpp
+ *
+ * Benchmark for parallel AtomSpace ingestion
+ *
+ * Imports transactions the way CognitiveEngine::import_transaction does
+ * (transaction, description, date and amount nodes, evaluation and flow
+ * links to shared account and predicate nodes) from 1, 2, 4, ... threads.
+ * Each run is repeated with every add behind one global mutex, which is
+ * how the AtomSpace behaved before it was sharded.
+ *
+ * Usage: bench-atomspace-ingest [transactions [max-threads]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../atomspace/atomspace.hpp"
+#include "bench-common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gnc::opencog;
+using namespace gnc::bench;
+
+namespace {
+
+constexpr size_t NUM_ACCOUNTS = 50;
+
+struct NoLock
+{
+    void lock() {}
+    void unlock() {}
+};
+
+template<typename Lock>
+void import_transaction(AtomSpace& space, Lock& lock, size_t txn)
+{
+    auto node = [&](AtomType type, const std::string& name) {
+        std::lock_guard<Lock> guard(lock);
+        return space.add_node(type, name);
+    };
+    auto link = [&](AtomType type, const Handle& a, const Handle& b) {
+        std::lock_guard<Lock> guard(lock);
+        return space.add_link(type, a, b);
+    };
+
+    auto txn_node = node(AtomTypes::TRANSACTION_NODE, "txn-" + std::to_string(txn));
+    auto desc = node(AtomTypes::CONCEPT_NODE, "payee-" + std::to_string(txn % 997));
+    link(AtomTypes::EVALUATION_LINK, node(AtomTypes::PREDICATE_NODE, "has-description"),
+         link(AtomTypes::LIST_LINK, txn_node, desc));
+    auto date = node(AtomTypes::DATE_NODE, "day-" + std::to_string(txn % 3650));
+    link(AtomTypes::TEMPORAL_LINK, txn_node, date);
+    auto amount = node(AtomTypes::AMOUNT_NODE, std::to_string((txn * 7919) % 100000 / 100.0));
+    link(AtomTypes::EVALUATION_LINK, node(AtomTypes::PREDICATE_NODE, "has-amount"),
+         link(AtomTypes::LIST_LINK, txn_node, amount));
+    auto debit = node(AtomTypes::ACCOUNT_NODE, "acct-" + std::to_string(txn % NUM_ACCOUNTS));
+    link(AtomTypes::FLOW_LINK, node(AtomTypes::PREDICATE_NODE, "debit"),
+         link(AtomTypes::LIST_LINK, txn_node, debit));
+    auto credit = node(AtomTypes::ACCOUNT_NODE,
+                       "acct-" + std::to_string((txn * 31 + 7) % NUM_ACCOUNTS));
+    link(AtomTypes::FLOW_LINK, node(AtomTypes::PREDICATE_NODE, "credit"),
+         link(AtomTypes::LIST_LINK, txn_node, credit));
+}
+
+template<typename Lock>
+void run(const char* label, size_t count, size_t nthreads)
+{
+    AtomSpace space;
+    Lock lock;
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nthreads; ++t)
+        threads.emplace_back([&, t]() {
+            for (size_t txn = t; txn < count; txn += nthreads)
+                import_transaction(space, lock, txn);
+        });
+    for (auto& thread : threads)
+        thread.join();
+    double secs = seconds_since(start);
+    std::printf("%-12s %2zu threads %9.3f ms %10.0f txn/s %9zu atoms\n", label,
+                nthreads, secs * 1e3, count / secs, space.size());
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10)
+                                  : std::max(1u, std::thread::hardware_concurrency());
+    if (count == 0 || max_threads == 0) {
+        std::fprintf(stderr, "Usage: %s [transactions [max-threads]]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%zu transactions, %u hardware threads\n", count,
+                std::thread::hardware_concurrency());
+    for (size_t n = 1; n <= max_threads; n *= 2) {
+        run<std::mutex>("global lock", count, n);
+        run<NoLock>("sharded", count, n);
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * bench-atomspace-memory.cpp
+ *
+ * Benchmark for AtomSpace memory use and lookups
+ *
+ * Models transactions as CognitiveEngine::import_transaction does (a
+ * transaction node with evaluation, temporal and flow links to shared
+ * date, amount, payee and account nodes), reports heap bytes per atom,
+ * then times the lookups the engine makes: by type and name, by UUID,
+ * incoming sets and membership.
+ *
+ * Usage: bench-atomspace-memory [transactions [lookups]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../atomspace/atomspace.hpp"
+#include "bench-common.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2 1
+#endif
+
+using namespace gnc::opencog;
+using namespace gnc::bench;
+
+namespace {
+
+constexpr size_t NUM_ACCOUNTS = 50;
+
+size_t heap_in_use()
+{
+#ifdef HAVE_MALLINFO2
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+void import_transaction(AtomSpace& space, size_t txn)
+{
+    auto txn_node = space.add_node(AtomTypes::TRANSACTION_NODE, "txn-" + std::to_string(txn));
+    auto desc = space.add_node(AtomTypes::CONCEPT_NODE, "payee-" + std::to_string(txn % 997));
+    space.add_link(AtomTypes::EVALUATION_LINK,
+                   space.add_node(AtomTypes::PREDICATE_NODE, "has-description"),
+                   space.add_link(AtomTypes::LIST_LINK, txn_node, desc));
+    auto date = space.add_node(AtomTypes::DATE_NODE, "day-" + std::to_string(txn % 3650));
+    space.add_link(AtomTypes::TEMPORAL_LINK, txn_node, date);
+    auto amount = space.add_node(AtomTypes::AMOUNT_NODE,
+                                 std::to_string((txn * 7919) % 100000 / 100.0));
+    space.add_link(AtomTypes::EVALUATION_LINK,
+                   space.add_node(AtomTypes::PREDICATE_NODE, "has-amount"),
+                   space.add_link(AtomTypes::LIST_LINK, txn_node, amount));
+    auto account = space.add_node(AtomTypes::ACCOUNT_NODE,
+                                  "acct-" + std::to_string(txn % NUM_ACCOUNTS));
+    space.add_link(AtomTypes::FLOW_LINK,
+                   space.add_node(AtomTypes::PREDICATE_NODE, "debit"),
+                   space.add_link(AtomTypes::LIST_LINK, txn_node, account));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t lookups = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    if (count == 0 || lookups == 0) {
+        std::fprintf(stderr, "Usage: %s [transactions [lookups]]\n", argv[0]);
+        return 1;
+    }
+
+    AtomSpace space;
+    size_t heap_before = heap_in_use();
+    auto start = Clock::now();
+    for (size_t txn = 0; txn < count; ++txn)
+        import_transaction(space, txn);
+    double secs = seconds_since(start);
+    size_t heap = heap_in_use() - heap_before;
+
+    auto stats = space.get_stats();
+    std::printf("%zu transactions: %zu atoms (%zu nodes, %zu links)\n", count,
+                stats.total_atoms, stats.total_nodes, stats.total_links);
+    report("import, per atom", secs, stats.total_atoms, "op");
+#ifdef HAVE_MALLINFO2
+    std::printf("%-24s %9.1f MiB %8.1f bytes/atom\n", "heap", heap / 1048576.0,
+                double(heap) / stats.total_atoms);
+#else
+    (void)heap;
+    std::printf("%-24s n/a (needs glibc mallinfo2)\n", "heap");
+#endif
+
+    std::vector<Handle> txns;
+    for (size_t i = 0; i < 1024; ++i)
+        txns.push_back(space.get_node(AtomTypes::TRANSACTION_NODE,
+                                      "txn-" + std::to_string(i * 7 % count)));
+
+    size_t found = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+        found += space.get_node(AtomTypes::ACCOUNT_NODE,
+                                "acct-" + std::to_string(i % NUM_ACCOUNTS)) != nullptr;
+    report("get_node", seconds_since(start), lookups, "op");
+
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+        found += space.get_atom(txns[i % txns.size()]->uuid()) != nullptr;
+    report("get_atom(uuid)", seconds_since(start), lookups, "op");
+
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+        found += space.contains(txns[i % txns.size()]);
+    report("contains", seconds_since(start), lookups, "op");
+
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+        found += space.get_incoming(txns[i % txns.size()]).size();
+    report("get_incoming(txn)", seconds_since(start), lookups, "op");
+
+    return found == 0 ? 1 : 0;
+}
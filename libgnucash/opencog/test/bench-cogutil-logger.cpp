@@ -0,0 +1,115 @@
+/*
+ * bench-cogutil-logger.cpp
+ *
+ * Benchmark for the cogutil Logger
+ *
+ * Times a disabled debug call, formatting the message first as the
+ * Logger used to and checking the level first as it does now. Then times
+ * enabled calls from 1, 2, 4, ... threads, delivered synchronously under
+ * the mutex and queued for the sink thread, both until the logging
+ * threads are done and until the callback has seen every message.
+ *
+ * Usage: bench-cogutil-logger [messages [max_threads]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../cogutil/logger.hpp"
+#include "bench-common.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace gnc::opencog;
+using namespace gnc::bench;
+
+namespace {
+
+void report(const char* label, size_t threads, double secs, size_t messages)
+{
+    std::printf("%-24s %3zu threads %9.3f ms %8.1f ns/message\n", label, threads,
+                secs * 1e3, secs * 1e9 / messages);
+}
+
+struct Timing
+{
+    double calls;       // until every logging thread has returned
+    double delivered;   // until the callback has seen every message
+};
+
+/**
+ * Log messages spread over threads threads.
+ */
+Timing run(Logger& logger, size_t threads, size_t messages)
+{
+    std::vector<std::thread> workers;
+    size_t per_thread = messages / threads;
+    auto start = Clock::now();
+    for (size_t t = 0; t < threads; ++t)
+        workers.emplace_back([&logger, per_thread, t]() {
+            for (size_t i = 0; i < per_thread; ++i)
+                logger.info("bench", "thread ", t, " message ", i, " value ", i * 0.5);
+        });
+    for (auto& worker : workers)
+        worker.join();
+    double calls = seconds_since(start);
+    logger.flush();
+    return {calls, seconds_since(start)};
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t messages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+    if (messages == 0 || max_threads == 0) {
+        std::fprintf(stderr, "Usage: %s [messages [max_threads]]\n", argv[0]);
+        return 1;
+    }
+
+    Logger logger;
+    std::atomic<size_t> delivered{0};
+    logger.set_callback([&](LogLevel, const std::string&, const std::string& message) {
+        delivered += message.size() > 0;
+    });
+
+    // Disabled calls: the old eager path built the string before the check.
+    volatile size_t sink = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < messages; ++i) {
+        std::string message = detail::format_message("message ", i, " value ", i * 0.5);
+        if (logger.should_log(LogLevel::DEBUG))
+            logger.log(LogLevel::DEBUG, "bench", message);
+        sink = sink + message.size();
+    }
+    report("disabled, format first", 1, seconds_since(start), messages);
+
+    start = Clock::now();
+    for (size_t i = 0; i < messages; ++i)
+        logger.debug("bench", "message ", i, " value ", i * 0.5);
+    report("disabled, check first", 1, seconds_since(start), messages);
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        delivered = 0;
+        Timing sync = run(logger, threads, messages);
+        report("synchronous", threads, sync.delivered, messages);
+
+        logger.start_async();
+        delivered = 0;
+        Timing async = run(logger, threads, messages);
+        logger.stop_async();
+        report("asynchronous, calls", threads, async.calls, messages);
+        report("asynchronous, delivered", threads, async.delivered, messages);
+        if (delivered != messages / threads * threads) {
+            std::fprintf(stderr, "lost messages: %zu delivered\n", delivered.load());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * bench-cogutil-queue.cpp
+ *
+ * Contention benchmark for the cogutil queues and thread pool
+ *
+ * Passes items from N producer threads to N consumer threads through
+ * ConcurrentQueue (one mutex) and through the lock-free MpmcQueue, for
+ * N = 1, 2, 4, ... up to the given thread count. Then times many small
+ * parallel loops run on the ThreadPool against starting threads for each
+ * loop, which is how the tensor kernels and the pattern matcher worked
+ * before.
+ *
+ * Usage: bench-cogutil-queue [items [max_threads [loops]]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../cogutil/concurrent_queue.hpp"
+#include "../cogutil/mpmc_queue.hpp"
+#include "../cogutil/thread_pool.hpp"
+#include "bench-common.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace gnc::opencog;
+using namespace gnc::bench;
+
+namespace {
+
+void report(const char* label, size_t threads, double secs, size_t items)
+{
+    std::printf("%-20s %3zu x %-3zu %9.3f ms %8.1f ns/item\n", label, threads, threads,
+                secs * 1e3, secs * 1e9 / items);
+}
+
+/**
+ * Run producers and consumers, each side with threads threads, moving
+ * items through push(value) and pop(value) -> bool. Returns the sum
+ * consumed, to check nothing was lost.
+ */
+template<typename Push, typename Pop>
+long long transfer(size_t threads, size_t items, Push push, Pop pop)
+{
+    std::atomic<size_t> consumed{0};
+    std::atomic<long long> sum{0};
+    std::vector<std::thread> workers;
+    size_t per_producer = items / threads;
+
+    for (size_t p = 0; p < threads; ++p)
+        workers.emplace_back([&, p]() {
+            for (size_t i = 0; i < per_producer; ++i)
+                push(static_cast<long long>(p * per_producer + i));
+        });
+    for (size_t c = 0; c < threads; ++c)
+        workers.emplace_back([&]() {
+            long long value, local = 0;
+            while (consumed.load(std::memory_order_relaxed) < per_producer * threads) {
+                if (pop(value)) {
+                    local += value;
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            sum += local;
+        });
+    for (auto& worker : workers)
+        worker.join();
+    return sum.load();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t items = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+    size_t loops = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 2000;
+    if (items == 0 || max_threads == 0 || loops == 0) {
+        std::fprintf(stderr, "Usage: %s [items [max_threads [loops]]]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%zu items, %u hardware threads\n", items,
+                std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        size_t n = items / threads * threads;
+        long long expected = static_cast<long long>(n) * (n - 1) / 2;
+
+        ConcurrentQueue<long long> locked;
+        auto start = Clock::now();
+        long long sum = transfer(threads, n,
+            [&](long long v) { locked.push(v); },
+            [&](long long& v) { return locked.try_pop(v); });
+        report("ConcurrentQueue", threads, seconds_since(start), n);
+        if (sum != expected) {
+            std::fprintf(stderr, "ConcurrentQueue lost items\n");
+            return 1;
+        }
+
+        MpmcQueue<long long> ring(1024);
+        start = Clock::now();
+        sum = transfer(threads, n,
+            [&](long long v) { while (!ring.try_push(v)) std::this_thread::yield(); },
+            [&](long long& v) { return ring.try_pop(v); });
+        report("MpmcQueue", threads, seconds_since(start), n);
+        if (sum != expected) {
+            std::fprintf(stderr, "MpmcQueue lost items\n");
+            return 1;
+        }
+    }
+
+    // Small parallel loops, as a kernel on a modest tensor would run.
+    const size_t width = 4096;
+    std::vector<double> data(width, 1.0);
+    size_t nthreads = std::max(2u, std::thread::hardware_concurrency());
+    auto body = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            data[i] = data[i] * 0.5 + 1.0;
+    };
+
+    auto start = Clock::now();
+    for (size_t l = 0; l < loops; ++l) {
+        size_t per_thread = (width + nthreads - 1) / nthreads;
+        std::vector<std::thread> threads;
+        for (size_t begin = per_thread; begin < width; begin += per_thread)
+            threads.emplace_back(body, begin, std::min(width, begin + per_thread));
+        body(0, per_thread);
+        for (auto& thread : threads)
+            thread.join();
+    }
+    double spawned = seconds_since(start);
+
+    ThreadPool pool(nthreads - 1);
+    start = Clock::now();
+    for (size_t l = 0; l < loops; ++l)
+        pool.parallel_for(0, width, (width + nthreads - 1) / nthreads, body);
+    double pooled = seconds_since(start);
+
+    std::printf("%zu loops of %zu on %zu threads\n", loops, width, nthreads);
+    std::printf("%-20s %9.3f ms %8.2f us/loop\n", "thread per loop", spawned * 1e3,
+                spawned * 1e6 / loops);
+    std::printf("%-20s %9.3f ms %8.2f us/loop\n", "ThreadPool", pooled * 1e3,
+                pooled * 1e6 / loops);
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * bench-common.hpp
+ *
+ * Timing and reporting helpers shared by the opencog and marketplace
+ * benchmarks
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GNC_BENCH_COMMON_HPP
+#define GNC_BENCH_COMMON_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace gnc {
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/** Print the total time of a step. */
+inline void report(const char* label, double secs)
+{
+    std::printf("  %-28s %10.3f ms\n", label, secs * 1e3);
+}
+
+/**
+ * Print the total time of a step and the time per item, e.g. "us/query",
+ * in whichever of ns, us or ms keeps the figure readable.
+ */
+inline void report(const char* label, double secs, size_t items, const char* item)
+{
+    double per = secs / items;
+    const char* unit = per < 1e-6 ? "ns" : per < 1e-3 ? "us" : "ms";
+    double scale = per < 1e-6 ? 1e9 : per < 1e-3 ? 1e6 : 1e3;
+    std::printf("  %-28s %10.3f ms %10.2f %s/%s\n", label, secs * 1e3, per * scale,
+                unit, item);
+}
+
+/** Run fn(0) .. fn(queries - 1) and return the seconds taken. */
+template<typename Fn>
+double time_queries(size_t queries, Fn&& fn)
+{
+    auto start = Clock::now();
+    for (size_t q = 0; q < queries; ++q)
+        fn(q);
+    return seconds_since(start);
+}
+
+} // namespace bench
+} // namespace gnc
+
+#endif // GNC_BENCH_COMMON_HPP
@@ -0,0 +1,106 @@
+/*
+ * bench-tensor-network.cpp
+ *
+ * Benchmark for the sparse TensorNetwork
+ *
+ * Builds flow graphs of growing size, up to the given numbers of accounts
+ * and edges, and times recording the flows, the first query (which builds
+ * the sparse indexes), PageRank, flow centrality and anomaly detection.
+ * Cycle detection is timed on a sparser graph over the same accounts, with
+ * three outgoing flows each, since a dense graph has far too many cycles
+ * to list.
+ *
+ * Usage: bench-tensor-network [accounts [edges [max_cycle_length]]]
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "../tensor-logic/tensor_network.hpp"
+#include "bench-common.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace gnc::tensor_logic;
+using namespace gnc::bench;
+
+namespace {
+
+std::vector<std::string> account_guids(size_t accounts)
+{
+    std::vector<std::string> guids;
+    guids.reserve(accounts);
+    for (size_t i = 0; i < accounts; ++i)
+        guids.push_back("account-" + std::to_string(i));
+    return guids;
+}
+
+void run(size_t accounts, size_t edges, size_t max_cycle_length)
+{
+    std::printf("%zu accounts, %zu flows\n", accounts, edges);
+    auto guids = account_guids(accounts);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, accounts - 1);
+    std::uniform_real_distribution<double> amount(1.0, 1000.0);
+
+    TensorNetwork network(12);
+    auto start = Clock::now();
+    for (const auto& guid : guids)
+        network.add_node(guid);
+    for (size_t i = 0; i < edges; ++i)
+        network.record_transaction(guids[pick(rng)], guids[pick(rng)], amount(rng), i % 12);
+    report("record flows", seconds_since(start));
+    std::printf("  %zu distinct edges\n", network.num_edges());
+
+    start = Clock::now();
+    auto outgoing = network.get_outgoing(guids[0]);
+    report("build sparse index", seconds_since(start));
+
+    start = Clock::now();
+    auto rank = network.pagerank();
+    report("pagerank (100 iter)", seconds_since(start));
+
+    start = Clock::now();
+    auto centrality = network.flow_centrality();
+    report("flow centrality", seconds_since(start));
+
+    start = Clock::now();
+    auto anomalies = network.detect_flow_anomalies(3.0);
+    report("flow anomalies", seconds_since(start));
+
+    TensorNetwork sparse(12);
+    for (size_t i = 0; i < accounts; ++i)
+        for (size_t k = 0; k < 3; ++k)
+            sparse.record_transaction(guids[i], guids[pick(rng)], amount(rng), k);
+
+    start = Clock::now();
+    auto cycles = sparse.detect_circular_flows(max_cycle_length);
+    report("circular flows (sparse)", seconds_since(start));
+
+    std::printf("  rank[0] %.3g, centrality[0] %.3g, %zu anomalies, %zu cycles\n",
+                rank[0], centrality[0], anomalies.size(), cycles.size());
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t accounts = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    size_t edges = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    size_t max_cycle_length = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 5;
+    if (accounts < 100 || edges == 0) {
+        std::fprintf(stderr, "Usage: %s [accounts [edges [max_cycle_length]]]\n"
+                     "(at least 100 accounts)\n", argv[0]);
+        return 1;
+    }
+
+    // Scale accounts and flows together, by 10x, up to the requested size.
+    for (size_t scale = 100; scale >= 1; scale /= 10)
+        run(accounts / scale, edges / scale ? edges / scale : 1, max_cycle_length);
+    return 0;
+}
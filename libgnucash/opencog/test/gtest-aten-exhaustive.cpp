@@ -511,14 +511,14 @@ TEST_F(TensorOpsTest, Softmax_LargerInputsGetHigherProbabilities)
     EXPECT_LT(result[1], result[2]);
 }
 
-TEST_F(TensorOpsTest, Normalize_UnitLength)
+TEST_F(TensorOpsTest, Normalize_StandardScores)
 {
-    DoubleTensor tensor({3.0, 4.0});  // 3-4-5 triangle
+    DoubleTensor tensor({3.0, 4.0});  // mean 3.5, std 0.5
 
     auto result = tensor_ops::normalize(tensor);
 
-    double length = std::sqrt(result[0] * result[0] + result[1] * result[1]);
-    EXPECT_NEAR(length, 1.0, 1e-6);
+    EXPECT_NEAR(result[0], -1.0, 1e-9);
+    EXPECT_NEAR(result[1], 1.0, 1e-9);
 }
 
 TEST_F(TensorOpsTest, MovingAverage_CalculatesCorrectly)
@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 #include "../aten/tensor.hpp"
 #include "../aten/tensor_ops.hpp"
+#include "../aten/tensor_kernels.hpp"
 
 using namespace gnc::aten;
 
@@ -187,18 +188,176 @@ TEST_F(ATenTest, MatrixMultiplication)
     EXPECT_EQ(result.at({1, 1}), 64.0);
 }
 
+TEST_F(ATenTest, MatrixMultiplicationAcrossTiles)
+{
+    // Odd sizes larger than the kernel tiles exercise the edge handling.
+    const size_t m = 7, k = 300, n = 263;
+    auto a = DoubleTensor::arange(0.0, double(m * k)).reshape({m, k}) / 1000.0;
+    auto b = DoubleTensor::arange(0.0, double(k * n)).reshape({k, n}) / 1000.0;
+
+    auto result = a.matmul(b);
+
+    ASSERT_EQ(result.sizes()[0], m);
+    ASSERT_EQ(result.sizes()[1], n);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double expected = 0.0;
+            for (size_t l = 0; l < k; ++l)
+                expected += a.at({i, l}) * b.at({l, j});
+            EXPECT_NEAR(result.at({i, j}), expected, 1e-9 * std::abs(expected));
+        }
+    }
+}
+
+TEST_F(ATenTest, BatchMatrixMultiplication)
+{
+    auto a = DoubleTensor::arange(0.0, 24.0).reshape({2, 3, 4});
+    auto b = DoubleTensor::arange(0.0, 16.0).reshape({2, 4, 2});
+
+    auto result = tensor_ops::bmm(a, b);
+
+    ASSERT_EQ(result.ndim(), 3);
+    EXPECT_EQ(result.sizes()[0], 2);
+    EXPECT_EQ(result.sizes()[1], 3);
+    EXPECT_EQ(result.sizes()[2], 2);
+    for (size_t batch = 0; batch < 2; ++batch) {
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 2; ++j) {
+                double expected = 0.0;
+                for (size_t l = 0; l < 4; ++l)
+                    expected += a.at({batch, i, l}) * b.at({batch, l, j});
+                EXPECT_EQ(result.at({batch, i, j}), expected);
+            }
+        }
+    }
+    EXPECT_THROW(tensor_ops::bmm(a, a), std::invalid_argument);
+}
+
+TEST_F(ATenTest, ShapeHoldsDimensionsInline)
+{
+    Shape shape{2, 3};
+    shape.insert(shape.begin(), 4);
+    EXPECT_EQ(shape, (Shape{4, 2, 3}));
+    shape.erase(shape.begin() + 1);
+    EXPECT_EQ(shape, (Shape{4, 3}));
+    EXPECT_THROW(Shape(MAX_DIMS + 1), std::invalid_argument);
+}
+
+TEST_F(ATenTest, ViewsShareStorage)
+{
+    auto tensor = DoubleTensor::arange(0.0, 6.0).reshape({2, 3});
+
+    auto t = tensor.transpose();
+    EXPECT_FALSE(t.is_contiguous());
+    EXPECT_EQ(t.sizes()[0], 3);
+    EXPECT_EQ(t.at({2, 1}), 5.0);
+    EXPECT_EQ(t[1], 3.0); // row-major order of the view
+    t.at({0, 1}) = 30.0;
+    EXPECT_EQ(tensor.at({1, 0}), 30.0);
+
+    auto column = tensor.slice(1, 1, 3);
+    EXPECT_EQ(column.sizes()[1], 2);
+    EXPECT_EQ(column.at({1, 1}), 5.0);
+
+    auto row = tensor.select(1);
+    EXPECT_TRUE(row.is_contiguous());
+    EXPECT_EQ(row.ndim(), 1);
+    EXPECT_EQ(row[0], 30.0);
+
+    auto copy = t.clone();
+    EXPECT_TRUE(copy.is_contiguous());
+    copy.at({0, 0}) = -1.0;
+    EXPECT_EQ(tensor.at({0, 0}), 0.0);
+    EXPECT_EQ(t.reshape({6})[1], 30.0);
+}
+
+TEST_F(ATenTest, InPlaceOperations)
+{
+    auto tensor = DoubleTensor({-1.0, 2.0, -3.0});
+    auto alias = tensor;
+    const double* storage = tensor.data();
+
+    tensor.add_(DoubleTensor({1.0, 1.0, 1.0}), 2.0).mul_(2.0).relu_();
+
+    EXPECT_EQ(tensor.data(), storage);
+    EXPECT_EQ(alias[0], 2.0);
+    EXPECT_EQ(alias[1], 8.0);
+    EXPECT_EQ(alias[2], 0.0);
+
+    auto view = tensor.slice(0, 1, 3);
+    view.zero_();
+    EXPECT_EQ(tensor[1], 0.0);
+    EXPECT_THROW(tensor.add_(DoubleTensor({1.0})), std::invalid_argument);
+}
+
+TEST_F(ATenTest, FusedElementwise)
+{
+    auto a = DoubleTensor({1.0, 2.0, 3.0, 4.0}).reshape({2, 2});
+    auto b = DoubleTensor({4.0, 3.0, 2.0, 1.0}).reshape({2, 2});
+
+    auto result = tensor_ops::fused([](double x, double y) { return (x - y) * 2.0 + x; },
+                                    a, b);
+    EXPECT_EQ(result.at({0, 0}), -5.0);
+    EXPECT_EQ(result.at({1, 1}), 10.0);
+
+    // Non-contiguous operands take the strided path.
+    auto t = tensor_ops::fused([](double x, double y) { return x * y; },
+                               a.transpose(), b);
+    EXPECT_EQ(t.at({0, 1}), 9.0);
+
+    tensor_ops::fused_(a, [](double x, double y) { return x + 0.5 * y; }, b);
+    EXPECT_EQ(a.at({0, 0}), 3.0);
+    EXPECT_EQ(a.at({1, 1}), 4.5);
+
+    EXPECT_EQ(tensor_ops::fused_sum([](double x, double y) { return x * y; }, b, b), 30.0);
+    EXPECT_THROW(tensor_ops::fused_sum([](double x, double y) { return x * y; },
+                                       b, b.flatten()), std::invalid_argument);
+}
+
+TEST_F(ATenTest, BatchedSimilarity)
+{
+    // Three unit rows of dimension 10, so dot() runs a full lane block
+    // plus a tail.
+    std::vector<double> rows(30, 0.0);
+    rows[0] = 1.0;
+    rows[10 + 1] = 1.0;
+    rows[20 + 0] = 0.6;
+    rows[20 + 9] = 0.8;
+
+    std::vector<double> queries(20, 0.0);
+    queries[9] = 2.0;
+    queries[10] = 3.0;
+    queries[11] = 4.0;
+    kernels::normalize(queries.data(), 10);
+    EXPECT_EQ(kernels::normalize(&queries[10], 10), 5.0);
+
+    std::vector<double> scores(6);
+    kernels::dot_rows(rows.data(), 3, 10, queries.data(), 2, scores.data());
+    EXPECT_DOUBLE_EQ(scores[0], 0.0);
+    EXPECT_DOUBLE_EQ(scores[2], 0.8);
+    EXPECT_DOUBLE_EQ(scores[3], 0.6);
+    EXPECT_DOUBLE_EQ(scores[4], 0.8);
+
+    auto best = kernels::top_k(&scores[3], 3, 2, 0.0);
+    ASSERT_EQ(best.size(), 2);
+    EXPECT_EQ(best[0], 1);
+    EXPECT_EQ(best[1], 0);
+    EXPECT_EQ(kernels::top_k(&scores[3], 3, 5, 0.7).size(), 1);
+
+    EXPECT_DOUBLE_EQ(kernels::cosine(&rows[20], queries.data(), 10), 0.8);
+    EXPECT_EQ(kernels::cosine(&rows[20], &scores[0], 1), 0.0);
+}
+
 TEST_F(ATenTest, TensorOpsNormalize)
 {
     auto tensor = DoubleTensor({1.0, 2.0, 3.0, 4.0});
     
     auto normalized = tensor_ops::normalize(tensor);
     
-    double sum_squares = 0.0;
-    for (size_t i = 0; i < normalized.size(); ++i) {
-        sum_squares += normalized.at(i) * normalized.at(i);
-    }
-    
-    EXPECT_NEAR(sum_squares, 1.0, 1e-6);
+    // Standard scores: zero mean and unit (population) variance
+    EXPECT_NEAR(normalized.mean(), 0.0, 1e-9);
+    EXPECT_NEAR(normalized.std(), 1.0, 1e-9);
+    EXPECT_NEAR(normalized.at(0), -1.5 / std::sqrt(1.25), 1e-9);
 }
 
 TEST_F(ATenTest, TensorOpsSoftmax)
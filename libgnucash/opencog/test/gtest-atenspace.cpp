@@ -11,6 +11,8 @@
 #include "../atenspace/atenspace.hpp"
 #include "../atenspace/tensor_atom.hpp"
 
+#include <thread>
+
 using namespace gnc::atenspace;
 using namespace gnc::opencog;
 using namespace gnc::aten;
@@ -201,6 +203,191 @@ TEST_F(ATenSpaceTest, CombineEmbeddings)
     EXPECT_EQ(combined.size(), 64 + 32 + 16);
 }
 
+TEST_F(ATenSpaceTest, FindSimilarFollowsEmbeddingChanges)
+{
+    auto food = space.add_tensor_node(AtomTypes::ACCOUNT_NODE, "Expenses:Food");
+    auto rent = space.add_tensor_node(AtomTypes::ACCOUNT_NODE, "Expenses:Rent");
+    auto query = DoubleTensor({1.0, 0.0});
+
+    space.set_embedding(food, EmbeddingType::SEMANTIC, DoubleTensor({1.0, 0.1}));
+    space.set_embedding(rent, EmbeddingType::SEMANTIC, DoubleTensor({0.1, 1.0}));
+    auto similar = space.find_similar(query, EmbeddingType::SEMANTIC, 1);
+    ASSERT_EQ(similar.size(), 1);
+    EXPECT_EQ(similar[0].first, food);
+
+    // Updates made on the node directly reach the index too
+    rent->set_embedding(EmbeddingType::SEMANTIC, DoubleTensor({1.0, 0.0}));
+    similar = space.find_similar(query, EmbeddingType::SEMANTIC, 1);
+    ASSERT_EQ(similar.size(), 1);
+    EXPECT_EQ(similar[0].first, rent);
+    EXPECT_NEAR(similar[0].second, 1.0, 1e-12);
+
+    // Adding an existing node again returns the indexed instance
+    EXPECT_EQ(space.add_tensor_node(AtomTypes::ACCOUNT_NODE, "Expenses:Rent"), rent);
+
+    EXPECT_TRUE(space.remove_atom(rent));
+    similar = space.find_similar(query, EmbeddingType::SEMANTIC, 2);
+    ASSERT_EQ(similar.size(), 1);
+    EXPECT_EQ(similar[0].first, food);
+
+    space.clear();
+    EXPECT_TRUE(space.find_similar(query, EmbeddingType::SEMANTIC).empty());
+}
+
+TEST_F(ATenSpaceTest, ApproximateSearchAgreesWithExact)
+{
+    EmbeddingConfig config;
+    config.ann_min_size = 500;
+    ATenSpace large(config);
+
+    // Clustered embeddings, like accounts grouped by category
+    std::mt19937 gen(42);
+    std::normal_distribution<double> dist(0.0, 1.0);
+    const size_t dim = 16, clusters = 20;
+    std::vector<DoubleTensor> centers;
+    for (size_t c = 0; c < clusters; ++c)
+        centers.push_back(ops::randn<double>(Shape{dim}));
+    for (size_t i = 0; i < 2000; ++i) {
+        auto emb = centers[i % clusters].clone();
+        for (size_t j = 0; j < dim; ++j)
+            emb[j] += 0.2 * dist(gen);
+        auto node = large.add_tensor_node(AtomTypes::ACCOUNT_NODE, "acct-" + std::to_string(i));
+        large.set_embedding(node, EmbeddingType::SEMANTIC, emb);
+    }
+
+    const auto& index = large.embedding_index(EmbeddingType::SEMANTIC);
+    EXPECT_EQ(index.size(), 2000);
+    EXPECT_EQ(index.dimension(), dim);
+
+    size_t found = 0, wanted = 0;
+    for (size_t q = 0; q < 50; ++q) {
+        auto query = centers[q % clusters].clone();
+        for (size_t j = 0; j < dim; ++j)
+            query[j] += 0.2 * dist(gen);
+        auto approx = large.find_similar(query, EmbeddingType::SEMANTIC, 10, -1.0);
+        auto exact = index.search_exact(query, 10);
+        ASSERT_EQ(approx.size(), 10);
+        for (size_t i = 1; i < approx.size(); ++i)
+            EXPECT_GE(approx[i - 1].second, approx[i].second);
+        for (const auto& [atom, sim] : exact) {
+            ++wanted;
+            for (const auto& hit : approx)
+                if (hit.first == atom) {
+                    ++found;
+                    break;
+                }
+        }
+    }
+    EXPECT_GE(double(found) / wanted, 0.9);
+}
+
+TEST_F(ATenSpaceTest, IndexFollowsChangesMadeThroughAtomSpace)
+{
+    AtomSpace& base = space;
+    auto query = DoubleTensor({1.0, 0.0});
+
+    auto food = create_tensor_node(AtomTypes::ACCOUNT_NODE, "Expenses:Food");
+    food->set_embedding(EmbeddingType::SEMANTIC, DoubleTensor({1.0, 0.1}));
+    base.add_atom(food);
+    auto rent = space.add_tensor_node(AtomTypes::ACCOUNT_NODE, "Expenses:Rent");
+    space.set_embedding(rent, EmbeddingType::SEMANTIC, DoubleTensor({0.1, 1.0}));
+    auto similar = space.find_similar(query, EmbeddingType::SEMANTIC, 2);
+    ASSERT_EQ(similar.size(), 2);
+    EXPECT_EQ(similar[0].first, food);
+
+    EXPECT_TRUE(base.remove_atom(food));
+    similar = space.find_similar(query, EmbeddingType::SEMANTIC, 2);
+    ASSERT_EQ(similar.size(), 1);
+    EXPECT_EQ(similar[0].first, rent);
+
+    // A removed node's later changes stay out of the index
+    food->set_embedding(EmbeddingType::SEMANTIC, DoubleTensor({1.0, 0.0}));
+    EXPECT_EQ(space.embedding_index(EmbeddingType::SEMANTIC).size(), 1);
+
+    base.add_atom(food);
+    EXPECT_EQ(space.embedding_index(EmbeddingType::SEMANTIC).size(), 2);
+
+    base.clear();
+    EXPECT_TRUE(space.find_similar(query, EmbeddingType::SEMANTIC).empty());
+    rent->set_embedding(EmbeddingType::SEMANTIC, DoubleTensor({1.0, 0.0}));
+    EXPECT_TRUE(space.find_similar(query, EmbeddingType::SEMANTIC).empty());
+}
+
+TEST_F(ATenSpaceTest, EmbeddingDimensionsAreChecked)
+{
+    auto food = space.add_tensor_node(AtomTypes::ACCOUNT_NODE, "Expenses:Food");
+    auto rent = space.add_tensor_node(AtomTypes::ACCOUNT_NODE, "Expenses:Rent");
+    space.set_embedding(food, EmbeddingType::SEMANTIC, DoubleTensor({1.0, 0.0}));
+
+    // The only indexed embedding of a type may change dimension
+    space.set_embedding(food, EmbeddingType::SEMANTIC, DoubleTensor({1.0, 0.0, 0.0}));
+    EXPECT_EQ(space.embedding_index(EmbeddingType::SEMANTIC).dimension(), 3);
+
+    EXPECT_THROW(space.set_embedding(rent, EmbeddingType::SEMANTIC,
+                                     DoubleTensor({1.0, 0.0})),
+                 std::invalid_argument);
+    EXPECT_FALSE(rent->has_embedding(EmbeddingType::SEMANTIC));
+    EXPECT_EQ(space.embedding_index(EmbeddingType::SEMANTIC).size(), 1);
+
+    // Other types are indexed separately
+    space.set_embedding(rent, EmbeddingType::TEMPORAL, DoubleTensor({1.0, 0.0}));
+
+    auto bad = create_tensor_node(AtomTypes::ACCOUNT_NODE, "Expenses:Travel");
+    bad->set_embedding(EmbeddingType::SEMANTIC, DoubleTensor({1.0}));
+    EXPECT_THROW(space.add_atom(bad), std::invalid_argument);
+    EXPECT_EQ(space.embedding_index(EmbeddingType::SEMANTIC).size(), 1);
+}
+
+TEST_F(ATenSpaceTest, LearnEmbeddingFromSeveralThreads)
+{
+    const size_t threads = 4, targets_per_thread = 8, steps = 50;
+    HandleSeq context;
+    for (int i = 0; i < 4; ++i)
+        context.push_back(space.add_tensor_node(AtomTypes::CONCEPT_NODE,
+                                                "context-" + std::to_string(i)));
+    for (const auto& ctx : context)
+        space.set_embedding(ctx, EmbeddingType::SEMANTIC,
+                            space.generate_semantic_embedding(ctx->name()));
+
+    std::vector<Handle> targets;
+    for (size_t i = 0; i < threads * targets_per_thread; ++i)
+        targets.push_back(space.add_tensor_node(AtomTypes::ACCOUNT_NODE,
+                                                "target-" + std::to_string(i)));
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+        workers.emplace_back([&, t]() {
+            for (size_t s = 0; s < steps; ++s)
+                for (size_t i = t; i < targets.size(); i += threads) {
+                    space.learn_embedding(targets[i], context);
+                    space.cosine_similarity(targets[i], context[0],
+                                            EmbeddingType::SEMANTIC);
+                }
+        });
+    for (auto& worker : workers)
+        worker.join();
+
+    // Each target took the same steps as it would on one thread
+    ATenSpace serial;
+    HandleSeq serial_context;
+    for (const auto& ctx : context) {
+        auto node = serial.add_tensor_node(AtomTypes::CONCEPT_NODE, ctx->name());
+        serial.set_embedding(node, EmbeddingType::SEMANTIC,
+                             *space.get_embedding(ctx, EmbeddingType::SEMANTIC));
+        serial_context.push_back(node);
+    }
+    for (const auto& target : targets) {
+        auto node = serial.add_tensor_node(AtomTypes::ACCOUNT_NODE, target->name());
+        for (size_t s = 0; s < steps; ++s)
+            serial.learn_embedding(node, serial_context);
+        auto expected = *serial.get_embedding(node, EmbeddingType::SEMANTIC);
+        auto learned = *space.get_embedding(target, EmbeddingType::SEMANTIC);
+        ASSERT_EQ(learned.size(), expected.size());
+        for (size_t j = 0; j < expected.size(); ++j)
+            EXPECT_DOUBLE_EQ(learned[j], expected[j]);
+    }
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -10,6 +10,8 @@
 #include <gtest/gtest.h>
 #include "../atomspace/atomspace.hpp"
 
+#include <thread>
+
 using namespace gnc::opencog;
 
 class AtomSpaceTest : public ::testing::Test
@@ -168,3 +170,95 @@ TEST_F(AtomSpaceTest, ConcurrentAccess)
 
     EXPECT_EQ(atomspace.size(), num_threads * nodes_per_thread);
 }
+
+TEST_F(AtomSpaceTest, ConcurrentLinksShareTargets)
+{
+    // Every thread links its own nodes to the same shared predicate, as
+    // transaction imports do with "has-amount" and the account nodes.
+    const int num_threads = 4;
+    const int links_per_thread = 200;
+    auto predicate = atomspace.add_node(AtomTypes::PREDICATE_NODE, "has-amount");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < links_per_thread; ++i) {
+                auto shared = atomspace.add_node(AtomTypes::PREDICATE_NODE, "has-amount");
+                auto txn = atomspace.add_node(AtomTypes::TRANSACTION_NODE,
+                    "txn-" + std::to_string(t) + "-" + std::to_string(i));
+                atomspace.add_link(AtomTypes::EVALUATION_LINK, shared, txn);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    size_t links = num_threads * links_per_thread;
+    EXPECT_EQ(atomspace.size(), 1 + 2 * links);
+    EXPECT_EQ(atomspace.size(AtomTypes::EVALUATION_LINK), links);
+    EXPECT_EQ(atomspace.get_incoming(predicate).size(), links);
+
+    auto stats = atomspace.get_stats();
+    EXPECT_EQ(stats.total_atoms, 1 + 2 * links);
+    EXPECT_EQ(stats.total_links, links);
+
+    auto txn = atomspace.get_node(AtomTypes::TRANSACTION_NODE, "txn-0-0");
+    ASSERT_NE(txn, nullptr);
+    EXPECT_EQ(atomspace.get_atom(txn->uuid()), txn);
+    auto link = atomspace.get_incoming(txn).at(0);
+    EXPECT_TRUE(atomspace.remove_atom(link));
+    EXPECT_EQ(atomspace.get_incoming(predicate).size(), links - 1);
+    EXPECT_EQ(atomspace.get_atom(link->uuid()), nullptr);
+
+    atomspace.clear();
+    EXPECT_EQ(atomspace.size(), 0);
+    EXPECT_TRUE(atomspace.get_incoming(predicate).empty());
+}
+
+TEST_F(AtomSpaceTest, AddLinkFromSequence)
+{
+    auto a = atomspace.add_node(AtomTypes::CONCEPT_NODE, "A");
+    auto b = atomspace.add_node(AtomTypes::CONCEPT_NODE, "B");
+    HandleSeq outgoing{a, b};
+
+    auto link = atomspace.add_link(AtomTypes::LIST_LINK, outgoing);
+    EXPECT_EQ(link, atomspace.add_link(AtomTypes::LIST_LINK, a, b));
+    EXPECT_EQ(link->arity(), 2);
+}
+
+TEST_F(AtomSpaceTest, RemoveKeepsIndexesConsistent)
+{
+    const int count = 2000;
+    auto hub = atomspace.add_node(AtomTypes::ACCOUNT_NODE, "Assets:Bank");
+    std::vector<Handle> nodes, links;
+    for (int i = 0; i < count; ++i) {
+        nodes.push_back(atomspace.add_node(AtomTypes::CONCEPT_NODE, "N" + std::to_string(i)));
+        links.push_back(atomspace.add_link(AtomTypes::LIST_LINK, nodes.back(), hub));
+    }
+
+    // Remove every other atom; entries displaced in the tables must
+    // still be found afterwards.
+    for (int i = 0; i < count; i += 2) {
+        EXPECT_TRUE(atomspace.remove_atom(links[i]));
+        EXPECT_TRUE(atomspace.remove_atom(nodes[i]));
+    }
+    EXPECT_FALSE(atomspace.remove_atom(nodes[0]));
+
+    EXPECT_EQ(atomspace.size(), 1 + count);
+    EXPECT_EQ(atomspace.size(AtomTypes::CONCEPT_NODE), count / 2);
+    EXPECT_EQ(atomspace.get_incoming(hub).size(), count / 2);
+    for (int i = 0; i < count; ++i) {
+        bool kept = i % 2 == 1;
+        EXPECT_EQ(atomspace.contains(nodes[i]), kept);
+        EXPECT_EQ(atomspace.get_atom(links[i]->uuid()) != nullptr, kept);
+        EXPECT_EQ(atomspace.get_node(AtomTypes::CONCEPT_NODE, "N" + std::to_string(i)) != nullptr,
+                  kept);
+        EXPECT_EQ(atomspace.get_incoming(nodes[i]).size(), kept ? 1u : 0u);
+    }
+
+    // A link listing the same atom twice is in its incoming set once
+    auto pair = atomspace.add_link(AtomTypes::LIST_LINK, hub, hub);
+    EXPECT_EQ(atomspace.get_incoming(hub).size(), count / 2 + 1);
+    EXPECT_TRUE(atomspace.remove_atom(pair));
+    EXPECT_EQ(atomspace.get_incoming(hub).size(), count / 2);
+}
@@ -8,9 +8,12 @@
  */
 
 #include <gtest/gtest.h>
+#include <cmath>
 #include "../gnc-cognitive/cognitive_engine.hpp"
+#include "../gnc-cognitive/event_feed.hpp"
 
 using namespace gnc::opencog;
+using gnc::tensor_logic::TensorLogicEngine;
 
 class CognitiveEngineTest : public ::testing::Test
 {
@@ -118,6 +121,88 @@ TEST_F(CognitiveEngineTest, DetectSpendingPatterns)
     EXPECT_GE(patterns.size(), 0);
 }
 
+TEST_F(CognitiveEngineTest, TransactionColumns)
+{
+    for (int i = 0; i < 4; ++i)
+        engine.import_transaction("txn-col-" + std::to_string(i), "Gym Membership",
+                                  "2024-0" + std::to_string(i + 1) + "-03",
+                                  40.0 + i, "acc-001", "acc-002");
+    engine.import_transaction("txn-col-0", "Gym Membership", "2024-01-03",
+                              44.0, "acc-001", "acc-002");
+
+    const auto& columns = engine.transactions();
+    ASSERT_EQ(columns.size(), 4);
+    EXPECT_EQ(columns.amounts()[0], 44.0);
+    EXPECT_EQ(columns.days()[0], TransactionColumns::parse_day("2024-01-03"));
+    EXPECT_EQ(TransactionColumns::parse_day("1970-01-01"), 0);
+    EXPECT_EQ(TransactionColumns::parse_day("2024-03-01") -
+              TransactionColumns::parse_day("2024-02-28"), 2);
+    EXPECT_EQ(TransactionColumns::parse_day("not a date"), TransactionColumns::NO_DAY);
+
+    auto patterns = engine.detect_spending_patterns();
+    ASSERT_EQ(patterns.size(), 1);
+    EXPECT_DOUBLE_EQ(patterns[0].average_amount, (44.0 + 41.0 + 42.0 + 43.0) / 4);
+    EXPECT_EQ(patterns[0].frequency, "monthly");
+}
+
+TEST_F(CognitiveEngineTest, TransactionColumnsFollowAtomSpace)
+{
+    for (int i = 0; i < 3; ++i)
+        engine.import_transaction("txn-sync-" + std::to_string(i), "Coffee",
+                                  "2024-05-0" + std::to_string(i + 1),
+                                  4.0 + i, "acc-001", "acc-002");
+    ASSERT_EQ(engine.transactions().size(), 3);
+
+    auto& atomspace = engine.atomspace();
+    atomspace.remove_atom(atomspace.get_node(AtomTypes::TRANSACTION_NODE, "txn-sync-1"));
+    EXPECT_EQ(engine.transactions().size(), 2);
+    EXPECT_TRUE(engine.remove_transaction("txn-sync-0"));
+    EXPECT_EQ(engine.transactions().size(), 1);
+
+    atomspace.clear();
+    EXPECT_EQ(engine.transactions().size(), 0);
+}
+
+TEST_F(CognitiveEngineTest, AnomalyScore)
+{
+    for (int i = 0; i < 6; ++i)
+        engine.import_transaction("txn-rent-" + std::to_string(i), "Rent", "2024-01-01",
+                                  1000.0 + (i % 2) * 10.0, "acc-001", "acc-002");
+    for (int i = 0; i < 6; ++i)
+        engine.import_transaction("txn-cafe-" + std::to_string(i), "Cafe", "2024-01-01",
+                                  5.0 + (i % 2), "acc-001", "acc-003");
+
+    // 1000 is typical rent but far above the overall mix.
+    EXPECT_LT(std::abs(engine.anomaly_score(1000.0, "Rent")), 1.5);
+    EXPECT_GT(engine.anomaly_score(1000.0, "Cafe"), 100.0);
+    EXPECT_NEAR(engine.anomaly_score(505.25), 0.0, 1e-9);
+
+    engine.remove_transaction("txn-rent-0");
+    const auto& stats = engine.transactions().amount_stats();
+    EXPECT_EQ(stats.count(), 11);
+}
+
+TEST_F(CognitiveEngineTest, AnomalyScoreByCategory)
+{
+    const char* shops[] = {"Corner Shop", "Market", "Bakery", "Deli"};
+    for (int i = 0; i < 4; ++i)
+        engine.import_transaction("txn-food-" + std::to_string(i), shops[i], "2024-02-01",
+                                  50.0 + i * 5.0, "acc-food", "acc-checking");
+    for (int i = 0; i < 4; ++i)
+        engine.import_transaction("txn-housing-" + std::to_string(i),
+                                  i % 2 ? "Rent" : "Repairs", "2024-02-01",
+                                  900.0 + i * 50.0, "acc-housing", "acc-checking");
+
+    // No description has enough history; the category decides.
+    EXPECT_GT(engine.anomaly_score(1000.0, "Butcher", "acc-food"), 50.0);
+    EXPECT_LT(std::abs(engine.anomaly_score(1000.0, "Plumber", "acc-housing")), 2.0);
+
+    engine.remove_transaction("txn-food-0");
+    auto id = engine.transactions().category_id("acc-food");
+    ASSERT_TRUE(id);
+    EXPECT_EQ(engine.transactions().category_stats(*id).count(), 3);
+}
+
 TEST_F(CognitiveEngineTest, DetectAnomalies)
 {
     // Import normal transactions
@@ -205,3 +290,57 @@ TEST_F(CognitiveEngineTest, VendorImport)
 
     EXPECT_EQ(result.category, "Groceries");
 }
+
+TEST_F(CognitiveEngineTest, EventFeedAppliesChanges)
+{
+    TensorLogicEngine tensor_logic;
+    tensor_logic.initialize();
+    EventFeed feed(engine, &tensor_logic);
+    feed.start();
+
+    feed.account_changed({"acc-checking", "Checking", "BANK", ""});
+    feed.account_changed({"acc-food", "Food", "EXPENSE", ""});
+    feed.transaction_changed({"txn-1", "Grocery Store", "2024-03-02", 80.0,
+                              "acc-food", "acc-checking", 2});
+    feed.transaction_changed({"txn-2", "Grocery Store", "2024-03-09", 20.0,
+                              "acc-food", "acc-checking", 2});
+    feed.transaction_changed({"txn-1", "Grocery Store", "2024-03-02", 50.0,
+                              "acc-food", "acc-checking", 2});
+    feed.transaction_destroyed("txn-2");
+    feed.flush();
+
+    feed.with_engines([](CognitiveEngine& cognitive, TensorLogicEngine* tensor) {
+        const auto& columns = cognitive.transactions();
+        ASSERT_EQ(columns.size(), 1);
+        EXPECT_EQ(columns.amounts()[0], 50.0);
+        EXPECT_FALSE(cognitive.atomspace().get_node(AtomTypes::TRANSACTION_NODE, "txn-2"));
+
+        auto flow = tensor->network().get_flow("acc-checking", "acc-food");
+        EXPECT_DOUBLE_EQ(flow[2], 50.0);
+        EXPECT_TRUE(tensor->get_account("acc-food"));
+    });
+
+    feed.stop();
+    EXPECT_GE(feed.batches(), 1);
+}
+
+TEST_F(CognitiveEngineTest, EventFeedFlushesWithoutWorker)
+{
+    TensorLogicEngine tensor_logic;
+    tensor_logic.initialize();
+    EventFeed feed(engine, &tensor_logic);
+
+    feed.account_changed({"acc-checking", "Checking", "BANK", ""});
+    feed.account_changed({"acc-food", "Food", "EXPENSE", ""});
+    feed.transaction_changed({"txn-1", "Grocery Store", "2024-03-02", 80.0,
+                              "acc-food", "acc-checking", 2});
+    feed.transaction_changed({"txn-2", "Grocery Store", "2025-03-02", 20.0,
+                              "acc-food", "acc-checking", 14});
+    feed.flush();
+
+    EXPECT_EQ(engine.transactions().size(), 2);
+    auto flow = tensor_logic.network().get_flow("acc-checking", "acc-food");
+    EXPECT_DOUBLE_EQ(flow[2], 80.0);
+    EXPECT_DOUBLE_EQ(flow.sum(), 80.0);
+    EXPECT_EQ(feed.batches(), 1);
+}
@@ -3,8 +3,10 @@
  *
  * Exhaustive unit tests for cogutil components:
  * - Counter
- * - Logger
+ * - Logger (synchronous and asynchronous)
  * - ConcurrentQueue
+ * - MpmcQueue, ThreadPool
+ * - RunningStats, Ewma, HoltWinters
  *
  * Copyright (C) 2024 GnuCash Developers
  * SPDX-License-Identifier: GPL-2.0-or-later
@@ -14,9 +16,13 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <map>
 #include "../cogutil/counter.hpp"
 #include "../cogutil/logger.hpp"
 #include "../cogutil/concurrent_queue.hpp"
+#include "../cogutil/mpmc_queue.hpp"
+#include "../cogutil/running_stats.hpp"
+#include "../cogutil/thread_pool.hpp"
 
 using namespace gnc::opencog;
 
@@ -323,6 +329,89 @@ TEST_F(LoggerTest, GlobalLogger)
     EXPECT_EQ(global.get_level(), LogLevel::DEBUG);
 }
 
+TEST_F(LoggerTest, FormatsOnlyEnabledLevels)
+{
+    Logger logger;
+    std::vector<std::pair<LogLevel, std::string>> seen;
+    logger.set_callback([&](LogLevel level, const std::string& component,
+                            const std::string& message) {
+        seen.emplace_back(level, component + ": " + message);
+    });
+
+    logger.info("pattern", "matched ", 3, " of ", 4.5);
+    logger.debug("pattern", "hidden ", 1);
+    ASSERT_EQ(seen.size(), 1);
+    EXPECT_EQ(seen[0].first, LogLevel::INFO);
+    EXPECT_EQ(seen[0].second, "pattern: matched 3 of 4.5");
+
+    logger.set_level(LogLevel::NONE);
+    logger.error("pattern", "silenced");
+    EXPECT_EQ(seen.size(), 1);
+}
+
+TEST_F(LoggerTest, MacroSkipsArgumentsWhenDisabled)
+{
+    Logger& global = Logger::get();
+    LogLevel saved = global.get_level();
+    global.set_level(LogLevel::INFO);
+
+    int evaluated = 0;
+    auto expensive = [&]() { return ++evaluated; };
+    GNC_COG_DEBUG("test", "value ", expensive());
+    GNC_COG_FINE("test", "value ", expensive());
+    EXPECT_EQ(evaluated, 0);
+
+    GNC_COG_INFO("test", "value ", expensive());
+    EXPECT_EQ(evaluated, 1);
+    global.set_level(saved);
+}
+
+TEST_F(LoggerTest, AsyncDeliversEveryMessageInThreadOrder)
+{
+    Logger logger;
+    logger.set_level(LogLevel::DEBUG);
+    std::mutex mutex;
+    std::map<std::string, std::vector<int>> seen;
+    logger.set_callback([&](LogLevel, const std::string& component,
+                            const std::string& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen[component].push_back(std::stoi(message));
+    });
+
+    logger.start_async();
+    EXPECT_TRUE(logger.is_async());
+
+    // More messages per thread than a ring holds.
+    const int per_thread = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&logger, t]() {
+            std::string component = "thread-" + std::to_string(t);
+            for (int i = 0; i < per_thread; ++i)
+                logger.debug(component, i);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    // The text of a C string is copied when the call is made.
+    char buffer[] = "7";
+    logger.info("buffer", buffer);
+    buffer[0] = '9';
+
+    logger.stop_async();
+    EXPECT_FALSE(logger.is_async());
+
+    ASSERT_EQ(seen.size(), 5);
+    for (int t = 0; t < 4; ++t) {
+        const auto& values = seen["thread-" + std::to_string(t)];
+        ASSERT_EQ(values.size(), per_thread);
+        for (int i = 0; i < per_thread; ++i)
+            EXPECT_EQ(values[i], i);
+    }
+    EXPECT_EQ(seen["buffer"], std::vector<int>{7});
+}
+
 // ============================================================
 // ConcurrentQueue Tests
 // ============================================================
@@ -512,6 +601,192 @@ TEST_F(ConcurrentQueueTest, CancelUnblocksWaitingThread)
     EXPECT_TRUE(pop_returned);
 }
 
+// ============================================================
+// MpmcQueue and ThreadPool Tests
+// ============================================================
+
+TEST(MpmcQueueTest, BoundedFifo)
+{
+    MpmcQueue<int> queue(3);
+    EXPECT_EQ(queue.capacity(), 4);
+    EXPECT_TRUE(queue.empty());
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE(queue.try_push(i));
+    EXPECT_FALSE(queue.try_push(4));     // full
+    EXPECT_EQ(queue.size(), 4);
+
+    int value;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+
+    // Wraps around the ring
+    for (int lap = 0; lap < 10; ++lap) {
+        EXPECT_TRUE(queue.try_push(lap));
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, lap);
+    }
+    EXPECT_THROW(MpmcQueue<int>(0), std::invalid_argument);
+}
+
+TEST(MpmcQueueTest, ConcurrentProducersConsumers)
+{
+    const int producers = 4, consumers = 4, per_producer = 20000;
+    MpmcQueue<int> queue(64);
+    std::atomic<long long> sum{0};
+    std::atomic<int> consumed{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < per_producer; ++i)
+                while (!queue.try_push(p * per_producer + i))
+                    std::this_thread::yield();
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&]() {
+            int value;
+            while (consumed.load() < producers * per_producer) {
+                if (queue.try_pop(value)) {
+                    sum += value;
+                    ++consumed;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    long long n = producers * per_producer;
+    EXPECT_EQ(consumed.load(), n);
+    EXPECT_EQ(sum.load(), n * (n - 1) / 2);     // every value exactly once
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(ThreadPoolTest, SubmitReturnsFutures)
+{
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.size(), 3);
+    EXPECT_FALSE(pool.in_worker());
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i)
+        results.push_back(pool.submit([](int x) { return x * x; }, i));
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(results[i].get(), i * i);
+
+    EXPECT_TRUE(pool.submit([&pool]() { return pool.in_worker(); }).get());
+
+    auto failed = pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ParallelForCoversRangeOnce)
+{
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(10007);
+    pool.parallel_for(3, hits.size(), 100, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            ++hits[i];
+    });
+    for (size_t i = 0; i < hits.size(); ++i)
+        EXPECT_EQ(hits[i].load(), i < 3 ? 0 : 1) << i;
+
+    // Nested loops inside pool tasks do not wait on each other.
+    std::atomic<size_t> inner{0};
+    pool.parallel_for(0, 16, 1, [&](size_t, size_t) {
+        pool.parallel_for(0, 1000, 10, [&](size_t begin, size_t end) {
+            inner += end - begin;
+        });
+    });
+    EXPECT_EQ(inner.load(), 16000);
+
+    EXPECT_THROW(pool.parallel_for(0, 100, 1, [](size_t begin, size_t) {
+        if (begin == 42) throw std::out_of_range("chunk 42");
+    }), std::out_of_range);
+}
+
+TEST(ThreadPoolTest, DestructorRunsQueuedTasks)
+{
+    std::atomic<int> ran{0};
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 2000; ++i)
+            pool.post([&ran]() { ++ran; });
+    }
+    EXPECT_EQ(ran.load(), 2000);
+}
+
+// ============================================================
+// Streaming Statistics Tests
+// ============================================================
+
+TEST(RunningStatsTest, MatchesTwoPassStatistics)
+{
+    std::vector<double> values{12.5, 3.0, 7.25, 100.0, -4.0, 9.5};
+    RunningStats stats, first, second;
+    for (size_t i = 0; i < values.size(); ++i) {
+        stats.add(values[i]);
+        (i < 3 ? first : second).add(values[i]);
+    }
+
+    double mean = 0.0, m2 = 0.0;
+    for (double v : values) mean += v;
+    mean /= values.size();
+    for (double v : values) m2 += (v - mean) * (v - mean);
+
+    EXPECT_EQ(stats.count(), 6);
+    EXPECT_NEAR(stats.mean(), mean, 1e-12);
+    EXPECT_NEAR(stats.variance(), m2 / 6, 1e-9);
+    EXPECT_NEAR(stats.sample_variance(), m2 / 5, 1e-9);
+
+    first.merge(second);
+    EXPECT_NEAR(first.mean(), mean, 1e-12);
+    EXPECT_NEAR(first.variance(), stats.variance(), 1e-9);
+
+    stats.remove(100.0);
+    RunningStats without;
+    for (double v : values)
+        if (v != 100.0) without.add(v);
+    EXPECT_NEAR(stats.mean(), without.mean(), 1e-12);
+    EXPECT_NEAR(stats.variance(), without.variance(), 1e-9);
+    EXPECT_NEAR(stats.z_score(without.mean() + without.stddev()), 1.0, 1e-12);
+}
+
+TEST(RunningStatsTest, EwmaFollowsLevelShift)
+{
+    Ewma ewma(0.5);
+    for (int i = 0; i < 20; ++i) ewma.add(10.0);
+    EXPECT_DOUBLE_EQ(ewma.mean(), 10.0);
+    EXPECT_DOUBLE_EQ(ewma.variance(), 0.0);
+    for (int i = 0; i < 20; ++i) ewma.add(20.0);
+    EXPECT_NEAR(ewma.mean(), 20.0, 1e-4);
+    EXPECT_THROW(Ewma(0.0), std::invalid_argument);
+}
+
+TEST(RunningStatsTest, HoltWintersForecastsTrendAndSeason)
+{
+    HoltWinters holt(0.5, 0.5);
+    for (int i = 0; i < 30; ++i) holt.add(100.0 + 5.0 * i);
+    EXPECT_NEAR(holt.forecast(1), 250.0, 1e-6);
+    EXPECT_NEAR(holt.forecast(3), 260.0, 1e-6);
+
+    // Period-4 season on a rising line
+    const double season[] = {10.0, -5.0, 0.0, -5.0};
+    HoltWinters seasonal(0.3, 0.1, 0.3, 4);
+    for (int i = 0; i < 40; ++i) seasonal.add(50.0 + i + season[i % 4]);
+    auto forecast = seasonal.forecast_range(4);
+    for (int h = 0; h < 4; ++h)
+        EXPECT_NEAR(forecast[h], 50.0 + (40 + h) + season[(40 + h) % 4], 1.0);
+    EXPECT_THROW(HoltWinters(0.3, 0.1, 0.1, 1), std::invalid_argument);
+}
+
 // ============================================================
 // Additional Edge Case Tests
 // ============================================================
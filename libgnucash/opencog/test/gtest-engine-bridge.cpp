@@ -0,0 +1,152 @@
+/*
+ * gtest-engine-bridge.cpp
+ *
+ * Unit tests for EngineBridge: book changes reaching the cognitive engines
+ *
+ * Copyright (C) 2024 GnuCash Developers
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <gtest/gtest.h>
+
+#include <Account.h>
+#include <Split.h>
+#include <Transaction.h>
+#include <cashobjects.h>
+#include <gnc-commodity.h>
+#include <gnc-date.h>
+#include <guid.h>
+#include <qof.h>
+
+#include "../gnc-cognitive/engine_bridge.hpp"
+
+using namespace gnc::opencog;
+using gnc::tensor_logic::TensorLogicEngine;
+
+class EngineBridgeTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        qof_init();
+        cashobjects_register();
+    }
+
+    static void TearDownTestSuite()
+    {
+        qof_close();
+    }
+
+    CognitiveEngine engine;
+    TensorLogicEngine tensor_logic;
+    QofBook* book = nullptr;
+    Account* checking = nullptr;
+    Account* food = nullptr;
+
+    void SetUp() override
+    {
+        engine.initialize();
+        tensor_logic.initialize();
+        book = qof_book_new();
+    }
+
+    void TearDown() override
+    {
+        qof_book_destroy(book);
+        engine.shutdown();
+    }
+
+    gnc_commodity* usd()
+    {
+        return gnc_commodity_table_lookup(gnc_commodity_table_get_table(book),
+                                          GNC_COMMODITY_NS_CURRENCY, "USD");
+    }
+
+    Account* add_account(const char* name, GNCAccountType type)
+    {
+        Account* account = xaccMallocAccount(book);
+        xaccAccountBeginEdit(account);
+        xaccAccountSetName(account, name);
+        xaccAccountSetType(account, type);
+        xaccAccountSetCommodity(account, usd());
+        gnc_account_append_child(gnc_book_get_root_account(book), account);
+        xaccAccountCommitEdit(account);
+        return account;
+    }
+
+    Transaction* add_transaction(const char* description, int day, int month, int year,
+                                 gint64 cents)
+    {
+        Transaction* trans = xaccMallocTransaction(book);
+        xaccTransBeginEdit(trans);
+        xaccTransSetCurrency(trans, usd());
+        xaccTransSetDescription(trans, description);
+        xaccTransSetDatePostedSecsNormalized(trans, gnc_dmy2time64(day, month, year));
+
+        gnc_numeric value = gnc_numeric_create(cents, 100);
+        add_split(trans, food, value);
+        add_split(trans, checking, gnc_numeric_neg(value));
+        xaccTransCommitEdit(trans);
+        return trans;
+    }
+
+    void add_split(Transaction* trans, Account* account, gnc_numeric amount)
+    {
+        Split* split = xaccMallocSplit(book);
+        xaccSplitSetAccount(split, account);
+        xaccSplitSetParent(split, trans);
+        xaccSplitSetAmount(split, amount);
+        xaccSplitSetValue(split, amount);
+    }
+
+    static std::string guid_of(gpointer instance)
+    {
+        char buff[GUID_ENCODING_LENGTH + 1];
+        guid_to_string_buff(qof_instance_get_guid(QOF_INSTANCE(instance)), buff);
+        return buff;
+    }
+};
+
+TEST_F(EngineBridgeTest, BookChangesReachTheEngines)
+{
+    EventFeed feed(engine, &tensor_logic);
+    EngineBridge bridge(feed, 2024);
+    feed.start();
+
+    checking = add_account("Checking", ACCT_TYPE_BANK);
+    food = add_account("Food", ACCT_TYPE_EXPENSE);
+    Transaction* march = add_transaction("Grocery Store", 2, 3, 2024, 8000);
+    Transaction* next_march = add_transaction("Grocery Store", 2, 3, 2025, 2000);
+    add_transaction("Grocery Store", 2, 3, 2023, 500);
+    feed.flush();
+
+    auto food_guid = guid_of(food), checking_guid = guid_of(checking);
+    feed.with_engines([&](CognitiveEngine& cognitive, TensorLogicEngine* tensor) {
+        EXPECT_TRUE(cognitive.atomspace().get_node(AtomTypes::ACCOUNT_NODE, food_guid));
+        // Accounts arrive once committed, not blank from xaccMallocAccount.
+        EXPECT_FALSE(cognitive.atomspace().get_node(AtomTypes::CONCEPT_NODE, ""));
+        ASSERT_TRUE(tensor->get_account(food_guid));
+        EXPECT_EQ(tensor->get_account(food_guid)->name(), "Food");
+        EXPECT_EQ(cognitive.transactions().size(), 3u);
+
+        // March 2025 is period 14, outside the twelve the engine keeps, so
+        // only March 2024 is in the flows.
+        auto flow = tensor->network().get_flow(checking_guid, food_guid);
+        EXPECT_DOUBLE_EQ(flow[2], 80.0);
+        EXPECT_DOUBLE_EQ(flow.sum(), 80.0);
+    });
+
+    xaccTransBeginEdit(march);
+    xaccTransDestroy(march);
+    xaccTransCommitEdit(march);
+    feed.flush();
+
+    auto next_guid = guid_of(next_march);
+    feed.with_engines([&](CognitiveEngine& cognitive, TensorLogicEngine* tensor) {
+        EXPECT_EQ(cognitive.transactions().size(), 2u);
+        EXPECT_TRUE(cognitive.atomspace().get_node(AtomTypes::TRANSACTION_NODE, next_guid));
+        EXPECT_DOUBLE_EQ(tensor->network().get_flow(checking_guid, food_guid)[2], 0.0);
+    });
+
+    feed.stop();
+}
@@ -134,3 +134,106 @@ TEST_F(PatternMatchTest, AccountHierarchyPattern)
 
     EXPECT_EQ(links.size(), 2);  // Food and Transportation
 }
+
+TEST_F(PatternMatchTest, MultiClauseJoin)
+{
+    PatternMatcher matcher(atomspace);
+
+    // Pets: (MemberLink X Pet) joined on X with (InheritanceLink X Animal)
+    auto pet = atomspace.add_node(AtomTypes::CONCEPT_NODE, "Pet");
+    auto dog = atomspace.get_node(AtomTypes::CONCEPT_NODE, "Dog");
+    auto cat = atomspace.get_node(AtomTypes::CONCEPT_NODE, "Cat");
+    auto rock = atomspace.add_node(AtomTypes::CONCEPT_NODE, "Rock");
+    atomspace.add_link(AtomTypes::MEMBER_LINK, dog, pet);
+    atomspace.add_link(AtomTypes::MEMBER_LINK, cat, pet);
+    atomspace.add_link(AtomTypes::MEMBER_LINK, rock, pet);
+
+    auto animal = atomspace.get_node(AtomTypes::CONCEPT_NODE, "Animal");
+    auto var_x = create_node(AtomTypes::VARIABLE_NODE, "X");
+    Pattern pattern;
+    pattern.add_variable("X", AtomTypes::CONCEPT_NODE)
+           .set_body(create_link(AtomTypes::MEMBER_LINK, var_x, pet))
+           .add_clause(create_link(AtomTypes::INHERITANCE_LINK, var_x, animal));
+
+    auto results = matcher.match(pattern);
+    ASSERT_EQ(results.size(), 2);
+    for (const auto& binding : results)
+        EXPECT_TRUE(binding.at("X") == dog || binding.at("X") == cat);
+
+    // Stopping after the first match
+    size_t seen = 0;
+    matcher.match(pattern, [&seen](const Bindings&) { return ++seen < 1; });
+    EXPECT_EQ(seen, 1);
+
+    // A constant that is not in the AtomSpace matches nothing.
+    Pattern missing;
+    missing.set_body(create_link(AtomTypes::MEMBER_LINK, var_x,
+                                 create_node(AtomTypes::CONCEPT_NODE, "Plant")));
+    EXPECT_TRUE(matcher.match(missing).empty());
+}
+
+TEST_F(PatternMatchTest, NestedPattern)
+{
+    PatternMatcher matcher(atomspace);
+
+    // (EvaluationLink kind (ListLink X Y)) for account pairs
+    auto kind = atomspace.add_node(AtomTypes::PREDICATE_NODE, "sibling");
+    auto food = atomspace.get_node(AtomTypes::ACCOUNT_NODE, "Expenses:Food");
+    auto transport = atomspace.get_node(AtomTypes::ACCOUNT_NODE, "Expenses:Transportation");
+    atomspace.add_link(AtomTypes::EVALUATION_LINK, kind,
+                       atomspace.add_link(AtomTypes::LIST_LINK, food, transport));
+
+    auto var_x = create_node(AtomTypes::VARIABLE_NODE, "X");
+    auto var_y = create_node(AtomTypes::VARIABLE_NODE, "Y");
+    auto expenses = atomspace.get_node(AtomTypes::ACCOUNT_NODE, "Expenses");
+    Pattern pattern;
+    pattern.add_variable("X", AtomTypes::ACCOUNT_NODE)
+           .add_variable("Y", AtomTypes::ACCOUNT_NODE)
+           .set_body(create_link(AtomTypes::EVALUATION_LINK, kind,
+                                 create_link(AtomTypes::LIST_LINK, var_x, var_y)))
+           .add_clause(create_link(AtomTypes::ACCOUNT_HIERARCHY_LINK, var_y, expenses));
+
+    auto results = matcher.match(pattern);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].at("X"), food);
+    EXPECT_EQ(results[0].at("Y"), transport);
+
+    // The declared type of a variable is checked.
+    Pattern wrong_type;
+    wrong_type.add_variable("X", AtomTypes::CONCEPT_NODE)
+              .set_body(create_link(AtomTypes::EVALUATION_LINK, kind,
+                                    create_link(AtomTypes::LIST_LINK, var_x, var_y)));
+    EXPECT_TRUE(matcher.match(wrong_type).empty());
+}
+
+TEST_F(PatternMatchTest, ParallelMatchAgreesWithMatch)
+{
+    PatternMatcher matcher(atomspace);
+
+    auto animal = atomspace.get_node(AtomTypes::CONCEPT_NODE, "Animal");
+    for (int i = 0; i < 200; ++i)
+        atomspace.add_link(AtomTypes::INHERITANCE_LINK,
+                           atomspace.add_node(AtomTypes::CONCEPT_NODE,
+                                              "Species" + std::to_string(i)),
+                           animal);
+
+    auto var_x = create_node(AtomTypes::VARIABLE_NODE, "X");
+    Pattern pattern;
+    pattern.add_variable("X", AtomTypes::CONCEPT_NODE)
+           .set_body(create_link(AtomTypes::INHERITANCE_LINK, var_x, animal));
+
+    auto expected = matcher.match(pattern);
+    ASSERT_EQ(expected.size(), 203);
+
+    MatchOptions options;
+    options.threads = 4;
+    EXPECT_EQ(matcher.match_parallel(pattern, options), expected);
+
+    options.limit = 10;
+    options.ordered = true;
+    auto first = matcher.match_parallel(pattern, options);
+    EXPECT_EQ(first, std::vector<Bindings>(expected.begin(), expected.begin() + 10));
+
+    options.ordered = false;
+    EXPECT_EQ(matcher.match_parallel(pattern, options).size(), 10);
+}
@@ -196,6 +196,38 @@ TEST_F(TensorLogicEngineTest, ForecastBalance)
     EXPECT_EQ(forecast.predicted_values.size(), 3);
 }
 
+TEST_F(TensorLogicEngineTest, ForecastBalanceFollowsTrend)
+{
+    engine.create_account("acc-001", "Checking", 1, 12, 1);
+    for (size_t month = 0; month < 12; ++month)
+        engine.import_account_data("acc-001", 0, month, 0, 1000.0 + month * 100.0, 0.0, 0.0);
+
+    auto forecast = engine.forecast_balance("acc-001", 3);
+
+    // The last balance is 2100 after steady rises of 100.
+    EXPECT_GT(forecast.predicted_values[0], 2100.0);
+    EXPECT_GT(forecast.predicted_values[2], forecast.predicted_values[0]);
+    EXPECT_NEAR(forecast.predicted_values[0], 2200.0, 1e-6);
+    EXPECT_LE(forecast.confidence_intervals.at({0, 0}), forecast.predicted_values[0]);
+}
+
+TEST_F(TensorLogicEngineTest, FlowAnomalyScore)
+{
+    engine.create_account("acc-001", "Checking", 1, 12, 1);
+    engine.create_account("acc-002", "Groceries", 1, 12, 1);
+    for (int i = 0; i < 10; ++i)
+        engine.record_transaction("acc-001", "acc-002", 50.0 + (i % 2) * 10.0, 0);
+
+    ASSERT_TRUE(engine.flow_stats("acc-002"));
+    EXPECT_EQ(engine.flow_stats("acc-002")->count(), 10);
+    EXPECT_DOUBLE_EQ(engine.flow_stats("acc-002")->mean(), 55.0);
+    EXPECT_GT(engine.flow_anomaly_score("acc-002", 500.0), 10.0);
+
+    engine.remove_transaction("acc-001", "acc-002", 60.0, 0);
+    EXPECT_EQ(engine.flow_stats("acc-001")->count(), 9);
+    EXPECT_EQ(engine.flow_anomaly_score("acc-unknown", 500.0), 0.0);
+}
+
 TEST_F(TensorLogicEngineTest, ForecastCashFlow)
 {
     engine.create_account("acc-001", "Checking", 1, 12, 1);
@@ -249,6 +281,37 @@ TEST_F(TensorLogicEngineTest, ClusterAccounts)
     EXPECT_EQ(clusters.size(), 2);
 }
 
+TEST(TensorAccountSetTest, SimilarityFollowsBalanceDirection)
+{
+    TensorAccountSet accounts;
+    auto add = [&](const std::string& guid, double balance, double flow) {
+        auto account = std::make_shared<TensorAccount>(guid, guid);
+        for (size_t p = 0; p < account->num_periods(); ++p) {
+            account->set_metric(0, p, 0, TensorAccount::Metrics::BALANCE, balance);
+            account->set_metric(0, p, 0, TensorAccount::Metrics::NET_FLOW, flow);
+        }
+        accounts.add_account(account);
+    };
+    add("asset-1", 100.0, 10.0);
+    add("asset-2", 250.0, 20.0);
+    add("liability-1", -100.0, -5.0);
+    add("liability-2", -300.0, -40.0);
+
+    auto similar = accounts.find_similar(*accounts.get_account("asset-1"), 2);
+    ASSERT_EQ(similar.size(), 2);
+    EXPECT_EQ(similar[0].first, "asset-2");
+    EXPECT_GT(similar[0].second, 0.99);
+    EXPECT_LT(similar[1].second, 0.0);
+
+    auto clusters = accounts.cluster_accounts(2);
+    ASSERT_EQ(clusters.size(), 2);
+    for (const auto& cluster : clusters) {
+        ASSERT_EQ(cluster.size(), 2);
+        EXPECT_EQ(cluster[0].substr(0, 5), cluster[1].substr(0, 5));
+    }
+    EXPECT_TRUE(accounts.cluster_accounts(0).empty());
+}
+
 TEST_F(TensorLogicEngineTest, GetNetworkStats)
 {
     engine.record_transaction("income", "checking", 2000.0, 0);
@@ -260,6 +323,81 @@ TEST_F(TensorLogicEngineTest, GetNetworkStats)
     EXPECT_GT(stats.num_network_edges, 0);
 }
 
+TEST(TensorNetworkTest, CircularFlowsListedOnceWithinBound)
+{
+    TensorNetwork network;
+    network.add_edge("a", "b", 100.0);
+    network.add_edge("b", "c", 100.0);
+    network.add_edge("c", "a", 100.0);
+    network.add_edge("c", "d", 50.0);
+    network.add_edge("d", "a", 50.0);
+    network.add_edge("b", "a", 10.0);   // two-account round trip, not listed
+
+    auto cycles = network.detect_circular_flows();
+    ASSERT_EQ(cycles.size(), 2);
+    std::sort(cycles.begin(), cycles.end(),
+              [](const auto& x, const auto& y) { return x.size() < y.size(); });
+    EXPECT_EQ(cycles[0], (std::vector<std::string>{"a", "b", "c", "a"}));
+    EXPECT_EQ(cycles[1], (std::vector<std::string>{"a", "b", "c", "d", "a"}));
+
+    EXPECT_EQ(network.detect_circular_flows(3).size(), 1);
+    EXPECT_TRUE(network.detect_circular_flows(2).empty());
+}
+
+TEST(TensorNetworkTest, SparseFlowsAndPageRank)
+{
+    TensorNetwork network(4);
+    network.add_node("a", "Account A");
+    network.add_edge("a", "b", 100.0, 1);
+    network.add_edge("a", "b", 40.0, 2);
+    network.add_edge("b", "c", 30.0, 1);
+    network.add_edge("c", "a", 20.0, 3);
+
+    EXPECT_EQ(network.get_nodes(), (std::vector<std::string>{"a", "b", "c"}));
+    EXPECT_EQ(network.get_outgoing("a"), std::vector<std::string>{"b"});
+    EXPECT_EQ(network.get_incoming("a"), std::vector<std::string>{"c"});
+    EXPECT_DOUBLE_EQ(network.get_total_outflow("a").sum(), 140.0);
+    EXPECT_DOUBLE_EQ(network.get_net_flow("b")[1], 70.0);
+    EXPECT_DOUBLE_EQ(network.get_flow_matrix(2)(0, 1), 40.0);
+
+    network.remove_transaction("a", "b", 40.0, 2);
+    auto edge = network.get_edge("a", "b");
+    ASSERT_TRUE(edge.has_value());
+    EXPECT_DOUBLE_EQ(edge->total_flow, 100.0);
+    EXPECT_EQ(edge->transaction_count, 1);
+    EXPECT_DOUBLE_EQ(edge->flow_tensor[2], 0.0);
+    EXPECT_FALSE(network.get_edge("b", "a").has_value());
+
+    // A plain cycle ranks every account alike.
+    auto rank = network.pagerank();
+    for (size_t i = 0; i < 3; ++i)
+        EXPECT_NEAR(rank[i], 1.0 / 3, 1e-9);
+
+    // New edges are indexed on the next query.
+    network.add_edge("b", "d", 10.0);
+    rank = network.pagerank();
+    EXPECT_LT(rank.sum(), 1.0);     // d has no outflow to pass its rank on
+    EXPECT_NEAR(rank[3], rank[2], 1e-12);
+}
+
+TEST(TensorNetworkTest, NodeEmbeddingsAreNodesByDimensions)
+{
+    TensorNetwork network(4);
+    network.add_edge("a", "b", 100.0, 1);
+    network.add_edge("b", "c", 30.0, 1);
+
+    auto embeddings = network.generate_node_embeddings(8);
+    EXPECT_EQ(embeddings.shape(), (Shape{3, 8}));
+}
+
+TEST_F(TensorLogicEngineTest, CompareEntitiesShape)
+{
+    engine.create_account("acc-001", "Expenses", 3, 12, 1);
+    auto comparison = engine.compare_entities("acc-001", TensorAccount::Metrics::BALANCE);
+    EXPECT_EQ(comparison.shape(), (Shape{3, 12}));
+    EXPECT_EQ(engine.get_account("acc-001")->get_balances().shape(), (Shape{3, 12, 1}));
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);